@@ -0,0 +1,22 @@
+-- benchmark_drawcalls
+-- @short: Retrieve draw call counters for the 2D pipeline.
+-- @outargs: stattbl
+-- @longdescr: Consecutive objects that use the default shaders and share the
+-- same texture and blend state are drawn together as a single batch rather
+-- than with one draw call each. This function returns a table with the
+-- fields *calls* (draw calls issued during the last refresh), *quads* (the
+-- number of 2D objects these covered), *total_calls*, *total_quads* and
+-- *refreshes* (accumulated since the last benchmark_enable) and *batching*
+-- which is false if batching has been disabled.
+-- @note: Batching can be disabled for comparison by setting the
+-- ARCAN_VIDEO_NO_BATCH environment variable, or the video_no_batch appl
+-- config key.
+-- @group: system
+-- @cfunction: getdrawstats
+-- @related: benchmark_enable, benchmark_data, benchmark_latency
+function main()
+#ifdef MAIN
+	local tbl = benchmark_drawcalls();
+	print(tbl.calls, tbl.quads, tbl.total_calls / tbl.refreshes);
+#endif
+end
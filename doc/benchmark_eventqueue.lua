@@ -0,0 +1,23 @@
+-- benchmark_eventqueue
+-- @short: Retrieve counters for the engine event queue.
+-- @outargs: stattbl
+-- @longdescr: Events that are produced outside of the main thread, or while
+-- the main event queue is full, are posted to an intermediate lock-free ring
+-- and transferred to the main queue in batches. This function returns a table
+-- with the counters for this ring: *posted* (number of events that passed
+-- through the ring), *saturated* (times the main queue was found full),
+-- *overflow* (events rejected as the ring was full as well), *batches*
+-- (number of batch transfers), *pending* (events currently in the ring),
+-- *high_water* (highest observed ring occupancy) and *capacity*.
+-- @note: The counters are not reset by benchmark_enable.
+-- @group: system
+-- @cfunction: geteventqueuestats
+-- @related: benchmark_enable, benchmark_data
+function main()
+#ifdef MAIN
+	local tbl = benchmark_eventqueue();
+	for k,v in pairs(tbl) do
+		print(k, v);
+	end
+#endif
+end
@@ -0,0 +1,38 @@
+-- benchmark_latency
+-- @short: Retrieve latency percentiles for main loop stages or a frameserver.
+-- @inargs:
+-- @inargs: vid:fsrv
+-- @outargs: stattbl
+-- @longdescr: The engine continuously records how long each stage of the
+-- main loop takes into a histogram with microsecond resolution. Without any
+-- arguments, this function returns a table indexed by stage name, where
+-- *event* covers event delivery to the scripting VM, *tick* the logical clock
+-- (including the clock_pulse handlers), *pollfeed* frameserver polling and
+-- buffer uploads, *synch* rendering and display synchronization and *frame*
+-- the time between two completed display synchronizations.
+-- If a frameserver *fsrv* is provided, the returned table instead covers the
+-- time spent uploading buffers from that frameserver, along with the video
+-- frame counters *produced* (frames signalled by the client), *consumed*
+-- (frames taken by the engine) and *dropped* (frames replaced by a newer one
+-- before being taken), and *mailbox* set if the client negotiated the
+-- latest-frame buffer mode.
+-- Each entry has the fields *count*, *min*, *max*, *mean*, *p50*, *p90*,
+-- *p99* and *p999*, all in microseconds. Percentiles are accurate to within
+-- ~6%.
+-- @note: The histograms are reset by calling benchmark_enable.
+-- @note: Setting the ARCAN_CONDUCTOR_TIMELOG environment variable to a file
+-- path will have the engine write the per-stage times of every frame to that
+-- file, one line per frame.
+-- @note: Frameservers that are not tracked by the engine scheduler return nil.
+-- @group: system
+-- @cfunction: getlatency
+-- @related: benchmark_enable, benchmark_data, benchmark_eventqueue,
+-- benchmark_drawcalls
+function main()
+#ifdef MAIN
+	local tbl = benchmark_latency();
+	for k,v in pairs(tbl) do
+		print(k, v.count, v.p50, v.p99, v.max);
+	end
+#endif
+end
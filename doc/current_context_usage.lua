@@ -1,12 +1,14 @@
 -- current_context_usage
 -- @short: Return how many cells the current context has, and how many of those cells that are currently unused.
 -- @inargs:
--- @outargs: total, used
--- @longdescr: This function sweeps the VID pool of the currently active
--- context and counts O(n) how many of these are in use and subsequently
--- returns how many slots are available in total, and how many are
--- maked as used. The number of free slots can be found by subtracting
--- used from total.
+-- @outargs: total, used, allocs, frees, peak
+-- @longdescr: This function returns how many VID slots the currently active
+-- context has in total, and how many of those that are marked as used.
+-- The number of free slots can be found by subtracting used from total.
+-- The remaining values are allocation counters for the context, *allocs*
+-- and *frees* are running totals since the context was created and *peak*
+-- is the highest number of slots that have been in use at the same time.
+-- Sampling *allocs* at two points in time gives the allocation rate.
 --
 -- @group: vidsys
 -- @cfunction: contextusage
@@ -16,6 +18,7 @@ function main()
 	a = fill_surface(32, 32, 0, 0, 0);
 	print(current_context_usage());
 	b = fill_surface(32, 32, 0, 0, 0);
+	delete_image(a);
 	print(current_context_usage());
 #endif
 end
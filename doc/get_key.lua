@@ -1,10 +1,17 @@
 -- get_key
 -- @short: Retrieve a key/value pair from the database.
 -- @inargs: key, *opttgt*, *optcfg*
+-- @inargs: keytbl, *opttgt*, *optcfg*
 -- @outargs: string or nil
+-- @outargs: kvtbl
 -- @longdescr: Return a single value associated with a *key*
 -- from either the appl global space, or from an optional
 -- target or optional target/configuration.
+-- If the first argument is a table of key strings, all the keys are
+-- resolved in as few queries as possible and the result is returned as a
+-- table with key as index and the stored string as value. Keys that are
+-- missing in the database are also missing from the returned table, and
+-- invalid keys are skipped with a warning.
 -- @group: database
 -- @cfunction: getkey
 -- @related: store_key
@@ -16,5 +23,10 @@ function main()
 	if (value == "result") then
 		print("OK");
 	end
+
+	store_key({a = "1", b = "2"});
+	for k,v in pairs(get_key({"a", "b", "c"})) do
+		print(k, v);
+	end
 #endif
 end
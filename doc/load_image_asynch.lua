@@ -1,12 +1,15 @@
 -- load_image_asynch
 -- @short: asynchronously load an image from a resource
--- @inargs: resource, *callback
+-- @inargs: resource, *callback, *priority
 -- @arg(*callback): a lua function that takes two arguments (sourcevid, statustbl)
 -- if the image succeeded, the "kind" field of "statustbl" will be set to "loaded"
 -- if the image couldn't be loaded, the "kind" field of "statustbl" will be set to "load_failed"
 -- and the "resource" field will be set to indicate the resource string that failed to load.
 -- in both cases, "width" and "height" will be set (as the video object will still be valid,
 -- just set to a placeholder source.
+-- @arg(*priority): images are decoded by a shared pool of worker threads,
+-- pending loads with a higher priority are picked before lower ones and
+-- loads with the same priority in the order they were requested (default: 0).
 -- @outargs: VID, fail:BADID
 -- @longdescr: Sets up a new video object container and attempts to load and
 -- decode an image from the specified resource.
@@ -14,6 +17,8 @@
 -- @note: The operation can be forced asynchronous by either doing an operation which requires
 -- a stable state for the current context (e.g. push/pop_video_context) or by explicitly calling
 -- image_pushasynch.
+-- @note: Deleting the VID before the image has been loaded cancels the load
+-- and no callback will be triggered.
 -- @group: image
 -- @cfunction: loadimageasynch
 -- @related: image_pushasynch load_image
@@ -1,5 +1,5 @@
 -- match_keys
--- @inargs: pattern, *domain*
+-- @inargs: pattern, *domain*, *map*
 -- @short: Return target:value for keys that match the specified pattern
 -- @outargs: strtbl
 -- @longdescr: This function can be used to retrieve multiple domain:value
@@ -7,6 +7,10 @@
 -- (where % is used as wildcard, SQL style).
 -- The optional *domain* argument can be set to KEY_CONFIG or to KEY_TARGET
 -- but defaults to the appl- specific key-value store.
+-- If *map* is set to true (only permitted for the appl- domain), the
+-- result is instead returned as a table with the matching keys as index
+-- and the stored strings as values, avoiding the need to split and
+-- re-query each entry.
 -- @group: database
 -- @cfunction: matchkeys
 -- @related:
@@ -22,9 +26,17 @@ function main()
 		local val = string.sub(v, stop + 1);
 		print(key, val);
 	end
+
+	for k,v in pairs(match_keys("%", nil, true)) do
+		print(k, v);
+	end
 #endif
 
 #ifdef ERROR1
 	print(match_keys("%", BADID)[1]);
 #endif
+
+#ifdef ERROR2
+	match_keys("%", KEY_CONFIG, true);
+#endif
 end
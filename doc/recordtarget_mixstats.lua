@@ -0,0 +1,27 @@
+-- recordtarget_mixstats
+-- @short: Retrieve buffering and underrun counters for the audio sources of a recordtarget.
+-- @inargs: vid
+-- @outargs: srctbl
+-- @longdescr: When a recordtarget has been defined with more than one audio
+-- source, each source is buffered separately (resampled to the native rate
+-- if needed) and mixed when all of them have provided enough samples. This
+-- function returns a table with one entry per source, in the order they were
+-- provided to define_recordtarget. Each entry has the fields *aid*,
+-- *buffered* (samples currently waiting to be mixed, both channels counted),
+-- *latency* (the same, in milliseconds), *underruns* (number of mixes where
+-- the source did not have enough buffered and was padded with silence),
+-- *underrun_samples* (the number of samples of silence inserted) and
+-- *dropped* (number of samples discarded as the source buffer was full).
+-- @note: A recordtarget with a single audio source bypasses the mixer, and
+-- the returned table will be empty.
+-- @group: targetcontrol
+-- @cfunction: recordmixstats
+-- @related: recordtarget_gain, define_recordtarget
+function main()
+#ifdef MAIN
+	local tbl = recordtarget_mixstats(rtgt);
+	for i,v in ipairs(tbl) do
+		print(v.aid, v.latency, v.underruns, v.dropped);
+	end
+#endif
+end
@@ -13,6 +13,8 @@
 #include <inttypes.h>
 #include <stdbool.h>
 #include <stdio.h>
+#include <string.h>
+#include <math.h>
 #include <unistd.h>
 
 #include "arcan_math.h"
@@ -32,9 +34,10 @@
 
 /*
  * checklist:
- *  [ ] actual setup to realtime- plot the different timings and stages
+ *  [x] actual setup to realtime- plot the different timings and stages
  *      so it is easier (possible) to debug and evaluate the different strategies,
  *      for sake of comparison, chrome has a builtin viewer for a json format
+ *      [ ] stream to a shmif debug segment rather than a file
  *
  *  [ ] parallelize PBO uploads
  *      (thought: test the systemic effects of not doing shm->gpu in process but
@@ -103,6 +106,142 @@ static struct {
 	struct arcan_frameserver* focus;
 } frameservers;
 
+/*
+ * Per-stage latency tracking, [frame] accumulates the time spent in each stage
+ * since the last synch so that it can be streamed to [log] (set through the
+ * ARCAN_CONDUCTOR_TIMELOG=path environment variable) one line per frame.
+ */
+static struct {
+	struct conductor_histogram stage[CONDUCTOR_STAGE_COUNT];
+	uint64_t frame[CONDUCTOR_STAGE_COUNT];
+	uint64_t last_synch;
+	uint64_t frame_count;
+	FILE* log;
+} timing;
+
+static const char* stage_names[] = {
+	"event",
+	"tick",
+	"pollfeed",
+	"synch",
+	"frame"
+};
+
+static size_t hist_bucket(uint64_t us)
+{
+	if (us < 16)
+		return us;
+
+	size_t exp = 63 - __builtin_clzll(us);
+	size_t ind = (exp - 3) * 16 + ((us >> (exp - 4)) & 15);
+	return ind < CONDUCTOR_HIST_BUCKETS ? ind : CONDUCTOR_HIST_BUCKETS - 1;
+}
+
+static uint64_t hist_upper(size_t ind)
+{
+	if (ind < 16)
+		return ind;
+
+	size_t exp = ind / 16 + 3;
+	return ((uint64_t)(16 + (ind % 16) + 1) << (exp - 4)) - 1;
+}
+
+void arcan_conductor_hist_add(struct conductor_histogram* hist, uint64_t us)
+{
+	if (!hist)
+		return;
+
+	if (us > UINT32_MAX)
+		us = UINT32_MAX;
+
+	if (!hist->count || us < hist->min)
+		hist->min = us;
+	if (us > hist->max)
+		hist->max = us;
+
+	hist->count++;
+	hist->sum += us;
+	hist->buckets[hist_bucket(us)]++;
+}
+
+uint64_t arcan_conductor_hist_percentile(
+	const struct conductor_histogram* hist, double p)
+{
+	if (!hist || !hist->count)
+		return 0;
+
+	uint64_t lim = ceil(p * (double)hist->count);
+	if (lim < 1)
+		lim = 1;
+
+	uint64_t acc = 0;
+	for (size_t i = 0; i < CONDUCTOR_HIST_BUCKETS; i++){
+		acc += hist->buckets[i];
+		if (acc >= lim){
+			uint64_t val = hist_upper(i);
+			return val > hist->max ? hist->max : val;
+		}
+	}
+
+	return hist->max;
+}
+
+const struct conductor_histogram*
+	arcan_conductor_timing(enum conductor_stage stage, const char** name)
+{
+	if (stage >= CONDUCTOR_STAGE_COUNT)
+		return NULL;
+
+	if (name)
+		*name = stage_names[stage];
+
+	return &timing.stage[stage];
+}
+
+void arcan_conductor_reset_timing()
+{
+	memset(timing.stage, '\0', sizeof(timing.stage));
+	memset(timing.frame, '\0', sizeof(timing.frame));
+	timing.last_synch = 0;
+
+	for (size_t i = 0; frameservers.ref && i < frameservers.count; i++)
+		if (frameservers.ref[i] && frameservers.ref[i]->upload_hist)
+			memset(frameservers.ref[i]->upload_hist,
+				'\0', sizeof(struct conductor_histogram));
+}
+
+void arcan_conductor_fsrv_upload(struct arcan_frameserver* fsrv, uint64_t us)
+{
+	arcan_conductor_hist_add(fsrv->upload_hist, us);
+}
+
+static void stage_add(enum conductor_stage stage, uint64_t start)
+{
+	uint64_t us = arcan_timemicros() - start;
+	arcan_conductor_hist_add(&timing.stage[stage], us);
+	timing.frame[stage] += us;
+}
+
+static void timing_frame(uint64_t now)
+{
+	if (timing.last_synch){
+		timing.frame[CONDUCTOR_STAGE_FRAME] = now - timing.last_synch;
+		arcan_conductor_hist_add(
+			&timing.stage[CONDUCTOR_STAGE_FRAME], now - timing.last_synch);
+	}
+	timing.last_synch = now;
+	timing.frame_count++;
+
+	if (timing.log){
+		fprintf(timing.log, "frame=%"PRIu64, timing.frame_count);
+		for (size_t i = 0; i < CONDUCTOR_STAGE_COUNT; i++)
+			fprintf(timing.log, ":%s=%"PRIu64, stage_names[i], timing.frame[i]);
+		fputc('\n', timing.log);
+	}
+
+	memset(timing.frame, '\0', sizeof(timing.frame));
+}
+
 enum synchopts {
 /* wait for display, wake clients after vsynch */
 	SYNCH_VSYNCH = 0,
@@ -234,6 +373,12 @@ void arcan_conductor_register_frameserver(struct arcan_frameserver* fsrv)
 	frameservers.used++;
 	frameservers.ref[dst_i] = fsrv;
 
+/* upload statistics are only tracked for the frameservers we know of */
+	if (!fsrv->upload_hist)
+		fsrv->upload_hist = arcan_alloc_mem(sizeof(struct conductor_histogram),
+			ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO | ARCAN_MEM_NONFATAL,
+			ARCAN_MEMALIGN_NATURAL);
+
 /*
  * other approach is to run a monitor thread here that futexes on the flags
  * and responds immediately instead, moving the polling etc. details to the
@@ -350,6 +495,9 @@ void arcan_conductor_deregister_frameserver(struct arcan_frameserver* fsrv)
 	frameservers.ref[dst_i] = NULL;
 	frameservers.used--;
 
+	arcan_mem_free(fsrv->upload_hist);
+	fsrv->upload_hist = NULL;
+
 	if (fsrv == frameservers.focus){
 		frameservers.focus = NULL;
 	}
@@ -430,8 +578,11 @@ static int trigger_video_synch(float frag)
 	conductor.set_deadline = -1;
 
 	arcan_lua_callvoidfun(main_lua_context, "preframe_pulse", false, NULL);
+		uint64_t start = arcan_timemicros();
 		platform_video_synch(conductor.tick_count, frag, NULL, NULL);
+		stage_add(CONDUCTOR_STAGE_SYNCH, start);
 	arcan_lua_callvoidfun(main_lua_context, "postframe_pulse", false, NULL);
+	timing_frame(arcan_timemicros());
 
 	arcan_bench_register_frame();
 	arcan_benchdata* stats = arcan_bench_data();
@@ -458,20 +609,35 @@ int arcan_conductor_run(arcan_tick_cb tick)
 	uint64_t next_synch = 0;
 	int sstate = -1;
 
+	const char* logfn = getenv("ARCAN_CONDUCTOR_TIMELOG");
+	if (logfn && !timing.log){
+		timing.log = fopen(logfn, "w");
+		if (!timing.log)
+			arcan_warning("conductor: couldn't open timelog (%s)\n", logfn);
+	}
+
 	for(;;){
 /*
  * specific note here, we'd like to know about frameservers that have resized
  * and then actually dispatch / process these twice so that their old buffers
  * might get to be updated before we synch to display.
  */
+		uint64_t start = arcan_timemicros();
 		arcan_video_pollfeed();
+		stage_add(CONDUCTOR_STAGE_POLLFEED, start);
+
 		arcan_audio_refresh();
 		last_tickcount = conductor.tick_count;
 		float frag = arcan_event_process(evctx, conductor_cycle);
 		uint64_t elapsed = arcan_timemillis() - last_synch;
 
 /* This fails when the event recipient has queued a SHUTDOWN event */
-		if (!arcan_event_feed(evctx, process_event, &exit_code))
+		start = arcan_timemicros();
+		bool alive = arcan_event_feed(evctx, process_event, &exit_code);
+		if (alive)
+			arcan_lua_flushinput(main_lua_context);
+		stage_add(CONDUCTOR_STAGE_EVENT, start);
+		if (!alive)
 			break;
 
 /* Chunk the time left until the next batch and yield in small steps. This
@@ -497,6 +663,11 @@ int arcan_conductor_run(arcan_tick_cb tick)
 		}
 	}
 
+	if (timing.log){
+		fclose(timing.log);
+		timing.log = NULL;
+	}
+
 	outcb = NULL;
 	return exit_code;
 }
@@ -519,6 +690,7 @@ void arcan_conductor_deadline(uint8_t deadline)
 
 static void conductor_cycle(int nticks)
 {
+	uint64_t start = arcan_timemicros();
 	conductor.tick_count += nticks;
 /* priority is always in maintaining logical clock and event processing */
 	unsigned njobs;
@@ -538,4 +710,6 @@ static void conductor_cycle(int nticks)
 
 	while(nticks--)
 		arcan_mem_tick();
+
+	stage_add(CONDUCTOR_STAGE_TICK, start);
 }
@@ -100,7 +100,58 @@ void arcan_conductor_setsynch(const char* arg);
  */
 void arcan_conductor_fakesynch(uint8_t left_ms);
 
+/*
+ * Latency histograms for the stages of the main loop. Values are recorded in
+ * microseconds into log-linear buckets (16 sub-buckets per power of two, so
+ * within ~6% of the recorded value) that cover up to about an hour.
+ */
+#define CONDUCTOR_HIST_BUCKETS 464
+struct conductor_histogram {
+	uint64_t count;
+	uint64_t sum;
+	uint32_t min, max;
+	uint32_t buckets[CONDUCTOR_HIST_BUCKETS];
+};
+
+enum conductor_stage {
+/* event queue drained into the scripting VM */
+	CONDUCTOR_STAGE_EVENT = 0,
+/* logical clock: video, audio and scripting VM ticks */
+	CONDUCTOR_STAGE_TICK,
+/* frameserver polling and buffer uploads */
+	CONDUCTOR_STAGE_POLLFEED,
+/* platform_video_synch, rendering and display synchronization */
+	CONDUCTOR_STAGE_SYNCH,
+/* time between two completed display synchs */
+	CONDUCTOR_STAGE_FRAME,
+	CONDUCTOR_STAGE_COUNT
+};
+
+void arcan_conductor_hist_add(struct conductor_histogram*, uint64_t us);
+
+/*
+ * Get the (upper bound) value below which [p] (0..1) of the samples fall.
+ */
+uint64_t arcan_conductor_hist_percentile(
+	const struct conductor_histogram*, double p);
+
+/*
+ * Get the histogram and a user presentable name for a stage, or NULL if
+ * the stage is out of range.
+ */
+const struct conductor_histogram*
+	arcan_conductor_timing(enum conductor_stage, const char** name);
+
+/*
+ * Reset all stage and frameserver histograms.
+ */
+void arcan_conductor_reset_timing();
+
 #ifndef VIDEO_PLATFORM_IMPL
+/* Record the time spent uploading a frame from [fsrv], this is a no-op for
+ * frameservers that are not registered with the conductor. */
+void arcan_conductor_fsrv_upload(struct arcan_frameserver* fsrv, uint64_t us);
+
 /* Update the priority target to match the specified frameserver. This
  * means that heuristics driving synchronization will be biased towards
  * letting the specific fsrv align synchronization - if the synchronization
@@ -34,6 +34,36 @@ static const char* ARCAN_TBL =
 
 static bool db_init = false;
 
+/* number of prepared statements kept around per handle */
+#ifndef DB_STMT_CACHE
+#define DB_STMT_CACHE 32
+#endif
+
+/*
+ * appl key/value writes are kept in memory and flushed in one transaction
+ * after this many calls to arcan_db_tick (logical clock ticks), when the
+ * number of pending writes grows past the limit or when the handle closes.
+ * The standalone tool writes through.
+ */
+#ifndef DB_FLUSH_TICKS
+#define DB_FLUSH_TICKS 50
+#endif
+
+#ifndef DB_PENDING_LIMIT
+#define DB_PENDING_LIMIT 1024
+#endif
+
+#define DB_PENDING_BUCKETS 256
+
+/* keys bound per statement in arcan_db_getvalues */
+#define DB_BATCH_KEYS 64
+
+#ifdef ARCAN_DB_STANDALONE
+static const bool db_writeback = false;
+#else
+static const bool db_writeback = true;
+#endif
+
 #define DB_VERSION_NUM "3"
 
 #define DDL_TARGET "CREATE TABLE target ("\
@@ -144,11 +174,230 @@ struct arcan_dbh {
 	enum DB_KVTARGET ttype;
 	union arcan_dbtrans_id trid;
 	bool trclean;
+	bool tropen;
 	sqlite3_stmt* transaction;
+
+/* prepared statements, looked up on the query string */
+	struct {
+		char* qry;
+		sqlite3_stmt* stmt;
+		uint64_t used;
+	} stmts[DB_STMT_CACHE];
+	uint64_t stmt_clock;
+
+/* appl key/value writes not yet in the database, NULL val means delete */
+	struct pending_kv {
+		char* appl;
+		char* key;
+		char* val;
+		struct pending_kv* next;
+	}* pending[DB_PENDING_BUCKETS];
+	size_t n_pending;
+	bool pending_clean;
+	int flush_ticks;
+
+/* staging for batch results before they are packed into one block */
+	char* kvbuf;
+	size_t kvbuf_sz;
 };
 
 static void setup_ddl(struct arcan_dbh* dbh);
 
+/*
+ * Get a prepared statement for [qry], reusing one from an earlier call if
+ * possible. The statement should be returned with db_stmt_release rather
+ * than finalized.
+ */
+static sqlite3_stmt* db_stmt(struct arcan_dbh* dbh, const char* qry)
+{
+	size_t slot = 0;
+
+	for (size_t i = 0; i < DB_STMT_CACHE; i++){
+		if (dbh->stmts[i].qry && strcmp(dbh->stmts[i].qry, qry) == 0){
+			dbh->stmts[i].used = ++dbh->stmt_clock;
+			return dbh->stmts[i].stmt;
+		}
+
+		if (dbh->stmts[i].used < dbh->stmts[slot].used)
+			slot = i;
+	}
+
+	sqlite3_stmt* stmt = NULL;
+	if (SQLITE_OK != sqlite3_prepare_v2(dbh->dbh, qry, -1, &stmt, NULL)){
+		arcan_warning("db_stmt(%s) failed: %s\n", qry, sqlite3_errmsg(dbh->dbh));
+		sqlite3_finalize(stmt);
+		return NULL;
+	}
+
+/* evict the least recently used */
+	if (dbh->stmts[slot].qry){
+		sqlite3_finalize(dbh->stmts[slot].stmt);
+		free(dbh->stmts[slot].qry);
+	}
+
+	dbh->stmts[slot].qry = strdup(qry);
+	dbh->stmts[slot].stmt = stmt;
+	dbh->stmts[slot].used = ++dbh->stmt_clock;
+
+	return stmt;
+}
+
+/* reset a cached statement so it can be reused, finalize any other */
+static void db_stmt_release(struct arcan_dbh* dbh, sqlite3_stmt* stmt)
+{
+	if (!stmt)
+		return;
+
+	for (size_t i = 0; i < DB_STMT_CACHE; i++)
+		if (dbh->stmts[i].stmt == stmt){
+			sqlite3_reset(stmt);
+			sqlite3_clear_bindings(stmt);
+			return;
+		}
+
+	sqlite3_finalize(stmt);
+}
+
+static void db_stmt_drop(struct arcan_dbh* dbh)
+{
+	for (size_t i = 0; i < DB_STMT_CACHE; i++){
+		sqlite3_finalize(dbh->stmts[i].stmt);
+		free(dbh->stmts[i].qry);
+		dbh->stmts[i].stmt = NULL;
+		dbh->stmts[i].qry = NULL;
+		dbh->stmts[i].used = 0;
+	}
+}
+
+static struct pending_kv** pending_find(
+	struct arcan_dbh* dbh, const char* appl, const char* key)
+{
+	size_t hash = 5381;
+	for (const char* c = key; *c; c++)
+		hash = hash * 33 + *c;
+	for (const char* c = appl; *c; c++)
+		hash = hash * 33 + *c;
+
+	struct pending_kv** cur = &dbh->pending[hash % DB_PENDING_BUCKETS];
+	while (*cur &&
+		(strcmp((*cur)->key, key) != 0 || strcmp((*cur)->appl, appl) != 0))
+		cur = &(*cur)->next;
+
+	return cur;
+}
+
+static bool db_applkv_write(struct arcan_dbh* dbh,
+	const char* applname, const char* key, const char* value)
+{
+	const char ddl_insert[] = "INSERT OR REPLACE "
+		"INTO appl_%s(key, val) VALUES(?, ?);";
+	const char k_drop[] = "DELETE FROM appl_%s WHERE key=?;";
+
+	const char* dqry = value ? ddl_insert : k_drop;
+	size_t upd_sz = sizeof(ddl_insert) + strlen(applname);
+	char upd_buf[ upd_sz ];
+	snprintf(upd_buf, upd_sz, dqry, applname);
+
+	sqlite3_stmt* stmt = db_stmt(dbh, upd_buf);
+	if (!stmt)
+		return false;
+
+	sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+	if (value)
+		sqlite3_bind_text(stmt, 2, value, -1, SQLITE_STATIC);
+
+	bool rv = sqlite3_step(stmt) == SQLITE_DONE;
+	db_stmt_release(dbh, stmt);
+	return rv;
+}
+
+bool arcan_db_flush(struct arcan_dbh* dbh)
+{
+	if (!dbh || (!dbh->n_pending && !dbh->pending_clean))
+		return true;
+
+	bool rv = true;
+
+	sqlite3_exec(dbh->dbh, "BEGIN;", NULL, NULL, NULL);
+
+	for (size_t i = 0; i < DB_PENDING_BUCKETS; i++){
+		struct pending_kv* cur = dbh->pending[i];
+		while (cur){
+			struct pending_kv* next = cur->next;
+			if (!db_applkv_write(dbh, cur->appl, cur->key, cur->val)){
+				arcan_warning("arcan_db_flush(%s:%s) failed: %s\n",
+					cur->appl, cur->key, sqlite3_errmsg(dbh->dbh));
+				rv = false;
+			}
+			free(cur->appl);
+			free(cur->key);
+			free(cur->val);
+			free(cur);
+			cur = next;
+		}
+		dbh->pending[i] = NULL;
+	}
+
+	if (dbh->pending_clean)
+		sqlite3_exec(dbh->dbh, dbh->akv_clean, NULL, NULL, NULL);
+
+	if (SQLITE_OK != sqlite3_exec(dbh->dbh, "COMMIT;", NULL, NULL, NULL)){
+		arcan_warning("arcan_db_flush(), commit failed: %s\n",
+			sqlite3_errmsg(dbh->dbh));
+		rv = false;
+	}
+
+	dbh->n_pending = 0;
+	dbh->pending_clean = false;
+	dbh->flush_ticks = 0;
+	return rv;
+}
+
+void arcan_db_tick(struct arcan_dbh* dbh)
+{
+	if (dbh && dbh->n_pending && ++dbh->flush_ticks >= DB_FLUSH_TICKS)
+		arcan_db_flush(dbh);
+}
+
+/* queue a write, empty or NULL value deletes. Without write-back the store
+ * is flushed immediately and the result is that of the write */
+static bool pending_set(struct arcan_dbh* dbh,
+	const char* appl, const char* key, const char* val)
+{
+	struct pending_kv** dst = pending_find(dbh, appl, key);
+	char* nval = NULL;
+
+	if (val && val[0] && !(nval = strdup(val)))
+		return false;
+
+	if (*dst){
+		free((*dst)->val);
+		(*dst)->val = nval;
+	}
+	else {
+		struct pending_kv* ent = malloc(sizeof(struct pending_kv));
+		if (!ent){
+			free(nval);
+			return false;
+		}
+		*ent = (struct pending_kv){
+			.appl = strdup(appl),
+			.key = strdup(key),
+			.val = nval
+		};
+		*dst = ent;
+		dbh->n_pending++;
+	}
+
+	if (!db_writeback)
+		return arcan_db_flush(dbh);
+
+	if (dbh->n_pending >= DB_PENDING_LIMIT)
+		arcan_db_flush(dbh);
+
+	return true;
+}
+
 static struct arcan_dbh* shared_handle;
 struct arcan_dbh* arcan_db_get_shared(const char** dappl)
 {
@@ -190,7 +439,7 @@ static struct arcan_strarr db_string_query(struct arcan_dbh* dbh,
 		res.data[res.count++] = (arg ? strdup(arg) : NULL);
 	}
 
-	sqlite3_finalize(stmt);
+	db_stmt_release(dbh, stmt);
 	return res;
 }
 
@@ -250,6 +499,8 @@ void arcan_db_dropappl(struct arcan_dbh* dbh, const char* appl)
 	if (0 == len)
 		return;
 
+	arcan_db_flush(dbh);
+
 	const char dropqry[] = "DELETE FROM appl_";
 	char dropbuf[sizeof(dropqry) + len + 1];
 	snprintf(dropbuf, sizeof(dropbuf), "%s%s;", dropqry, appl);
@@ -457,15 +708,16 @@ arcan_targetid arcan_db_targetid(struct arcan_dbh* dbh,
 {
 	arcan_targetid rid = BAD_TARGET;
 	static const char dql[] = "SELECT tgtid FROM target WHERE name = ?;";
-	sqlite3_stmt* stmt;
+	sqlite3_stmt* stmt = db_stmt(dbh, dql);
+	if (!stmt)
+		return rid;
 
-	sqlite3_prepare_v2(dbh->dbh, dql, sizeof(dql)-1, &stmt, NULL);
 	sqlite3_bind_text(stmt, 1, identifier, -1, SQLITE_STATIC);
 
 	if (SQLITE_ROW == sqlite3_step(stmt))
 		rid = sqlite3_column_int64(stmt, 0);
 
-	sqlite3_finalize(stmt);
+	db_stmt_release(dbh, stmt);
 	return rid;
 }
 
@@ -511,17 +763,18 @@ arcan_configid arcan_db_configid(struct arcan_dbh* dbh,
 {
 	static const char dql[] = "SELECT cfgid FROM config"
 		"	WHERE name = ? AND target = ?;";
-	sqlite3_stmt* stmt;
 	arcan_configid cid = BAD_CONFIG;
+	sqlite3_stmt* stmt = db_stmt(dbh, dql);
+	if (!stmt)
+		return cid;
 
-	sqlite3_prepare_v2(dbh->dbh, dql, sizeof(dql)-1, &stmt, NULL);
 	sqlite3_bind_text(stmt, 1, config, strlen(config), SQLITE_STATIC);
 	sqlite3_bind_int(stmt, 2, target);
 
 	if (SQLITE_ROW == sqlite3_step(stmt))
 		cid = sqlite3_column_int64(stmt, 0);
 
-	sqlite3_finalize(stmt);
+	db_stmt_release(dbh, stmt);
 	return cid;
 }
 
@@ -680,54 +933,49 @@ char* arcan_db_execname(struct arcan_dbh* dbh, arcan_targetid tid)
 void arcan_db_begin_transaction(struct arcan_dbh* dbh,
 	enum DB_KVTARGET kvt, union arcan_dbtrans_id id)
 {
-	if (dbh->transaction)
+	if (dbh->tropen)
 		arcan_fatal("arcan_db_begin_transaction()"
 			"	called during a pending transaction\n");
 
-	sqlite3_exec(dbh->dbh, "BEGIN;", NULL, NULL, NULL);
-	int code = SQLITE_OK;
+	dbh->trid = id;
+	dbh->ttype = kvt;
+	dbh->tropen = true;
 
+/* appl keys go through the write-back cache */
+	const char* qry = NULL;
 	switch (kvt){
 	case DVT_APPL:
-		code = sqlite3_prepare_v2(dbh->dbh, dbh->akv_update,
-			dbh->akv_upd_sz, &dbh->transaction, NULL);
-	break;
+	case DVT_ENDM:
+		return;
 
 	case DVT_TARGET:
-		code = sqlite3_prepare_v2(dbh->dbh, DI_INSKV_TARGET,
-			strlen(DI_INSKV_TARGET)+1, &dbh->transaction, NULL);
+		qry = DI_INSKV_TARGET;
 	break;
 
 	case DVT_CONFIG:
-		code = sqlite3_prepare_v2(dbh->dbh, DI_INSKV_CONFIG,
-			strlen(DI_INSKV_CONFIG)+1, &dbh->transaction, NULL);
+		qry = DI_INSKV_CONFIG;
 	break;
 
 	case DVT_CONFIG_ENV:
-		code = sqlite3_prepare_v2(dbh->dbh, DI_INSKV_CONFIG_ENV,
-			strlen(DI_INSKV_TARGET_ENV)+1, &dbh->transaction, NULL);
+		qry = DI_INSKV_CONFIG_ENV;
 	break;
 
 	case DVT_TARGET_ENV:
-		code = sqlite3_prepare_v2(dbh->dbh, DI_INSKV_TARGET_ENV,
-			strlen(DI_INSKV_TARGET_ENV)+1, &dbh->transaction, NULL);
+		qry = DI_INSKV_TARGET_ENV;
 	break;
 
 	case DVT_TARGET_LIBV:
-		code = sqlite3_prepare_v2(dbh->dbh, DI_INSKV_TARGET_LIBV,
-			strlen(DI_INSKV_TARGET_LIBV)+1, &dbh->transaction, NULL);
-	break;
-	case DVT_ENDM:
+		qry = DI_INSKV_TARGET_LIBV;
 	break;
 	}
 
-	if (code != SQLITE_OK){
+	sqlite3_exec(dbh->dbh, "BEGIN;", NULL, NULL, NULL);
+	dbh->transaction = db_stmt(dbh, qry);
+
+	if (!dbh->transaction){
 		arcan_warning("arcan_db_begin_transaction(), failed: %s\n",
 			sqlite3_errmsg(dbh->dbh));
 	}
-
-	dbh->trid = id;
-	dbh->ttype = kvt;
 }
 
 struct arcan_strarr arcan_db_getkeys(struct arcan_dbh* dbh,
@@ -745,11 +993,12 @@ struct arcan_strarr arcan_db_getkeys(struct arcan_dbh* dbh,
 	else
 		qry = queries[1];
 
-	sqlite3_stmt * stmt;
-	sqlite3_prepare_v2(dbh->dbh, qry, sizeof(GET_KV_TGT)-1, &stmt, NULL);
-	sqlite3_bind_int(stmt, 1, tgt>=DVT_TARGET && tgt<DVT_CONFIG ? id.tid:id.cid);
-
 #undef GET_KV_TGT
+	sqlite3_stmt* stmt = db_stmt(dbh, qry);
+	if (!stmt)
+		return (struct arcan_strarr){0};
+
+	sqlite3_bind_int(stmt, 1, tgt>=DVT_TARGET && tgt<DVT_CONFIG ? id.tid:id.cid);
 	return db_string_query(dbh, stmt, NULL, 0);
 }
 
@@ -760,10 +1009,15 @@ struct arcan_strarr arcan_db_applkeys(struct arcan_dbh* dbh,
 
 	size_t mk_sz = sizeof(MATCH_APPL) + strlen(applname);
 	char mk_buf[ mk_sz ];
-	ssize_t nw = snprintf(mk_buf, mk_sz, MATCH_APPL, applname);
+	snprintf(mk_buf, mk_sz, MATCH_APPL, applname);
+
+/* pattern matching is left to sqlite, so pending writes need to be there */
+	arcan_db_flush(dbh);
+
+	sqlite3_stmt* stmt = db_stmt(dbh, mk_buf);
+	if (!stmt)
+		return (struct arcan_strarr){0};
 
-	sqlite3_stmt* stmt;
-	sqlite3_prepare_v2(dbh->dbh, mk_buf, mk_sz-1, &stmt, NULL);
 	sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_TRANSIENT);
 
 	return db_string_query(dbh, stmt, NULL, 0);
@@ -787,8 +1041,10 @@ struct arcan_strarr arcan_db_matchkey(struct arcan_dbh* dbh,
 	else
 		qry = queries[1];
 
-	sqlite3_stmt* stmt;
-	sqlite3_prepare_v2(dbh->dbh, qry, sizeof(MATCH_KEY_TGT)-1, &stmt, NULL);
+	sqlite3_stmt* stmt = db_stmt(dbh, qry);
+	if (!stmt)
+		return (struct arcan_strarr){0};
+
 	sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_TRANSIENT);
 
 	return db_string_query(dbh, stmt, NULL, 0);
@@ -801,9 +1057,12 @@ char* arcan_db_getvalue(struct arcan_dbh* dbh,
 /* must match enum */
 	assert(DVT_ENDM == 5);
 
+	if (tgt == DVT_APPL)
+		return arcan_db_appl_val(dbh, dbh->applname, key);
+
 	static const char* queries[] = {
-		"SELECT val FROM target_kv WHERE key = ? AND tgtid = ? LIMIT 1;",
-		"SELECT val FROM config_kv WHERE key = ? AND cfgid = ? LIMIT 1;"
+		"SELECT val FROM target_kv WHERE key = ? AND target = ? LIMIT 1;",
+		"SELECT val FROM config_kv WHERE key = ? AND config = ? LIMIT 1;"
 	};
 
 	const char* qry = NULL;
@@ -812,21 +1071,12 @@ char* arcan_db_getvalue(struct arcan_dbh* dbh,
 	else
 		qry = queries[1];
 
-/* assume they all are the same length */
-	static size_t qry_sz;
-	if (qry_sz == 0)
-		qry_sz = strlen(queries[1]);
-
-	sqlite3_stmt* stmt = NULL;
+	sqlite3_stmt* stmt = db_stmt(dbh, qry);
+	if (!stmt)
+		return NULL;
 
-	if (tgt == DVT_APPL){
-		sqlite3_prepare_v2(dbh->dbh, dbh->akv_get, dbh->akv_get_sz, &stmt, NULL);
-	}
-	else {
-		sqlite3_prepare_v2(dbh->dbh, qry, qry_sz, &stmt, NULL);
-		sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
-		sqlite3_bind_int(stmt, 2, id);
-	}
+	sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
+	sqlite3_bind_int64(stmt, 2, id);
 
 	if (SQLITE_ROW == sqlite3_step(stmt)){
 		const char* row = (const char*) sqlite3_column_text(stmt, 0);
@@ -834,17 +1084,197 @@ char* arcan_db_getvalue(struct arcan_dbh* dbh,
 			res = strdup(row);
 	}
 
-	sqlite3_finalize(stmt);
+	db_stmt_release(dbh, stmt);
+	return res;
+}
+
+/*
+ * Rows are staged as key\0val\0 pairs in a per-handle buffer and packed
+ * into a single allocation when the query is done.
+ */
+static bool kv_stage(struct arcan_dbh* dbh, size_t* ofs, const char* str)
+{
+	size_t len = strlen(str) + 1;
+
+	if (*ofs + len > dbh->kvbuf_sz){
+		size_t nsz = dbh->kvbuf_sz ? dbh->kvbuf_sz : 4096;
+		while (nsz < *ofs + len)
+			nsz *= 2;
+
+		char* nbuf = realloc(dbh->kvbuf, nsz);
+		if (!nbuf)
+			return false;
+
+		dbh->kvbuf = nbuf;
+		dbh->kvbuf_sz = nsz;
+	}
+
+	memcpy(&dbh->kvbuf[*ofs], str, len);
+	*ofs += len;
+	return true;
+}
+
+static void kv_collect(struct arcan_dbh* dbh,
+	sqlite3_stmt* stmt, size_t* count, size_t* ofs)
+{
+	while (sqlite3_step(stmt) == SQLITE_ROW){
+		const char* key = (const char*) sqlite3_column_text(stmt, 0);
+		const char* val = (const char*) sqlite3_column_text(stmt, 1);
+		if (!key || !val)
+			continue;
+
+		size_t pre = *ofs;
+		if (!kv_stage(dbh, ofs, key) || !kv_stage(dbh, ofs, val)){
+			*ofs = pre;
+			break;
+		}
+		(*count)++;
+	}
+
+	db_stmt_release(dbh, stmt);
+}
+
+static struct arcan_dbkv kv_pack(struct arcan_dbh* dbh, size_t count, size_t ofs)
+{
+	struct arcan_dbkv res = {0};
+	if (!count)
+		return res;
+
+	size_t ptr_sz = sizeof(char*) * count * 2;
+	char** block = arcan_alloc_mem(ptr_sz + ofs,
+		ARCAN_MEM_STRINGBUF, ARCAN_MEM_NONFATAL, ARCAN_MEMALIGN_NATURAL);
+	if (!block)
+		return res;
+
+	char* strs = (char*) block + ptr_sz;
+	memcpy(strs, dbh->kvbuf, ofs);
+
+	res.keys = block;
+	res.vals = block + count;
+	res.count = count;
+
+	for (size_t i = 0; i < count; i++){
+		res.keys[i] = strs;
+		strs += strlen(strs) + 1;
+		res.vals[i] = strs;
+		strs += strlen(strs) + 1;
+	}
+
 	return res;
 }
 
+/*
+ * Build the batch query for the kv store of [tgt] into [buf], the id (if
+ * any) is always bound as parameter [idarg] and [cond] is the key filter.
+ */
+static bool kv_query(struct arcan_dbh* dbh, enum DB_KVTARGET tgt,
+	char* buf, size_t buf_sz, const char* cond, int idarg)
+{
+	ssize_t nw;
+
+	if (tgt == DVT_APPL)
+		nw = snprintf(buf, buf_sz,
+			"SELECT key, val FROM appl_%s WHERE %s;", dbh->applname, cond);
+	else if (tgt >= DVT_TARGET && tgt < DVT_CONFIG)
+		nw = snprintf(buf, buf_sz,
+			"SELECT key, val FROM target_kv WHERE target = ?%d AND %s;", idarg, cond);
+	else
+		nw = snprintf(buf, buf_sz,
+			"SELECT key, val FROM config_kv WHERE config = ?%d AND %s;", idarg, cond);
+
+	return nw > 0 && nw < buf_sz;
+}
+
+struct arcan_dbkv arcan_db_getvalues(struct arcan_dbh* dbh,
+	enum DB_KVTARGET tgt, int64_t id, const char** keys, size_t n_keys)
+{
+	static char cond[sizeof("key IN ()") + DB_BATCH_KEYS * 4];
+	if (!cond[0]){
+		size_t ofs = snprintf(cond, sizeof(cond), "key IN (?1");
+		for (size_t i = 1; i < DB_BATCH_KEYS; i++)
+			ofs += snprintf(&cond[ofs], sizeof(cond) - ofs, ",?%zu", i + 1);
+		snprintf(&cond[ofs], sizeof(cond) - ofs, ")");
+	}
+
+	size_t qry_sz = sizeof(cond) + strlen(dbh->applname) + 80;
+	char qry[qry_sz];
+	if (!n_keys || !kv_query(dbh, tgt, qry, qry_sz, cond, DB_BATCH_KEYS + 1))
+		return (struct arcan_dbkv){0};
+
+	if (tgt == DVT_APPL)
+		arcan_db_flush(dbh);
+
+	size_t count = 0, ofs = 0;
+
+/* unbound parameters are NULL and will never match */
+	for (size_t base = 0; base < n_keys; base += DB_BATCH_KEYS){
+		sqlite3_stmt* stmt = db_stmt(dbh, qry);
+		if (!stmt)
+			break;
+
+		for (size_t i = 0; i < DB_BATCH_KEYS && base + i < n_keys; i++)
+			sqlite3_bind_text(stmt, i + 1, keys[base + i], -1, SQLITE_STATIC);
+
+		if (tgt != DVT_APPL)
+			sqlite3_bind_int64(stmt, DB_BATCH_KEYS + 1, id);
+
+		kv_collect(dbh, stmt, &count, &ofs);
+	}
+
+	return kv_pack(dbh, count, ofs);
+}
+
+struct arcan_dbkv arcan_db_matchvalues(struct arcan_dbh* dbh,
+	enum DB_KVTARGET tgt, int64_t id, const char* pattern)
+{
+	size_t qry_sz = strlen(dbh->applname) + 128;
+	char qry[qry_sz];
+	if (!pattern || !kv_query(dbh, tgt, qry, qry_sz, "key LIKE ?1", 2))
+		return (struct arcan_dbkv){0};
+
+	if (tgt == DVT_APPL)
+		arcan_db_flush(dbh);
+
+	sqlite3_stmt* stmt = db_stmt(dbh, qry);
+	if (!stmt)
+		return (struct arcan_dbkv){0};
+
+	sqlite3_bind_text(stmt, 1, pattern, -1, SQLITE_STATIC);
+	if (tgt != DVT_APPL)
+		sqlite3_bind_int64(stmt, 2, id);
+
+	size_t count = 0, ofs = 0;
+	kv_collect(dbh, stmt, &count, &ofs);
+	return kv_pack(dbh, count, ofs);
+}
+
+void arcan_db_free_kv(struct arcan_dbkv* kv)
+{
+	if (!kv)
+		return;
+
+	arcan_mem_free(kv->keys);
+	*kv = (struct arcan_dbkv){0};
+}
+
 void arcan_db_add_kvpair(
 	struct arcan_dbh* dbh, const char* key, const char* val)
 {
-	if (!dbh->transaction)
+	if (!dbh->tropen)
 		arcan_fatal("arcan_db_add_kvpair() "
 			"called without any open transaction.");
 
+	if (dbh->ttype == DVT_APPL){
+		if (!val)
+			dbh->pending_clean = true;
+		else
+			pending_set(dbh, dbh->applname, key, val);
+		return;
+	}
+
+	if (!dbh->transaction)
+		return;
+
 	if (!val){
 		dbh->trclean = true;
 		return;
@@ -877,24 +1307,33 @@ void arcan_db_add_kvpair(
 	if (SQLITE_DONE != rc)
 		arcan_warning("arcan_db_addkvpair(%s=%s), %d failed: %s\n",
 			key, val, rc, sqlite3_errmsg(dbh->dbh));
-	else {
-		sqlite3_clear_bindings(dbh->transaction);
-		sqlite3_reset(dbh->transaction);
-	}
+
+	sqlite3_clear_bindings(dbh->transaction);
+	sqlite3_reset(dbh->transaction);
 }
 
 void arcan_db_end_transaction(struct arcan_dbh* dbh)
 {
-	if (!dbh->transaction)
+	if (!dbh->tropen)
 		arcan_fatal("arcan_db_end_transaction() "
 			"called without any open transaction.");
 
-	sqlite3_finalize(dbh->transaction);
+	dbh->tropen = false;
+
+	if (dbh->ttype == DVT_APPL || dbh->ttype == DVT_ENDM){
+		if (!db_writeback)
+			arcan_db_flush(dbh);
+		return;
+	}
+
+	if (!dbh->transaction){
+		sqlite3_exec(dbh->dbh, "ROLLBACK;", NULL, NULL, NULL);
+		return;
+	}
+
+	db_stmt_release(dbh, dbh->transaction);
 	if (dbh->trclean){
 		switch (dbh->ttype){
-		case DVT_APPL:
-			sqlite3_exec(dbh->dbh, dbh->akv_clean, NULL, NULL, NULL);
-		break;
 		case DVT_TARGET:
 			sqlite3_exec(dbh->dbh, DI_DROPKV_TARGET, NULL, NULL, NULL);
 		break;
@@ -918,40 +1357,13 @@ void arcan_db_end_transaction(struct arcan_dbh* dbh)
 bool arcan_db_appl_kv(struct arcan_dbh* dbh,
 	const char* applname, const char* key, const char* value)
 {
-	bool rv = false;
-
-	if (dbh->transaction)
-		arcan_fatal("arcan_db_appl_kv() called during a pending transaction\n");
-
 	if (!applname || !dbh || !key)
-		return rv;
-
-	const char ddl_insert[] = "INSERT OR REPLACE "
-		"INTO appl_%s(key, val) VALUES(?, ?);";
-	const char k_drop[] = "DELETE FROM appl_%s WHERE key=?;";
-
-	size_t upd_sz = 0;
-	const char* dqry = ddl_insert;
-
-	if (!value){
-		upd_sz = sizeof(k_drop) + strlen(applname);
-		dqry = k_drop;
-	}
-	else
-		upd_sz = sizeof(ddl_insert) + strlen(applname);
-
-	char upd_buf[ upd_sz ];
-	ssize_t nw = snprintf(upd_buf, upd_sz, dqry, applname);
-
-	sqlite3_stmt* stmt = NULL;
-	sqlite3_prepare_v2(dbh->dbh, upd_buf, nw, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, key,   -1, SQLITE_TRANSIENT);
-	sqlite3_bind_text(stmt, 2, value, -1, SQLITE_TRANSIENT);
+		return false;
 
-	rv = sqlite3_step(stmt) == SQLITE_DONE;
-	sqlite3_finalize(stmt);
+	if (dbh->tropen)
+		arcan_fatal("arcan_db_appl_kv() called during a pending transaction\n");
 
-	return rv;
+	return pending_set(dbh, applname, key, value);
 }
 
 char* arcan_db_appl_val(struct arcan_dbh* dbh,
@@ -960,16 +1372,22 @@ char* arcan_db_appl_val(struct arcan_dbh* dbh,
 	if (!dbh || !key)
 		return NULL;
 
+/* writes that are still pending take precedence */
+	struct pending_kv** pend = pending_find(dbh, applname, key);
+	if (*pend)
+		return (*pend)->val ? strdup((*pend)->val) : NULL;
+
 	const char qry[] = "SELECT val FROM appl_%s WHERE key = ?;";
 
 	size_t wbuf_sz = strlen(applname) + sizeof(qry);
 	char wbuf[ wbuf_sz ];
-	memset(wbuf, '\0', wbuf_sz);
 	snprintf(wbuf, wbuf_sz, qry, applname);
 
-	sqlite3_stmt* stmt = NULL;
-	sqlite3_prepare_v2(dbh->dbh, wbuf, wbuf_sz, &stmt, NULL);
-	sqlite3_bind_text(stmt, 1, (char*) key, -1, SQLITE_TRANSIENT);
+	sqlite3_stmt* stmt = db_stmt(dbh, wbuf);
+	if (!stmt)
+		return NULL;
+
+	sqlite3_bind_text(stmt, 1, key, -1, SQLITE_STATIC);
 
 	char* rv = NULL;
 	int rc = sqlite3_step(stmt);
@@ -981,7 +1399,7 @@ char* arcan_db_appl_val(struct arcan_dbh* dbh,
 			rv = strdup((const char*) rowt);
 	}
 
-	sqlite3_finalize(stmt);
+	db_stmt_release(dbh, stmt);
 
 	return rv;
 }
@@ -1032,10 +1450,15 @@ void arcan_db_close(struct arcan_dbh** ctx)
 	if (!ctx)
 		return;
 
+	arcan_db_flush(*ctx);
+	db_stmt_drop(*ctx);
+
 	sqlite3_close((*ctx)->dbh);
 	arcan_mem_free((*ctx)->applname);
 	arcan_mem_free((*ctx)->akv_update);
 	arcan_mem_free((*ctx)->akv_get);
+	arcan_mem_free((*ctx)->akv_clean);
+	free((*ctx)->kvbuf);
 	arcan_mem_free(*ctx);
 	*ctx = NULL;
 }
@@ -1071,6 +1494,7 @@ struct arcan_dbh* arcan_db_open(const char* fname, const char* applname)
 		assert(dbh);
 
 		if ( !dbh_integrity_check(res) ){
+			db_stmt_drop(res);
 			sqlite3_close(dbh);
 			arcan_mem_free(res);
 			return NULL;
@@ -1082,6 +1506,10 @@ struct arcan_dbh* arcan_db_open(const char* fname, const char* applname)
 		db_void_query(res, "PRAGMA foreign_keys=ON;", false);
 		db_void_query(res, "PRAGMA synchronous=OFF;", false);
 
+/* readers no longer block on the writer and commits append to a log
+ * rather than rewrite pages, no-op for :memory: */
+		db_void_query(res, "PRAGMA journal_mode=WAL;", false);
+
 		return res;
 	}
 	else
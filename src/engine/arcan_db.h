@@ -60,6 +60,18 @@ void arcan_db_set_shared(struct arcan_dbh*);
  */
 void arcan_db_close(struct arcan_dbh**);
 
+/*
+ * Write any pending appl key/value stores to the database, this happens
+ * implicitly on close, when enough stores have accumulated or when enough
+ * ticks have passed. Returns false if any of the writes failed.
+ */
+bool arcan_db_flush(struct arcan_dbh*);
+
+/*
+ * Call once per logical clock tick, flushes pending stores periodically.
+ */
+void arcan_db_tick(struct arcan_dbh*);
+
 /*
  * Define this to add database features that should
  * only be present in a standalone application
@@ -182,6 +194,31 @@ void arcan_db_end_transaction(struct arcan_dbh*);
 char* arcan_db_getvalue(struct arcan_dbh*,
 	enum DB_KVTARGET, int64_t id, const char* key);
 
+/*
+ * Batch results, keys[i] maps to vals[i]. Everything is packed into a
+ * single allocation that is released with arcan_db_free_kv.
+ */
+struct arcan_dbkv {
+	size_t count;
+	char** keys;
+	char** vals;
+};
+
+/*
+ * Retrieve the values for a set of keys in one go, keys that are not
+ * present are omitted from the result. Same id rules as for getvalue.
+ */
+struct arcan_dbkv arcan_db_getvalues(struct arcan_dbh*,
+	enum DB_KVTARGET, int64_t id, const char** keys, size_t n_keys);
+
+/*
+ * Retrieve all key/value pairs where key matches pattern (SQL LIKE)
+ */
+struct arcan_dbkv arcan_db_matchvalues(struct arcan_dbh*,
+	enum DB_KVTARGET, int64_t id, const char* pattern);
+
+void arcan_db_free_kv(struct arcan_dbkv*);
+
 /*
  * dump all kv pairs as key=value for a specific
  * target or configuration
@@ -219,8 +256,11 @@ bool arcan_db_verifytarget(struct arcan_dbh* dbh, arcan_targetid);
 void arcan_db_dropappl(struct arcan_dbh* dbh, const char* appl);
 
 /*
- * Synchronously store/retrieve a key-value pair,
- * set to empty value to delete.
+ * Store/retrieve a key-value pair, set to empty value to delete.
+ * Stores are kept in memory and written in batches, see arcan_db_tick,
+ * retrieval sees pending stores. The return value then only says if the
+ * store could be queued. In the standalone build (arcan_db) stores are
+ * written immediately and a failed write returns false.
  */
 bool arcan_db_appl_kv(struct arcan_dbh* dbh, const char* appl,
 	const char* key, const char* value);
@@ -22,6 +22,8 @@
 #include <math.h>
 #include <assert.h>
 #include <signal.h>
+#include <pthread.h>
+#include <stdatomic.h>
 
 /*
  * fixed limit of allowed events in queue before we need to do something more
@@ -32,6 +34,15 @@
 #define ARCAN_EVENT_QUEUE_LIM 255
 #endif
 
+/*
+ * multi-producer ring that threads other than the main one (and the main
+ * thread itself when the primary queue is saturated) post into, drained in
+ * batches into the default context, must be a power of two.
+ */
+#ifndef ARCAN_EVENT_MPSC_SZ
+#define ARCAN_EVENT_MPSC_SZ 1024
+#endif
+
 #include "arcan_math.h"
 #include "arcan_general.h"
 #include "arcan_video.h"
@@ -65,6 +76,38 @@ static struct arcan_evctx default_evctx = {
 	}
 #endif
 
+_Static_assert((ARCAN_EVENT_MPSC_SZ & (ARCAN_EVENT_MPSC_SZ - 1)) == 0,
+	"ARCAN_EVENT_MPSC_SZ must be a power of two");
+
+/*
+ * Bounded MPSC ring (sequence-per-cell), producers claim a position through
+ * [head], write the cell and publish it by advancing the cell sequence. The
+ * consumer (main thread) is the only one to move [tail]. Head, tail and the
+ * cells are kept on separate cache lines to avoid producers and the consumer
+ * fighting over the same line.
+ */
+struct mpsc_cell {
+	_Atomic size_t seq;
+	arcan_event ev;
+};
+
+static struct {
+	_Alignas(64) _Atomic size_t head;
+	_Alignas(64) _Atomic size_t tail;
+	_Alignas(64) struct mpsc_cell cells[ARCAN_EVENT_MPSC_SZ];
+} mpsc;
+
+static struct {
+	_Atomic uint64_t posted;
+	_Atomic uint64_t saturated;
+	_Atomic uint64_t overflow;
+	_Atomic size_t high_water;
+	uint64_t batches;
+} evstats;
+
+static pthread_t main_thread;
+static bool mpsc_ready;
+
 /* set through environment variable to ensure we can shut down
  * cleanly based on a certain keybinding */
 static int panic_keysym = -1, panic_keymod = -1;
@@ -73,6 +116,127 @@ arcan_evctx* arcan_event_defaultctx(){
 	return &default_evctx;
 }
 
+static void mpsc_init()
+{
+	for (size_t i = 0; i < ARCAN_EVENT_MPSC_SZ; i++)
+		atomic_store_explicit(&mpsc.cells[i].seq, i, memory_order_relaxed);
+
+	atomic_store(&mpsc.head, 0);
+	atomic_store(&mpsc.tail, 0);
+	main_thread = pthread_self();
+	mpsc_ready = true;
+}
+
+static inline bool on_main_thread()
+{
+	return !mpsc_ready || pthread_equal(pthread_self(), main_thread);
+}
+
+static inline size_t mpsc_pending()
+{
+	return atomic_load_explicit(&mpsc.head, memory_order_relaxed) -
+		atomic_load_explicit(&mpsc.tail, memory_order_relaxed);
+}
+
+/*
+ * Safe to call from any thread, returns ARCAN_ERRC_OUT_OF_SPACE if the ring
+ * is full, the caller decides what to do with the event at that point.
+ */
+static int mpsc_post(const struct arcan_event* const src)
+{
+	size_t pos = atomic_load_explicit(&mpsc.head, memory_order_relaxed);
+	struct mpsc_cell* cell;
+
+	for(;;){
+		cell = &mpsc.cells[pos & (ARCAN_EVENT_MPSC_SZ - 1)];
+		size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+		intptr_t dif = (intptr_t)seq - (intptr_t)pos;
+
+		if (dif == 0){
+			if (atomic_compare_exchange_weak_explicit(&mpsc.head,
+				&pos, pos + 1, memory_order_relaxed, memory_order_relaxed))
+				break;
+		}
+		else if (dif < 0){
+			atomic_fetch_add_explicit(&evstats.overflow, 1, memory_order_relaxed);
+			return ARCAN_ERRC_OUT_OF_SPACE;
+		}
+		else
+			pos = atomic_load_explicit(&mpsc.head, memory_order_relaxed);
+	}
+
+	cell->ev = *src;
+	atomic_store_explicit(&cell->seq, pos + 1, memory_order_release);
+	atomic_fetch_add_explicit(&evstats.posted, 1, memory_order_relaxed);
+
+/* approximate, only used for diagnostics */
+	size_t used = pos + 1 - atomic_load_explicit(&mpsc.tail, memory_order_relaxed);
+	if (used > atomic_load_explicit(&evstats.high_water, memory_order_relaxed))
+		atomic_store_explicit(&evstats.high_water, used, memory_order_relaxed);
+
+	return ARCAN_OK;
+}
+
+/*
+ * Consumer side, only the main thread. Returns false if there is no
+ * published event at the tail.
+ */
+static bool mpsc_pop(arcan_event* dst)
+{
+	size_t pos = atomic_load_explicit(&mpsc.tail, memory_order_relaxed);
+	struct mpsc_cell* cell = &mpsc.cells[pos & (ARCAN_EVENT_MPSC_SZ - 1)];
+	size_t seq = atomic_load_explicit(&cell->seq, memory_order_acquire);
+
+	if (seq != pos + 1)
+		return false;
+
+	*dst = cell->ev;
+	atomic_store_explicit(&cell->seq,
+		pos + ARCAN_EVENT_MPSC_SZ, memory_order_release);
+	atomic_store_explicit(&mpsc.tail, pos + 1, memory_order_relaxed);
+	return true;
+}
+
+/*
+ * Move as many events as the default queue can hold from the ring, in order.
+ * This never calls into the drain handler, whatever doesn't fit stays in the
+ * ring until the next batch.
+ */
+static size_t mpsc_drain(arcan_evctx* ctx)
+{
+	size_t count = 0;
+	if (ctx != &default_evctx || !mpsc_ready)
+		return 0;
+
+	while (((*ctx->back + 1) % ctx->eventbuf_sz) != *ctx->front){
+		arcan_event ev;
+		if (!mpsc_pop(&ev))
+			break;
+
+		ctx->eventbuf[*ctx->back] = ev;
+		*ctx->back = (*ctx->back + 1) % ctx->eventbuf_sz;
+		count++;
+	}
+
+	if (count)
+		evstats.batches++;
+
+	return count;
+}
+
+void arcan_event_queuestats(struct arcan_event_queuestats* dst)
+{
+	*dst = (struct arcan_event_queuestats){
+		.posted = atomic_load(&evstats.posted),
+		.saturated = atomic_load(&evstats.saturated),
+		.overflow = atomic_load(&evstats.overflow),
+		.batches = evstats.batches,
+		.pending = mpsc_pending(),
+		.high_water = atomic_load(&evstats.high_water),
+		.capacity = ARCAN_EVENT_MPSC_SZ
+	};
+}
+
 /*
  * If the shmpage integrity is somehow compromised,
  * if semaphore use is out of order etc.
@@ -90,7 +254,7 @@ static void pull_killswitch(arcan_evctx* ctx)
 int arcan_event_poll(arcan_evctx* ctx, struct arcan_event* dst)
 {
 	assert(dst);
-	if (*ctx->front == *ctx->back)
+	if (*ctx->front == *ctx->back && !mpsc_drain(ctx))
 		return 0;
 
 /* overflow in external connection? pull killswitch that will hopefully
@@ -174,18 +338,67 @@ int arcan_event_enqueue(arcan_evctx* ctx, const struct arcan_event* const src)
 		|| (ctx->state_fl & EVSTATE_DEAD) > 0)
 		return ARCAN_OK;
 
+	if (panic_keysym != -1 && panic_keymod != -1 &&
+		src->category == EVENT_IO && src->io.kind == EVENT_IO_BUTTON &&
+		src->io.devkind == EVENT_IDEVKIND_KEYBOARD &&
+		src->io.input.translated.modifiers == panic_keymod &&
+		src->io.input.translated.keysym == panic_keysym
+	){
+		arcan_event ev = {
+			.category = EVENT_SYSTEM,
+			.sys.kind = EVENT_SYSTEM_EXIT,
+			.sys.errcode = EXIT_SUCCESS
+		};
+
+		return arcan_event_enqueue(ctx, &ev);
+	}
+
+	bool full = ((*ctx->back + 1) % ctx->eventbuf_sz) == *ctx->front;
+
+/* The default queue is only ever touched by the main thread, everyone else
+ * goes through the ring. The main thread spills into the ring when the queue
+ * is full, and keeps doing so while the ring has events pending so that the
+ * order is preserved when the next batch is drained. */
+	if (ctx == &default_evctx && mpsc_ready){
+		if (!on_main_thread())
+			return mpsc_post(src);
+
+		if (full || mpsc_pending()){
+			if (full)
+				atomic_fetch_add_explicit(&evstats.saturated, 1, memory_order_relaxed);
+
+			if (ARCAN_OK == mpsc_post(src))
+				return ARCAN_OK;
+
+/* both are saturated, move what fits from the ring first so that the direct
+ * write below doesn't land ahead of events that were posted before it */
+			mpsc_drain(ctx);
+			if (mpsc_pending()){
+				if (!ctx->drain || (ctx->state_fl & EVSTATE_IN_DRAIN) > 0)
+					return ARCAN_ERRC_OUT_OF_SPACE;
+
+				ctx->state_fl |= EVSTATE_IN_DRAIN;
+					arcan_event_feed(ctx, ctx->drain, NULL);
+				ctx->state_fl &= ~EVSTATE_IN_DRAIN;
+			}
+
+			full = ((*ctx->back + 1) % ctx->eventbuf_sz) == *ctx->front;
+		}
+	}
+
 /* One big caveat with this approach is the possibility of feedback loop with
  * magnification - forcing us to break ordering by directly feeding drain.
  * Given that we have special treatment for _EXPIRE and similar calls,
  * there shouldn't be any functions that has this behavior. Still, broken
- * ordering is better than running out of space. */
-
-	 if (((*ctx->back + 1) % ctx->eventbuf_sz) == *ctx->front){
+ * ordering is better than running out of space. For the default context,
+ * this is only reached when the spill ring is saturated as well. */
+	if (full){
 		if (ctx->drain){
 /* very rare / impossible, but safe-guard against future bad code */
 			if ((ctx->state_fl & EVSTATE_IN_DRAIN) > 0){
 				arcan_event ev = *src;
 				ctx->drain(&ev, 1);
+				return ARCAN_OK;
 			}
 /* tradeoff, can cascade to embarassing GC pause or video- stall but better
  * than data corruption and unpredictable states -- this can theoretically
@@ -200,21 +413,6 @@ int arcan_event_enqueue(arcan_evctx* ctx, const struct arcan_event* const src)
 			return ARCAN_ERRC_OUT_OF_SPACE;
 	}
 
-	if (panic_keysym != -1 && panic_keymod != -1 &&
-		src->category == EVENT_IO && src->io.kind == EVENT_IO_BUTTON &&
-		src->io.devkind == EVENT_IDEVKIND_KEYBOARD &&
-		src->io.input.translated.modifiers == panic_keymod &&
-		src->io.input.translated.keysym == panic_keysym
-	){
-		arcan_event ev = {
-			.category = EVENT_SYSTEM,
-			.sys.kind = EVENT_SYSTEM_EXIT,
-			.sys.errcode = EXIT_SUCCESS
-		};
-
-		return arcan_event_enqueue(ctx, &ev);
-	}
-
 	ctx->eventbuf[(*ctx->back) % ctx->eventbuf_sz] = *src;
 	*ctx->back = (*ctx->back + 1) % ctx->eventbuf_sz;
 
@@ -401,6 +599,7 @@ float arcan_event_process(arcan_evctx* ctx, arcan_tick_cb cb)
 	int64_t delta = arcan_frametime() - base;
 
 	platform_event_process(ctx);
+	mpsc_drain(ctx);
 
 	if (delta > ARCAN_TIMER_TICK){
 		int nticks = delta / ARCAN_TIMER_TICK;
@@ -449,6 +648,10 @@ void arcan_event_purge()
 {
 	eventfront = 0;
 	eventback = 0;
+
+	arcan_event ev;
+	while (mpsc_pop(&ev)){}
+
 	platform_event_reset(&default_evctx);
 }
 
@@ -536,7 +739,11 @@ bool arcan_event_feed(struct arcan_evctx* ctx,
 		return false;
 	}
 
-	while (*ctx->front != *ctx->back){
+/* pull in the first batch from producer threads, and then the next one
+ * whenever the queue runs dry so that a single feed empties both */
+	mpsc_drain(ctx);
+
+	while (*ctx->front != *ctx->back || mpsc_drain(ctx)){
 /* slide, we forego _poll to cut down on one copy */
 		arcan_event* ev = &ctx->eventbuf[ *(ctx->front) ];
 		*(ctx->front) = (*(ctx->front) + 1) % ctx->eventbuf_sz;
@@ -586,6 +793,9 @@ void arcan_event_init(arcan_evctx* ctx)
 		return;
 	}
 
+	if (ctx == &default_evctx && !mpsc_ready)
+		mpsc_init();
+
 /*
  * used for testing response to clock skew over time
  */
@@ -128,6 +128,25 @@ void arcan_event_repl(struct arcan_evctx* ctx, enum ARCAN_EVENT_CATEGORY cat,
  */
 void arcan_event_purge();
 
+/*
+ * Events enqueued on the default context from threads other than the one
+ * that called arcan_event_init (or from the main thread while the context is
+ * saturated) are posted to a lock-free multi-producer ring and moved into
+ * the context in batches as part of _process, _poll and _feed. Only when that
+ * ring is full as well will the main thread fall back to synchronously
+ * draining the context. These counters track that behavior.
+ */
+struct arcan_event_queuestats {
+	uint64_t posted;    /* events that went through the ring */
+	uint64_t saturated; /* main-thread enqueues that found the context full */
+	uint64_t overflow;  /* posts rejected due to the ring being full */
+	uint64_t batches;   /* number of non-empty batch transfers */
+	size_t pending;     /* events currently in the ring */
+	size_t high_water;  /* highest observed ring occupancy */
+	size_t capacity;
+};
+void arcan_event_queuestats(struct arcan_event_queuestats* dst);
+
 /* Try to remove at most one event from the ingoing slot of the event
  * queue and put into *dst. returns 0 if there are no events to receive,
  * or 1 if an event was successfully dequeued. */
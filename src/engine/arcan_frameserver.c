@@ -36,6 +36,14 @@
 
 #include "arcan_event.h"
 #include "arcan_img.h"
+#include "arcan_renderfun.h"
+#include "arcan_ttf.h"
+#include "../shmif/tui/raster/raster.h"
+#include "../frameserver/util/resampler/speex_resampler.h"
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 /*
  * implementation defined for out-of-order execution
@@ -54,6 +62,7 @@ static inline void emit_deliveredframe(arcan_frameserver* src,
 	unsigned long long pts, unsigned long long framecount);
 static inline void emit_droppedframe(arcan_frameserver* src,
 	unsigned long long pts, unsigned long long framecount);
+static void drop_amixer(arcan_frameserver* dst);
 
 static void autoclock_frame(arcan_frameserver* tgt)
 {
@@ -92,6 +101,15 @@ arcan_errc arcan_frameserver_free(arcan_frameserver* src)
 
 	arcan_conductor_deregister_frameserver(src);
 
+/* will also release our reference to the shared glyph atlas */
+	tui_raster_free(src->tpack.raster);
+	src->tpack.raster = NULL;
+	src->tpack.atlas = NULL;
+	if (BADFD != src->tpack.fd){
+		close(src->tpack.fd);
+		src->tpack.fd = BADFD;
+	}
+
 	arcan_aobj_id aid = src->aid;
 	uintptr_t tag = src->tag;
 	arcan_vobj_id vid = src->vid;
@@ -103,6 +121,7 @@ arcan_errc arcan_frameserver_free(arcan_frameserver* src)
 		base++;
 	}
 	src->alocks = NULL;
+	drop_amixer(src);
 
 	char msg[32];
 	if (!platform_fsrv_lastwords(src, msg, COUNT_OF(msg)))
@@ -181,6 +200,54 @@ bool arcan_frameserver_control_chld(arcan_frameserver* src){
 	return true;
 }
 
+/*
+ * (Re-)build the TPACK raster state with the currently known font, size and
+ * density. If no font has been set, the engine default font will be used.
+ */
+static void tpack_rebuild(arcan_frameserver* src)
+{
+	int fd, pt_size, hint;
+	arcan_video_fontdefaults(&fd, &pt_size, &hint);
+
+	if (BADFD != src->tpack.fd)
+		fd = src->tpack.fd;
+
+	if (src->tpack.custom_hint)
+		hint = src->tpack.hint;
+
+	if (BADFD == fd)
+		return;
+
+/* size is tracked in mm, like the client side the wrapper works in pt */
+	if (src->desc.hint.sz > 0)
+		pt_size = src->desc.hint.sz * 2.8346456693f;
+
+	if (pt_size < 4)
+		pt_size = 4;
+
+	float dpi = src->desc.hint.ppcm > EPSILON ? src->desc.hint.ppcm * 2.54f : 72.0;
+
+	struct tui_raster_atlas* atlas = tui_raster_atlas_grab(fd, pt_size, dpi, hint);
+	if (!atlas){
+		arcan_warning("frameserver(tpack), couldn't build atlas from font\n");
+		return;
+	}
+
+	if (!src->tpack.raster){
+		size_t cw, ch;
+		tui_raster_atlas_cell_size(atlas, &cw, &ch);
+		src->tpack.raster = tui_raster_setup(cw, ch);
+		if (!src->tpack.raster){
+			tui_raster_atlas_drop(atlas);
+			return;
+		}
+	}
+
+	tui_raster_setatlas(src->tpack.raster, atlas);
+	src->tpack.atlas = atlas;
+	src->tpack.invalidated = true;
+}
+
 static bool push_buffer(arcan_frameserver* src,
 	struct agp_vstore* store, struct arcan_shmif_region* dirty)
 {
@@ -192,17 +259,6 @@ static bool push_buffer(arcan_frameserver* src,
 	int vready = atomic_load_explicit(&src->shm.ptr->vready,memory_order_consume);
 	int vmask=~atomic_load_explicit(&src->shm.ptr->vpending,memory_order_consume);
 
-	vready = (vready <= 0 || vready > src->vbuf_cnt) ? 0 : vready - 1;
-	shmif_pixel* buf = src->vbufs[vready];
-
-/* special case, the contents is in a compressed format that can either
- * be rasterized or deferred to on-GPU rasterization / atlas lookup, so
- * the other setup isn't strictly needed. */
-	if (src->desc.hints & SHMIF_RHINT_TPACK){
-/* tui_raster_renderagp(ctx, store, buf,
- * 	s->desc.width * s->desc.height * sizeof(shmif_pixel), true); */
-	}
-
 /* Need to do this check here as-well as in the regular frameserver tick
  * control because the backing store might have changed somehwere else. */
 	if (src->desc.width != store->w || src->desc.height != store->h ||
@@ -244,9 +300,39 @@ static bool push_buffer(arcan_frameserver* src,
 		arcan_video_resizefeed(src->vid, src->desc.width, src->desc.height);
 
 		src->desc.rz_flag = false;
+		src->tpack.invalidated = true;
 		explicit = true;
 	}
 
+/* in mailbox mode the newest frame is taken rather than peeked at, a client
+ * that publishes after this gets the slot back empty and knows we hold it */
+	if (src->flags.mailbox){
+		vready = atomic_exchange_explicit(
+			&src->shm.ptr->vready, 0, memory_order_acq_rel);
+		if (!vready)
+			return false;
+		vmask = ~0;
+	}
+
+	vready = (vready <= 0 || vready > src->vbuf_cnt) ? 0 : vready - 1;
+	shmif_pixel* buf = src->vbufs[vready];
+
+/* special case, the contents is in a packed cell format that we raster
+ * ourselves through the shared glyph atlas. Only the lines present in the
+ * buffer are touched and uploaded, unless the store has been invalidated
+ * through a resize or a font change */
+	if (src->desc.hints & SHMIF_RHINT_TPACK){
+		if (!src->tpack.raster)
+			tpack_rebuild(src);
+
+		if (-1 != tui_raster_renderagp(src->tpack.raster, store, (uint8_t*) buf,
+			src->desc.width * src->desc.height * sizeof(shmif_pixel),
+			!src->tpack.invalidated))
+			src->tpack.invalidated = false;
+
+		goto commit_mask;
+	}
+
 	if (-1 != src->vstream.handle){
 		bool failev = src->vstream.dead;
 
@@ -493,7 +579,8 @@ int arcan_frameserver_releaselock(struct arcan_frameserver* tgt)
 	tgt->flags.release_pending = false;
 	TRAMP_GUARD(0, tgt);
 
-	atomic_store_explicit(&tgt->shm.ptr->vready, 0, memory_order_release);
+	if (!tgt->flags.mailbox)
+		atomic_store_explicit(&tgt->shm.ptr->vready, 0, memory_order_release);
 	arcan_sem_post( tgt->vsync );
 		if (tgt->desc.hints & SHMIF_RHINT_VSIGNAL_EV){
 			platform_fsrv_pushevent(tgt, &(struct arcan_event){
@@ -589,10 +676,16 @@ enum arcan_ffunc_rv arcan_frameserver_vdirect FFUNC_HEAD
  * to be repeat until it succeeds - this mechanism could/should(?) also
  * be used with the vpts- below, simply defer until the deadline has
  * passed */
-		if (g_buffers_locked == 1 || tgt->flags.locked || !push_buffer(tgt,
-				dst_store, shmpage->hints & SHMIF_RHINT_SUBREGION ? &dirty : NULL)){
+		if (g_buffers_locked == 1 || tgt->flags.locked)
+			goto no_out;
+
+		uint64_t upload_start = arcan_timemicros();
+		if (!push_buffer(tgt, dst_store, !tgt->flags.mailbox &&
+				(shmpage->hints & SHMIF_RHINT_SUBREGION) ? &dirty : NULL)){
 			goto no_out;
 		}
+		arcan_conductor_fsrv_upload(tgt, arcan_timemicros() - upload_start);
+		atomic_fetch_add_explicit(&shmpage->vconsumed, 1, memory_order_relaxed);
 
 /* for tighter latency management, here is where the estimated next
  * synch deadline for any output it is used on could/should be set,
@@ -607,7 +700,8 @@ enum arcan_ffunc_rv arcan_frameserver_vdirect FFUNC_HEAD
 /* interactive frameserver blocks on vsemaphore only,
  * so set monitor flags and wake up */
 		if (g_buffers_locked != 2){
-			atomic_store_explicit(&shmpage->vready, 0, memory_order_release);
+			if (!tgt->flags.mailbox)
+				atomic_store_explicit(&shmpage->vready, 0, memory_order_release);
 
 			arcan_sem_post( tgt->vsync );
 			if (tgt->desc.hints & SHMIF_RHINT_VSIGNAL_EV){
@@ -781,74 +875,241 @@ no_out:
 	return FRV_NOFRAME;
 }
 
-/* assumptions:
- * buf_sz doesn't contain partial samples (% (bytes per sample * channels))
- * dst->amixer inaud is allocated and allocation count matches n_aids */
-static void feed_amixer(arcan_frameserver* dst, arcan_aobj_id srcid,
-	int16_t* buf, int nsamples)
+/*
+ * Recording mixer, each source gets a ring of gain-applied int16 samples at
+ * the shmif samplerate (interleaved L/R, as both the monitor feeds and the
+ * output are interleaved, the per-channel gain is just a lane pattern). The
+ * mix is a saturating sum in 32-bit, so gain and clipping both come out of
+ * the pack instructions. The ring is mixed out when every source has enough
+ * buffered, or when one of them is about to overflow in which case starved
+ * sources are padded with silence and accounted as underruns.
+ */
+#define AMIXER_MASK (ARCAN_AMIXER_RING - 1)
+
+#ifndef ARCAN_AMIXER_THRESHOLD
+#define ARCAN_AMIXER_THRESHOLD 512
+#endif
+
+/* samples per mixing block */
+#define AMIXER_BLOCK 512
+
+/* gains are Q12 so that sources can be amplified up to 8x */
+static int16_t gain_q12(float gain)
 {
-/* formats; nsamples (samples in, 2 samples / frame)
- * cur->inbuf; samples converted to float with gain, 2 samples / frame)
- * dst->outbuf; SINT16, in bytes, ofset in bytes */
-	size_t minv = INT_MAX;
+	float v = gain * 4096.0f;
+	return v >= 32767.0f ? 32767 : (v <= -32768.0f ? -32768 : lrintf(v));
+}
 
-/* 1. Convert to float and buffer. Find the lowest common number of samples
- * buffered. Truncate if needed. Assume source feeds L/R */
-	for (int i = 0; i < dst->amixer.n_aids; i++){
-		struct frameserver_audsrc* cur = dst->amixer.inaud + i;
+static inline int16_t clip_s16(int32_t v)
+{
+	return v > 32767 ? 32767 : (v < -32768 ? -32768 : v);
+}
 
-		if (cur->src_aid == srcid){
-			int ulim = sizeof(cur->inbuf) / sizeof(float);
-			int count = 0;
+/* n is in samples and even, dst is L- aligned */
+static void amix_gain(int16_t* dst, const int16_t* src,
+	size_t n, int16_t gl, int16_t gr)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	__m128i g = _mm_setr_epi16(gl, gr, gl, gr, gl, gr, gl, gr);
+	for (; i + 8 <= n; i += 8){
+		__m128i x = _mm_loadu_si128((const __m128i*)&src[i]);
+		__m128i lo = _mm_mullo_epi16(x, g);
+		__m128i hi = _mm_mulhi_epi16(x, g);
+		__m128i p0 = _mm_srai_epi32(_mm_unpacklo_epi16(lo, hi), 12);
+		__m128i p1 = _mm_srai_epi32(_mm_unpackhi_epi16(lo, hi), 12);
+		_mm_storeu_si128((__m128i*)&dst[i], _mm_packs_epi32(p0, p1));
+	}
+#endif
+	for (; i < n; i += 2){
+		dst[i+0] = clip_s16(((int32_t)src[i+0] * gl) >> 12);
+		dst[i+1] = clip_s16(((int32_t)src[i+1] * gr) >> 12);
+	}
+}
 
-			while (nsamples-- && cur->inofs < ulim){
-				float val = *buf++;
-				cur->inbuf[cur->inofs++] =
-					(count++ % 2 ? cur->l_gain : cur->r_gain) * (val / 32767.0f);
-			}
-		}
+static void amix_add(int32_t* acc, const int16_t* src, size_t n)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; i + 8 <= n; i += 8){
+		__m128i x = _mm_loadu_si128((const __m128i*)&src[i]);
+		__m128i a0 = _mm_loadu_si128((const __m128i*)&acc[i+0]);
+		__m128i a1 = _mm_loadu_si128((const __m128i*)&acc[i+4]);
+		a0 = _mm_add_epi32(a0, _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16));
+		a1 = _mm_add_epi32(a1, _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16));
+		_mm_storeu_si128((__m128i*)&acc[i+0], a0);
+		_mm_storeu_si128((__m128i*)&acc[i+4], a1);
+	}
+#endif
+	for (; i < n; i++)
+		acc[i] += src[i];
+}
 
-		if (cur->inofs < minv)
-			minv = cur->inofs;
+static void amix_pack(uint8_t* dst, const int32_t* acc, size_t n)
+{
+	size_t i = 0;
+#ifdef __SSE2__
+	for (; i + 8 <= n; i += 8){
+		__m128i a0 = _mm_loadu_si128((const __m128i*)&acc[i+0]);
+		__m128i a1 = _mm_loadu_si128((const __m128i*)&acc[i+4]);
+		_mm_storeu_si128((__m128i*)&dst[i * 2], _mm_packs_epi32(a0, a1));
+	}
+#endif
+	for (; i < n; i++){
+		int16_t v = clip_s16(acc[i]);
+		memcpy(&dst[i * 2], &v, sizeof(int16_t));
 	}
+}
 
 /*
- * 2. If number of samples exceeds some threshold, mix (minv)
- * samples together and store in dst->outb Formulae used:
- * A = float(sampleA) * gainA.
- * B = float(sampleB) * gainB. Z = A + B - A * B
+ * Mix [n] samples of every source into the output buffer, sources that has
+ * less than that buffered are padded with silence and marked as underrun.
  */
-		if (minv != INT_MAX && minv > 512 && dst->sz_audb - dst->ofs_audb > 0){
-/* clamp */
-			if (dst->ofs_audb + minv * sizeof(uint16_t) > dst->sz_audb)
-				minv = (dst->sz_audb - dst->ofs_audb) / sizeof(uint16_t);
+static void amixer_mix(arcan_frameserver* dst, size_t n)
+{
+	int32_t acc[AMIXER_BLOCK];
+	size_t space = (dst->sz_audb - dst->ofs_audb) / sizeof(int16_t);
+	n = (n > space ? space : n) & ~(size_t)1;
+	if (!n)
+		return;
 
-			for (int sc = 0; sc < minv; sc++){
-				float work_sample = 0;
+	for (size_t i = 0; i < dst->amixer.n_aids; i++){
+		struct frameserver_audsrc* cur = &dst->amixer.inaud[i];
+		if (cur->count < n){
+			cur->underruns++;
+			cur->underrun_samples += n - cur->count;
+		}
+	}
 
-			for (int i = 0; i < dst->amixer.n_aids; i++){
-				work_sample += dst->amixer.inaud[i].inbuf[sc] - (work_sample *
-					dst->amixer.inaud[i].inbuf[sc]);
-			}
-/* clip output */
-			int16_t sample_conv = work_sample >= 1.0 ? 32767.0 :
-				(work_sample < -1.0 ? -32768 : work_sample * 32767);
-			memcpy(&dst->audb[dst->ofs_audb], &sample_conv, sizeof(int16_t));
-			dst->ofs_audb += sizeof(int16_t);
+	for (size_t ofs = 0; ofs < n; ofs += AMIXER_BLOCK){
+		size_t nb = n - ofs > AMIXER_BLOCK ? AMIXER_BLOCK : n - ofs;
+		memset(acc, '\0', nb * sizeof(int32_t));
+
+		for (size_t i = 0; i < dst->amixer.n_aids; i++){
+			struct frameserver_audsrc* cur = &dst->amixer.inaud[i];
+			if (cur->count <= ofs)
+				continue;
+
+			size_t left = cur->count - ofs > nb ? nb : cur->count - ofs;
+			size_t pos = (cur->head + ofs) & AMIXER_MASK;
+			size_t span = ARCAN_AMIXER_RING - pos;
+			if (span > left)
+				span = left;
+
+			amix_add(acc, &cur->ring[pos], span);
+			amix_add(&acc[span], cur->ring, left - span);
 		}
-/* 2b. Reset intermediate buffers, slide if needed. */
-		for (int j = 0; j < dst->amixer.n_aids; j++){
-			struct frameserver_audsrc* cur = dst->amixer.inaud + j;
-			if (cur->inofs > minv){
-				memmove(cur->inbuf, &cur->inbuf[minv], (cur->inofs - minv) *
-					sizeof(float));
-				cur->inofs -= minv;
-			}
-			else
-				cur->inofs = 0;
+
+		amix_pack(&dst->audb[dst->ofs_audb], acc, nb);
+		dst->ofs_audb += nb * sizeof(int16_t);
+	}
+
+	for (size_t i = 0; i < dst->amixer.n_aids; i++){
+		struct frameserver_audsrc* cur = &dst->amixer.inaud[i];
+		size_t step = cur->count > n ? n : cur->count;
+		cur->head = (cur->head + step) & AMIXER_MASK;
+		cur->count -= step;
+	}
+}
+
+static void amixer_push(arcan_frameserver* dst,
+	struct frameserver_audsrc* cur, const int16_t* buf, size_t n)
+{
+/* rather than stalling every source on one that has stopped feeding,
+ * mix out what the others have and let that one underrun */
+	if (ARCAN_AMIXER_RING - cur->count < n){
+		size_t max = 0;
+		for (size_t i = 0; i < dst->amixer.n_aids; i++)
+			if (dst->amixer.inaud[i].count > max)
+				max = dst->amixer.inaud[i].count;
+		amixer_mix(dst, max);
+	}
+
+	size_t space = ARCAN_AMIXER_RING - cur->count;
+	if (n > space){
+		cur->dropped += n - space;
+		n = space;
+	}
+
+	int16_t gl = gain_q12(cur->l_gain);
+	int16_t gr = gain_q12(cur->r_gain);
+
+	while (n){
+		size_t pos = (cur->head + cur->count) & AMIXER_MASK;
+		size_t span = ARCAN_AMIXER_RING - pos;
+		if (span > n)
+			span = n;
+
+		amix_gain(&cur->ring[pos], buf, span, gl, gr);
+		cur->count += span;
+		buf += span;
+		n -= span;
+	}
+}
+
+/* assumptions:
+ * buf_sz doesn't contain partial samples (% (bytes per sample * channels))
+ * dst->amixer inaud is allocated and allocation count matches n_aids
+ * sources are stereo, nsamples counts both channels */
+static void feed_amixer(arcan_frameserver* dst, arcan_aobj_id srcid,
+	int16_t* buf, size_t nsamples, unsigned frequency)
+{
+	struct frameserver_audsrc* cur = NULL;
+	for (size_t i = 0; i < dst->amixer.n_aids && !cur; i++)
+		if (dst->amixer.inaud[i].src_aid == srcid)
+			cur = &dst->amixer.inaud[i];
+
+	if (!cur)
+		return;
+
+	nsamples &= ~(size_t)1;
+
+	if (frequency == ARCAN_SHMIF_SAMPLERATE || frequency == 0)
+		amixer_push(dst, cur, buf, nsamples);
+	else {
+		if (!cur->resampler || cur->rate != frequency){
+			if (cur->resampler)
+				speex_resampler_destroy(cur->resampler);
+			cur->resampler = speex_resampler_init(ARCAN_SHMIF_ACHANNELS,
+				frequency, ARCAN_SHMIF_SAMPLERATE, SPEEX_RESAMPLER_QUALITY_DEFAULT, NULL);
+			cur->rate = frequency;
+			if (!cur->resampler)
+				return;
+		}
+
+		int16_t tmp[AMIXER_BLOCK];
+		while (nsamples){
+			spx_uint32_t in_len = nsamples >> 1;
+			spx_uint32_t out_len = AMIXER_BLOCK >> 1;
+			speex_resampler_process_interleaved_int(
+				cur->resampler, buf, &in_len, tmp, &out_len);
+			amixer_push(dst, cur, tmp, out_len << 1);
+			buf += in_len << 1;
+			nsamples -= in_len << 1;
+
+			if (!in_len && !out_len)
+				break;
 		}
 	}
 
+	size_t minv = SIZE_MAX;
+	for (size_t i = 0; i < dst->amixer.n_aids; i++)
+		if (dst->amixer.inaud[i].count < minv)
+			minv = dst->amixer.inaud[i].count;
+
+	if (minv >= ARCAN_AMIXER_THRESHOLD)
+		amixer_mix(dst, minv);
+}
+
+static void drop_amixer(arcan_frameserver* dst)
+{
+	for (size_t i = 0; i < dst->amixer.n_aids; i++)
+		if (dst->amixer.inaud[i].resampler)
+			speex_resampler_destroy(dst->amixer.inaud[i].resampler);
+
+	arcan_mem_free(dst->amixer.inaud);
+	dst->amixer.inaud = NULL;
+	dst->amixer.n_aids = 0;
 }
 
 void arcan_frameserver_update_mixweight(arcan_frameserver* dst,
@@ -868,7 +1129,7 @@ void arcan_frameserver_avfeed_mixer(arcan_frameserver* dst, int n_sources,
 	assert(sources != NULL && dst != NULL && n_sources > 0);
 
 	if (dst->amixer.n_aids)
-		arcan_mem_free(dst->amixer.inaud);
+		drop_amixer(dst);
 
 	dst->amixer.inaud = arcan_alloc_mem(
 		n_sources * sizeof(struct frameserver_audsrc),
@@ -877,7 +1138,6 @@ void arcan_frameserver_avfeed_mixer(arcan_frameserver* dst, int n_sources,
 	for (int i = 0; i < n_sources; i++){
 		dst->amixer.inaud[i].l_gain  = 1.0;
 		dst->amixer.inaud[i].r_gain  = 1.0;
-		dst->amixer.inaud[i].inofs   = 0;
 		dst->amixer.inaud[i].src_aid = *sources++;
 	}
 
@@ -891,34 +1151,34 @@ void arcan_frameserver_avfeedmon(arcan_aobj_id src, uint8_t* buf,
 	assert((intptr_t)(buf) % 4 == 0);
 
 /*
- * FIXME: This is a victim of a recent shmif refactor where we started to
- * allow negotating different samplerates. This should be complemented with
- * the speex- resampler that's in the codebase already
+ * with no mixing setup (lowest latency path), we just feed the sync buffer
+ * shared with the frameserver. otherwise we forward to the amixer that is
+ * responsible for pushing as much as has been generated by all the defined
+ * sources, resampled to the native rate.
+ */
+	if (dst->amixer.n_aids > 0){
+		feed_amixer(dst, src, (int16_t*) buf, buf_sz >> 1, frequency);
+		return;
+	}
+
+/*
+ * FIXME: the direct path should be complemented with the resampler
+ * as well, the mixer path handles it already
  */
 	if (frequency != ARCAN_SHMIF_SAMPLERATE){
 		static bool warn;
 		if (!warn){
 			arcan_warning("arcan_frameserver_avfeedmon(), monitoring an audio feed\n"
-				"with a non-native samplerate, this is >currently< supported for\n"
-				"playback but not for recording (TOFIX).\n");
+				"with a non-native samplerate, this is >currently< only supported\n"
+				"for recording through a mixer (multiple sources).\n");
 			warn = true;
 		}
 	}
 
-/*
- * with no mixing setup (lowest latency path), we just feed the sync buffer
- * shared with the frameserver. otherwise we forward to the amixer that is
- * responsible for pushing as much as has been generated by all the defined
- * sources
- */
-	if (dst->amixer.n_aids > 0){
-		feed_amixer(dst, src, (int16_t*) buf, buf_sz >> 1);
-	}
-	else if (dst->ofs_audb + buf_sz < dst->sz_audb){
+	if (dst->ofs_audb + buf_sz < dst->sz_audb){
 			memcpy(dst->audb + dst->ofs_audb, buf, buf_sz);
 			dst->ofs_audb += buf_sz;
 	}
-	else;
 }
 
 static inline void emit_deliveredframe(arcan_frameserver* src,
@@ -1264,24 +1524,40 @@ arcan_errc arcan_frameserver_setfont(
 	if (!fsrv)
 		return ARCAN_ERRC_NO_SUCH_OBJECT;
 
-/* first step, just track the values themselves, when we resolve the packing
- * server side entirely and not just apply the updates, we can just reraster
- * and immediately resize etc. but not there yet */
+/* fallback slots are not yet part of the server-side raster, the client
+ * still gets them forwarded and can raster on its own */
+	if (slot != 0)
+		return ARCAN_OK;
+
+	bool rebuild = false;
+
+/* the caller retains ownership of the descriptor */
 	if (BADFD != fd){
+		int nfd = dup(fd);
+		if (BADFD != nfd){
+			if (BADFD != fsrv->tpack.fd)
+				close(fsrv->tpack.fd);
+			fsrv->tpack.fd = nfd;
+			rebuild = true;
+		}
+	}
 
-/* currently just dup, later switch this to a lookup function in arcan_ttf
- * where we resolve to an inode lookup index instead, along with a ref/deref
- * kind of tracking (gives glyph caching / reuse across frameservers) */
+	if (hint >= 0 && (!fsrv->tpack.custom_hint || hint != fsrv->tpack.hint)){
+		fsrv->tpack.hint = hint;
+		fsrv->tpack.custom_hint = true;
+		rebuild = true;
 	}
 
 	if (sz > 0 && sz != fsrv->desc.hint.sz){
-/* calculate the new cell size and send that based on the fonts */
-		if (slot == 0){
-
-		}
-
 		fsrv->desc.hint.sz = sz;
+		rebuild = true;
 	}
+
+/* only worth doing if the segment actually uses TPACK, otherwise it will be
+ * built on the first TPACK frame */
+	if (rebuild && fsrv->tpack.raster)
+		tpack_rebuild(fsrv);
+
 	return ARCAN_OK;
 }
 
@@ -1291,4 +1567,15 @@ void arcan_frameserver_displayhint(
 	if (!fsrv)
 		return;
 
+	if (w && h){
+		fsrv->desc.hint.width = w;
+		fsrv->desc.hint.height = h;
+	}
+
+/* density affects the pt -> px conversion so the atlas has to be swapped */
+	if (ppcm > EPSILON && fabs(ppcm - fsrv->desc.hint.ppcm) > EPSILON){
+		fsrv->desc.hint.ppcm = ppcm;
+		if (fsrv->tpack.raster)
+			tpack_rebuild(fsrv);
+	}
 }
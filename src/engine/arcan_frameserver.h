@@ -81,12 +81,29 @@ struct arcan_frameserver_meta {
 	unsigned long long lastpts;
 };
 
+/* samples (both channels) buffered per recording source, power of two */
+#ifndef ARCAN_AMIXER_RING
+#define ARCAN_AMIXER_RING 8192
+#endif
+
 struct frameserver_audsrc {
-	float inbuf[4096];
-	off_t inofs;
+/* interleaved, gain applied and at the shmif samplerate */
+	int16_t ring[ARCAN_AMIXER_RING];
+	size_t head, count;
+
 	arcan_aobj_id src_aid;
 	float l_gain;
 	float r_gain;
+
+/* speex resampler state, created when the source rate isn't native */
+	void* resampler;
+	unsigned rate;
+
+/* number of mixes where the source was padded with silence, the number
+ * of samples padded and the number of samples lost to a full ring */
+	unsigned long long underruns;
+	unsigned long long underrun_samples;
+	unsigned long long dropped;
 };
 
 struct arcan_frameserver {
@@ -142,6 +159,7 @@ struct arcan_frameserver {
 		bool locked : 1;
 		bool release_pending : 1;
 		bool no_adopt : 1;
+		bool mailbox : 1;
 
 /* privilege level indicators */
 		bool external : 1;
@@ -179,6 +197,9 @@ struct arcan_frameserver {
 	int64_t launchedtime;
 	unsigned vfcount;
 
+/* upload latency, allocated and owned by the conductor while registered */
+	struct conductor_histogram* upload_hist;
+
 /* per segment identification cookie */
 	uint32_t cookie;
 
@@ -191,6 +212,20 @@ struct arcan_frameserver {
 		int format;
 	} vstream;
 
+/* server-side rasterization of SHMIF_RHINT_TPACK buffers, the atlas is an
+ * alias of the one owned by the raster context and can be shared with other
+ * frameservers that use the same font. [fd] is the last font descriptor set
+ * through arcan_frameserver_setfont, kept so that size and density changes
+ * can rebuild the atlas */
+	struct {
+		struct tui_raster_context* raster;
+		struct tui_raster_atlas* atlas;
+		file_handle fd;
+		int hint;
+		bool custom_hint;
+		bool invalidated;
+	} tpack;
+
 /* temporary buffer for aligning queue/dequeue events in audio, can/should
  * be scrapped after the 0.6 audio refactor */
 	size_t sz_audb;
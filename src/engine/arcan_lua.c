@@ -1826,9 +1826,11 @@ static int loadimageasynch(lua_State* ctx)
 		ref = luaL_ref(ctx, LUA_REGISTRYINDEX);
 	}
 
-	if (path && strlen(path) > 0){
-		id = arcan_video_loadimageasynch(path, (img_cons){}, ref);
-	}
+	int prio = luaL_optnumber(ctx, 3, 0);
+
+	if (path && strlen(path) > 0)
+		id = arcan_video_loadimageasynch(path, (img_cons){}, ref, prio);
+
 	arcan_mem_free(path);
 
 	lua_pushvid(ctx, id);
@@ -3801,10 +3803,16 @@ static int contextusage(lua_State* ctx)
 	LUA_TRACE("current_context_usage");
 
 	unsigned usecount;
+	size_t allocs, frees, peak;
 	lua_pushinteger(ctx, arcan_video_contextusage(&usecount));
 	lua_pushinteger(ctx, usecount);
 
-	LUA_ETRACE("current_context_usage", NULL, 2);
+	arcan_video_contextstats(&allocs, &frees, &peak);
+	lua_pushinteger(ctx, allocs);
+	lua_pushinteger(ctx, frees);
+	lua_pushinteger(ctx, peak);
+
+	LUA_ETRACE("current_context_usage", NULL, 5);
 }
 
 /*
@@ -4500,14 +4508,12 @@ static const char* domain_str(int num)
 #define FLTPUSH(X,Y,Z) fltpush(msgbuf, COUNT_OF((X))-1, (char*)((X)), Y, Z)
 
 /*
- * Repack an ioevent into a table that will be added to the out stack,
- * primarly used for the normal appl_input callback, but may also come
- * nested from a frameserver.
+ * Repack an ioevent into the table at [top], [samples] is an optional
+ * table to reuse for analog samples rather than creating a new one.
  */
-static void append_iotable(lua_State* ctx, arcan_ioevent* ev)
+static void fill_iotable(
+	lua_State* ctx, arcan_ioevent* ev, int top, int samples)
 {
-	int top = funtable(ctx, ev->kind);
-
 	lua_pushstring(ctx, "kind");
 	if (ev->label[0] && ev->kind != EVENT_IO_STATUS &&
 		ev->label[COUNT_OF(ev->label)-1] == '\0'){
@@ -4588,13 +4594,22 @@ static void append_iotable(lua_State* ctx, arcan_ioevent* ev)
 		tblbool(ctx, "relative", ev->input.analog.gotrel,top);
 
 		lua_pushstring(ctx, "samples");
-		lua_createtable(ctx, ev->input.analog.nvalues, 0);
+		if (samples)
+			lua_pushvalue(ctx, samples);
+		else
+			lua_createtable(ctx, ev->input.analog.nvalues, 0);
 		int top2 = lua_gettop(ctx);
 			for (size_t i = 0; i < ev->input.analog.nvalues; i++){
 				lua_pushnumber(ctx, i + 1);
 				lua_pushnumber(ctx, ev->input.analog.axisval[i]);
 				lua_rawset(ctx, top2);
 			}
+		if (samples)
+			for (size_t i = ev->input.analog.nvalues;
+				i < COUNT_OF(ev->input.analog.axisval); i++){
+				lua_pushnil(ctx);
+				lua_rawseti(ctx, top2, i + 1);
+			}
 		lua_rawset(ctx, top);
 	break;
 
@@ -4641,11 +4656,233 @@ static void append_iotable(lua_State* ctx, arcan_ioevent* ev)
 	}
 }
 
+/*
+ * Repack an ioevent into a table that will be added to the out stack,
+ * primarly used for the normal appl_input callback, but may also come
+ * nested from a frameserver.
+ */
+static void append_iotable(lua_State* ctx, arcan_ioevent* ev)
+{
+	fill_iotable(ctx, ev, funtable(ctx, ev->kind), 0);
+}
+
+/*
+ * Opt-in batched input: when the appl defines _input_raw, io events are
+ * queued during an event feed and delivered as one array when the feed is
+ * done, or earlier if some other event would otherwise overtake them. The
+ * event tables are recycled between batches, so the appl should not hold on
+ * to them beyond the call. Analog and touch motion samples for the same
+ * device and axis are folded into the queued one, with [merged] counting
+ * how many samples went into it.
+ */
+#ifndef INPUT_BATCH_LIMIT
+#define INPUT_BATCH_LIMIT 256
+#endif
+
+static struct {
+	arcan_ioevent evs[INPUT_BATCH_LIMIT];
+	uint16_t merged[INPUT_BATCH_LIMIT];
+	size_t count, last_count;
+
+/* registry references for the recycled tables and the array passed */
+	lua_State* ctx;
+	int pool_ref, batch_ref;
+
+/* set while the handler runs, a flush from within (event queue drain) can't
+ * reuse the tables the handler might still be iterating */
+	bool in_call;
+} input_batch;
+
+static bool batch_merge(arcan_ioevent* dst, arcan_ioevent* src)
+{
+	if (strncmp(dst->label, src->label, COUNT_OF(dst->label)) != 0)
+		return false;
+
+/* only motion, press and release transitions are kept */
+	if (src->kind == EVENT_IO_TOUCH){
+		if (!dst->input.touch.active || !src->input.touch.active)
+			return false;
+
+		dst->input.touch = src->input.touch;
+		return true;
+	}
+
+	if (dst->input.analog.gotrel != src->input.analog.gotrel ||
+		dst->input.analog.nvalues != src->input.analog.nvalues)
+		return false;
+
+/* the relative samples accumulate, the rest is replaced by the newer one, see
+ * the notes on ordering in arcan_shmif_event.h. With 3 values the last one has
+ * no defined meaning so there is nothing to say it can be folded, with 4 the
+ * second axis is packed after the first */
+	size_t nv = src->input.analog.nvalues;
+	if (nv == 3)
+		return false;
+
+	size_t rel = src->input.analog.gotrel ? 0 : 1;
+	int sum[2] = {0};
+
+	for (size_t i = 0; i < 2 && rel + i * 2 < nv; i++){
+		size_t ind = rel + i * 2;
+		sum[i] = dst->input.analog.axisval[ind] + src->input.analog.axisval[ind];
+		if (sum[i] < INT16_MIN || sum[i] > INT16_MAX)
+			return false;
+	}
+
+	memcpy(dst->input.analog.axisval,
+		src->input.analog.axisval, sizeof(src->input.analog.axisval));
+
+	for (size_t i = 0; i < 2 && rel + i * 2 < nv; i++)
+		dst->input.analog.axisval[rel + i * 2] = sum[i];
+
+	return true;
+}
+
+static void batch_input(lua_State* ctx, arcan_ioevent* ev)
+{
+/* look back for a sample on the same axis, only samples on other axes of the
+ * same device can be passed (x/y split over two subids), anything else would
+ * be reordered against the motion and acts as a barrier */
+	if (ev->kind == EVENT_IO_AXIS_MOVE || ev->kind == EVENT_IO_TOUCH)
+		for (size_t i = input_batch.count; i > 0; i--){
+			arcan_ioevent* cur = &input_batch.evs[i-1];
+			if (cur->devid != ev->devid ||
+				cur->devkind != ev->devkind || cur->kind != ev->kind)
+				break;
+
+			if (cur->subid != ev->subid)
+				continue;
+
+			if (batch_merge(cur, ev)){
+				if (input_batch.merged[i-1] < UINT16_MAX)
+					input_batch.merged[i-1]++;
+				return;
+			}
+			break;
+		}
+
+	if (input_batch.count == INPUT_BATCH_LIMIT)
+		arcan_lua_flushinput(ctx);
+
+	input_batch.evs[input_batch.count] = *ev;
+	input_batch.merged[input_batch.count++] = 0;
+}
+
+static void clear_table(lua_State* ctx, int ind)
+{
+	lua_pushnil(ctx);
+	while (lua_next(ctx, ind)){
+		lua_pop(ctx, 1);
+		lua_pushvalue(ctx, -1);
+		lua_pushnil(ctx);
+		lua_rawset(ctx, ind);
+	}
+}
+
+void arcan_lua_flushinput(lua_State* ctx)
+{
+	size_t count = input_batch.count;
+	if (!count)
+		return;
+	input_batch.count = 0;
+
+/* the handler went away while we were queueing, deliver as normal input */
+	if (!grabapplfunction(ctx, "input_raw", 9)){
+		for (size_t i = 0; i < count; i++){
+			if (!grabapplfunction(ctx, "input", 5))
+				break;
+			append_iotable(ctx, &input_batch.evs[i]);
+			alua_call(ctx, 1, 0, LINE_TAG":event:input");
+		}
+		return;
+	}
+
+	if (input_batch.ctx != ctx || !input_batch.pool_ref){
+		input_batch.ctx = ctx;
+		lua_newtable(ctx);
+		input_batch.pool_ref = luaL_ref(ctx, LUA_REGISTRYINDEX);
+		lua_newtable(ctx);
+		input_batch.batch_ref = luaL_ref(ctx, LUA_REGISTRYINDEX);
+		input_batch.last_count = 0;
+		input_batch.in_call = false;
+	}
+
+/* nested, the pooled tables are in use so build new ones for this batch */
+	bool nested = input_batch.in_call;
+	int batch, pool = 0;
+
+	if (nested){
+		lua_createtable(ctx, count, 0);
+		batch = lua_gettop(ctx);
+	}
+	else {
+		lua_rawgeti(ctx, LUA_REGISTRYINDEX, input_batch.batch_ref);
+		batch = lua_gettop(ctx);
+		lua_rawgeti(ctx, LUA_REGISTRYINDEX, input_batch.pool_ref);
+		pool = lua_gettop(ctx);
+	}
+
+	for (size_t i = 0; i < count; i++){
+		if (pool)
+			lua_rawgeti(ctx, pool, i + 1);
+		else
+			lua_pushnil(ctx);
+
+		if (!lua_istable(ctx, -1)){
+			lua_pop(ctx, 1);
+			lua_newtable(ctx);
+			if (pool){
+				lua_pushvalue(ctx, -1);
+				lua_rawseti(ctx, pool, i + 1);
+			}
+		}
+		int top = lua_gettop(ctx);
+
+/* keep the samples table around while the rest of the entry is cleared */
+		lua_pushstring(ctx, "samples");
+		lua_rawget(ctx, top);
+		int samples = lua_istable(ctx, -1) ? lua_gettop(ctx) : 0;
+
+		clear_table(ctx, top);
+		fill_iotable(ctx, &input_batch.evs[i], top, samples);
+		if (input_batch.merged[i])
+			tblnum(ctx, "merged", input_batch.merged[i], top);
+
+		lua_settop(ctx, top);
+		lua_rawseti(ctx, batch, i + 1);
+	}
+
+	if (nested){
+		alua_call(ctx, 1, 0, LINE_TAG":event:input_raw");
+		return;
+	}
+
+	for (size_t i = count; i < input_batch.last_count; i++){
+		lua_pushnil(ctx);
+		lua_rawseti(ctx, batch, i + 1);
+	}
+	input_batch.last_count = count;
+
+	lua_pop(ctx, 1);
+	input_batch.in_call = true;
+	alua_call(ctx, 1, 0, LINE_TAG":event:input_raw");
+	input_batch.in_call = false;
+}
+
 void arcan_lua_pushevent(lua_State* ctx, arcan_event* ev)
 {
 	bool adopt_check = false;
 	char msgbuf[sizeof(arcan_event)+1];
 
+	if (ev->category == EVENT_IO && grabapplfunction(ctx, "input_raw", 9)){
+		lua_pop(ctx, 1);
+		batch_input(ctx, &ev->io);
+		return;
+	}
+
+/* anything queued goes first so that input isn't reordered */
+	arcan_lua_flushinput(ctx);
+
 	if (ev->category == EVENT_IO && grabapplfunction(ctx, "input", 5)){
 		append_iotable(ctx, &ev->io);
 		alua_call(ctx, 1, 0, LINE_TAG":event:input");
@@ -6096,6 +6333,20 @@ static int push_stringres(lua_State* ctx, struct arcan_strarr* res)
 	return rv;
 }
 
+static void push_kvmap(lua_State* ctx, struct arcan_dbkv* kv)
+{
+	lua_createtable(ctx, 0, kv->count);
+	int top = lua_gettop(ctx);
+
+	for (size_t i = 0; i < kv->count; i++){
+		lua_pushstring(ctx, kv->keys[i]);
+		lua_pushstring(ctx, kv->vals[i]);
+		lua_rawset(ctx, top);
+	}
+
+	arcan_db_free_kv(kv);
+}
+
 static int matchkeys(lua_State* ctx)
 {
 	LUA_TRACE("match_keys");
@@ -6106,6 +6357,17 @@ static int matchkeys(lua_State* ctx)
 		arcan_fatal("match keys(%d) invalid domain specified, "
 			"domain must be KEY_TARGET or KEY_CONFIG\n");
 
+	if (lua_toboolean(ctx, 3)){
+		if (domain != DVT_APPL)
+			arcan_fatal("match_keys(pattern, domain, map) "
+				"map form is only allowed for the appl domain\n");
+
+		struct arcan_dbkv kv =
+			arcan_db_matchvalues(DBHANDLE, DVT_APPL, 0, pattern);
+		push_kvmap(ctx, &kv);
+		LUA_ETRACE("match_keys", NULL, 1);
+	}
+
 	struct arcan_strarr res;
 	if (domain == DVT_APPL)
 		res = arcan_db_applkeys(DBHANDLE, arcan_appl_id(), pattern);
@@ -6141,10 +6403,63 @@ static int getkeys(lua_State* ctx)
 	LUA_ETRACE("get_keys", NULL, rv);
 }
 
+/*
+ * get_key with a table of keys, resolve the domain like the single key
+ * version and return a key -> value table in one query
+ */
+static int getkeys_bulk(lua_State* ctx)
+{
+	enum DB_KVTARGET kvt = DVT_APPL;
+	int64_t id = 0;
+
+	const char* opt_target = luaL_optstring(ctx, 2, NULL);
+	if (opt_target){
+		kvt = DVT_TARGET;
+		id = arcan_db_targetid(DBHANDLE, opt_target, NULL);
+
+		const char* opt_config = luaL_optstring(ctx, 3, NULL);
+		if (opt_config){
+			kvt = DVT_CONFIG;
+			id = arcan_db_configid(DBHANDLE, id, opt_config);
+		}
+	}
+
+	size_t n_keys = lua_rawlen(ctx, 1);
+	const char** keys = arcan_alloc_mem(sizeof(char*) * (n_keys + 1),
+		ARCAN_MEM_STRINGBUF, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
+	size_t count = 0;
+
+/* only take actual strings, a converted number would not be anchored */
+	for (size_t i = 1; i <= n_keys; i++){
+		lua_rawgeti(ctx, 1, i);
+		const char* key = lua_type(ctx, -1) == LUA_TSTRING ?
+			lua_tostring(ctx, -1) : NULL;
+
+		if (key && validate_key(key))
+			keys[count++] = key;
+		else
+			arcan_warning("get_key, key[%zu] rejected "
+				"(restricted to [a-Z0-9_+/=])\n", i);
+
+		lua_pop(ctx, 1);
+	}
+
+	struct arcan_dbkv kv = arcan_db_getvalues(DBHANDLE, kvt, id, keys, count);
+	arcan_mem_free(keys);
+	push_kvmap(ctx, &kv);
+
+	return 1;
+}
+
 static int getkey(lua_State* ctx)
 {
 	LUA_TRACE("get_key");
 
+	if (lua_type(ctx, 1) == LUA_TTABLE){
+		int rv = getkeys_bulk(ctx);
+		LUA_ETRACE("get_key", NULL, rv);
+	}
+
 	const char* key = luaL_checkstring(ctx, 1);
 	if (!validate_key(key)){
 		arcan_warning("invalid key specified (restricted to [a-Z0-9_])\n");
@@ -6168,7 +6483,12 @@ static int getkey(lua_State* ctx)
 			free(val);
 		}
 		else{
-			arcan_db_getvalue(DBHANDLE, DVT_TARGET, tid, key);
+			char* val = arcan_db_getvalue(DBHANDLE, DVT_TARGET, tid, key);
+			if (val)
+				lua_pushstring(ctx, val);
+			else
+				lua_pushnil(ctx);
+			free(val);
 		}
 	}
 	else {
@@ -7049,6 +7369,9 @@ void arcan_lua_shutdown(lua_State* ctx)
  * luactx : rawres, lastsrc, cb_source_kind, db_source_tag, last_segreq,
  * pending_socket_label, pending_socket_descr */
 	lua_close(ctx);
+	input_batch.ctx = NULL;
+	input_batch.count = 0;
+	input_batch.in_call = false;
 }
 
 void arcan_lua_dostring(lua_State* ctx, const char* code)
@@ -10045,6 +10368,38 @@ static int recordgain(lua_State* ctx)
 	LUA_ETRACE("recordtarget_gain", NULL, 0);
 }
 
+static int recordmixstats(lua_State* ctx)
+{
+	LUA_TRACE("recordtarget_mixstats");
+
+	arcan_vobject* vobj;
+	luaL_checkvid(ctx, 1, &vobj);
+	arcan_frameserver* fsrv = vobj->feed.state.ptr;
+
+	if (!fsrv || vobj->feed.state.tag != ARCAN_TAG_FRAMESERV)
+		arcan_fatal("recordtarget_mixstats(1), " FATAL_MSG_FRAMESERV);
+
+	lua_newtable(ctx);
+	int top = lua_gettop(ctx);
+
+	for (size_t i = 0; i < fsrv->amixer.n_aids; i++){
+		struct frameserver_audsrc* src = &fsrv->amixer.inaud[i];
+		lua_pushnumber(ctx, i + 1);
+		lua_newtable(ctx);
+		int ttop = lua_gettop(ctx);
+		tblnum(ctx, "aid", src->src_aid, ttop);
+		tblnum(ctx, "buffered", src->count, ttop);
+		tblnum(ctx, "latency", 1000.0 * (double)(src->count /
+			ARCAN_SHMIF_ACHANNELS) / (double)ARCAN_SHMIF_SAMPLERATE, ttop);
+		tblnum(ctx, "underruns", src->underruns, ttop);
+		tblnum(ctx, "underrun_samples", src->underrun_samples, ttop);
+		tblnum(ctx, "dropped", src->dropped, ttop);
+		lua_rawset(ctx, top);
+	}
+
+	LUA_ETRACE("recordtarget_mixstats", NULL, 1);
+}
+
 extern arcan_benchdata benchdata;
 static int togglebench(lua_State* ctx)
 {
@@ -10065,6 +10420,10 @@ static int togglebench(lua_State* ctx)
 	memset(benchdata.framecost, '\0', sizeof(benchdata.framecost));
 	benchdata.tickofs = benchdata.frameofs = benchdata.costofs = 0;
 	benchdata.framecount = benchdata.tickcount = benchdata.costcount = 0;
+	arcan_conductor_reset_timing();
+	arcan_video_display.draws_total.calls = 0;
+	arcan_video_display.draws_total.quads = 0;
+	arcan_video_display.draws_refreshes = 0;
 
 	LUA_ETRACE("benchmark_enable", NULL, 0);
 }
@@ -10134,6 +10493,115 @@ static int getbenchvals(lua_State* ctx)
 	LUA_ETRACE("benchmark_data", NULL, 6);
 }
 
+static int geteventqueuestats(lua_State* ctx)
+{
+	LUA_TRACE("benchmark_eventqueue");
+
+	struct arcan_event_queuestats stats;
+	arcan_event_queuestats(&stats);
+
+	lua_newtable(ctx);
+	int top = lua_gettop(ctx);
+	tblnum(ctx, "posted", stats.posted, top);
+	tblnum(ctx, "saturated", stats.saturated, top);
+	tblnum(ctx, "overflow", stats.overflow, top);
+	tblnum(ctx, "batches", stats.batches, top);
+	tblnum(ctx, "pending", stats.pending, top);
+	tblnum(ctx, "high_water", stats.high_water, top);
+	tblnum(ctx, "capacity", stats.capacity, top);
+
+	LUA_ETRACE("benchmark_eventqueue", NULL, 1);
+}
+
+static int getdrawstats(lua_State* ctx)
+{
+	LUA_TRACE("benchmark_drawcalls");
+
+	lua_newtable(ctx);
+	int top = lua_gettop(ctx);
+	tblnum(ctx, "calls", arcan_video_display.draws.calls, top);
+	tblnum(ctx, "quads", arcan_video_display.draws.quads, top);
+	tblnum(ctx, "total_calls", arcan_video_display.draws_total.calls, top);
+	tblnum(ctx, "total_quads", arcan_video_display.draws_total.quads, top);
+	tblnum(ctx, "refreshes", arcan_video_display.draws_refreshes, top);
+	tblbool(ctx, "batching", !arcan_video_display.no_batch, top);
+
+	LUA_ETRACE("benchmark_drawcalls", NULL, 1);
+}
+
+static void pushhistogram(lua_State* ctx, const struct conductor_histogram* h)
+{
+	lua_newtable(ctx);
+	int top = lua_gettop(ctx);
+	tblnum(ctx, "count", h->count, top);
+	tblnum(ctx, "min", h->min, top);
+	tblnum(ctx, "max", h->max, top);
+	tblnum(ctx, "mean", h->count ? (double)h->sum / (double)h->count : 0, top);
+	tblnum(ctx, "p50", arcan_conductor_hist_percentile(h, 0.5), top);
+	tblnum(ctx, "p90", arcan_conductor_hist_percentile(h, 0.9), top);
+	tblnum(ctx, "p99", arcan_conductor_hist_percentile(h, 0.99), top);
+	tblnum(ctx, "p999", arcan_conductor_hist_percentile(h, 0.999), top);
+}
+
+/* the frame counters live in the shmpage, so guard against SIGBUS */
+static bool pull_fsrv_vstats(arcan_frameserver* src, struct shmif_vstats* out)
+{
+	jmp_buf tramp;
+	if (!src->shm.ptr || 0 != setjmp(tramp))
+		return false;
+
+	platform_fsrv_enter(src, tramp);
+	*out = (struct shmif_vstats){
+		.produced = atomic_load(&src->shm.ptr->vproduced),
+		.consumed = atomic_load(&src->shm.ptr->vconsumed),
+		.dropped = atomic_load(&src->shm.ptr->vdropped)
+	};
+	platform_fsrv_leave();
+	return true;
+}
+
+static int getlatency(lua_State* ctx)
+{
+	LUA_TRACE("benchmark_latency");
+
+	if (lua_type(ctx, 1) == LUA_TNUMBER){
+		arcan_vobject* vobj;
+		luaL_checkvid(ctx, 1, &vobj);
+		arcan_frameserver* fsrv = vobj->feed.state.ptr;
+		if (vobj->feed.state.tag != ARCAN_TAG_FRAMESERV)
+			arcan_fatal("benchmark_latency(vid) -- " FATAL_MSG_FRAMESERV);
+
+		if (!fsrv->upload_hist){
+			lua_pushnil(ctx);
+			LUA_ETRACE("benchmark_latency", "no upload statistics", 1);
+		}
+
+		pushhistogram(ctx, fsrv->upload_hist);
+		struct shmif_vstats vs;
+		if (pull_fsrv_vstats(fsrv, &vs)){
+			int top = lua_gettop(ctx);
+			tblnum(ctx, "produced", vs.produced, top);
+			tblnum(ctx, "consumed", vs.consumed, top);
+			tblnum(ctx, "dropped", vs.dropped, top);
+			tblbool(ctx, "mailbox", fsrv->flags.mailbox, top);
+		}
+		LUA_ETRACE("benchmark_latency", NULL, 1);
+	}
+
+	lua_newtable(ctx);
+	int top = lua_gettop(ctx);
+
+	for (size_t i = 0; i < CONDUCTOR_STAGE_COUNT; i++){
+		const char* name;
+		const struct conductor_histogram* h = arcan_conductor_timing(i, &name);
+		lua_pushstring(ctx, name);
+		pushhistogram(ctx, h);
+		lua_rawset(ctx, top);
+	}
+
+	LUA_ETRACE("benchmark_latency", NULL, 1);
+}
+
 static int timestamp(lua_State* ctx)
 {
 	LUA_TRACE("benchmark_timestamp");
@@ -11557,6 +12025,7 @@ static const luaL_Reg tgtfuns[] = {
 {"rendertarget_forceupdate",   rendertargetforce        },
 {"rendertarget_vids",          rendertarget_vids        },
 {"recordtarget_gain",          recordgain               },
+{"recordtarget_mixstats",      recordmixstats           },
 {"rendertarget_detach",        renderdetach             },
 {"rendertarget_bind",          renderbind               },
 {"rendertarget_attach",        renderattach             },
@@ -11738,6 +12207,9 @@ static const luaL_Reg sysfuns[] = {
 {"benchmark_enable",    togglebench      },
 {"benchmark_timestamp", timestamp        },
 {"benchmark_data",      getbenchvals     },
+{"benchmark_eventqueue", geteventqueuestats},
+{"benchmark_latency", getlatency},
+{"benchmark_drawcalls", getdrawstats},
 {"appl_arguments",      getapplarguments },
 {"system_identstr",     getidentstr      },
 {"system_defaultfont",  setdefaultfont   },
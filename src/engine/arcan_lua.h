@@ -42,6 +42,11 @@ void arcan_lua_setglobalint(struct arcan_luactx* ctx, const char* key, int val);
 void arcan_lua_setglobalstr(struct arcan_luactx* ctx,
 	const char* key, const char* val);
 void arcan_lua_pushevent(struct arcan_luactx* ctx, arcan_event* ev);
+
+/* deliver input queued for the _input_raw entry point, call after an
+ * event feed has been processed */
+void arcan_lua_flushinput(struct arcan_luactx* ctx);
+
 bool arcan_lua_callvoidfun(struct arcan_luactx* ctx,
 	const char* fun, bool warn, const char** argv);
 
@@ -252,6 +252,7 @@ static void override_resspaces(const char* respath)
 
 static void fatal_shutdown()
 {
+	arcan_db_flush(arcan_db_get_shared(NULL));
 	arcan_audio_shutdown();
 	arcan_video_shutdown(false);
 }
@@ -266,6 +267,8 @@ static struct {
 
 static void main_cycle()
 {
+	arcan_db_tick(arcan_db_get_shared(NULL));
+
 	if (settings.monitor && !settings.in_monitor){
 		if (--settings.monitor_counter == 0){
 			static int mc;
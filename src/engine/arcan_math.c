@@ -51,6 +51,22 @@ void multiply_matrix(float* restrict dst,
 				b[i+2] * a[j+8] +
 				b[i+3] * a[j+12];
 }
+
+void interp_fract_batch(float* dst,
+	const float* startt, const float* endt, float ts, size_t n)
+{
+	for (size_t i = 0; i < n; i++){
+		float rv = (EPSILON + (ts - startt[i])) / (endt[i] - startt[i]);
+		dst[i] = rv > 1.0 ? 1.0 : rv;
+	}
+}
+
+void interp_1d_linear_batch(float* dst,
+	const float* sv, const float* ev, const float* fract, size_t n)
+{
+	for (size_t i = 0; i < n; i++)
+		dst[i] = sv[i] + (ev[i] - sv[i]) * fract[i];
+}
 #endif
 
 void scale_matrix(float* m, float xs, float ys, float zs)
@@ -5,6 +5,8 @@
 #ifndef HAVE_ARCAN_MATH
 #define HAVE_ARCAN_MATH
 
+#include <stddef.h>
+
 #define EPSILON 0.000001f
 #define DEG2RAD(X) (X * M_PI / 180)
 
@@ -113,6 +115,17 @@ vector interp_3d_expin(vector startv, vector endv, float fract);
 vector interp_3d_expinout(vector startv, vector endv, float fract);
 vector interp_3d_smoothstep(vector startv, vector endv, float fract);
 
+/*
+ * Batched forms of the above for values stored as separate arrays (structure
+ * of arrays). _fract_batch calculates the clamped [0..1] progress at [ts]
+ * for n start/end pairs, _linear_batch interpolates n values with one fract
+ * each. [dst] may alias any of the inputs.
+ */
+void interp_fract_batch(float* dst,
+	const float* startt, const float* endt, float ts, size_t n);
+void interp_1d_linear_batch(float* dst,
+	const float* startv, const float* endv, const float* fract, size_t n);
+
 void update_view(orientation* dst, float roll, float pitch, float yaw);
 
 /* camera / view functions */
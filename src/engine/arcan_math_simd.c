@@ -150,3 +150,45 @@ void multiply_matrix(float* restrict dst,
 #endif
 }
 
+
+/*
+ * The batch inputs come from growable arrays that are not guaranteed to be
+ * aligned, so these always use unaligned loads and handle the tail scalar.
+ */
+void interp_fract_batch(float* dst,
+	const float* startt, const float* endt, float ts, size_t n)
+{
+	const __m128 vts = _mm_set1_ps(ts);
+	const __m128 veps = _mm_set1_ps(EPSILON);
+	const __m128 vone = _mm_set1_ps(1.0);
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4){
+		__m128 st = _mm_loadu_ps(&startt[i]);
+		__m128 et = _mm_loadu_ps(&endt[i]);
+		__m128 rv = _mm_div_ps(
+			_mm_add_ps(veps, _mm_sub_ps(vts, st)), _mm_sub_ps(et, st));
+		_mm_storeu_ps(&dst[i], _mm_min_ps(rv, vone));
+	}
+
+	for (; i < n; i++){
+		float rv = (EPSILON + (ts - startt[i])) / (endt[i] - startt[i]);
+		dst[i] = rv > 1.0 ? 1.0 : rv;
+	}
+}
+
+void interp_1d_linear_batch(float* dst,
+	const float* sv, const float* ev, const float* fract, size_t n)
+{
+	size_t i = 0;
+
+	for (; i + 4 <= n; i += 4){
+		__m128 s = _mm_loadu_ps(&sv[i]);
+		__m128 e = _mm_loadu_ps(&ev[i]);
+		__m128 f = _mm_loadu_ps(&fract[i]);
+		_mm_storeu_ps(&dst[i], _mm_add_ps(s, _mm_mul_ps(_mm_sub_ps(e, s), f)));
+	}
+
+	for (; i < n; i++)
+		dst[i] = sv[i] + (ev[i] - sv[i]) * fract[i];
+}
@@ -26,6 +26,12 @@
 #include <stdint.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <pthread.h>
+#include <sys/stat.h>
+
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
 
 #include <ft2build.h>
 #include FT_FREETYPE_H
@@ -106,9 +112,12 @@ struct _TTF_Font {
 	int underline_offset;
 	int underline_height;
 
-	/* Cache for style-transformed glyphs */
+	/* Last glyph found, points into the shared glyph cache */
 	c_glyph *current;
-	c_glyph cache[257]; /* 257 is a prime */
+	uint64_t cache_key;
+
+	/* Used if the glyph cache could not be allocated */
+	c_glyph scratch;
 
 	/* We are responsible for closing the font stream */
 	FILE* src;
@@ -238,6 +247,8 @@ int TTF_Init( void )
 	return status;
 }
 
+static uint64_t font_cache_key(TTF_Font* font);
+
 static unsigned long ft_read(FT_Stream stream, unsigned long ofs,
 	unsigned char* buf, unsigned long count)
 {
@@ -415,6 +426,7 @@ TTF_Font* TTF_OpenFontIndexRW( FILE* src, int freesrc, int ptsize,
 	/* x offset = cos(((90.0-12)/360)*2*M_PI), or 12 degree angle */
 	font->glyph_italics = 0.207f;
 	font->glyph_italics *= font->height;
+	font->cache_key = font_cache_key(font);
 
 	return font;
 }
@@ -491,17 +503,289 @@ static void Flush_Glyph( c_glyph* glyph )
 	glyph->cached = 0;
 }
 
-void TTF_Flush_Cache( TTF_Font* font )
+/*
+ * Glyph cache shared between all the fonts opened by a thread (like the
+ * library handle). Entries are keyed on the file the face was loaded from and
+ * the size rather than on the TTF_Font, so the same font re-opened for another
+ * slot or at a size that has been used before gets the glyphs that are already
+ * rendered. The least recently used entry is evicted when it is full.
+ *
+ * Each thread owns its cache, it is released by TTF_Quit in that thread or
+ * when the thread exits.
+ */
+#ifndef TTF_GLYPH_CACHE_LIMIT
+#define TTF_GLYPH_CACHE_LIMIT 2048
+#endif
+
+#define GLYPH_CACHE_BUCKETS (TTF_GLYPH_CACHE_LIMIT * 2)
+#define GLYPH_NONE UINT32_MAX
+
+struct glyph_key {
+	uint64_t face;
+	uint32_t ch;
+	int style;
+	int outline;
+	int hinting;
+	bool by_ind;
+};
+
+struct glyph_entry {
+	struct glyph_key key;
+	c_glyph glyph;
+	bool live;
+
+/* the face does not have the glyph, kept so fallback chains can skip it */
+	bool missing;
+
+	uint32_t chain;
+	uint32_t prev, next;
+};
+
+struct glyph_cache {
+	struct glyph_entry* entries;
+	uint32_t* buckets;
+	uint32_t head, tail, free;
+	size_t used;
+};
+
+static _Thread_local struct glyph_cache gcache;
+static pthread_once_t gcache_once = PTHREAD_ONCE_INIT;
+static pthread_key_t gcache_owner;
+
+static uint64_t hash_mix(uint64_t h, uint64_t v)
 {
-	int i;
-	int size = sizeof( font->cache ) / sizeof( font->cache[0] );
+	h ^= v + 0x9e3779b97f4a7c15ull + (h << 6) + (h >> 2);
+	return h;
+}
+
+static uint64_t hash_str(uint64_t h, const char* str)
+{
+	while (str && *str)
+		h = (h ^ (uint8_t)*str++) * 0x100000001b3ull;
+	return h;
+}
+
+/*
+ * Identify the face and the size it was opened at, everything the glyph
+ * renderer takes from the font outside of style, outline and hinting. Two
+ * files can have the same metadata but different outlines so the identity of
+ * the file itself is part of the key, ctime covers an inode being reused.
+ */
+static uint64_t font_cache_key(TTF_Font* font)
+{
+	FT_Face face = font->face;
+	uint64_t h = 0xcbf29ce484222325ull;
+
+	struct stat fs;
+	if (0 == fstat(fileno(font->src), &fs)){
+		h = hash_mix(h, fs.st_dev);
+		h = hash_mix(h, fs.st_ino);
+		h = hash_mix(h, fs.st_size);
+		h = hash_mix(h, (uint64_t) fs.st_mtim.tv_sec << 32 ^ fs.st_mtim.tv_nsec);
+		h = hash_mix(h, (uint64_t) fs.st_ctim.tv_sec << 32 ^ fs.st_ctim.tv_nsec);
+	}
+/* without an identity, don't share with anything else */
+	else
+		h = hash_mix(h, (uintptr_t) font);
+
+	h = hash_str(h, face->family_name);
+	h = hash_str(h, face->style_name);
+	h = hash_mix(h, face->num_glyphs);
+	h = hash_mix(h, face->face_index);
+	h = hash_mix(h, face->units_per_EM);
+	h = hash_mix(h, face->face_flags);
+	h = hash_mix(h, (uint32_t) face->ascender << 16 | (uint16_t) face->descender);
+	h = hash_mix(h, face->size->metrics.x_ppem << 16 | face->size->metrics.y_ppem);
+	h = hash_mix(h, font->ptsize);
+	h = hash_mix(h, (uint32_t) font->ascent << 16 | (uint16_t) font->height);
+	return h;
+}
+
+static bool key_eq(struct glyph_key* a, struct glyph_key* b)
+{
+	return a->face == b->face && a->ch == b->ch && a->style == b->style &&
+		a->outline == b->outline && a->hinting == b->hinting &&
+		a->by_ind == b->by_ind;
+}
+
+static uint32_t key_bucket(struct glyph_key* key)
+{
+	uint64_t h = hash_mix(key->face, key->ch);
+	h = hash_mix(h, (uint64_t)key->style << 32 | (uint32_t)key->outline);
+	h = hash_mix(h, (uint64_t)key->hinting << 1 | key->by_ind);
+	return h % GLYPH_CACHE_BUCKETS;
+}
+
+static void gcache_free(struct glyph_cache* cache)
+{
+	if (!cache->entries)
+		return;
 
-	for( i = 0; i < size; ++i ) {
-		if( font->cache[i].cached ) {
-			Flush_Glyph( &font->cache[i] );
+	for (size_t i = 0; i < cache->used; i++)
+		if (cache->entries[i].live)
+			Flush_Glyph(&cache->entries[i].glyph);
+
+	free(cache->entries);
+	free(cache->buckets);
+	cache->entries = NULL;
+	cache->buckets = NULL;
+}
+
+static void gcache_exit(void* cache)
+{
+	gcache_free(cache);
+}
+
+static void gcache_key()
+{
+	pthread_key_create(&gcache_owner, gcache_exit);
+}
+
+static bool gcache_init()
+{
+	pthread_once(&gcache_once, gcache_key);
+
+	gcache.entries = calloc(TTF_GLYPH_CACHE_LIMIT, sizeof(struct glyph_entry));
+	gcache.buckets = malloc(GLYPH_CACHE_BUCKETS * sizeof(uint32_t));
+	if (!gcache.entries || !gcache.buckets){
+		free(gcache.entries);
+		free(gcache.buckets);
+		gcache.entries = NULL;
+		gcache.buckets = NULL;
+		return false;
+	}
+
+	for (size_t i = 0; i < GLYPH_CACHE_BUCKETS; i++)
+		gcache.buckets[i] = GLYPH_NONE;
+
+	gcache.head = gcache.tail = gcache.free = GLYPH_NONE;
+	gcache.used = 0;
+
+/* so that threads that never call TTF_Quit don't leak their cache */
+	pthread_setspecific(gcache_owner, &gcache);
+	return true;
+}
+
+static void lru_unlink(uint32_t i)
+{
+	struct glyph_entry* ent = &gcache.entries[i];
+
+	if (ent->prev != GLYPH_NONE)
+		gcache.entries[ent->prev].next = ent->next;
+	else
+		gcache.head = ent->next;
+
+	if (ent->next != GLYPH_NONE)
+		gcache.entries[ent->next].prev = ent->prev;
+	else
+		gcache.tail = ent->prev;
+}
+
+static void lru_push(uint32_t i)
+{
+	struct glyph_entry* ent = &gcache.entries[i];
+	ent->prev = GLYPH_NONE;
+	ent->next = gcache.head;
+
+	if (gcache.head != GLYPH_NONE)
+		gcache.entries[gcache.head].prev = i;
+	else
+		gcache.tail = i;
+
+	gcache.head = i;
+}
+
+static void gcache_drop(uint32_t i)
+{
+	struct glyph_entry* ent = &gcache.entries[i];
+	uint32_t* cur = &gcache.buckets[key_bucket(&ent->key)];
+
+	while (*cur != i)
+		cur = &gcache.entries[*cur].chain;
+	*cur = ent->chain;
+
+	lru_unlink(i);
+	Flush_Glyph(&ent->glyph);
+	ent->live = false;
+	ent->chain = gcache.free;
+	gcache.free = i;
+}
+
+static struct glyph_entry* gcache_get(TTF_Font* font, uint32_t ch, bool by_ind)
+{
+	if (!gcache.entries && !gcache_init())
+		return NULL;
+
+	struct glyph_key key = {
+		.face = font->cache_key,
+		.ch = ch,
+		.style = font->style & ~TTF_STYLE_NO_GLYPH_CHANGE,
+		.outline = font->outline,
+		.hinting = font->hinting,
+		.by_ind = by_ind
+	};
+
+	uint32_t bucket = key_bucket(&key);
+	for (uint32_t i = gcache.buckets[bucket];
+		i != GLYPH_NONE; i = gcache.entries[i].chain){
+		if (!key_eq(&gcache.entries[i].key, &key))
+			continue;
+
+		if (gcache.head != i){
+			lru_unlink(i);
+			lru_push(i);
 		}
+		return &gcache.entries[i];
+	}
 
+	uint32_t i;
+	if (gcache.free != GLYPH_NONE){
+		i = gcache.free;
+		gcache.free = gcache.entries[i].chain;
 	}
+	else if (gcache.used < TTF_GLYPH_CACHE_LIMIT)
+		i = gcache.used++;
+	else {
+		i = gcache.tail;
+		gcache_drop(i);
+		gcache.free = gcache.entries[i].chain;
+	}
+
+	struct glyph_entry* ent = &gcache.entries[i];
+	*ent = (struct glyph_entry){
+		.key = key,
+		.live = true,
+		.chain = gcache.buckets[bucket]
+	};
+	gcache.buckets[bucket] = i;
+	lru_push(i);
+
+	return ent;
+}
+
+static void gcache_release()
+{
+	if (!gcache.entries)
+		return;
+
+	gcache_free(&gcache);
+	pthread_setspecific(gcache_owner, NULL);
+}
+
+/*
+ * The cache key covers style, outline and hinting so changing those does
+ * not require a flush, this is for dropping everything rendered from a face.
+ */
+void TTF_Flush_Cache( TTF_Font* font )
+{
+	Flush_Glyph(&font->scratch);
+
+	if (!gcache.entries)
+		return;
+
+	for (size_t i = 0; i < gcache.used; i++)
+		if (gcache.entries[i].live && gcache.entries[i].key.face == font->cache_key)
+			gcache_drop(i);
 }
 
 static FT_Error Load_Glyph(
@@ -835,18 +1119,28 @@ static FT_Error Load_Glyph(
 static FT_Error Find_Glyph(
 	TTF_Font* font, uint32_t ch, int want, bool by_ind)
 {
-	int retval = 0;
-	int hsize = sizeof( font->cache ) / sizeof( font->cache[0] );
+	struct glyph_entry* ent = gcache_get(font, ch, by_ind);
+	if (!ent){
+		font->current = &font->scratch;
+		Flush_Glyph( font->current );
+		return Load_Glyph( font, ch, font->current, want, by_ind );
+	}
 
-	int h = ch % hsize;
-	font->current = &font->cache[h];
+	font->current = &ent->glyph;
+	if (ent->missing)
+		return -1;
 
-	if (font->current->cached != ch)
-		Flush_Glyph( font->current );
+	if ( (ent->glyph.stored & want) == want )
+		return 0;
 
-	if ( (font->current->stored & want) != want ) {
-		retval = Load_Glyph( font, ch, font->current, want, by_ind );
+	FT_Error retval = Load_Glyph( font, ch, &ent->glyph, want, by_ind );
+	if (retval){
+		if (0 == ent->glyph.index)
+			ent->missing = true;
+		else
+			gcache_drop(ent - gcache.entries);
 	}
+
 	return retval;
 }
 
@@ -866,7 +1160,8 @@ TTF_Font* TTF_FindGlyph(
 void TTF_CloseFont( TTF_Font* font )
 {
 	if ( font ) {
-		TTF_Flush_Cache( font );
+/* cached glyphs are kept, the same face is likely to be opened again */
+		Flush_Glyph( &font->scratch );
 		if ( font->face ) {
 			FT_Done_Face( font->face );
 		}
@@ -1045,15 +1340,8 @@ int TTF_GlyphMetrics(TTF_Font *font, uint32_t ch,
 
 void TTF_SetFontStyle( TTF_Font* font, int style )
 {
-	int prev_style = font->style;
+	/* The glyph cache is keyed on style, no need to flush */
 	font->style = style | font->face_style;
-
-	/* Flush the cache if the style has changed.
-	* Ignore UNDERLINE which does not impact glyph drawning.
-	* */
-	if ( (font->style | TTF_STYLE_NO_GLYPH_CHANGE ) != ( prev_style | TTF_STYLE_NO_GLYPH_CHANGE )) {
-		TTF_Flush_Cache( font );
-	}
 }
 
 _Thread_local static size_t pool_cnt;
@@ -1287,6 +1575,180 @@ static inline av_pixel pack_subpx(uint8_t fg[4],
 		return PACK(fg[0], fg[1], fg[2], 0xff);
 }
 
+/*
+ * Vectorized versions of the pack_ functions above, 4 pixels at a time. They
+ * work on the packed PIXEL as bytes so they are independent of the channel
+ * order the PACK macro produces, only the alpha lane is special. The result
+ * matches the scalar versions exactly, the caller handles what is left over.
+ */
+struct blend_state {
+	PIXEL fg;
+	PIXEL bg;
+	PIXEL amask;
+	uint8_t bga;
+	bool usebg;
+};
+
+static void blend_setup(struct blend_state* bs,
+	uint8_t fg[4], uint8_t bg[4], bool usebg)
+{
+	bs->fg = PACK(fg[0], fg[1], fg[2], 0xff);
+	bs->bg = PACK(bg[0], bg[1], bg[2], bg[3]);
+	bs->amask = PACK(0, 0, 0, 0xff);
+	bs->bga = bg[3];
+	bs->usebg = usebg;
+}
+
+#ifdef __SSE2__
+static inline __m128i div255_epu16(__m128i v)
+{
+	v = _mm_add_epi16(v, _mm_set1_epi16(0x80));
+	return _mm_srli_epi16(_mm_add_epi16(v, _mm_srli_epi16(v, 8)), 8);
+}
+
+/*
+ * [cov] is the packed coverage (r, g, b, a) for subpixel glyphs and the
+ * alpha repeated in every lane for grayscale ones, [arep] has the alpha
+ * repeated in every lane.
+ */
+static inline __m128i blend4(__m128i dst, __m128i cov, __m128i arep,
+	const struct blend_state* bs, bool subpx)
+{
+	const __m128i zero = _mm_setzero_si128();
+	__m128i amask = _mm_set1_epi32(bs->amask);
+	__m128i fg = _mm_set1_epi32(bs->fg);
+	__m128i fg_lo = _mm_unpacklo_epi8(fg, zero);
+
+	__m128i nfg_lo = fg_lo;
+	__m128i nfg_hi = fg_lo;
+	if (subpx){
+		nfg_lo = div255_epu16(
+			_mm_mullo_epi16(_mm_unpacklo_epi8(cov, zero), fg_lo));
+		nfg_hi = div255_epu16(
+			_mm_mullo_epi16(_mm_unpackhi_epi8(cov, zero), fg_lo));
+	}
+
+	if (!bs->usebg){
+		__m128i col = _mm_or_si128(
+			_mm_andnot_si128(amask, _mm_packus_epi16(nfg_lo, nfg_hi)),
+			_mm_and_si128(amask, arep)
+		);
+		__m128i keep = _mm_cmpeq_epi32(cov, zero);
+		return _mm_or_si128(
+			_mm_and_si128(keep, dst), _mm_andnot_si128(keep, col));
+	}
+
+	__m128i bg_lo = _mm_unpacklo_epi8(_mm_set1_epi32(bs->bg), zero);
+	__m128i a_lo = _mm_unpacklo_epi8(arep, zero);
+	__m128i a_hi = _mm_unpackhi_epi8(arep, zero);
+	__m128i ia_lo = _mm_sub_epi16(_mm_set1_epi16(255), a_lo);
+	__m128i ia_hi = _mm_sub_epi16(_mm_set1_epi16(255), a_hi);
+
+	__m128i lo = div255_epu16(_mm_add_epi16(
+		_mm_mullo_epi16(a_lo, nfg_lo), _mm_mullo_epi16(ia_lo, bg_lo)));
+	__m128i hi = div255_epu16(_mm_add_epi16(
+		_mm_mullo_epi16(a_hi, nfg_hi), _mm_mullo_epi16(ia_hi, bg_lo)));
+
+/* pack_pixel_bg keeps the background alpha if a < 2 * bg alpha,
+ * except for full coverage */
+	__m128i alpha = arep;
+	if (bs->bga){
+		int lim = bs->bga * 2 > 256 ? 256 : bs->bga * 2;
+		__m128i tm1 = _mm_set1_epi8((char)(lim - 1));
+		__m128i lt = _mm_cmpeq_epi8(_mm_max_epu8(arep, tm1), tm1);
+		alpha = _mm_or_si128(
+			_mm_and_si128(lt, _mm_set1_epi8((char)bs->bga)),
+			_mm_andnot_si128(lt, arep)
+		);
+	}
+	alpha = _mm_or_si128(alpha, _mm_cmpeq_epi8(arep, _mm_set1_epi8((char)0xff)));
+
+	return _mm_or_si128(
+		_mm_andnot_si128(amask, _mm_packus_epi16(lo, hi)),
+		_mm_and_si128(amask, alpha)
+	);
+}
+
+static inline __m128i repeat_alpha(const uint8_t a[4])
+{
+	uint32_t v;
+	memcpy(&v, a, 4);
+	__m128i res = _mm_cvtsi32_si128(v);
+	res = _mm_unpacklo_epi8(res, res);
+	return _mm_unpacklo_epi16(res, res);
+}
+
+/* returns the number of pixels written, a multiple of 4 */
+static size_t blend_gray(PIXEL* out,
+	const uint8_t* src, size_t n, const struct blend_state* bs)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		__m128i arep = repeat_alpha(&src[i]);
+		__m128i dst = bs->usebg ?
+			arep : _mm_loadu_si128((__m128i*) &out[i]);
+		_mm_storeu_si128((__m128i*) &out[i], blend4(dst, arep, arep, bs, false));
+	}
+	return i;
+}
+
+/*
+ * subpixel coverage for pixel i is at src[i * px], with the b, g and r
+ * samples [ch] bytes apart (horizontal or vertical LCD layout).
+ */
+static size_t blend_lcd(PIXEL* out, const uint8_t* src,
+	size_t px, size_t ch, size_t n, const struct blend_state* bs)
+{
+	size_t i = 0;
+	for (; i + 4 <= n; i += 4){
+		PIXEL cov[4];
+		uint8_t a[4];
+
+		for (size_t j = 0; j < 4; j++){
+			const uint8_t* s = &src[(i + j) * px];
+			uint8_t b = s[0];
+			uint8_t g = s[ch];
+			uint8_t r = s[ch * 2];
+			a[j] = (r + g + b) / 3;
+			cov[j] = PACK(r, g, b, a[j]);
+		}
+
+		__m128i cv = _mm_loadu_si128((__m128i*) cov);
+		__m128i dst = bs->usebg ? cv : _mm_loadu_si128((__m128i*) &out[i]);
+		_mm_storeu_si128((__m128i*) &out[i],
+			blend4(dst, cv, repeat_alpha(a), bs, true));
+	}
+	return i;
+}
+#else
+static size_t blend_gray(PIXEL* out,
+	const uint8_t* src, size_t n, const struct blend_state* bs)
+{
+	return 0;
+}
+
+static size_t blend_lcd(PIXEL* out, const uint8_t* src,
+	size_t px, size_t ch, size_t n, const struct blend_state* bs)
+{
+	return 0;
+}
+#endif
+
+/* number of pixels the blit loops in render_unicode may touch on a row */
+static size_t span_limit(PIXEL* out, PIXEL* ubound, int gwidth, size_t width)
+{
+	if (gwidth <= 0 || out >= ubound)
+		return 0;
+
+	size_t n = gwidth;
+	if (n > width)
+		n = width;
+	if (n > (size_t)(ubound - out))
+		n = ubound - out;
+
+	return n;
+}
+
 static void yfill(PIXEL* dst, PIXEL clr, int yfill, int w, int h, int stride)
 {
 	for (int br = 0, ur = h-1; br < yfill; br++, ur--){
@@ -1312,6 +1774,9 @@ static bool render_unicode(
 	c_glyph* glyph = outf->current;
 	*advance = glyph->advance;
 
+	struct blend_state bs;
+	blend_setup(&bs, fg, bg, usebg);
+
 	int gwidth = 0;
 	/* Ensure the width of the pixmap is correct. On some cases,
  * freetype may report a larger pixmap than possible.*/
@@ -1419,7 +1884,12 @@ static bool render_unicode(
 			uint8_t* src = (uint8_t*)(glyph->pixmap.buffer+glyph->pixmap.pitch*row);
 			out = out < dst ? dst : out;
 
-			for (int col = 0; col < gwidth && col < width && out < ubound; col++){
+			int col = blend_lcd(out, src, 3, 1,
+				span_limit(out, ubound, gwidth, width), &bs);
+			out += col;
+			src += col * 3;
+
+			for (; col < gwidth && col < width && out < ubound; col++){
 				uint8_t b = *src++;
 				uint8_t g = *src++;
 				uint8_t r = *src++;
@@ -1442,7 +1912,12 @@ static bool render_unicode(
 			uint8_t* src = (uint8_t*)(glyph->pixmap.buffer+(glyph->pixmap.pitch*3)*row);
 			out = out < dst ? dst : out;
 
-			for (int col = 0; col < gwidth && col < width && out < ubound; col++){
+			int col = blend_lcd(out, src, 1, glyph->pixmap.pitch,
+				span_limit(out, ubound, gwidth, width), &bs);
+			out += col;
+			src += col;
+
+			for (; col < gwidth && col < width && out < ubound; col++, src++){
 				uint8_t b = *src;
 				uint8_t g = *(src + glyph->pixmap.pitch);
 				uint8_t r = *(src + glyph->pixmap.pitch + glyph->pixmap.pitch);
@@ -1467,8 +1942,17 @@ static bool render_unicode(
 		PIXEL* out = &dst[(row+glyph->yoffset)*stride+(*xstart+glyph->minx)];
 		uint8_t* src = (uint8_t*)(glyph->pixmap.buffer+glyph->pixmap.pitch * row);
 		out = out < dst ? dst : out;
-		for (int col = 0; col < gwidth && col < width && out < ubound; col++){
-			uint8_t a = *src++;
+
+/* the metrics can be wider than the pixmap (mono hinting with bold),
+ * treat the missing columns as uncovered rather than reading past it */
+		int pw = glyph->pixmap.width;
+		int col = blend_gray(out, src,
+			span_limit(out, ubound, gwidth < pw ? gwidth : pw, width), &bs);
+		out += col;
+		src += col;
+
+		for (; col < gwidth && col < width && out < ubound; col++){
+			uint8_t a = col < pw ? *src++ : 0;
 			if (usebg)
 				*out++ = pack_pixel_bg(fg, bg, a);
 			else if (a)
@@ -1571,7 +2055,6 @@ int TTF_GetFontStyle( const TTF_Font* font )
 void TTF_SetFontOutline( TTF_Font* font, int outline )
 {
 	font->outline = outline;
-	TTF_Flush_Cache( font );
 }
 
 int TTF_GetFontOutline( const TTF_Font* font )
@@ -1593,8 +2076,6 @@ void TTF_SetFontHinting( TTF_Font* font, int hinting )
 		font->hinting = FT_RENDER_MODE_LCD_V;
 	else
 		font->hinting = FT_RENDER_MODE_NORMAL;
-
-	TTF_Flush_Cache( font );
 }
 
 int TTF_GetFontHinting( const TTF_Font* font )
@@ -1617,6 +2098,7 @@ void TTF_Quit( void )
 {
 	if ( TTF_initialized ) {
 		if ( --TTF_initialized == 0 ) {
+			gcache_release();
 			FT_Done_FreeType( library );
 		}
 	}
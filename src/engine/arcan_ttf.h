@@ -187,6 +187,11 @@ bool TTF_RenderUNICODEglyph(PIXEL* dst,
 	int* advance, unsigned* prev_index
 );
 
+/*
+ * Glyphs are cached per thread across all open fonts, keyed on the face,
+ * size, style, outline, hinting and codepoint (see TTF_GLYPH_CACHE_LIMIT).
+ * This drops all cached glyphs that were rendered from the face of [font].
+ */
 void TTF_Flush_Cache( TTF_Font* font );
 
 /*
@@ -25,6 +25,7 @@
 
 #include <pthread.h>
 #include <semaphore.h>
+#include <stdatomic.h>
 
 #define CLAMP(x, l, h) (((x) > (h)) ? (h) : (((x) < (l)) ? (l) : (x)))
 
@@ -32,6 +33,23 @@
 #define ASYNCH_CONCURRENT_THREADS 12
 #endif
 
+/* pending asynchronous image loads beyond this are decoded on submission */
+#ifndef ASYNCH_QUEUE_LIMIT
+#define ASYNCH_QUEUE_LIMIT 1024
+#endif
+
+/* decoded buffers from cancelled loads kept for reuse as rescale targets */
+#ifndef ASYNCH_RECYCLE_LIMIT
+#define ASYNCH_RECYCLE_LIMIT 8
+#endif
+
+/* upper bound for the number of threads building rendertarget draw lists,
+ * the effective number is also limited by the number of online cores and
+ * can be lowered (0 to disable) with ARCAN_VIDEO_RTGT_THREADS */
+#ifndef RTGT_BUILD_THREADS
+#define RTGT_BUILD_THREADS 8
+#endif
+
 #include PLATFORM_HEADER
 
 #include "arcan_shmif.h"
@@ -59,7 +77,76 @@
 
 long long ARCAN_VIDEO_WORLDID = -1;
 static surface_properties empty_surface();
-static sem_handle asynchsynch;
+/* output of the (possibly threaded) decode step of an image load */
+struct image_decode {
+	av_pixel* buf;
+	size_t buf_sz;
+	size_t w, h;
+	size_t origw, origh;
+	bool compressed;
+};
+
+enum asynch_state {
+	ASYNCH_QUEUED = 0,
+	ASYNCH_RUNNING,
+	ASYNCH_DONE
+};
+
+/*
+ * One pending loadimage_asynch, referenced from feed.state.ptr of the vobject.
+ * The worker threads only ever look at the job, everything needed to decode is
+ * captured when it is submitted and the result is applied on the main thread.
+ */
+struct asynch_job {
+	arcan_vobj_id dstid;
+	char* fname;
+	intptr_t tag;
+	int prio;
+	uint64_t seq;
+
+	img_cons forced;
+	enum arcan_vimage_mode scale;
+	bool fliph;
+
+/* protected by asynch.lock */
+	enum asynch_state state;
+	bool cancelled;
+	struct asynch_job* next;
+
+	arcan_errc rc;
+	struct image_decode img;
+};
+
+/*
+ * Fixed pool of decode threads (spawned on first use) that pull from a bounded
+ * queue ordered on priority, then on submission. Finished jobs are chained on
+ * the done- list and collected by arcan_video_tick.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t finished;
+	bool init;
+	size_t n_threads;
+
+	struct asynch_job* queue[ASYNCH_QUEUE_LIMIT];
+	size_t n_queued;
+	size_t n_running;
+	uint64_t seq;
+
+	struct asynch_job* done_first;
+	struct asynch_job* done_last;
+
+	struct {
+		av_pixel* buf;
+		size_t sz;
+	} recycle[ASYNCH_RECYCLE_LIMIT];
+	size_t n_recycle;
+} asynch = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.finished = PTHREAD_COND_INITIALIZER
+};
 
 /* these match arcan_vinterpolant enum */
 static arcan_interp_3d_function lut_interp_3d[] = {
@@ -119,13 +206,21 @@ unsigned vcontext_ind = 0;
 static bool detach_fromtarget(struct rendertarget* dst, arcan_vobject* src);
 static void attach_object(struct rendertarget* dst, arcan_vobject* src);
 static arcan_errc update_zv(arcan_vobject* vobj, int newzv);
+static void video_releaseid(struct arcan_video_context* ctx, arcan_vobj_id id);
 static void rebase_transform(struct surface_transform*, int64_t);
+static void asynch_drain();
+static void tfactive_add(struct arcan_video_context*, arcan_vobject*);
+static void tfactive_remove(struct arcan_video_context*, arcan_vobject*);
 static size_t process_rendertarget(struct rendertarget*, float);
 static arcan_vobject* new_vobject(arcan_vobj_id* id,
 struct arcan_video_context* dctx);
 static inline void build_modelview(float* dmatr,
 	float* imatr, surface_properties* prop, arcan_vobject* src);
 static inline void process_readback(struct rendertarget* tgt, float fract);
+static void pick_mark(arcan_vobject* vobj);
+static void pick_attach(struct rendertarget* tgt, arcan_vobject* vobj);
+static void pick_detach(struct rendertarget* tgt, arcan_vobject* vobj);
+static void pick_drop(struct rendertarget* tgt);
 
 static inline void trace(const char* msg, ...)
 {
@@ -254,6 +349,7 @@ static void invalidate_cache(arcan_vobject* vobj)
 		return;
 
 	vobj->valid_cache = false;
+	pick_mark(vobj);
 
 	for (size_t i = 0; i < vobj->childslots; i++)
 		if (vobj->children[i])
@@ -278,6 +374,10 @@ static void dropchild(arcan_vobject* parent, arcan_vobject* child)
 static void deallocate_gl_context(
 	struct arcan_video_context* context, bool del, struct agp_vstore* safe_store)
 {
+/* let the pool finish all pending decodes first, the joins below then only
+ * have to apply the results */
+	asynch_drain();
+
 /* index (0) is always worldid */
 	for (size_t i = 1; i < context->vitem_limit; i++){
 		if (FL_TEST(&(context->vitems_pool[i]), FL_INUSE)){
@@ -305,8 +405,14 @@ static void deallocate_gl_context(
 
 /* pool is dynamically sized and size is set on layer push */
 	if (del){
+		pick_drop(&context->stdoutp);
 		arcan_mem_free(context->vitems_pool);
 		context->vitems_pool = NULL;
+		arcan_mem_free(context->vfree);
+		context->vfree = context->vfree_sum = NULL;
+		arcan_mem_free(context->tfactive);
+		context->tfactive = NULL;
+		context->tfactive_count = context->tfactive_limit = 0;
 	}
 }
 
@@ -365,7 +471,7 @@ static void reallocate_gl_context(struct arcan_video_context* context)
 					char* fname = strdup( current->vstore->vinf.text.source );
 					arcan_mem_free(current->vstore->vinf.text.source);
 				arcan_vint_getimage(fname,
-					current, (img_cons){.w = current->origw, .h = current->origh}, false);
+					current, (img_cons){.w = current->origw, .h = current->origh});
 				arcan_mem_free(fname);
 			}
 			else
@@ -422,6 +528,9 @@ static void push_transfer_persists(
 		memcpy(dstobj, srcobj, sizeof(arcan_vobject));
 		dst->nalive++; /* fake allocate */
 		dstobj->parent = &dst->world; /* don't cross- reference worlds */
+		dstobj->tfslot = 0;
+		if (dstobj->transform)
+			tfactive_add(dst, dstobj);
 		attach_object(&dst->stdoutp, dstobj);
 		trace("vcontext_stack_push() : transfer-attach: %s\n", srcobj->tracetag);
 	}
@@ -451,7 +560,11 @@ static void pop_transfer_persists(
 		memcpy(dstobj, srcobj, sizeof(arcan_vobject));
 		attach_object(&dst->stdoutp, dstobj);
 		dstobj->parent = parent;
+		dstobj->tfslot = 0;
+		if (dstobj->transform)
+			tfactive_add(dst, dstobj);
 		memset(srcobj, '\0', sizeof(arcan_vobject));
+		video_releaseid(src, i);
 	}
 }
 
@@ -627,6 +740,18 @@ signed arcan_video_pushcontext()
 
 	current_context = &vcontext_stack[ vcontext_ind ];
 	current_context->stdoutp.first = NULL;
+
+/* the pick indices belong to the context below, these are rebuilt lazily */
+	current_context->stdoutp.pick = NULL;
+	for (size_t i = 0; i < RENDERTARGET_LIMIT; i++)
+		current_context->rtargets[i].pick = NULL;
+
+	current_context->vfree = current_context->vfree_sum = NULL;
+	current_context->tfactive = NULL;
+	current_context->tfactive_count = current_context->tfactive_limit = 0;
+	memset(&current_context->vstats, '\0', sizeof(current_context->vstats));
+	memset(current_context->stdoutp.skip, '\0',
+		sizeof(current_context->stdoutp.skip));
 	current_context->vitem_ofs = 1;
 	current_context->nalive = 0;
 
@@ -643,6 +768,8 @@ signed arcan_video_pushcontext()
 	);
 
 	current_context->rtargets[0].first = NULL;
+	memset(current_context->rtargets[0].skip, '\0',
+		sizeof(current_context->rtargets[0].skip));
 
 /* propagate persistent flagged objects upwards */
 	push_transfer_persists(
@@ -912,31 +1039,141 @@ static inline surface_properties empty_surface()
 	return res;
 }
 
+/*
+ * Vids are handed out from a two-level bitmap of free slots instead of
+ * scanning the pool for one without FL_INUSE. Slot 0 (world) and the last
+ * slot are never marked as available.
+ */
+static void vfree_build(struct arcan_video_context* ctx)
+{
+	size_t words = (ctx->vitem_limit + 63) / 64;
+	size_t sum_words = (words + 63) / 64;
+
+	arcan_mem_free(ctx->vfree);
+	ctx->vfree = arcan_alloc_mem(sizeof(uint64_t) * (words + sum_words),
+		ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
+	ctx->vfree_sum = &ctx->vfree[words];
+	ctx->vfree_pool = ctx->vitems_pool;
+	ctx->vfree_lim = ctx->vitem_limit;
+	ctx->vstats.used = 0;
+
+	for (size_t i = 1; i + 1 < ctx->vitem_limit; i++){
+		if (FL_TEST(&ctx->vitems_pool[i], FL_INUSE)){
+			ctx->vstats.used++;
+			continue;
+		}
+
+		ctx->vfree[i >> 6] |= 1ull << (i & 63);
+		ctx->vfree_sum[i >> 12] |= 1ull << ((i >> 6) & 63);
+	}
+
+	if (ctx->vstats.used > ctx->vstats.peak)
+		ctx->vstats.peak = ctx->vstats.used;
+}
+
+static inline bool vfree_valid(struct arcan_video_context* ctx)
+{
+	return ctx->vfree &&
+		ctx->vfree_pool == ctx->vitems_pool && ctx->vfree_lim == ctx->vitem_limit;
+}
+
+static inline void vfree_mark(
+	struct arcan_video_context* ctx, size_t i, bool avail)
+{
+	size_t w = i >> 6;
+
+	if (avail){
+		ctx->vfree[w] |= 1ull << (i & 63);
+		ctx->vfree_sum[w >> 6] |= 1ull << (w & 63);
+	}
+	else {
+		ctx->vfree[w] &= ~(1ull << (i & 63));
+		if (!ctx->vfree[w])
+			ctx->vfree_sum[w >> 6] &= ~(1ull << (w & 63));
+	}
+}
+
+/* first available slot >= start, 0 if there is none */
+static size_t vfree_find(struct arcan_video_context* ctx, size_t start)
+{
+	size_t words = (ctx->vitem_limit + 63) / 64;
+	size_t sum_words = (words + 63) / 64;
+	size_t w = start >> 6;
+
+	if (w >= words)
+		return 0;
+
+	uint64_t bits = ctx->vfree[w] & (~0ull << (start & 63));
+	if (bits)
+		return (w << 6) + __builtin_ctzll(bits);
+
+/* then the summary for the next word that has anything available */
+	w++;
+	size_t sw = w >> 6;
+	if (sw >= sum_words)
+		return 0;
+
+	uint64_t sum = ctx->vfree_sum[sw] & (~0ull << (w & 63));
+	for (;;){
+		if (sum){
+			size_t fw = (sw << 6) + __builtin_ctzll(sum);
+			return (fw << 6) + __builtin_ctzll(ctx->vfree[fw]);
+		}
+
+		if (++sw >= sum_words)
+			return 0;
+		sum = ctx->vfree_sum[sw];
+	}
+}
+
 static arcan_vobj_id video_allocid(
 	bool* status, struct arcan_video_context* ctx, bool write)
 {
-	unsigned i = ctx->vitem_ofs, c = ctx->vitem_limit;
 	*status = false;
 
-	while (c--){
-		if (i == 0) /* 0 is protected */
-			i = 1;
+	if (!vfree_valid(ctx))
+		vfree_build(ctx);
 
-		if (!FL_TEST(&ctx->vitems_pool[i], FL_INUSE)){
-			*status = true;
-			if (!write)
-				return i;
+/* continue from the last allocation rather than take the lowest, so that a
+ * recently deleted vid isn't handed out again right away */
+	size_t i = vfree_find(ctx, ctx->vitem_ofs);
+	if (!i)
+		i = vfree_find(ctx, 1);
 
-			ctx->nalive++;
-			FL_SET(&ctx->vitems_pool[i], FL_INUSE);
-			ctx->vitem_ofs = (ctx->vitem_ofs + 1) >= ctx->vitem_limit ? 1 : i + 1;
-			return i;
-		}
+	if (!i)
+		return ARCAN_EID;
 
-		i = (i + 1) % (ctx->vitem_limit - 1);
+/* slot was taken behind our back, resynch and try again */
+	if (FL_TEST(&ctx->vitems_pool[i], FL_INUSE)){
+		arcan_warning("[bug] vid (%zu) in use but marked as free\n", i);
+		vfree_build(ctx);
+		return video_allocid(status, ctx, write);
 	}
 
-	return ARCAN_EID;
+	*status = true;
+	if (!write)
+		return i;
+
+	ctx->nalive++;
+	FL_SET(&ctx->vitems_pool[i], FL_INUSE);
+	vfree_mark(ctx, i, false);
+	ctx->vitem_ofs = (i + 1) >= ctx->vitem_limit ? 1 : i + 1;
+
+	ctx->vstats.allocs++;
+	if (++ctx->vstats.used > ctx->vstats.peak)
+		ctx->vstats.peak = ctx->vstats.used;
+
+	return i;
+}
+
+static void video_releaseid(struct arcan_video_context* ctx, arcan_vobj_id id)
+{
+	if (!vfree_valid(ctx) || id <= 0 || id + 1 >= ctx->vitem_limit)
+		return;
+
+	vfree_mark(ctx, id, true);
+	ctx->vstats.frees++;
+	ctx->vstats.used--;
 }
 
 arcan_errc arcan_video_resampleobject(arcan_vobj_id vid,
@@ -1214,9 +1451,114 @@ arcan_vobject* arcan_video_getobject(arcan_vobj_id id)
 	return rc;
 }
 
+/*
+ * Attachment list nodes are carved out of slabs and recycled through a
+ * free-list rather than allocated per attach. This keeps order churn (raise
+ * on focus, particle systems) away from the allocator and the nodes of a
+ * list close together. Slabs are retained for the lifetime of the process.
+ *
+ * Nodes are only as large as their number of express lanes, so there is one
+ * free-list per lane count. Three out of four nodes have no lanes at all and
+ * each lane is a quarter as likely as the one below, the slabs shrink to match.
+ */
+#ifndef LITEM_SLAB
+#define LITEM_SLAB 256
+#endif
+
+static struct {
+	arcan_vobject_litem* free[LITEM_SKIP_LEVELS+1];
+	uint32_t seed;
+} litem_pool = {
+	.seed = 0x9e3779b9
+};
+
+static inline size_t litem_size(uint8_t levels)
+{
+	return sizeof(arcan_vobject_litem) + sizeof(arcan_vobject_litem*) * levels;
+}
+
+static arcan_vobject_litem* litem_alloc(uint8_t levels)
+{
+	size_t sz = litem_size(levels);
+
+	if (!litem_pool.free[levels]){
+		size_t n = LITEM_SLAB >> (2 * levels);
+		n = n < 8 ? 8 : n;
+
+		uint8_t* slab = arcan_alloc_mem(sz * n,
+			ARCAN_MEM_VSTRUCT, 0, ARCAN_MEMALIGN_NATURAL);
+
+		for (size_t i = n; i > 0; i--){
+			arcan_vobject_litem* cur = (arcan_vobject_litem*) &slab[(i-1) * sz];
+			cur->next = litem_pool.free[levels];
+			litem_pool.free[levels] = cur;
+		}
+	}
+
+	arcan_vobject_litem* res = litem_pool.free[levels];
+	litem_pool.free[levels] = res->next;
+	memset(res, '\0', sz);
+	res->levels = levels;
+	return res;
+}
+
+static void litem_release(arcan_vobject_litem* item)
+{
+	item->next = litem_pool.free[item->levels];
+	litem_pool.free[item->levels] = item;
+}
+
+/* number of express lanes for a new node, p = 1/4 per lane */
+static uint8_t litem_levels()
+{
+	uint32_t x = litem_pool.seed;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	litem_pool.seed = x;
+
+	uint8_t lvl = 0;
+	while (lvl < LITEM_SKIP_LEVELS && (x & 3) == 0){
+		lvl++;
+		x >>= 2;
+	}
+
+	return lvl;
+}
+
+/* the forward link of [at] in lane [lvl], NULL at is the list head */
+static inline arcan_vobject_litem** litem_lane(
+	struct rendertarget* dst, arcan_vobject_litem* at, size_t lvl)
+{
+	if (lvl == 0)
+		return at ? &at->next : &dst->first;
+
+	return at ? &at->skip[lvl-1] : &dst->skip[lvl-1];
+}
+
+/*
+ * Fill [pred] with the last node in each lane that sorts before [order], NULL
+ * meaning the head. With [inclusive] equal orders are passed as well, which
+ * gives the insertion point as new attachments go after their equals.
+ */
+static void litem_find(struct rendertarget* dst, int order,
+	bool inclusive, arcan_vobject_litem* pred[LITEM_SKIP_LEVELS+1])
+{
+	arcan_vobject_litem* at = NULL;
+
+	for (ssize_t lvl = LITEM_SKIP_LEVELS; lvl >= 0; lvl--){
+		arcan_vobject_litem* next;
+		while ((next = *litem_lane(dst, at, lvl)) && (next->elem->order < order ||
+			(inclusive && next->elem->order == order)))
+			at = next;
+		pred[lvl] = at;
+	}
+}
+
 static bool detach_fromtarget(struct rendertarget* dst, arcan_vobject* src)
 {
 	arcan_vobject_litem* torem;
+	arcan_vobject_litem* pred[LITEM_SKIP_LEVELS+1];
 	assert(src);
 
 /* already detached? */
@@ -1239,17 +1581,28 @@ static bool detach_fromtarget(struct rendertarget* dst, arcan_vobject* src)
 	if (dst->camtag == src->cellid)
 		dst->camtag = ARCAN_EID;
 
-/* find it */
-	torem = dst->first;
-	while(torem){
-		if (torem->elem == src)
-			break;
-
+/* find it, the lanes take us to the first node with the same order, as
+ * update_zv re-sorts every attachment the order is always current and if
+ * it isn't there it isn't attached */
+	litem_find(dst, src->order, false, pred);
+	torem = pred[0] ? pred[0]->next : dst->first;
+	while (torem && torem->elem != src && torem->elem->order == src->order)
 		torem = torem->next;
-	}
-	if (!torem)
+
+	if (!torem || torem->elem != src)
 		return false;
 
+/* unlink from the express lanes, level 0 is handled below */
+	for (size_t lvl = 1; lvl <= torem->levels; lvl++){
+		arcan_vobject_litem** lane = litem_lane(dst, pred[lvl], lvl);
+
+		while (*lane && *lane != torem)
+			lane = litem_lane(dst, *lane, lvl);
+
+		if (*lane)
+			*lane = torem->skip[lvl-1];
+	}
+
 /* (1.) remove first */
 	if (dst->first == torem){
 		dst->first = torem->next;
@@ -1274,7 +1627,8 @@ static bool detach_fromtarget(struct rendertarget* dst, arcan_vobject* src)
 	torem->elem = (arcan_vobject*) 0xfeedface;
 
 /* cleanup torem */
-	arcan_mem_free(torem);
+	litem_release(torem);
+	pick_detach(dst, src);
 
 	if (src->owner == dst)
 		src->owner = NULL;
@@ -1338,11 +1692,7 @@ static void attach_object(struct rendertarget* dst, arcan_vobject* src)
 	if (dst->link)
 		return attach_object(dst->link, src);
 
-	arcan_vobject_litem* new_litem =
-		arcan_alloc_mem(sizeof *new_litem,
-			ARCAN_MEM_VSTRUCT, 0, ARCAN_MEMALIGN_NATURAL);
-
-	new_litem->next = new_litem->previous = NULL;
+	arcan_vobject_litem* new_litem = litem_alloc(litem_levels());
 	new_litem->elem = src;
 
 /* (pre) if orphaned, assign */
@@ -1350,42 +1700,24 @@ static void attach_object(struct rendertarget* dst, arcan_vobject* src)
 		src->owner = dst;
 	}
 
-/* 2. insert first into empty? */
-	if (!dst->first)
-		dst->first = new_litem;
-	else
-/* 3. insert first with n >= 1 */
-	if (dst->first->elem->order > src->order){
-		new_litem->next = dst->first;
-		dst->first = new_litem;
-		new_litem->next->previous = new_litem;
-	}
-/* 4. insert last or arbitrary */
-	else {
-		bool last;
-		arcan_vobject_litem* ipoint = dst->first;
-
-/* 5. scan for insertion point */
-		do
-			last = (ipoint->elem->order <= src->order);
-		while (last && ipoint->next && (ipoint = ipoint->next));
-
-/* 6. insert last? */
-		if (last){
-			new_litem->previous = ipoint;
-			ipoint->next = new_litem;
-		}
+/* insert after the last node with order <= src->order, splicing into every
+ * lane the new node is part of, lane 0 being the regular list */
+	arcan_vobject_litem* pred[LITEM_SKIP_LEVELS+1];
+	litem_find(dst, src->order, true, pred);
 
-		else {
-/* 7. insert arbitrary */
-			ipoint->previous->next = new_litem;
-			new_litem->previous = ipoint->previous;
-			ipoint->previous = new_litem;
-			new_litem->next = ipoint;
-		}
+	for (size_t lvl = 0; lvl <= new_litem->levels; lvl++){
+		arcan_vobject_litem** lane = litem_lane(dst, pred[lvl], lvl);
+		*litem_lane(dst, new_litem, lvl) = *lane;
+		*lane = new_litem;
 	}
 
+	new_litem->previous = pred[0];
+	if (new_litem->next)
+		new_litem->next->previous = new_litem;
+
 	FLAG_DIRTY(src);
+	pick_attach(dst, src);
+
 	if (dst->color){
 		src->extrefc.attachments++;
 		dst->color->extrefc.attachments++;
@@ -1599,10 +1931,6 @@ arcan_errc arcan_video_init(uint16_t width, uint16_t height, uint8_t bpp,
 
 /* might be called multiple times due to longjmp recover etc. */
 	if (firstinit){
-		if (-1 == arcan_sem_init(&asynchsynch, ASYNCH_CONCURRENT_THREADS)){
-			arcan_warning("video_init couldn't create synchronization handle\n");
-		}
-
 		arcan_vint_defaultmapping(arcan_video_display.default_txcos, 1.0, 1.0);
 		arcan_vint_defaultmapping(arcan_video_display.cursor_txcos, 1.0, 1.0);
 		arcan_vint_mirrormapping(arcan_video_display.mirror_txcos, 1.0, 1.0);
@@ -1617,6 +1945,11 @@ arcan_errc arcan_video_init(uint16_t width, uint16_t height, uint8_t bpp,
 		if (get_config("video_ignore_dirty", 0, NULL, tag)){
 			arcan_video_display.ignore_dirty = SIZE_MAX >> 1;
 		}
+
+/* same goes for drawing runs of plain 2D objects as batches */
+		if (get_config("video_no_batch", 0, NULL, tag)){
+			arcan_video_display.no_batch = true;
+		}
 	}
 
 	if (!platform_video_init(width, height, bpp, fs, frames, caption)){
@@ -1704,29 +2037,78 @@ static uint16_t nexthigher(uint16_t k)
 	return k+1;
 }
 
-arcan_errc arcan_vint_getimage(const char* fname, arcan_vobject* dst,
-	img_cons forced, bool asynchsrc)
-{
 /*
- * with asynchsynch, it's likely that we get a storm of requests and we'd
- * likely suffer thrashing, so limit this.  also, look into using
- * pthread_setschedparam and switch to pthreads exclusively
+ * Take a buffer of [sz] bytes from the set left behind by cancelled loads,
+ * or allocate a new one if there is no exact match.
  */
-	arcan_sem_wait(asynchsynch);
+static av_pixel* recycle_get(size_t sz)
+{
+	av_pixel* res = NULL;
+
+	pthread_mutex_lock(&asynch.lock);
+	for (size_t i = 0; i < asynch.n_recycle; i++){
+		if (asynch.recycle[i].sz != sz)
+			continue;
+
+		res = asynch.recycle[i].buf;
+		asynch.recycle[i] = asynch.recycle[--asynch.n_recycle];
+		break;
+	}
+	pthread_mutex_unlock(&asynch.lock);
+
+	if (!res)
+		res = arcan_alloc_mem(sz, ARCAN_MEM_VBUFFER, 0, ARCAN_MEMALIGN_PAGE);
+
+	return res;
+}
+
+/* caller is expected to hold asynch.lock */
+static void recycle_put(av_pixel* buf, size_t sz)
+{
+	if (!buf)
+		return;
+
+/* replace the oldest entry, the newer one is more likely to match the
+ * dimensions of whatever is being loaded right now */
+	if (asynch.n_recycle == ASYNCH_RECYCLE_LIMIT){
+		arcan_mem_free(asynch.recycle[0].buf);
+		memmove(asynch.recycle, &asynch.recycle[1],
+			sizeof(asynch.recycle[0]) * (ASYNCH_RECYCLE_LIMIT - 1));
+		asynch.n_recycle--;
+	}
+
+	asynch.recycle[asynch.n_recycle].buf = buf;
+	asynch.recycle[asynch.n_recycle].sz = sz;
+	asynch.n_recycle++;
+}
+
+static void recycle_flush()
+{
+	pthread_mutex_lock(&asynch.lock);
+	for (size_t i = 0; i < asynch.n_recycle; i++)
+		arcan_mem_free(asynch.recycle[i].buf);
+	asynch.n_recycle = 0;
+	pthread_mutex_unlock(&asynch.lock);
+}
 
+/*
+ * Decode, repack and (if needed) rescale the image in [fname] into [out].
+ * This does not touch any engine state and is safe to run from the asynch
+ * worker threads, the result is moved into a vobject by apply_image.
+ */
+static arcan_errc decode_image(const char* fname, img_cons forced,
+	enum arcan_vimage_mode desm, bool fliph, struct image_decode* out)
+{
 	size_t inw, inh;
 
 /* try- open */
 	data_source inres = arcan_open_resource(fname);
-	if (inres.fd == BADFD){
-		arcan_sem_post(asynchsynch);
+	if (inres.fd == BADFD)
 		return ARCAN_ERRC_BAD_RESOURCE;
-	}
 
 /* mmap (preferred) or buffer (mmap not working / useful due to alignment) */
 	map_region inmem = arcan_map_resource(&inres, false);
 	if (inmem.ptr == NULL){
-		arcan_sem_post(asynchsynch);
 		arcan_release_resource(&inres);
 		return ARCAN_ERRC_BAD_RESOURCE;
 	}
@@ -1735,44 +2117,31 @@ arcan_errc arcan_vint_getimage(const char* fname, arcan_vobject* dst,
 	uint32_t* ch_imgbuf = NULL;
 
 	arcan_errc rv = arcan_img_decode(fname, inmem.ptr, inmem.sz,
-		&ch_imgbuf, &inw, &inh, &meta, dst->vstore->imageproc == IMAGEPROC_FLIPH);
+		&ch_imgbuf, &inw, &inh, &meta, fliph);
 
 	arcan_release_map(inmem);
 	arcan_release_resource(&inres);
 
 	if (ARCAN_OK != rv)
-		goto done;
+		return rv;
 
 	av_pixel* imgbuf = arcan_img_repack(ch_imgbuf, inw, inh);
-	if (!imgbuf){
-		rv = ARCAN_ERRC_OUT_OF_SPACE;
-		goto done;
-	}
-
-	uint16_t neww, newh;
+	if (!imgbuf)
+		return ARCAN_ERRC_OUT_OF_SPACE;
 
 /* store this so we can maintain aspect ratios etc. while still
  * possibly aligning to next power of two */
-	dst->origw = inw;
-	dst->origh = inh;
-
-	neww = inw;
-	newh = inh;
-
-/* the thread_loader will take care of converting the asynchsrc
- * to an image once its completely done */
-	if (!asynchsrc)
-		dst->feed.state.tag = ARCAN_TAG_IMAGE;
-
-/* need to keep the identification string in order to rebuild
- * on a forced push/pop */
-	struct agp_vstore* dstframe = dst->vstore;
-	dstframe->vinf.text.source = strdup(fname);
+	out->origw = inw;
+	out->origh = inh;
+	out->compressed = meta.compressed;
 
-	enum arcan_vimage_mode desm = dst->vstore->scale;
+	if (meta.compressed){
+		arcan_mem_free(imgbuf);
+		return ARCAN_OK;
+	}
 
-	if (meta.compressed)
-		goto push_comp;
+	uint16_t neww = inw;
+	uint16_t newh = inh;
 
 /* the user requested specific dimensions, or we are in a mode where
  * we should manually enfore a stretch to the nearest power of two */
@@ -1784,38 +2153,68 @@ arcan_errc arcan_vint_getimage(const char* fname, arcan_vobject* dst,
 	if (forced.h > 0 && forced.w > 0){
 		neww = desm == ARCAN_VIMAGE_SCALEPOW2 ? nexthigher(forced.w) : forced.w;
 		newh = desm == ARCAN_VIMAGE_SCALEPOW2 ? nexthigher(forced.h) : forced.h;
-		dst->origw = forced.w;
-		dst->origh = forced.h;
+		out->origw = forced.w;
+		out->origh = forced.h;
 
-		dstframe->vinf.text.s_raw = neww * newh * sizeof(av_pixel);
-		dstframe->vinf.text.raw = arcan_alloc_mem(dstframe->vinf.text.s_raw,
-			ARCAN_MEM_VBUFFER, 0, ARCAN_MEMALIGN_PAGE);
+		out->buf_sz = neww * newh * sizeof(av_pixel);
+		out->buf = recycle_get(out->buf_sz);
 
 		arcan_renderfun_stretchblit((char*)imgbuf, inw, inh,
-			(uint32_t*) dstframe->vinf.text.raw,
-			neww, newh, dst->vstore->imageproc == IMAGEPROC_FLIPH);
+			(uint32_t*) out->buf, neww, newh, fliph);
 		arcan_mem_free(imgbuf);
 	}
 	else {
-		neww = inw;
-		newh = inh;
-		dstframe->vinf.text.raw = imgbuf;
-		dstframe->vinf.text.s_raw = inw * inh * sizeof(av_pixel);
+		out->buf = imgbuf;
+		out->buf_sz = inw * inh * sizeof(av_pixel);
 	}
 
-	dst->vstore->w = neww;
-	dst->vstore->h = newh;
+	out->w = neww;
+	out->h = newh;
+
+	return ARCAN_OK;
+}
 
 /*
- * for the asynch case, we need to do this separately as we're in a different
- * thread and forcibly assigning the glcontext to another thread is expensive */
+ * Move a decoded image into the store of [dst], the caller is responsible
+ * for synchronizing the store with the GPU side.
+ */
+static void apply_image(arcan_vobject* dst,
+	const char* fname, struct image_decode* img)
+{
+	dst->origw = img->origw;
+	dst->origh = img->origh;
+
+/* need to keep the identification string in order to rebuild
+ * on a forced push/pop */
+	struct agp_vstore* dstframe = dst->vstore;
+	dstframe->vinf.text.source = strdup(fname);
+
+	if (img->compressed)
+		return;
 
-push_comp:
-	if (!asynchsrc && dst->vstore->txmapped != TXSTATE_OFF)
+	dstframe->vinf.text.raw = img->buf;
+	dstframe->vinf.text.s_raw = img->buf_sz;
+	dstframe->w = img->w;
+	dstframe->h = img->h;
+	img->buf = NULL;
+}
+
+arcan_errc arcan_vint_getimage(const char* fname,
+	arcan_vobject* dst, img_cons forced)
+{
+	struct image_decode img = {0};
+	arcan_errc rv = decode_image(fname, forced, dst->vstore->scale,
+		dst->vstore->imageproc == IMAGEPROC_FLIPH, &img);
+
+	if (ARCAN_OK != rv)
+		return rv;
+
+	dst->feed.state.tag = ARCAN_TAG_IMAGE;
+	apply_image(dst, fname, &img);
+
+	if (dst->vstore->txmapped != TXSTATE_OFF)
 		agp_update_vstore(dst->vstore, true);
 
-done:
-	arcan_sem_post(asynchsynch);
 	return rv;
 }
 
@@ -2371,98 +2770,355 @@ arcan_errc arcan_video_setasframe(arcan_vobj_id dst,
 	return ARCAN_OK;
 }
 
-struct thread_loader_args {
-	arcan_vobject* dst;
-	pthread_t self;
-	arcan_vobj_id dstid;
-	char* fname;
-	intptr_t tag;
-	img_cons constraints;
-	arcan_errc rc;
-};
-
-static void* thread_loader(void* in)
-{
-	struct thread_loader_args* largs = (struct thread_loader_args*) in;
-	arcan_vobject* dst = largs->dst;
-	largs->rc = arcan_vint_getimage(largs->fname, dst, largs->constraints, true);
-	dst->feed.state.tag = ARCAN_TAG_ASYNCIMGRD;
-	return 0;
-}
+static void* asynch_worker(void* arg);
 
-void arcan_vint_joinasynch(arcan_vobject* img, bool emit, bool force)
+static void asynch_setup()
 {
-	if (!force && img->feed.state.tag != ARCAN_TAG_ASYNCIMGRD){
-		return;
-	}
-
-	struct thread_loader_args* args =
-		(struct thread_loader_args*) img->feed.state.ptr;
+	asynch.init = true;
 
-	pthread_join(args->self, NULL);
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nt = ncpu > 1 ? ncpu : 1;
+	if (nt > ASYNCH_CONCURRENT_THREADS)
+		nt = ASYNCH_CONCURRENT_THREADS;
 
-	arcan_event loadev = {
-		.category = EVENT_VIDEO,
-		.vid.data = args->tag,
-		.vid.source = args->dstid
-	};
+	pthread_attr_t jattr;
+	pthread_attr_init(&jattr);
+	pthread_attr_setdetachstate(&jattr, PTHREAD_CREATE_DETACHED);
 
-	if (args->rc == ARCAN_OK){
-		loadev.vid.kind = EVENT_VIDEO_ASYNCHIMAGE_LOADED;
-		loadev.vid.width = img->origw;
-		loadev.vid.height = img->origh;
+	for (size_t i = 0; i < nt; i++){
+		pthread_t pthr;
+		if (0 != pthread_create(&pthr, &jattr, asynch_worker, NULL)){
+			arcan_warning("image decode worker thread creation failed\n");
+			break;
+		}
+		asynch.n_threads++;
 	}
-/* copy broken placeholder instead */
-	else {
-		img->origw = 32;
-		img->origh = 32;
-		img->vstore->vinf.text.s_raw = 32 * 32 * sizeof(av_pixel);
-		img->vstore->vinf.text.raw = arcan_alloc_mem(img->vstore->vinf.text.s_raw,
-			ARCAN_MEM_VBUFFER, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_PAGE);
 
-		img->vstore->w = 32;
-		img->vstore->h = 32;
-		img->vstore->vinf.text.source = strdup(args->fname);
-		img->vstore->filtermode = ARCAN_VFILTER_NONE;
+	pthread_attr_destroy(&jattr);
+}
 
-		loadev.vid.width = 32;
-		loadev.vid.height = 32;
-		loadev.vid.kind = EVENT_VIDEO_ASYNCHIMAGE_FAILED;
+/* the functions below expect the caller to hold asynch.lock */
+static struct asynch_job* asynch_dequeue()
+{
+	size_t best = 0;
+	for (size_t i = 1; i < asynch.n_queued; i++){
+		struct asynch_job* cur = asynch.queue[i];
+		struct asynch_job* cmp = asynch.queue[best];
+		if (cur->prio > cmp->prio || (cur->prio == cmp->prio && cur->seq < cmp->seq))
+			best = i;
 	}
 
-	agp_update_vstore(img->vstore, true);
-
-	if (emit)
-		arcan_event_enqueue(arcan_event_defaultctx(), &loadev);
+	struct asynch_job* res = asynch.queue[best];
+	asynch.queue[best] = asynch.queue[--asynch.n_queued];
+	return res;
+}
 
-	arcan_mem_free(args->fname);
-	arcan_mem_free(args);
-	img->feed.state.ptr = NULL;
-	img->feed.state.tag = ARCAN_TAG_IMAGE;
+static void asynch_unqueue(struct asynch_job* job)
+{
+	for (size_t i = 0; i < asynch.n_queued; i++)
+		if (asynch.queue[i] == job){
+			asynch.queue[i] = asynch.queue[--asynch.n_queued];
+			return;
+		}
 }
 
-static arcan_vobj_id loadimage_asynch(const char* fname,
-	img_cons constraints, intptr_t tag)
+static void asynch_finish(struct asynch_job* job)
 {
-	arcan_vobj_id rv = ARCAN_EID;
-	arcan_vobject* dstobj = arcan_video_newvobject(&rv);
-	if (!dstobj)
-		return rv;
+	job->state = ASYNCH_DONE;
+	job->next = NULL;
 
-	struct thread_loader_args* args = arcan_alloc_mem(
-		sizeof(struct thread_loader_args),
-		ARCAN_MEM_THREADCTX, 0, ARCAN_MEMALIGN_NATURAL);
+	if (asynch.done_last)
+		asynch.done_last->next = job;
+	else
+		asynch.done_first = job;
 
-	args->dstid = rv;
-	args->dst = dstobj;
-	args->fname = strdup(fname);
-	args->tag = tag;
-	args->constraints = constraints;
+	asynch.done_last = job;
+	pthread_cond_broadcast(&asynch.finished);
+}
 
-	dstobj->feed.state.tag = ARCAN_TAG_ASYNCIMGLD;
-	dstobj->feed.state.ptr = args;
+static void asynch_unlink(struct asynch_job* job)
+{
+	struct asynch_job* prev = NULL;
+	struct asynch_job* cur = asynch.done_first;
 
-	pthread_create(&args->self, NULL, thread_loader, (void*) args);
+	while (cur && cur != job){
+		prev = cur;
+		cur = cur->next;
+	}
+
+	if (!cur)
+		return;
+
+	if (prev)
+		prev->next = cur->next;
+	else
+		asynch.done_first = cur->next;
+
+	if (asynch.done_last == cur)
+		asynch.done_last = prev;
+}
+
+static void asynch_free(struct asynch_job* job)
+{
+	recycle_put(job->img.buf, job->img.buf_sz);
+	arcan_mem_free(job->fname);
+	arcan_mem_free(job);
+}
+
+/* take the next queued job and decode it, lock is released while decoding */
+static void asynch_step()
+{
+	struct asynch_job* job = asynch_dequeue();
+	job->state = ASYNCH_RUNNING;
+	asynch.n_running++;
+	pthread_mutex_unlock(&asynch.lock);
+
+	job->rc = decode_image(job->fname,
+		job->forced, job->scale, job->fliph, &job->img);
+
+/* the vobject might have been deleted while we were busy */
+	pthread_mutex_lock(&asynch.lock);
+	asynch.n_running--;
+	if (job->cancelled){
+		asynch_free(job);
+		pthread_cond_broadcast(&asynch.finished);
+	}
+	else
+		asynch_finish(job);
+}
+
+static void* asynch_worker(void* arg)
+{
+	pthread_mutex_lock(&asynch.lock);
+	for(;;){
+		while (!asynch.n_queued)
+			pthread_cond_wait(&asynch.wake, &asynch.lock);
+
+		asynch_step();
+	}
+
+	return NULL;
+}
+
+/*
+ * Wait for every outstanding job to finish, the calling thread takes queued
+ * jobs the same way the workers do so that they are decoded in parallel with
+ * the pool rather than one after the other when each object is joined.
+ */
+static void asynch_drain()
+{
+	if (!asynch.init)
+		return;
+
+	pthread_mutex_lock(&asynch.lock);
+	for(;;){
+		if (asynch.n_queued)
+			asynch_step();
+		else if (asynch.n_running)
+			pthread_cond_wait(&asynch.finished, &asynch.lock);
+		else
+			break;
+	}
+	pthread_mutex_unlock(&asynch.lock);
+}
+
+void arcan_vint_joinasynch(arcan_vobject* img, bool emit, bool force)
+{
+	struct asynch_job* job = img->feed.state.ptr;
+	if ((img->feed.state.tag != ARCAN_TAG_ASYNCIMGLD &&
+		img->feed.state.tag != ARCAN_TAG_ASYNCIMGRD) || !job)
+		return;
+
+	pthread_mutex_lock(&asynch.lock);
+	if (!force && job->state != ASYNCH_DONE){
+		pthread_mutex_unlock(&asynch.lock);
+		return;
+	}
+
+/* no point in waiting for a worker to get around to it */
+	if (job->state == ASYNCH_QUEUED){
+		asynch_unqueue(job);
+		pthread_mutex_unlock(&asynch.lock);
+		job->rc = decode_image(job->fname,
+			job->forced, job->scale, job->fliph, &job->img);
+	}
+	else {
+		while (job->state != ASYNCH_DONE)
+			pthread_cond_wait(&asynch.finished, &asynch.lock);
+		asynch_unlink(job);
+		pthread_mutex_unlock(&asynch.lock);
+	}
+
+	arcan_event loadev = {
+		.category = EVENT_VIDEO,
+		.vid.data = job->tag,
+		.vid.source = job->dstid
+	};
+
+	if (job->rc == ARCAN_OK){
+		apply_image(img, job->fname, &job->img);
+		loadev.vid.kind = EVENT_VIDEO_ASYNCHIMAGE_LOADED;
+		loadev.vid.width = img->origw;
+		loadev.vid.height = img->origh;
+	}
+/* copy broken placeholder instead */
+	else {
+		img->origw = 32;
+		img->origh = 32;
+		img->vstore->vinf.text.s_raw = 32 * 32 * sizeof(av_pixel);
+		img->vstore->vinf.text.raw = arcan_alloc_mem(img->vstore->vinf.text.s_raw,
+			ARCAN_MEM_VBUFFER, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_PAGE);
+
+		img->vstore->w = 32;
+		img->vstore->h = 32;
+		img->vstore->vinf.text.source = strdup(job->fname);
+		img->vstore->filtermode = ARCAN_VFILTER_NONE;
+
+		loadev.vid.width = 32;
+		loadev.vid.height = 32;
+		loadev.vid.kind = EVENT_VIDEO_ASYNCHIMAGE_FAILED;
+	}
+
+	agp_update_vstore(img->vstore, true);
+
+	if (emit)
+		arcan_event_enqueue(arcan_event_defaultctx(), &loadev);
+
+	arcan_mem_free(job->img.buf);
+	arcan_mem_free(job->fname);
+	arcan_mem_free(job);
+	img->feed.state.ptr = NULL;
+	img->feed.state.tag = ARCAN_TAG_IMAGE;
+}
+
+/*
+ * Apply all finished jobs to their vobjects and emit the corresponding
+ * events, in the order they were completed.
+ */
+static void asynch_collect()
+{
+	if (!asynch.init)
+		return;
+
+	pthread_mutex_lock(&asynch.lock);
+	struct asynch_job* job = asynch.done_first;
+	asynch.done_first = asynch.done_last = NULL;
+	pthread_mutex_unlock(&asynch.lock);
+
+	while (job){
+		struct asynch_job* next = job->next;
+		job->next = NULL;
+
+		arcan_vobject* vobj = arcan_video_getobject(job->dstid);
+		if (vobj && vobj->feed.state.ptr == job)
+			arcan_vint_joinasynch(vobj, true, false);
+		else {
+			pthread_mutex_lock(&asynch.lock);
+			asynch_free(job);
+			pthread_mutex_unlock(&asynch.lock);
+		}
+
+		job = next;
+	}
+}
+
+/*
+ * Drop any outstanding load for [vobj] without waiting for it, a job that
+ * is being decoded is flagged and released by the worker when it finishes.
+ */
+static void asynch_cancel(arcan_vobject* vobj)
+{
+	struct asynch_job* job = vobj->feed.state.ptr;
+	if (!job)
+		return;
+
+	pthread_mutex_lock(&asynch.lock);
+	switch (job->state){
+	case ASYNCH_QUEUED:
+		asynch_unqueue(job);
+		asynch_free(job);
+	break;
+	case ASYNCH_RUNNING:
+		job->cancelled = true;
+	break;
+	case ASYNCH_DONE:
+		asynch_unlink(job);
+		asynch_free(job);
+	break;
+	}
+	pthread_mutex_unlock(&asynch.lock);
+
+	vobj->feed.state.ptr = NULL;
+	vobj->feed.state.tag = ARCAN_TAG_NONE;
+}
+
+static arcan_vobj_id loadimage_asynch(const char* fname,
+	img_cons constraints, intptr_t tag, int prio)
+{
+	arcan_vobj_id rv = ARCAN_EID;
+	arcan_vobject* dstobj = arcan_video_newvobject(&rv);
+	if (!dstobj)
+		return rv;
+
+	struct asynch_job* job = arcan_alloc_mem(sizeof(struct asynch_job),
+		ARCAN_MEM_THREADCTX, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
+
+	job->dstid = rv;
+	job->fname = strdup(fname);
+	job->tag = tag;
+	job->prio = prio;
+	job->forced = constraints;
+	job->scale = dstobj->vstore->scale;
+	job->fliph = dstobj->vstore->imageproc == IMAGEPROC_FLIPH;
+
+	dstobj->feed.state.tag = ARCAN_TAG_ASYNCIMGLD;
+	dstobj->feed.state.ptr = job;
+
+	if (!asynch.init)
+		asynch_setup();
+
+	pthread_mutex_lock(&asynch.lock);
+	if (asynch.n_threads && asynch.n_queued < ASYNCH_QUEUE_LIMIT){
+		job->seq = asynch.seq++;
+		asynch.queue[asynch.n_queued++] = job;
+		pthread_cond_signal(&asynch.wake);
+		pthread_mutex_unlock(&asynch.lock);
+		return rv;
+	}
+	pthread_mutex_unlock(&asynch.lock);
+
+/* no workers or the queue is saturated, decode here but still deliver the
+ * result through the event queue so it looks the same to the caller */
+	job->state = ASYNCH_RUNNING;
+	job->rc = decode_image(job->fname,
+		job->forced, job->scale, job->fliph, &job->img);
+
+	pthread_mutex_lock(&asynch.lock);
+	asynch_finish(job);
+	pthread_mutex_unlock(&asynch.lock);
+
+	return rv;
+}
+
+arcan_errc arcan_video_asynchpriority(arcan_vobj_id id, int prio)
+{
+	arcan_vobject* vobj = arcan_video_getobject(id);
+
+	if (!vobj)
+		return ARCAN_ERRC_NO_SUCH_OBJECT;
+
+	if (vobj->feed.state.tag != ARCAN_TAG_ASYNCIMGLD || !vobj->feed.state.ptr)
+		return ARCAN_ERRC_UNACCEPTED_STATE;
+
+	struct asynch_job* job = vobj->feed.state.ptr;
+	arcan_errc rv = ARCAN_ERRC_UNACCEPTED_STATE;
+
+	pthread_mutex_lock(&asynch.lock);
+	if (job->state == ASYNCH_QUEUED){
+		job->prio = prio;
+		rv = ARCAN_OK;
+	}
+	pthread_mutex_unlock(&asynch.lock);
 
 	return rv;
 }
@@ -2494,7 +3150,7 @@ static arcan_vobj_id loadimage(const char* fname, img_cons constraints,
 	if (newvobj == NULL)
 		return ARCAN_EID;
 
-	arcan_errc rc = arcan_vint_getimage(fname, newvobj, constraints, false);
+	arcan_errc rc = arcan_vint_getimage(fname, newvobj, constraints);
 
 	if (rc != ARCAN_OK)
 		arcan_video_deleteobject(rv);
@@ -2615,9 +3271,9 @@ arcan_errc arcan_video_resizefeed(arcan_vobj_id id, size_t w, size_t h)
 }
 
 arcan_vobj_id arcan_video_loadimageasynch(const char* rloc,
-	img_cons constraints, intptr_t tag)
+	img_cons constraints, intptr_t tag, int prio)
 {
-	arcan_vobj_id rv = loadimage_asynch(rloc, constraints, tag);
+	arcan_vobj_id rv = loadimage_asynch(rloc, constraints, tag, prio);
 
 	if (rv > 0){
 		arcan_vobject* vobj = arcan_video_getobject(rv);
@@ -2744,7 +3400,27 @@ static arcan_errc update_zv(arcan_vobject* vobj, int newzv)
  * corruption checks, this could be further optimized
  * by using the fact that we're simply "sliding" in the
  * same chain.
+ *
+ * The object can also be shared into other rendertargets, those lists
+ * need to be re-sorted as well or detach won't find it there.
  */
+	struct rendertarget* shared[RENDERTARGET_LIMIT + 1];
+	size_t n_shared = 0;
+
+	if (vobj->extrefc.attachments > 1){
+		struct rendertarget* stdoutp = &current_context->stdoutp;
+		if (owner != stdoutp && !stdoutp->link && detach_fromtarget(stdoutp, vobj))
+			shared[n_shared++] = stdoutp;
+
+/* linked rendertargets have no list of their own, detach would follow the
+ * link and take the node from the target it refers to */
+		for (size_t i = 0; i < current_context->n_rtargets; i++){
+			struct rendertarget* rtgt = &current_context->rtargets[i];
+			if (rtgt != owner && !rtgt->link && detach_fromtarget(rtgt, vobj))
+				shared[n_shared++] = rtgt;
+		}
+	}
+
 	int oldv = vobj->order;
 	detach_fromtarget(owner, vobj);
 	vobj->order = newzv;
@@ -2753,6 +3429,8 @@ static arcan_errc update_zv(arcan_vobject* vobj, int newzv)
 		vobj->order *= -1;
 
 	attach_object(owner, vobj);
+	for (size_t i = 0; i < n_shared; i++)
+		attach_object(shared[i], vobj);
 
 /*
  * unfortunately, we need to do this recursively AND
@@ -2814,6 +3492,66 @@ arcan_errc arcan_video_setlife(arcan_vobj_id id, unsigned lifetime)
 	return rv;
 }
 
+/*
+ * The set of objects with a transform chain is kept up to date as chains
+ * are added and run out so that the transform pass doesn't have to sweep
+ * the whole pool every refresh. Entries that have gone stale anyway (a
+ * slot reused, a persist copy) are pruned by tfpass_begin.
+ */
+static void tfactive_drop(struct arcan_video_context* ctx, size_t ind)
+{
+	size_t last = --ctx->tfactive_count;
+	if (ind == last)
+		return;
+
+	arcan_vobj_id moved = ctx->tfactive[last];
+	ctx->tfactive[ind] = moved;
+	if (ctx->vitems_pool[moved].tfslot == last + 1)
+		ctx->vitems_pool[moved].tfslot = ind + 1;
+}
+
+static inline bool tfactive_member(
+	struct arcan_video_context* ctx, arcan_vobject* vobj)
+{
+	return vobj->tfslot && vobj->tfslot <= ctx->tfactive_count &&
+		ctx->tfactive[vobj->tfslot - 1] == vobj->cellid;
+}
+
+static void tfactive_add(struct arcan_video_context* ctx, arcan_vobject* vobj)
+{
+	if (tfactive_member(ctx, vobj))
+		return;
+
+/* on failure the object is just not part of the batched pass, apply and
+ * resolve_vidprop will interpolate it on their own */
+	if (ctx->tfactive_count == ctx->tfactive_limit){
+		size_t nl = ctx->tfactive_limit ? ctx->tfactive_limit * 2 : 256;
+		arcan_vobj_id* buf = arcan_alloc_mem(sizeof(arcan_vobj_id) * nl,
+			ARCAN_MEM_VSTRUCT, ARCAN_MEM_NONFATAL, ARCAN_MEMALIGN_NATURAL);
+		if (!buf){
+			vobj->tfslot = 0;
+			return;
+		}
+
+		if (ctx->tfactive){
+			memcpy(buf, ctx->tfactive, sizeof(arcan_vobj_id) * ctx->tfactive_count);
+			arcan_mem_free(ctx->tfactive);
+		}
+		ctx->tfactive = buf;
+		ctx->tfactive_limit = nl;
+	}
+
+	ctx->tfactive[ctx->tfactive_count++] = vobj->cellid;
+	vobj->tfslot = ctx->tfactive_count;
+}
+
+static void tfactive_remove(struct arcan_video_context* ctx, arcan_vobject* vobj)
+{
+	if (tfactive_member(ctx, vobj))
+		tfactive_drop(ctx, vobj->tfslot - 1);
+	vobj->tfslot = 0;
+}
+
 arcan_errc arcan_video_zaptransform(arcan_vobj_id id, unsigned left[4])
 {
 	arcan_vobject* vobj = arcan_video_getobject(id);
@@ -2844,6 +3582,7 @@ arcan_errc arcan_video_zaptransform(arcan_vobj_id id, unsigned left[4])
 	}
 
 	vobj->transform = NULL;
+	tfactive_remove(current_context, vobj);
 
 	FLAG_DIRTY(vobj);
 	return ARCAN_OK;
@@ -2985,6 +3724,7 @@ arcan_errc arcan_video_instanttransform(
 	}
 
 	vobj->transform = NULL;
+	tfactive_remove(current_context, vobj);
 	invalidate_cache(vobj);
 	return ARCAN_OK;
 }
@@ -3080,6 +3820,8 @@ arcan_errc arcan_video_copytransform(arcan_vobj_id sid, arcan_vobj_id did)
 
 	arcan_video_zaptransform(did, NULL);
 	dst->transform = dup_chain(src->transform);
+	if (dst->transform)
+		tfactive_add(current_context, dst);
 	update_zv(dst, src->order);
 
 	invalidate_cache(dst);
@@ -3181,10 +3923,11 @@ static void drop_rtarget(arcan_vobject* vobj)
 		arcan_vobject_litem* last = current;
 		current->elem = (arcan_vobject*) 0xfacefeed;
 		current = current->next;
-		last->next = (struct arcan_vobject_litem*) 0xdeadbeef;
-		arcan_mem_free(last);
+		litem_release(last);
 	}
 
+	pick_drop(dst);
+
 /* compact the context array of rendertargets */
 	if (dstind+1 < RENDERTARGET_LIMIT)
 		memmove(&current_context->rtargets[dstind],
@@ -3329,8 +4072,10 @@ arcan_errc arcan_video_deleteobject(arcan_vobj_id id)
 		vobj->feed.state.tag = ARCAN_TAG_NONE;
 	}
 
-	if (vobj->feed.state.tag == ARCAN_TAG_ASYNCIMGLD)
-		arcan_video_pushasynch(id);
+/* a pending load is just discarded, no reason to wait for it */
+	if (vobj->feed.state.tag == ARCAN_TAG_ASYNCIMGLD ||
+		vobj->feed.state.tag == ARCAN_TAG_ASYNCIMGRD)
+		asynch_cancel(vobj);
 
 /* video storage, will take care of refcounting in case of shared storage */
 	arcan_vint_drop_vstore(vobj->vstore);
@@ -3352,6 +4097,7 @@ arcan_errc arcan_video_deleteobject(arcan_vobj_id id)
 /* lots of default values are assumed to be 0, so reset the
  * entire object to be sure. will help leak detectors as well */
 	memset(vobj, 0, sizeof(arcan_vobject));
+	video_releaseid(current_context, id);
 
 	for (size_t i = 0; i < cascade_c; i++){
 		if (!pool[i])
@@ -3505,8 +4251,10 @@ arcan_errc arcan_video_objectrotate3d(arcan_vobj_id id,
 				ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
 	}
 
-	if (!vobj->transform)
+	if (!vobj->transform){
 		vobj->transform = base;
+		tfactive_add(current_context, vobj);
+	}
 
 	base->rotate.startt = last->rotate.endt < arcan_video_display.c_ticks ?
 		arcan_video_display.c_ticks : last->rotate.endt;
@@ -3635,8 +4383,10 @@ arcan_errc arcan_video_objectopacity(arcan_vobj_id id,
 							ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
 			}
 
-			if (!vobj->transform)
+			if (!vobj->transform){
 				vobj->transform = base;
+				tfactive_add(current_context, vobj);
+			}
 
 			if (vobj->owner)
 				vobj->owner->transfc++;
@@ -3769,8 +4519,10 @@ arcan_errc arcan_video_objectmove(arcan_vobj_id id, float newx,
 
 	point newp = {newx, newy, newz};
 
-	if (!vobj->transform)
+	if (!vobj->transform){
 		vobj->transform = base;
+		tfactive_add(current_context, vobj);
+	}
 
 	base->move.startt = last->move.endt < arcan_video_display.c_ticks ?
 		arcan_video_display.c_ticks : last->move.endt;
@@ -3830,8 +4582,10 @@ arcan_errc arcan_video_objectscale(arcan_vobj_id id, float wf,
 						ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO, ARCAN_MEMALIGN_NATURAL);
 			}
 
-			if (!vobj->transform)
+			if (!vobj->transform){
 				vobj->transform = base;
+				tfactive_add(current_context, vobj);
+			}
 
 			base->scale.startt = last->scale.endt < arcan_video_display.c_ticks ?
 				arcan_video_display.c_ticks : last->scale.endt;
@@ -4003,8 +4757,10 @@ static void compact_transformation(arcan_vobject* base,
 		arcan_mem_free(work);
 		if (last)
 			last->next = NULL;
-		else
+		else {
 			base->transform = NULL;
+			tfactive_remove(current_context, base);
+		}
 	}
 }
 
@@ -4236,8 +4992,6 @@ static int tick_rendertarget(struct rendertarget* tgt)
 	while (current){
 		arcan_vobject* elem = current->elem;
 
-		arcan_vint_joinasynch(elem, true, false);
-
 		if (elem->last_updated != arcan_video_display.c_ticks)
 			tgt->transfc += update_object(elem, arcan_video_display.c_ticks);
 
@@ -4280,6 +5034,8 @@ unsigned arcan_video_tick(unsigned steps, unsigned* njobs)
 	unsigned now = arcan_frametime();
 	uint32_t tsd = arcan_video_display.c_ticks;
 
+	asynch_collect();
+
 #ifdef SHADER_TIME_PERIOD
 	tsd = tsd % SHADER_TIME_PERIOD;
 #endif
@@ -4356,6 +5112,55 @@ bool arcan_video_visible(arcan_vobj_id id)
 	return rv;
 }
 
+/* set on threads building draw lists for a rendertarget, see build_cmdlist */
+_Thread_local static struct rendertarget* build_rtgt;
+
+/* objects deeper than this resolve the remainder of their chain recursively */
+#ifndef RESOLVE_CHAIN_LIMIT
+#define RESOLVE_CHAIN_LIMIT 64
+#endif
+
+/*
+ * State for the batched transform pass that runs before the rendertargets of
+ * a refresh are drawn. The interpolation inputs of all running transforms are
+ * gathered per channel (move, scale, blend) into separate arrays, grouped by
+ * interpolation function, so that the common linear case can be done with
+ * the vector batch functions. The resolved properties are then calculated in
+ * order of hierarchy depth so that each object is resolved once.
+ */
+enum tf_channel {
+	TF_MOVE = 0,
+	TF_SCALE,
+	TF_BLEND,
+	TF_CHANNELS
+};
+
+#define TF_NINTERP (sizeof(lut_interp_3d) / sizeof(lut_interp_3d[0]))
+
+struct tf_soa {
+	size_t count;
+	size_t group[TF_NINTERP + 1];
+	uint32_t* ref;
+	float* startt;
+	float* endt;
+	float* fract;
+	float* sv[3];
+	float* ev[3];
+	float* ov[3];
+};
+
+static struct {
+	unsigned gen;
+	float lerp;
+	bool active;
+	bool building;
+
+	size_t count, limit;
+	arcan_vobject** obj;
+	uint64_t* order;
+	struct tf_soa ch[TF_CHANNELS];
+} tfpass;
+
 /* take sprops, apply them to the coordinates in vobj with proper
  * masking (or force to ignore mask), store the results in dprops */
 static void apply(arcan_vobject* vobj, surface_properties* dprops,
@@ -4363,7 +5168,13 @@ static void apply(arcan_vobject* vobj, surface_properties* dprops,
 {
 	*dprops = vobj->current;
 
-	if (vobj->transform){
+	if (vobj->transform && tfpass.active &&
+		vobj->frame_lgen == tfpass.gen && lerp == tfpass.lerp){
+		*dprops = vobj->frame_local;
+		if (!sprops)
+			return;
+	}
+	else if (vobj->transform){
 		surface_transform* tf = vobj->transform;
 		unsigned ct = arcan_video_display.c_ticks;
 
@@ -4433,117 +5244,426 @@ static void apply(arcan_vobject* vobj, surface_properties* dprops,
  * which is then re-used every rendercall.
  * Queueing a transformation immediately invalidates the cache.
  */
-void arcan_resolve_vidprop(arcan_vobject* vobj, float lerp,
-	surface_properties* props)
+static bool tfpass_grow(size_t count)
 {
-	if (vobj->valid_cache)
-		*props = vobj->prop_cache;
+	if (count <= tfpass.limit)
+		return true;
 
-/* first recurse to parents */
-	else if (vobj->parent && vobj->parent != &current_context->world){
-		surface_properties dprop = empty_surface();
-		arcan_resolve_vidprop(vobj->parent, lerp, &dprop);
-		apply(vobj, props, &dprop, lerp, false);
-		switch(vobj->p_anchor){
-		case ANCHORP_UR:
-			props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
-		break;
-		case ANCHORP_LR:
-			props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
-			props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
-		break;
-		case ANCHORP_LL:
-			props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
-		break;
-		case ANCHORP_CR:
-			props->position.y += vobj->parent->origh * vobj->parent->current.scale.y * 0.5;
-			props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
-		break;
-		case ANCHORP_C:
-		case ANCHORP_UC:
-		case ANCHORP_CL:
-		case ANCHORP_LC:{
-			float mid_y = (vobj->parent->origh * vobj->parent->current.scale.y) * 0.5;
-			float mid_x = (vobj->parent->origw * vobj->parent->current.scale.x) * 0.5;
-			if (vobj->p_anchor == ANCHORP_UC ||
-				vobj->p_anchor == ANCHORP_LC || vobj->p_anchor == ANCHORP_C)
-				props->position.x += mid_x;
-
-			if (vobj->p_anchor == ANCHORP_CL || vobj->p_anchor == ANCHORP_C)
-				props->position.y += mid_y;
-
-			if (vobj->p_anchor == ANCHORP_LC)
-				props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
-		}
-		case ANCHORP_UL:
-		default:
-		break;
-		}
-	}
-	else
-		apply(vobj, props, &current_context->world.current, lerp, true);
+	size_t nl = tfpass.limit ? tfpass.limit : 256;
+	while (nl < count)
+		nl *= 2;
 
-	arcan_vobject* current = vobj;
-	bool can_cache = true;
-	while (current){
-		if (current->transform){
-			can_cache = false;
-			break;
+/* all the per-object arrays share one allocation: the object pointer, the
+ * depth sort key and for each channel twelve float arrays and a reference */
+	size_t fsz = sizeof(float) * nl;
+	size_t tot = sizeof(arcan_vobject*) * nl +
+		sizeof(uint64_t) * nl + TF_CHANNELS * (sizeof(uint32_t) * nl + 12 * fsz);
+
+	uint8_t* buf = arcan_alloc_mem(tot,
+		ARCAN_MEM_VSTRUCT, ARCAN_MEM_NONFATAL, ARCAN_MEMALIGN_SIMD);
+	if (!buf)
+		return false;
+
+	if (tfpass.obj){
+		memcpy(buf, tfpass.obj, sizeof(arcan_vobject*) * tfpass.count);
+		memcpy(buf + sizeof(arcan_vobject*) * nl,
+			tfpass.order, sizeof(uint64_t) * tfpass.count);
+		arcan_mem_free(tfpass.obj);
+	}
+
+	tfpass.obj = (arcan_vobject**) buf;
+	buf += sizeof(arcan_vobject*) * nl;
+	tfpass.order = (uint64_t*) buf;
+	buf += sizeof(uint64_t) * nl;
+
+	for (size_t i = 0; i < TF_CHANNELS; i++){
+		struct tf_soa* ch = &tfpass.ch[i];
+		ch->startt = (float*) buf; buf += fsz;
+		ch->endt = (float*) buf; buf += fsz;
+		ch->fract = (float*) buf; buf += fsz;
+		for (size_t j = 0; j < 3; j++){
+			ch->sv[j] = (float*) buf; buf += fsz;
+			ch->ev[j] = (float*) buf; buf += fsz;
+			ch->ov[j] = (float*) buf; buf += fsz;
 		}
-		current = current->parent;
+		ch->ref = (uint32_t*) buf; buf += sizeof(uint32_t) * nl;
 	}
 
-	if (can_cache && vobj->owner && vobj->valid_cache == false){
-		surface_properties dprop = *props;
-		vobj->prop_cache  = *props;
-		vobj->valid_cache = true;
-		build_modelview(vobj->prop_matr, vobj->owner->base, &dprop, vobj);
-	}
-	else
-		;
+	tfpass.limit = nl;
+	return true;
 }
 
-static void calc_cp_area(arcan_vobject* vobj, point* ul, point* lr)
+static inline void tf_push(enum tf_channel chn, uint32_t ref, int interp,
+	arcan_tickv startt, arcan_tickv endt, const float* sv, const float* ev)
 {
-	surface_properties cur;
-	arcan_resolve_vidprop(vobj, 0.0, &cur);
-
-	ul->x = cur.position.x < ul->x ? cur.position.x : ul->x;
-	ul->y = cur.position.y < ul->y ? cur.position.y : ul->y;
+	struct tf_soa* ch = &tfpass.ch[chn];
+	size_t pos = ch->group[interp]++;
 
-	float t1 = (cur.position.x + cur.scale.x * vobj->origw);
-	float t2 = (cur.position.y + cur.scale.y * vobj->origh);
-	lr->x = cur.position.x > t1 ? cur.position.x : t1;
-	lr->y = cur.position.y > t2 ? cur.position.y : t2;
+	ch->ref[pos] = ref;
+	ch->startt[pos] = startt;
+	ch->endt[pos] = endt;
 
-	if (vobj->parent && vobj->parent != &current_context->world)
-		calc_cp_area(vobj->parent, ul, lr);
+	size_t nc = chn == TF_BLEND ? 1 : 3;
+	for (size_t i = 0; i < nc; i++){
+		ch->sv[i][pos] = sv[i];
+		ch->ev[i][pos] = ev[i];
+	}
 }
 
-static inline void build_modelview(float* dmatr,
-	float* imatr, surface_properties* prop, arcan_vobject* src)
+static int tf_depthcmp(const void* a, const void* b)
 {
-	float _Alignas(16) omatr[16];
-	float _Alignas(16) tmatr[16];
+	uint64_t av = *(const uint64_t*) a;
+	uint64_t bv = *(const uint64_t*) b;
+	return av < bv ? -1 : av > bv;
+}
 
-/* now position represents centerpoint in screen coordinates */
-	prop->scale.x *= src->origw * 0.5f;
-	prop->scale.y *= src->origh * 0.5f;
-	prop->position.x += prop->scale.x;
-	prop->position.y += prop->scale.y;
+static inline bool resolved_props(
+	arcan_vobject* vobj, float lerp, surface_properties* props)
+{
+	if (tfpass.active && vobj->frame_wgen == tfpass.gen && lerp == tfpass.lerp){
+		*props = vobj->frame_world;
+		return true;
+	}
 
-	src->rotate_state =
-		fabsf(prop->rotation.roll)  > EPSILON ||
-		fabsf(prop->rotation.pitch) > EPSILON ||
-		fabsf(prop->rotation.yaw)   > EPSILON;
+	if (__atomic_load_n(&vobj->valid_cache, __ATOMIC_ACQUIRE)){
+		*props = vobj->prop_cache;
+		return true;
+	}
 
-	memcpy(tmatr, imatr, sizeof(float) * 16);
+	return false;
+}
 
-	if (src->rotate_state){
-		if (FL_TEST(src, FL_FULL3D))
-			matr_quatf(norm_quat (prop->rotation.quaternion), omatr);
-		else
-			matr_rotatef(DEG2RAD(prop->rotation.roll), omatr);
+/* apply the parent-relative anchor point to an already applied [props] */
+static inline void apply_anchor(arcan_vobject* vobj, surface_properties* props)
+{
+	switch(vobj->p_anchor){
+	case ANCHORP_UR:
+		props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
+	break;
+	case ANCHORP_LR:
+		props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
+		props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
+	break;
+	case ANCHORP_LL:
+		props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
+	break;
+	case ANCHORP_CR:
+		props->position.y += vobj->parent->origh * vobj->parent->current.scale.y * 0.5;
+		props->position.x += vobj->parent->origw * vobj->parent->current.scale.x;
+	break;
+	case ANCHORP_C:
+	case ANCHORP_UC:
+	case ANCHORP_CL:
+	case ANCHORP_LC:{
+		float mid_y = (vobj->parent->origh * vobj->parent->current.scale.y) * 0.5;
+		float mid_x = (vobj->parent->origw * vobj->parent->current.scale.x) * 0.5;
+		if (vobj->p_anchor == ANCHORP_UC ||
+			vobj->p_anchor == ANCHORP_LC || vobj->p_anchor == ANCHORP_C)
+			props->position.x += mid_x;
+
+		if (vobj->p_anchor == ANCHORP_CL || vobj->p_anchor == ANCHORP_C)
+			props->position.y += mid_y;
+
+		if (vobj->p_anchor == ANCHORP_LC)
+			props->position.y += vobj->parent->origh * vobj->parent->current.scale.y;
+	}
+	case ANCHORP_UL:
+	default:
+	break;
+	}
+}
+
+/*
+ * Resolve the chain from the topmost unresolved ancestor downwards rather
+ * than recursing into the parent, stopping at the first ancestor that has a
+ * cached or already resolved state.
+ */
+void arcan_resolve_vidprop(arcan_vobject* vobj, float lerp,
+	surface_properties* props)
+{
+	arcan_vobject* chain[RESOLVE_CHAIN_LIMIT];
+	surface_properties base;
+	bool have_base = false;
+	size_t n = 0;
+
+	for (arcan_vobject* cur = vobj;;){
+		if (resolved_props(cur, lerp, &base)){
+			have_base = true;
+			break;
+		}
+
+		chain[n++] = cur;
+		if (!cur->parent || cur->parent == &current_context->world)
+			break;
+
+		if (n == RESOLVE_CHAIN_LIMIT){
+			base = empty_surface();
+			arcan_resolve_vidprop(cur->parent, lerp, &base);
+			have_base = true;
+			break;
+		}
+
+		cur = cur->parent;
+	}
+
+	if (!n){
+		*props = base;
+		return;
+	}
+
+/* the cache can only be used if there are no transforms in the chain */
+	bool can_cache = true;
+	for (arcan_vobject* cur = chain[n-1]->parent; cur; cur = cur->parent)
+		if (cur->transform){
+			can_cache = false;
+			break;
+		}
+
+	while (n--){
+		arcan_vobject* cur = chain[n];
+		surface_properties res = empty_surface();
+		can_cache = can_cache && !cur->transform;
+
+		if (have_base){
+			apply(cur, &res, &base, lerp, false);
+			apply_anchor(cur, &res);
+		}
+		else
+			apply(cur, &res, &current_context->world.current, lerp, true);
+
+/* when building draw lists in parallel, only the thread working on the
+ * owning rendertarget may populate the cache, others just read it */
+		if (can_cache && cur->owner && cur->valid_cache == false &&
+			(!build_rtgt || build_rtgt == cur->owner)){
+			surface_properties dprop = res;
+			cur->prop_cache = res;
+			build_modelview(cur->prop_matr, cur->owner->base, &dprop, cur);
+			__atomic_store_n(&cur->valid_cache, true, __ATOMIC_RELEASE);
+		}
+
+/* only during the batched pass, which is on the main thread */
+		if (tfpass.building){
+			cur->frame_world = res;
+			cur->frame_wgen = tfpass.gen;
+		}
+
+		base = res;
+		have_base = true;
+	}
+
+	*props = base;
+}
+
+/*
+ * Interpolate all running transforms for the refresh at [fract] and resolve
+ * the objects that carry them in order of depth. The results are used by
+ * apply / arcan_resolve_vidprop until tfpass_end.
+ */
+static void tfpass_begin(float fract)
+{
+	tfpass.gen++;
+	tfpass.lerp = fract;
+	tfpass.active = false;
+	tfpass.count = 0;
+
+	size_t counts[TF_CHANNELS][TF_NINTERP] = {0};
+
+/* first pass, collect the objects and the size of each group */
+	struct arcan_video_context* ctx = current_context;
+	for (size_t i = 0; i < ctx->tfactive_count;){
+		arcan_vobj_id id = ctx->tfactive[i];
+		arcan_vobject* vobj = id > 0 && id < ctx->vitem_limit ?
+			&ctx->vitems_pool[id] : NULL;
+
+		if (!vobj || !FL_TEST(vobj, FL_INUSE) ||
+			!vobj->transform || vobj->tfslot != i + 1){
+			tfactive_drop(ctx, i);
+			continue;
+		}
+		i++;
+
+		if (!tfpass_grow(tfpass.count + 1))
+			break;
+
+		surface_transform* tf = vobj->transform;
+		if (tf->move.startt && tf->move.interp < TF_NINTERP)
+			counts[TF_MOVE][tf->move.interp]++;
+		if (tf->scale.startt && tf->scale.interp < TF_NINTERP)
+			counts[TF_SCALE][tf->scale.interp]++;
+		if (tf->blend.startt && tf->blend.interp < TF_NINTERP)
+			counts[TF_BLEND][tf->blend.interp]++;
+
+		size_t depth = 0;
+		for (arcan_vobject* cur = vobj->parent; cur &&
+			cur != &current_context->world; cur = cur->parent)
+			depth++;
+
+		tfpass.order[tfpass.count] = ((uint64_t)depth << 32) | tfpass.count;
+		tfpass.obj[tfpass.count++] = vobj;
+	}
+
+	if (!tfpass.count)
+		return;
+
+/* group offsets, group[k] is used as the insertion cursor and ends up as the
+ * end of group k, with group[TF_NINTERP] as the total */
+	for (size_t c = 0; c < TF_CHANNELS; c++){
+		size_t ofs = 0;
+		for (size_t k = 0; k < TF_NINTERP; k++){
+			tfpass.ch[c].group[k] = ofs;
+			ofs += counts[c][k];
+		}
+		tfpass.ch[c].group[TF_NINTERP] = ofs;
+		tfpass.ch[c].count = ofs;
+	}
+
+	for (size_t i = 0; i < tfpass.count; i++){
+		arcan_vobject* vobj = tfpass.obj[i];
+		surface_transform* tf = vobj->transform;
+		vobj->frame_local = vobj->current;
+
+		if (tf->move.startt && tf->move.interp < TF_NINTERP)
+			tf_push(TF_MOVE, i, tf->move.interp, tf->move.startt,
+				tf->move.endt, tf->move.startp.xyz, tf->move.endp.xyz);
+
+		if (tf->scale.startt && tf->scale.interp < TF_NINTERP)
+			tf_push(TF_SCALE, i, tf->scale.interp, tf->scale.startt,
+				tf->scale.endt, tf->scale.startd.xyz, tf->scale.endd.xyz);
+
+		if (tf->blend.startt && tf->blend.interp < TF_NINTERP)
+			tf_push(TF_BLEND, i, tf->blend.interp, tf->blend.startt,
+				tf->blend.endt, &tf->blend.startopa, &tf->blend.endopa);
+	}
+
+	float ts = (float)arcan_video_display.c_ticks + fract;
+
+	for (size_t c = 0; c < TF_CHANNELS; c++){
+		struct tf_soa* ch = &tfpass.ch[c];
+		size_t nc = c == TF_BLEND ? 1 : 3;
+		if (!ch->count)
+			continue;
+
+		interp_fract_batch(ch->fract, ch->startt, ch->endt, ts, ch->count);
+
+/* linear is the first group and the only one that is batched, the others
+ * go through the same per-value functions as the non-batched path */
+		size_t n_lin = ch->group[0];
+		for (size_t j = 0; j < nc; j++)
+			interp_1d_linear_batch(ch->ov[j], ch->sv[j], ch->ev[j], ch->fract, n_lin);
+
+		for (size_t k = 1; k < TF_NINTERP; k++)
+			for (size_t i = ch->group[k-1]; i < ch->group[k]; i++){
+				if (nc == 1){
+					ch->ov[0][i] = lut_interp_1d[k](ch->sv[0][i], ch->ev[0][i], ch->fract[i]);
+					continue;
+				}
+				vector res = lut_interp_3d[k](
+					(vector){.x = ch->sv[0][i], .y = ch->sv[1][i], .z = ch->sv[2][i]},
+					(vector){.x = ch->ev[0][i], .y = ch->ev[1][i], .z = ch->ev[2][i]},
+					ch->fract[i]
+				);
+				ch->ov[0][i] = res.x;
+				ch->ov[1][i] = res.y;
+				ch->ov[2][i] = res.z;
+			}
+
+/* scatter back into the local state of each object */
+		for (size_t i = 0; i < ch->count; i++){
+			surface_properties* dst = &tfpass.obj[ch->ref[i]]->frame_local;
+			float* out = c == TF_MOVE ? dst->position.xyz :
+				(c == TF_SCALE ? dst->scale.xyz : &dst->opa);
+			for (size_t j = 0; j < nc; j++)
+				out[j] = ch->ov[j][i];
+		}
+	}
+
+/* rotation uses a per-transform quaternion function so there is no batch */
+	for (size_t i = 0; i < tfpass.count; i++){
+		arcan_vobject* vobj = tfpass.obj[i];
+		surface_transform* tf = vobj->transform;
+
+		if (tf->rotate.startt){
+			surface_properties* dst = &vobj->frame_local;
+			dst->rotation.quaternion = tf->rotate.interp(
+				tf->rotate.starto.quaternion, tf->rotate.endo.quaternion,
+				lerp_fract(tf->rotate.startt, tf->rotate.endt, ts)
+			);
+
+			vector ang = angle_quat(dst->rotation.quaternion);
+			dst->rotation.roll  = ang.x;
+			dst->rotation.pitch = ang.y;
+			dst->rotation.yaw   = ang.z;
+		}
+
+		vobj->frame_lgen = tfpass.gen;
+	}
+
+	tfpass.active = true;
+
+/* resolve parents before children so each object is only resolved once,
+ * any intermediate ancestors get recorded along the way */
+	qsort(tfpass.order, tfpass.count, sizeof(uint64_t), tf_depthcmp);
+	tfpass.building = true;
+	for (size_t i = 0; i < tfpass.count; i++){
+		arcan_vobject* vobj = tfpass.obj[tfpass.order[i] & 0xffffffff];
+		surface_properties dprops;
+		arcan_resolve_vidprop(vobj, fract, &dprops);
+	}
+	tfpass.building = false;
+}
+
+static void tfpass_end()
+{
+	tfpass.active = false;
+}
+
+static void calc_cp_area(arcan_vobject* vobj, point* ul, point* lr)
+{
+	surface_properties cur;
+	arcan_resolve_vidprop(vobj, 0.0, &cur);
+
+	ul->x = cur.position.x < ul->x ? cur.position.x : ul->x;
+	ul->y = cur.position.y < ul->y ? cur.position.y : ul->y;
+
+	float t1 = (cur.position.x + cur.scale.x * vobj->origw);
+	float t2 = (cur.position.y + cur.scale.y * vobj->origh);
+	lr->x = cur.position.x > t1 ? cur.position.x : t1;
+	lr->y = cur.position.y > t2 ? cur.position.y : t2;
+
+	if (vobj->parent && vobj->parent != &current_context->world)
+		calc_cp_area(vobj->parent, ul, lr);
+}
+
+static inline bool prop_rotated(const surface_properties* prop)
+{
+	return fabsf(prop->rotation.roll)  > EPSILON ||
+		fabsf(prop->rotation.pitch) > EPSILON ||
+		fabsf(prop->rotation.yaw)   > EPSILON;
+}
+
+static inline void build_modelview(float* dmatr,
+	float* imatr, surface_properties* prop, arcan_vobject* src)
+{
+	float _Alignas(16) omatr[16];
+	float _Alignas(16) tmatr[16];
+
+/* now position represents centerpoint in screen coordinates */
+	prop->scale.x *= src->origw * 0.5f;
+	prop->scale.y *= src->origh * 0.5f;
+	prop->position.x += prop->scale.x;
+	prop->position.y += prop->scale.y;
+
+/* this can run on a draw-list worker, so rotate_state is left for the
+ * main thread to update (see replay_cmdlist) */
+	bool rotated = prop_rotated(prop);
+
+	memcpy(tmatr, imatr, sizeof(float) * 16);
+
+	if (rotated){
+		if (FL_TEST(src, FL_FULL3D))
+			matr_quatf(norm_quat (prop->rotation.quaternion), omatr);
+		else
+			matr_rotatef(DEG2RAD(prop->rotation.roll), omatr);
 	}
 
 	point oofs = src->origo_ofs;
@@ -4560,7 +5680,7 @@ static inline void build_modelview(float* dmatr,
 	else
 		translate_matrix(tmatr, prop->position.x, prop->position.y, 0.0);
 
-	if (src->rotate_state)
+	if (rotated)
 		multiply_matrix(dmatr, tmatr, omatr);
 	else
 		memcpy(dmatr, tmatr, sizeof(float) * 16);
@@ -4632,20 +5752,6 @@ static inline void setup_surf(struct rendertarget* dst,
 	update_shenv(src, prop);
 }
 
-static inline void setup_shape_surf(struct rendertarget* dst,
-	surface_properties* prop, arcan_vobject* src, float** mv)
-{
-	static float _Alignas(16) dmatr[16];
-	surface_properties oldprop = *prop;
-	if (src->feed.state.tag == ARCAN_TAG_ASYNCIMGLD)
-		return;
-
-	build_modelview(dmatr, dst->base, prop, src);
-	*mv = dmatr;
-	scale_matrix(*mv, prop->scale.x, prop->scale.y, 1.0);
-	update_shenv(src, prop);
-}
-
 static inline void draw_colorsurf(struct rendertarget* dst,
 	surface_properties prop, arcan_vobject* src,
 	float r, float g, float b, float* txcos)
@@ -4661,41 +5767,6 @@ static inline void draw_colorsurf(struct rendertarget* dst,
 		prop.scale.x, prop.scale.y, txcos, mvm);
 }
 
-/*
- * When we deal with multiple AGP implementations, it probably makes sense
- * to move some of these steps to that layer, as there might be more backend
- * specific ways that are faster (particularly for software that can have
- * many fastpaths)
- */
-static inline void draw_texsurf(struct rendertarget* dst,
-	surface_properties prop, arcan_vobject* src, float* txcos)
-{
-	float* mvm = NULL;
-/*
- * Shape is treated mostly as a simplified 3D model but with an ortographic
- * projection and no hierarchy of meshes etc. we still need to switch to 3D
- * mode so we get a depth buffer to work with as there might be vertex- stage Z
- * displacement. This switch is slightly expensive (depth-buffer clear) though
- * used for such fringe cases that it's only a problem when measured as such.
- */
-	if (src->shape){
-		if (!src->shape->nodepth)
-			agp_pipeline_hint(PIPELINE_3D);
-
-		setup_shape_surf(dst, &prop, src, &mvm);
-		agp_shader_envv(MODELVIEW_MATR, mvm, sizeof(float) * 16);
-		agp_submit_mesh(src->shape, MESH_FACING_BOTH);
-
-		if (!src->shape->nodepth)
-			agp_pipeline_hint(PIPELINE_2D);
-	}
-	else {
-		setup_surf(dst, &prop, src, &mvm);
-		agp_draw_vobj(
-			-prop.scale.x, -prop.scale.y, prop.scale.x, prop.scale.y, txcos, mvm);
-	}
-}
-
 /*
  * Perform an explicit poll pass of the object in question.
  * Assumes [dst] is valid.
@@ -4867,10 +5938,8 @@ void arcan_vint_bindmulti(arcan_vobject* elem, size_t ind)
  * customized texture coordinates.
  */
 static inline bool setup_shallow_texclip(arcan_vobject* elem,
-	float** txcos, surface_properties* dprops, float fract)
+	float** txcos, float* cliptxbuf, surface_properties* dprops, float fract)
 {
-	static float cliptxbuf[8];
-
 	surface_properties pprops = empty_surface();
 	arcan_resolve_vidprop(elem->parent, fract, &pprops);
 
@@ -4896,7 +5965,8 @@ static inline bool setup_shallow_texclip(arcan_vobject* elem,
 	else if (	cp_x >= p_x && cp_xw <= p_xw && cp_y >= p_y && cp_yh <= p_yh )
 		return true;
 
-	memcpy(cliptxbuf, *txcos, sizeof(float) * 8);
+	memcpy(cliptxbuf,
+		*txcos ? *txcos : arcan_video_display.default_txcos, sizeof(float) * 8);
 	float xrange = cliptxbuf[2] - cliptxbuf[0];
 	float yrange = cliptxbuf[7] - cliptxbuf[1];
 
@@ -4936,8 +6006,6 @@ static inline bool setup_shallow_texclip(arcan_vobject* elem,
 	dprops->scale.x = cp_w / elem->origw;
 	dprops->scale.y = cp_h / elem->origh;
 
-/* this is expensive, we should instead temporarily offset */
-	elem->valid_cache = false;
 	*txcos = cliptxbuf;
 	return true;
 }
@@ -4948,59 +6016,100 @@ struct rendertarget* arcan_vint_current_rt()
 	return current_rendertarget;
 }
 
-static size_t process_rendertarget(struct rendertarget* tgt, float fract)
-{
-	arcan_vobject_litem* current;
-	if (tgt->link){
-		current = tgt->link->first;
-		tgt->dirtyc += tgt->link->dirtyc;
-		tgt->transfc += tgt->link->transfc;
-	}
-	else
-		current = tgt->first;
+/*
+ * Drawing a rendertarget is split in two: building a list of draw commands
+ * (resolving properties, clipping, modelviews) which only touches the CPU
+ * side and can run on a worker thread, and replaying that list which is the
+ * only part that talks to AGP and has to stay on the main thread.
+ */
+enum rcmd_mv {
+	RCMD_MV_NONE = 0,
+	RCMD_MV_LOCAL,
+	RCMD_MV_CACHED
+};
 
-	if (arcan_video_display.ignore_dirty == 0 &&
-		(!tgt->link && tgt->dirtyc == 0 && tgt->transfc == 0))
-		return 0;
+struct rtgt_cmd {
+	_Alignas(16) float mv[16];
+	float cliptx[8];
+	float* txcos;
+	surface_properties prop;
+	arcan_vobject* elem;
+	enum rcmd_mv mvmode;
+	bool texclip;
+	bool colorsurf;
+	bool stencil;
+	bool rotated;
+};
 
-	current_rendertarget = tgt;
-	agp_activate_rendertarget(tgt->art);
-	agp_shader_envv(RTGT_ID, &tgt->id, sizeof(int));
-	agp_shader_envv(OBJ_OPACITY, &(float){1.0}, sizeof(float));
+struct rtgt_cmdlist {
+	struct rtgt_cmd* cmds;
+	size_t count;
+	size_t limit;
+};
 
-	if (!FL_TEST(tgt, TGTFL_NOCLEAR))
-		agp_rendertarget_clear();
+/* one list per possible job (rendertargets + world) and one for the inline
+ * path (tick clocked rendertargets, forceupdate), reused between frames */
+static struct rtgt_cmdlist rtgt_cmdlists[RENDERTARGET_LIMIT + 2];
+#define RTGT_INLINE_LIST (RENDERTARGET_LIMIT + 1)
 
-	size_t pc = arcan_video_display.ignore_dirty ? 1 : 0;
+static bool grow_cmdlist(struct rtgt_cmdlist* dst)
+{
+	size_t nl = dst->limit ? dst->limit * 2 : 64;
+	struct rtgt_cmd* cmds = arcan_alloc_mem(sizeof(struct rtgt_cmd) * nl,
+		ARCAN_MEM_VSTRUCT, ARCAN_MEM_NONFATAL, ARCAN_MEMALIGN_SIMD);
 
-/* first, handle all 3d work (which may require multiple passes etc.) */
-	if (tgt->order3d == ORDER3D_FIRST && current && current->elem->order < 0){
-		current = arcan_3d_refresh(tgt->camtag, current, fract);
-		pc++;
+	if (!cmds)
+		return false;
+
+	if (dst->cmds){
+		memcpy(cmds, dst->cmds, sizeof(struct rtgt_cmd) * dst->count);
+		arcan_mem_free(dst->cmds);
 	}
 
-/* skip a possible 3d pipeline */
-	while (current && current->elem->order < 0)
-		current = current->next;
+	dst->cmds = cmds;
+	dst->limit = nl;
+	return true;
+}
 
-	if (!current)
-		goto end3d;
+/*
+ * Accumulate the dirty state from a linked target and check if there is
+ * anything to do, this does not look at the object list.
+ */
+static bool rtgt_skip(struct rendertarget* tgt)
+{
+	if (tgt->link){
+		tgt->dirtyc += tgt->link->dirtyc;
+		tgt->transfc += tgt->link->transfc;
+		return false;
+	}
 
-/* make sure we're in a decent state for 2D */
-	agp_pipeline_hint(PIPELINE_2D);
+	return arcan_video_display.ignore_dirty == 0 &&
+		tgt->dirtyc == 0 && tgt->transfc == 0;
+}
 
-	agp_shader_activate(agp_default_shader(BASIC_2D));
-	agp_shader_envv(PROJECTION_MATR, tgt->projection, sizeof(float)*16);
+/*
+ * Build the draw commands for the 2D part of [tgt]. This may run on a worker
+ * thread in parallel with other rendertargets so it must not call into AGP
+ * or modify any object state beyond the property cache of objects that [tgt]
+ * owns (see arcan_resolve_vidprop).
+ */
+static void build_cmdlist(
+	struct rendertarget* tgt, struct rtgt_cmdlist* dst, float fract)
+{
+	build_rtgt = tgt;
+	dst->count = 0;
+
+	arcan_vobject_litem* current = tgt->link ? tgt->link->first : tgt->first;
+	while (current && current->elem->order < 0)
+		current = current->next;
 
-	while (current && current->elem->order >= 0){
+	for (; current && current->elem->order >= 0; current = current->next){
 		arcan_vobject* elem = current->elem;
 
-		if (current->elem->order < tgt->min_order){
-			current = current->next;
+		if (elem->order < tgt->min_order)
 			continue;
-		}
 
-		if (current->elem->order > tgt->max_order)
+		if (elem->order > tgt->max_order)
 			break;
 
 /* calculate coordinate system translations, world cannot be masked */
@@ -5008,34 +6117,182 @@ static size_t process_rendertarget(struct rendertarget* tgt, float fract)
 		arcan_resolve_vidprop(elem, fract, &dprops);
 
 /* don't waste time on objects that aren't supposed to be visible */
-		if ( dprops.opa <= EPSILON || elem == tgt->color){
-			current = current->next;
+		if (dprops.opa <= EPSILON || elem == tgt->color)
 			continue;
-		}
 
-/* enable clipping using stencil buffer, we need to reset the state of the
- * stencil buffer between draw calls so track if it's enabled or not */
-		bool clipped = false;
+		if (dst->count == dst->limit && !grow_cmdlist(dst))
+			break;
+
+		struct rtgt_cmd* cmd = &dst->cmds[dst->count];
+		cmd->elem = elem;
+		cmd->stencil = false;
+		cmd->rotated = prop_rotated(&dprops);
 
 /*
  * texture coordinates that will be passed to the draw call, clipping and other
  * effects may maintain a local copy and manipulate these
  */
-		float* txcos = elem->txcos;
-		float** dstcos = &txcos;
-
+		cmd->txcos = elem->txcos;
 		if ( (elem->mask & MASK_MAPPING) > 0)
-			txcos = elem->parent != &current_context->world ?
+			cmd->txcos = elem->parent != &current_context->world ?
 				elem->parent->txcos : elem->txcos;
 
-		if (!txcos)
-			txcos = arcan_video_display.default_txcos;
+		if (!cmd->txcos)
+			cmd->txcos = arcan_video_display.default_txcos;
+
+		if (elem->frameset &&
+			elem->frameset->mode != ARCAN_FRAMESET_MULTITEXTURE)
+			cmd->txcos = elem->frameset->frames[elem->frameset->index].txcos;
+
+/* a common clipping situation is that we have an invisible clipping parent
+ * where neither objects is in a rotated state, which gives an easy way
+ * out through the drawing region */
+		cmd->texclip = false;
+		if (elem->clip == ARCAN_CLIP_SHALLOW &&
+			elem->parent != &current_context->world && !cmd->rotated){
+			float* txcos = cmd->txcos;
+			if (!setup_shallow_texclip(elem, &txcos, cmd->cliptx, &dprops, fract))
+				continue;
+
+/* the list may move when it grows, so track this rather than the pointer */
+			cmd->texclip = txcos == cmd->cliptx;
+		}
+/* the stencil needs to be drawn as part of the submission */
+		else if (elem->clip != ARCAN_CLIP_OFF &&
+			elem->parent != &current_context->world)
+			cmd->stencil = true;
+
+		cmd->colorsurf =
+			elem->vstore->txmapped == TXSTATE_OFF && elem->program != 0;
+
+/* the cached modelview is only valid for the owner and the unclipped case */
+		if (elem->feed.state.tag == ARCAN_TAG_ASYNCIMGLD)
+			cmd->mvmode = RCMD_MV_NONE;
+
+		else if (elem->shape && !cmd->colorsurf){
+			build_modelview(cmd->mv, tgt->base, &dprops, elem);
+			scale_matrix(cmd->mv, dprops.scale.x, dprops.scale.y, 1.0);
+			cmd->mvmode = RCMD_MV_LOCAL;
+		}
+		else if (!cmd->texclip && tgt == elem->owner && elem->valid_cache){
+			dprops.scale.x *= elem->origw * 0.5f;
+			dprops.scale.y *= elem->origh * 0.5f;
+			dprops.position.x += dprops.scale.x;
+			dprops.position.y += dprops.scale.y;
+			cmd->mvmode = RCMD_MV_CACHED;
+		}
+		else {
+			build_modelview(cmd->mv, tgt->base, &dprops, elem);
+			cmd->mvmode = RCMD_MV_LOCAL;
+		}
+
+		cmd->prop = dprops;
+		dst->count++;
+	}
+
+	build_rtgt = NULL;
+}
+
+static enum arcan_blendfunc cmd_blendmode(struct rtgt_cmd* cmd)
+{
+	arcan_vobject* elem = cmd->elem;
+
+	if (cmd->prop.opa < 1.0 - EPSILON || elem->blendmode == BLEND_NONE)
+		return elem->blendmode;
+
+	return elem->blendmode == BLEND_FORCE ? BLEND_FORCE : BLEND_NORMAL;
+}
+
+/*
+ * Plain quads with the default shaders only differ in transform, opacity and
+ * color, which the batch shaders take per vertex, so a run of them that share
+ * store and blend state can be drawn with a single call.
+ */
+static bool cmd_batchable(struct rtgt_cmd* cmd)
+{
+	arcan_vobject* elem = cmd->elem;
+
+	if (cmd->stencil || cmd->mvmode == RCMD_MV_NONE || elem->shape ||
+		(elem->frameset && elem->frameset->mode == ARCAN_FRAMESET_MULTITEXTURE))
+		return false;
+
+	if (cmd->colorsurf)
+		return elem->program == agp_default_shader(COLOR_2D);
+
+	return elem->vstore->txmapped == TXSTATE_TEX2D &&
+		(elem->program == 0 || elem->program == agp_default_shader(BASIC_2D));
+}
+
+static size_t replay_cmdlist(
+	struct rendertarget* tgt, struct rtgt_cmdlist* src, float fract)
+{
+	size_t pc = 0;
+	struct {
+		bool active;
+		agp_shader_id shid;
+		struct agp_vstore* store;
+		enum arcan_blendfunc blend;
+	} batch = {0};
+
+/* make sure we're in a decent state for 2D */
+	agp_pipeline_hint(PIPELINE_2D);
+
+	agp_shader_activate(agp_default_shader(BASIC_2D));
+	agp_shader_envv(PROJECTION_MATR, tgt->projection, sizeof(float)*16);
+
+	for (size_t i = 0; i < src->count; i++){
+		struct rtgt_cmd* cmd = &src->cmds[i];
+		arcan_vobject* elem = cmd->elem;
+		float* txcos = cmd->texclip ? cmd->cliptx : cmd->txcos;
+		float sx = cmd->prop.scale.x;
+		float sy = cmd->prop.scale.y;
+
+/* the workers only record rotation, hittest and friends read it from here */
+		elem->rotate_state = cmd->rotated;
+
+		if (!arcan_video_display.no_batch && cmd_batchable(cmd)){
+			struct agp_vstore* store = elem->frameset ?
+				elem->frameset->frames[elem->frameset->index].frame : elem->vstore;
+			agp_shader_id shid =
+				agp_default_shader(cmd->colorsurf ? BATCH_COLOR_2D : BATCH_2D);
+			enum arcan_blendfunc blend = cmd_blendmode(cmd);
+
+			if (!batch.active || batch.shid != shid ||
+				batch.store != store || batch.blend != blend){
+				agp_batch_flush();
+				if (!cmd->colorsurf)
+					agp_activate_vstore(store);
+				agp_shader_activate(shid);
+				agp_blendstate(blend);
+				batch.active = true;
+				batch.shid = shid;
+				batch.store = store;
+				batch.blend = blend;
+			}
+
+			float col[4] = {1.0, 1.0, 1.0, cmd->prop.opa};
+			if (cmd->colorsurf){
+				col[0] = elem->vstore->vinf.col.r;
+				col[1] = elem->vstore->vinf.col.g;
+				col[2] = elem->vstore->vinf.col.b;
+			}
+
+			agp_batch_vobj(-sx, -sy, sx, sy, txcos, cmd->mvmode == RCMD_MV_CACHED ?
+				elem->prop_matr : cmd->mv, col);
+			pc++;
+			continue;
+		}
+
+/* anything else is drawn on its own and sets up its own state */
+		if (batch.active){
+			agp_batch_flush();
+			batch.active = false;
+		}
 
 /* depending on frameset- mode, we may need to split the frameset up into
- * multitexturing, or switch the txcos with the ones that may be used for
- * clipping, but mapping TU indices to current shader must be done before.
- * To not skip on the early-out-on-clipping and not incur additional state
- * change costs, only do it in this edge case. */
+ * multitexturing, but mapping TU indices to current shader must be done
+ * before. To not incur additional state change costs, only do it in this
+ * edge case. */
 		bool shader_sw = false;
 		agp_shader_id shid = elem->program > 0 ?
 			elem->program : agp_default_shader(BASIC_2D);
@@ -5046,60 +6303,108 @@ static size_t process_rendertarget(struct rendertarget* tgt, float fract)
 				shader_sw = true;
 				arcan_vint_bindmulti(elem, elem->frameset->index);
 			}
-			else{
-				struct frameset_store* ds =
-					&elem->frameset->frames[elem->frameset->index];
-				txcos = ds->txcos;
-				agp_activate_vstore(ds->frame);
-			}
+			else
+				agp_activate_vstore(
+					elem->frameset->frames[elem->frameset->index].frame);
 		}
 		else
 			agp_activate_vstore(elem->vstore);
 
-/* a common clipping situation is that we have an invisible clipping parent
- * where neither objects is in a rotated state, which gives an easy way
- * out through the drawing region */
-		if (elem->clip == ARCAN_CLIP_SHALLOW &&
-			elem->parent != &current_context->world && !elem->rotate_state){
-			if (!setup_shallow_texclip(elem, dstcos, &dprops, fract)){
-				current = current->next;
-				continue;
-			}
-		}
-		else if (elem->clip != ARCAN_CLIP_OFF &&
-			elem->parent != &current_context->world){
-			clipped = true;
+/* enable clipping using stencil buffer, we need to reset the state of the
+ * stencil buffer between draw calls so track if it's enabled or not */
+		if (cmd->stencil)
 			populate_stencil(tgt, elem, fract);
+
+		if (!shader_sw)
+			agp_shader_activate(shid);
+
+		agp_blendstate(cmd_blendmode(cmd));
+
+		float* mvm = NULL;
+		if (cmd->mvmode != RCMD_MV_NONE){
+			mvm = cmd->mvmode == RCMD_MV_CACHED ? elem->prop_matr : cmd->mv;
+			update_shenv(elem, &cmd->prop);
 		}
 
-		if (!shader_sw)
-			agp_shader_activate(shid);
+		if (cmd->colorsurf){
+			float cval[3] = {
+				elem->vstore->vinf.col.r,
+				elem->vstore->vinf.col.g,
+				elem->vstore->vinf.col.b
+			};
+			agp_shader_forceunif("obj_col", shdrvec3, (void*) &cval);
+			agp_draw_vobj(-sx, -sy, sx, sy, txcos, mvm);
+		}
+		else if (elem->vstore->txmapped == TXSTATE_TEX2D){
+/*
+ * Shape is treated mostly as a simplified 3D model but with an ortographic
+ * projection and no hierarchy of meshes etc. we still need to switch to 3D
+ * mode so we get a depth buffer to work with as there might be vertex- stage Z
+ * displacement. This switch is slightly expensive (depth-buffer clear) though
+ * used for such fringe cases that it's only a problem when measured as such.
+ */
+			if (elem->shape){
+				if (mvm){
+					if (!elem->shape->nodepth)
+						agp_pipeline_hint(PIPELINE_3D);
+
+					agp_shader_envv(MODELVIEW_MATR, mvm, sizeof(float) * 16);
+					agp_submit_mesh(elem->shape, MESH_FACING_BOTH);
+
+					if (!elem->shape->nodepth)
+						agp_pipeline_hint(PIPELINE_2D);
+				}
+			}
+			else
+				agp_draw_vobj(-sx, -sy, sx, sy, txcos, mvm);
+		}
+		pc++;
+
+		if (cmd->stencil)
+			agp_disable_stencil();
+	}
+
+	agp_batch_flush();
+	return pc;
+}
+
+static size_t process_rendertarget(struct rendertarget* tgt, float fract)
+{
+/* the list might already have been built as part of a refresh, otherwise
+ * the dirty check is done here before touching the list of objects */
+	struct rtgt_cmdlist* cmds = tgt->cmds;
+	tgt->cmds = NULL;
 
-		if (dprops.opa < 1.0 - EPSILON || elem->blendmode == BLEND_NONE)
-			agp_blendstate(elem->blendmode);
-		else
-			if (elem->blendmode == BLEND_FORCE)
-				agp_blendstate(elem->blendmode);
-			else
-				agp_blendstate(BLEND_NORMAL);
+	if (!cmds){
+		if (rtgt_skip(tgt))
+			return 0;
 
-		if (elem->vstore->txmapped == TXSTATE_OFF && elem->program != 0)
-			draw_colorsurf(tgt, dprops, elem, elem->vstore->vinf.col.r,
-				elem->vstore->vinf.col.g, elem->vstore->vinf.col.b, *dstcos);
-		else if (elem->vstore->txmapped == TXSTATE_TEX2D)
-			draw_texsurf(tgt, dprops, elem, *dstcos);
-		else
-			;
-		pc++;
+		cmds = &rtgt_cmdlists[RTGT_INLINE_LIST];
+		build_cmdlist(tgt, cmds, fract);
+	}
 
-		if (clipped)
-			agp_disable_stencil();
+	arcan_vobject_litem* current = tgt->link ? tgt->link->first : tgt->first;
 
-		current = current->next;
+	current_rendertarget = tgt;
+	agp_activate_rendertarget(tgt->art);
+	agp_shader_envv(RTGT_ID, &tgt->id, sizeof(int));
+	agp_shader_envv(OBJ_OPACITY, &(float){1.0}, sizeof(float));
+
+	if (!FL_TEST(tgt, TGTFL_NOCLEAR))
+		agp_rendertarget_clear();
+
+	size_t pc = arcan_video_display.ignore_dirty ? 1 : 0;
+
+/* first, handle all 3d work (which may require multiple passes etc.) */
+	if (tgt->order3d == ORDER3D_FIRST && current && current->elem->order < 0){
+		arcan_3d_refresh(tgt->camtag, current, fract);
+		pc++;
 	}
 
+	if (cmds->count)
+		pc += replay_cmdlist(tgt, cmds, fract);
+
 /* reset and try the 3d part again if requested */
-end3d:
 	current = tgt->first;
 	if (current && current->elem->order < 0 && tgt->order3d == ORDER3D_LAST){
 		agp_shader_activate(agp_default_shader(BASIC_2D));
@@ -5111,6 +6416,128 @@ end3d:
 	return pc;
 }
 
+/*
+ * Worker pool for building rendertarget draw lists. Threads are spawned on
+ * first use and then sleep on [work] until the main thread posts a new
+ * generation of jobs, each thread (main included) picks jobs by bumping
+ * [next] until they run out.
+ */
+static struct {
+	pthread_mutex_t lock;
+	pthread_cond_t work;
+	pthread_cond_t done;
+	unsigned gen;
+	size_t n_threads;
+	size_t pending;
+
+	struct rendertarget** jobs;
+	size_t n_jobs;
+	_Atomic size_t next;
+	float fract;
+
+	bool init;
+} rtgt_pool = {
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.work = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER
+};
+
+static void rtgt_pool_run()
+{
+	size_t ind;
+	while ((ind = atomic_fetch_add(&rtgt_pool.next, 1)) < rtgt_pool.n_jobs){
+		struct rendertarget* tgt = rtgt_pool.jobs[ind];
+		build_cmdlist(tgt, &rtgt_cmdlists[ind], rtgt_pool.fract);
+		tgt->cmds = &rtgt_cmdlists[ind];
+	}
+}
+
+static void* rtgt_pool_worker(void* arg)
+{
+	unsigned gen = 0;
+
+	pthread_mutex_lock(&rtgt_pool.lock);
+	for(;;){
+		while (gen == rtgt_pool.gen)
+			pthread_cond_wait(&rtgt_pool.work, &rtgt_pool.lock);
+		gen = rtgt_pool.gen;
+		pthread_mutex_unlock(&rtgt_pool.lock);
+
+		rtgt_pool_run();
+
+		pthread_mutex_lock(&rtgt_pool.lock);
+		if (--rtgt_pool.pending == 0)
+			pthread_cond_signal(&rtgt_pool.done);
+	}
+
+	return NULL;
+}
+
+static void rtgt_pool_setup()
+{
+	rtgt_pool.init = true;
+
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nt = ncpu > 1 ? ncpu - 1 : 0;
+	if (nt > RTGT_BUILD_THREADS)
+		nt = RTGT_BUILD_THREADS;
+
+	const char* env = getenv("ARCAN_VIDEO_RTGT_THREADS");
+	if (env){
+		size_t lim = strtoul(env, NULL, 10);
+		if (lim < nt)
+			nt = lim;
+	}
+
+	pthread_attr_t jattr;
+	pthread_attr_init(&jattr);
+	pthread_attr_setdetachstate(&jattr, PTHREAD_CREATE_DETACHED);
+
+	for (size_t i = 0; i < nt; i++){
+		pthread_t pthr;
+		if (0 != pthread_create(&pthr, &jattr, rtgt_pool_worker, NULL)){
+			arcan_warning("rendertarget worker thread creation failed\n");
+			break;
+		}
+		rtgt_pool.n_threads++;
+	}
+
+	pthread_attr_destroy(&jattr);
+}
+
+/*
+ * Build the draw lists for [jobs], in parallel if there are threads to spare
+ * and more than one job, otherwise inline.
+ */
+static void build_cmdlists(struct rendertarget** jobs, size_t n, float fract)
+{
+	if (n > 1 && !rtgt_pool.init)
+		rtgt_pool_setup();
+
+	rtgt_pool.jobs = jobs;
+	rtgt_pool.n_jobs = n;
+	rtgt_pool.fract = fract;
+	atomic_store(&rtgt_pool.next, 0);
+
+	if (n < 2 || !rtgt_pool.n_threads){
+		rtgt_pool_run();
+		return;
+	}
+
+	pthread_mutex_lock(&rtgt_pool.lock);
+	rtgt_pool.pending = rtgt_pool.n_threads;
+	rtgt_pool.gen++;
+	pthread_cond_broadcast(&rtgt_pool.work);
+	pthread_mutex_unlock(&rtgt_pool.lock);
+
+	rtgt_pool_run();
+
+	pthread_mutex_lock(&rtgt_pool.lock);
+	while (rtgt_pool.pending)
+		pthread_cond_wait(&rtgt_pool.done, &rtgt_pool.lock);
+	pthread_mutex_unlock(&rtgt_pool.lock);
+}
+
 arcan_errc arcan_video_forceread(arcan_vobj_id sid, bool local,
 	av_pixel** dptr, size_t* dsize)
 {
@@ -5242,10 +6669,12 @@ void arcan_vint_pollreadback(struct rendertarget* tgt)
 	FL_CLEAR(tgt, TGTFL_READING);
 }
 
-static size_t steptgt(float fract, struct rendertarget* tgt)
+/*
+ * Check if a frame-clocked rendertarget is due for an update this refresh,
+ * this steps the refresh counter so should only be called once per target.
+ */
+static bool steptgt_due(float fract, struct rendertarget* tgt)
 {
-	size_t transfc = 0;
-
 /* A special case here are rendertargets where the color output store
  * is explicitly bound only to a frameserver. This requires that:
  * 1. The frameserver is still waiting to synch
@@ -5258,18 +6687,22 @@ static size_t steptgt(float fract, struct rendertarget* tgt)
 		arcan_ffunc_lookup(dst->feed.ffunc)
 			(FFUNC_POLL, 0, 0, 0, 0, 0, dst->feed.state, dst->cellid) == FRV_GOTFRAME)
 	{
-		return transfc;
+		return false;
 	}
 
-	if (tgt->refresh < 0 && process_counter(tgt,
-		&tgt->refreshcnt, tgt->refresh, fract)){
-		process_rendertarget(tgt, fract);
-		transfc = tgt->transfc;
-		tgt->dirtyc = 0;
+	return tgt->refresh < 0 && process_counter(tgt,
+		&tgt->refreshcnt, tgt->refresh, fract);
+}
+
+static size_t steptgt(float fract, struct rendertarget* tgt)
+{
+	process_rendertarget(tgt, fract);
+	size_t transfc = tgt->transfc;
+	tgt->dirtyc = 0;
+
 /* may need to readback even if we havn't updated as it may
  * be used as clock (though optimization possibility of using buffer) */
-		process_readback(tgt, fract);
-	}
+	process_readback(tgt, fract);
 	return transfc;
 }
 
@@ -5288,23 +6721,59 @@ unsigned arcan_vint_refresh(float fract, size_t* ndirty)
 	if (arcan_video_display.ignore_dirty > 0)
 		arcan_video_display.ignore_dirty--;
 
-/* rendertargets may be composed on world- output, begin there */
-	for (size_t ind = 0; ind < current_context->n_rtargets; ind++){
-		struct rendertarget* tgt = &current_context->rtargets[ind];
+/* rendertargets may be composed on world- output, so that is the last one */
+	size_t n_tgt = current_context->n_rtargets;
+	struct rendertarget* tgts[RENDERTARGET_LIMIT + 1];
+	struct rendertarget* jobs[RENDERTARGET_LIMIT + 1];
+	bool due[RENDERTARGET_LIMIT + 1];
+	size_t n_jobs = 0;
+	bool any_due = false;
+
+	for (size_t ind = 0; ind < n_tgt; ind++)
+		tgts[ind] = &current_context->rtargets[ind];
+	tgts[n_tgt++] = &current_context->stdoutp;
+
+/* figure out which targets will be drawn without looking at their object
+ * lists, linked ones share objects with their source and are built inline */
+	for (size_t ind = 0; ind < n_tgt; ind++){
+		struct rendertarget* tgt = tgts[ind];
 		tgt->dirtyc += arcan_video_display.dirty;
-		transfc += steptgt(fract, tgt);
+		due[ind] = steptgt_due(fract, tgt);
+		any_due |= due[ind];
+
+		if (due[ind] && !tgt->link && !rtgt_skip(tgt))
+			jobs[n_jobs++] = tgt;
 	}
 
+/* the CPU side of all targets can be done ahead of the submission,
+ * starting with the interpolation of everything that is moving */
+	if (any_due)
+		tfpass_begin(fract);
+
+	build_cmdlists(jobs, n_jobs, fract);
+
+	for (size_t ind = 0; ind < n_tgt; ind++){
 /* reset the bound rendertarget, otherwise we may be in an undefined
  * state if world isn't dirty or with pending transfers */
-	current_rendertarget = NULL;
-	agp_activate_rendertarget(NULL);
+		if (ind == n_tgt - 1){
+			current_rendertarget = NULL;
+			agp_activate_rendertarget(NULL);
+		}
+
+		if (due[ind])
+			transfc += steptgt(fract, tgts[ind]);
+	}
 
-	current_context->stdoutp.dirtyc += arcan_video_display.dirty;
-	transfc += steptgt(fract, &current_context->stdoutp);
+	tfpass_end();
 	*ndirty = arcan_video_display.dirty;
 	arcan_video_display.dirty = transfc;
 
+	agp_drawstats(&arcan_video_display.draws.calls,
+		&arcan_video_display.draws.quads, true);
+	arcan_video_display.draws_total.calls += arcan_video_display.draws.calls;
+	arcan_video_display.draws_total.quads += arcan_video_display.draws.quads;
+	arcan_video_display.draws_refreshes++;
+
 	long long int post = arcan_timemillis();
 	return post - pre;
 }
@@ -5466,57 +6935,422 @@ static inline bool obj_visible(arcan_vobject* vobj)
 	return visible;
 }
 
-size_t arcan_video_rpick(arcan_vobj_id rt,
-	arcan_vobj_id* dst, size_t lim, int x, int y)
+/*
+ * Spatial index for pick / rpick. The screen space of each rendertarget is
+ * split into a uniform grid where each cell has the objects whose (cached)
+ * bounding box overlaps it. Only objects with a valid property cache get
+ * binned as everything else (running transforms, parent chains with running
+ * transforms, 3d objects) would need to be re-binned every tick. Those go in
+ * a 'volatile' set that is always tested, and are moved to the grid when
+ * their cache becomes valid.
+ *
+ * Geometry changes are tracked through invalidate_cache, which queues the
+ * object on its owner index. Attach and detach add or remove the entry
+ * directly. Each entry carries a key of (order, attach stamp) which sorts
+ * the same way as the list does, as attach_object inserts after equals. The
+ * stamps are re-assigned from the list when the index is (re)built.
+ */
+#ifndef PICK_CELL_SZ
+#define PICK_CELL_SZ 64
+#endif
+
+struct pick_ent {
+	arcan_vobject* obj;
+	uint64_t seq;
+};
+
+struct pick_list {
+	struct pick_ent* ents;
+	size_t count, limit;
+};
+
+struct pick_index {
+	struct pick_list* cells;
+	size_t cols, rows;
+	size_t w, h;
+	uint32_t stamp;
+	bool rebuild;
+	bool fail;
+
+	struct pick_list vol;
+	struct pick_list dirty;
+	struct pick_list hits;
+};
+
+static bool pick_push(struct pick_list* dst, arcan_vobject* obj, uint64_t seq)
 {
-	size_t count = 0;
-	arcan_vobject* vobj = arcan_video_getobject(rt);
-	struct rendertarget* tgt = arcan_vint_findrt(vobj);
+	if (dst->count == dst->limit){
+		size_t nl = dst->limit ? dst->limit * 2 : 8;
+		struct pick_ent* ents = arcan_alloc_mem(sizeof(struct pick_ent) * nl,
+			ARCAN_MEM_VSTRUCT, ARCAN_MEM_NONFATAL, ARCAN_MEMALIGN_NATURAL);
+		if (!ents)
+			return false;
 
-	if (lim == 0 || !tgt || !tgt->first)
-		return count;
+		if (dst->ents){
+			memcpy(ents, dst->ents, sizeof(struct pick_ent) * dst->count);
+			arcan_mem_free(dst->ents);
+		}
+		dst->ents = ents;
+		dst->limit = nl;
+	}
+
+	dst->ents[dst->count++] = (struct pick_ent){.obj = obj, .seq = seq};
+	return true;
+}
+
+static void pick_drop(struct rendertarget* tgt)
+{
+	struct pick_index* idx = tgt->pick;
+	if (!idx)
+		return;
+
+	for (size_t i = 0; i < idx->cols * idx->rows; i++)
+		arcan_mem_free(idx->cells[i].ents);
+	arcan_mem_free(idx->cells);
+
+	arcan_mem_free(idx->vol.ents);
+	arcan_mem_free(idx->dirty.ents);
+	arcan_mem_free(idx->hits.ents);
+	arcan_mem_free(idx);
+	tgt->pick = NULL;
+}
+
+static void pick_remove(struct pick_list* dst, arcan_vobject* obj)
+{
+	for (size_t i = 0; i < dst->count; i++)
+		if (dst->ents[i].obj == obj){
+			dst->ents[i] = dst->ents[--dst->count];
+			return;
+		}
+}
+
+/* sorts as the list does, order first then the order of attachment */
+static inline uint64_t pick_key(struct pick_index* idx, int order)
+{
+	return ((uint64_t)((uint32_t) order ^ 0x80000000) << 32) | idx->stamp++;
+}
+
+/* geometry change of a single object, re-bin on the next query */
+static void pick_mark(arcan_vobject* vobj)
+{
+	if (!vobj->owner || !vobj->owner->pick ||
+		vobj->owner->pick->rebuild || vobj->pick.queued)
+		return;
 
+	if (pick_push(&vobj->owner->pick->dirty, vobj, 0))
+		vobj->pick.queued = true;
+	else
+		vobj->owner->pick->fail = true;
+}
+
+static void pick_unbin(struct pick_index* idx, arcan_vobject* vobj)
+{
+	if (!vobj->pick.binned)
+		return;
+
+	for (size_t y = vobj->pick.y1; y <= vobj->pick.y2; y++)
+		for (size_t x = vobj->pick.x1; x <= vobj->pick.x2; x++){
+			struct pick_list* cell = &idx->cells[y * idx->cols + x];
+			for (size_t i = 0; i < cell->count; i++)
+				if (cell->ents[i].obj == vobj){
+					cell->ents[i] = cell->ents[--cell->count];
+					break;
+				}
+		}
+
+	vobj->pick.binned = false;
+}
+
+static inline size_t pick_clamp(float v, size_t n)
+{
+	if (v < 0)
+		return 0;
+	size_t res = v / PICK_CELL_SZ;
+	return res >= n ? n - 1 : res;
+}
+
+static bool pick_bin(
+	struct rendertarget* tgt, struct pick_index* idx, arcan_vobject* vobj)
+{
+	vector projv[4];
+
+	if (vobj->owner != tgt || !vobj->valid_cache ||
+		ARCAN_OK != arcan_video_screencoords(vobj->cellid, projv))
+		return false;
+
+	float x1 = projv[0].x, y1 = projv[0].y, x2 = x1, y2 = y1;
+	for (size_t i = 1; i < 4; i++){
+		x1 = projv[i].x < x1 ? projv[i].x : x1;
+		y1 = projv[i].y < y1 ? projv[i].y : y1;
+		x2 = projv[i].x > x2 ? projv[i].x : x2;
+		y2 = projv[i].y > y2 ? projv[i].y : y2;
+	}
+
+	vobj->pick.x1 = pick_clamp(x1, idx->cols);
+	vobj->pick.y1 = pick_clamp(y1, idx->rows);
+	vobj->pick.x2 = pick_clamp(x2, idx->cols);
+	vobj->pick.y2 = pick_clamp(y2, idx->rows);
+
+	for (size_t y = vobj->pick.y1; y <= vobj->pick.y2; y++)
+		for (size_t x = vobj->pick.x1; x <= vobj->pick.x2; x++)
+			if (!pick_push(&idx->cells[y * idx->cols + x], vobj, vobj->pick.seq))
+				idx->fail = true;
+
+	vobj->pick.binned = true;
+	return true;
+}
+
+/* place an object owned by the index either in the grid or the volatile set */
+static void pick_place(
+	struct rendertarget* tgt, struct pick_index* idx, arcan_vobject* vobj)
+{
+	if (vobj->pick.vol || pick_bin(tgt, idx, vobj))
+		return;
+
+	if (pick_push(&idx->vol, vobj, vobj->pick.seq))
+		vobj->pick.vol = true;
+	else
+		idx->fail = true;
+}
+
+static void pick_attach(struct rendertarget* tgt, arcan_vobject* vobj)
+{
+	struct pick_index* idx = tgt->pick;
+	if (!idx || idx->rebuild)
+		return;
+
+/* out of stamps, renumber from the list instead */
+	if (idx->stamp == UINT32_MAX){
+		idx->rebuild = true;
+		return;
+	}
+
+/* only the owner has pick state in the object itself */
+	if (vobj->owner != tgt){
+		if (!pick_push(&idx->vol, vobj, pick_key(idx, vobj->order)))
+			idx->fail = true;
+		return;
+	}
+
+	vobj->pick.seq = pick_key(idx, vobj->order);
+	vobj->pick.binned = vobj->pick.vol = vobj->pick.queued = false;
+	pick_place(tgt, idx, vobj);
+}
+
+static void pick_detach(struct rendertarget* tgt, arcan_vobject* vobj)
+{
+	struct pick_index* idx = tgt->pick;
+
+	if (vobj->owner != tgt){
+		if (idx && !idx->rebuild)
+			pick_remove(&idx->vol, vobj);
+		return;
+	}
+
+	if (idx && !idx->rebuild){
+		pick_unbin(idx, vobj);
+		if (vobj->pick.vol)
+			pick_remove(&idx->vol, vobj);
+		if (vobj->pick.queued)
+			pick_remove(&idx->dirty, vobj);
+	}
+
+/* the flags might be left from an index that has since been dropped */
+	vobj->pick.binned = vobj->pick.vol = vobj->pick.queued = false;
+}
+
+static bool pick_rebuild(struct rendertarget* tgt, struct pick_index* idx)
+{
+	size_t w = tgt->color ? tgt->color->origw : 0;
+	size_t h = tgt->color ? tgt->color->origh : 0;
+	size_t cols = w / PICK_CELL_SZ + 1;
+	size_t rows = h / PICK_CELL_SZ + 1;
+
+	if (cols * rows != idx->cols * idx->rows){
+		for (size_t i = 0; i < idx->cols * idx->rows; i++)
+			arcan_mem_free(idx->cells[i].ents);
+		arcan_mem_free(idx->cells);
+
+		idx->cols = idx->rows = 0;
+		idx->cells = arcan_alloc_mem(sizeof(struct pick_list) * cols * rows,
+			ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO | ARCAN_MEM_NONFATAL,
+			ARCAN_MEMALIGN_NATURAL);
+
+		if (!idx->cells)
+			return false;
+	}
+	else
+		for (size_t i = 0; i < cols * rows; i++)
+			idx->cells[i].count = 0;
+
+	idx->cols = cols;
+	idx->rows = rows;
+	idx->w = w;
+	idx->h = h;
+
+	for (size_t i = 0; i < idx->dirty.count; i++)
+		idx->dirty.ents[i].obj->pick.queued = false;
+	idx->dirty.count = 0;
+	idx->vol.count = 0;
+	idx->stamp = 0;
+	idx->rebuild = false;
+
+	for (arcan_vobject_litem* cur = tgt->first; cur; cur = cur->next){
+		arcan_vobject* vobj = cur->elem;
+		uint64_t seq = pick_key(idx, vobj->order);
+
+/* objects that are attached to more than one rendertarget only have pick
+ * state for their owner, so for the others we always test them */
+		if (vobj->owner != tgt){
+			if (!pick_push(&idx->vol, vobj, seq))
+				idx->fail = true;
+			continue;
+		}
+
+		vobj->pick.seq = seq;
+		vobj->pick.binned = vobj->pick.vol = vobj->pick.queued = false;
+		pick_place(tgt, idx, vobj);
+	}
+
+	return true;
+}
+
+static int pick_seqcmp(const void* a, const void* b)
+{
+	uint64_t as = ((const struct pick_ent*) a)->seq;
+	uint64_t bs = ((const struct pick_ent*) b)->seq;
+	return as < bs ? -1 : as > bs;
+}
+
+static inline bool pick_hit(arcan_vobject* vobj, int x, int y, bool any_id)
+{
+	return (any_id || vobj->cellid) && (vobj->mask & MASK_UNPICKABLE) == 0 &&
+		obj_visible(vobj) && arcan_video_hittest(vobj->cellid, x, y);
+}
+
+/* fallback if the index can't be allocated, test all objects in order */
+static size_t pick_linear(struct rendertarget* tgt,
+	arcan_vobj_id* dst, size_t lim, int x, int y, bool reverse, bool any_id)
+{
+	size_t count = 0;
 	arcan_vobject_litem* current = tgt->first;
 
-/* skip to last, then start stepping backwards */
-	while (current->next)
-		current = current->next;
+	if (reverse)
+		while (current->next)
+			current = current->next;
 
 	while (current && count < lim){
-		arcan_vobject* vobj = current->elem;
+		if (pick_hit(current->elem, x, y, any_id))
+			dst[count++] = current->elem->cellid;
+
+		current = reverse ? current->previous : current->next;
+	}
+
+	return count;
+}
+
+/*
+ * Collect at most [lim] hits at [x, y] in [tgt] into [dst], front-to-back
+ * order if [reverse] is set, otherwise back-to-front.
+ */
+static size_t pick_query(struct rendertarget* tgt,
+	arcan_vobj_id* dst, size_t lim, int x, int y, bool reverse, bool any_id)
+{
+	if (!tgt->pick){
+		tgt->pick = arcan_alloc_mem(sizeof(struct pick_index),
+			ARCAN_MEM_VSTRUCT, ARCAN_MEM_BZERO | ARCAN_MEM_NONFATAL,
+			ARCAN_MEMALIGN_NATURAL);
+		if (!tgt->pick)
+			return pick_linear(tgt, dst, lim, x, y, reverse, any_id);
+		tgt->pick->rebuild = true;
+	}
+
+	struct pick_index* idx = tgt->pick;
+	if (tgt->color &&
+		(idx->w != tgt->color->origw || idx->h != tgt->color->origh))
+		idx->rebuild = true;
+
+	if (idx->rebuild && !pick_rebuild(tgt, idx)){
+		pick_drop(tgt);
+		return pick_linear(tgt, dst, lim, x, y, reverse, any_id);
+	}
+
+/* re-bin everything that has changed since last time */
+	for (size_t i = 0; i < idx->dirty.count; i++){
+		arcan_vobject* vobj = idx->dirty.ents[i].obj;
+		vobj->pick.queued = false;
+		if (vobj->owner != tgt || !FL_TEST(vobj, FL_INUSE))
+			continue;
+
+		pick_unbin(idx, vobj);
+		pick_place(tgt, idx, vobj);
+	}
+	idx->dirty.count = 0;
+
+/* and move anything that has settled from the volatile set to the grid */
+	for (size_t i = 0; i < idx->vol.count;){
+		arcan_vobject* vobj = idx->vol.ents[i].obj;
+		if (vobj->owner == tgt && pick_bin(tgt, idx, vobj)){
+			vobj->pick.vol = false;
+			idx->vol.ents[i] = idx->vol.ents[--idx->vol.count];
+		}
+		else
+			i++;
+	}
+
+	idx->hits.count = 0;
+	struct pick_list* cell = &idx->cells[
+		pick_clamp(y, idx->rows) * idx->cols + pick_clamp(x, idx->cols)];
+
+	for (size_t i = 0; i < cell->count; i++)
+		if (pick_hit(cell->ents[i].obj, x, y, any_id) &&
+			!pick_push(&idx->hits, cell->ents[i].obj, cell->ents[i].seq))
+			idx->fail = true;
 
-		if ((vobj->mask & MASK_UNPICKABLE) == 0 && obj_visible(vobj) &&
-			arcan_video_hittest(vobj->cellid, x, y))
-				dst[count++] = vobj->cellid;
+	for (size_t i = 0; i < idx->vol.count; i++)
+		if (pick_hit(idx->vol.ents[i].obj, x, y, any_id) &&
+			!pick_push(&idx->hits, idx->vol.ents[i].obj, idx->vol.ents[i].seq))
+			idx->fail = true;
 
-		current = current->previous;
+/* partial index, drop it and try again next time */
+	if (idx->fail){
+		pick_drop(tgt);
+		return pick_linear(tgt, dst, lim, x, y, reverse, any_id);
+	}
+
+	qsort(idx->hits.ents, idx->hits.count, sizeof(struct pick_ent), pick_seqcmp);
+
+	size_t count = 0;
+	for (size_t i = 0; i < idx->hits.count && count < lim; i++){
+		size_t ind = reverse ? idx->hits.count - 1 - i : i;
+		dst[count++] = idx->hits.ents[ind].obj->cellid;
 	}
 
 	return count;
 }
 
-size_t arcan_video_pick(arcan_vobj_id rt,
+size_t arcan_video_rpick(arcan_vobj_id rt,
 	arcan_vobj_id* dst, size_t lim, int x, int y)
 {
-	size_t count = 0;
 	arcan_vobject* vobj = arcan_video_getobject(rt);
 	struct rendertarget* tgt = arcan_vint_findrt(vobj);
-	if (lim == 0 || !tgt || !tgt->first)
-		return count;
 
-	arcan_vobject_litem* current = tgt->first;
+	if (lim == 0 || !tgt || !tgt->first)
+		return 0;
 
-	while (current && count < lim){
-		arcan_vobject* vobj = current->elem;
+	return pick_query(tgt, dst, lim, x, y, true, true);
+}
 
-		if (vobj->cellid && !(vobj->mask & MASK_UNPICKABLE) &&
-			obj_visible(vobj) && arcan_video_hittest(vobj->cellid, x, y))
-				dst[count++] = vobj->cellid;
+size_t arcan_video_pick(arcan_vobj_id rt,
+	arcan_vobj_id* dst, size_t lim, int x, int y)
+{
+	arcan_vobject* vobj = arcan_video_getobject(rt);
+	struct rendertarget* tgt = arcan_vint_findrt(vobj);
 
-		current = current->next;
-	}
+	if (lim == 0 || !tgt || !tgt->first)
+		return 0;
 
-	return count;
+	return pick_query(tgt, dst, lim, x, y, false, false);
 }
 
 img_cons arcan_video_storage_properties(arcan_vobj_id id)
@@ -5731,15 +7565,27 @@ arcan_errc arcan_video_maxorder(arcan_vobj_id rt, uint16_t* ov)
 unsigned arcan_video_contextusage(unsigned* used)
 {
 	if (used){
-		*used = 0;
-		for (unsigned i = 1; i < current_context->vitem_limit-1; i++)
-			if (FL_TEST(&current_context->vitems_pool[i], FL_INUSE))
-				(*used)++;
+		if (!vfree_valid(current_context))
+			vfree_build(current_context);
+		*used = current_context->vstats.used;
 	}
 
 	return current_context->vitem_limit-1;
 }
 
+void arcan_video_contextstats(size_t* allocs, size_t* frees, size_t* peak)
+{
+	if (!vfree_valid(current_context))
+		vfree_build(current_context);
+
+	if (allocs)
+		*allocs = current_context->vstats.allocs;
+	if (frees)
+		*frees = current_context->vstats.frees;
+	if (peak)
+		*peak = current_context->vstats.peak;
+}
+
 bool arcan_video_contextsize(unsigned newlim)
 {
 	if (newlim <= 1 || newlim >= VITEM_CONTEXT_LIMIT)
@@ -5816,6 +7662,7 @@ void arcan_video_shutdown(bool release_fsrv)
 
 	agp_shader_flush();
 	deallocate_gl_context(current_context, true, NULL);
+	recycle_flush();
 	arcan_video_reset_fontcache();
 	agp_rendertarget_clear();
 	TTF_Quit();
@@ -367,6 +367,12 @@ signed arcan_video_extpushcontext(arcan_vobj_id* dst);
  */
 unsigned arcan_video_contextusage(unsigned* used);
 
+/*
+ * Allocation counters for the current context, [allocs] and [frees] are
+ * running totals and [peak] the highest number of slots in use at once.
+ */
+void arcan_video_contextstats(size_t* allocs, size_t* frees, size_t* peak);
+
 /*
  * Create a "visible" but initially non-drawable object with its initial
  * dimensions set to [origw] and [origh] ordered by [zv]. This should be
@@ -517,16 +523,17 @@ arcan_errc arcan_video_resizefeed(arcan_vobj_id id, size_t w, size_t h);
  * defined in the resource will be retained, otherwise the image will be
  * rescaled upon loading (unfiltered and rather slow).
  *
- * The asynchronous version will spawn a worker thread (up to a certain
- * number, compile-time limited with ASYNCH_CONCURRENT_THREADS).
- * Context operations will force a join on any outstanding asynchronous
- * loading jobs.
+ * The asynchronous version queues the decode on a shared pool of worker
+ * threads (compile-time limited with ASYNCH_CONCURRENT_THREADS), results
+ * are collected on video_tick. Context operations will force a join on any
+ * outstanding asynchronous loading jobs, deleting the object cancels it.
+ * Jobs with a higher [prio] are decoded first, see arcan_video_asynchpriority.
  *
  * Loadimage returns ARCAN_EID on failure, asynch will always succeed but
  * may later enqueue EVENT_ASYNCHIMAGE_FAILED or EVENT_VIDEO_ASYNCHIMAGE_LOADED
  */
 arcan_vobj_id arcan_video_loadimageasynch(const char* resource,
-	img_cons constraints, intptr_t tag);
+	img_cons constraints, intptr_t tag, int prio);
 arcan_vobj_id arcan_video_loadimage(const char* fname,
 	img_cons constraints, unsigned short zv);
 
@@ -537,6 +544,13 @@ arcan_vobj_id arcan_video_loadimage(const char* fname,
  */
 arcan_errc arcan_video_pushasynch(arcan_vobj_id id);
 
+/*
+ * Change the decode priority of an asynchronous load that has not yet been
+ * picked up by a worker, higher values are served first and jobs with the
+ * same priority are served in the order they were submitted.
+ */
+arcan_errc arcan_video_asynchpriority(arcan_vobj_id id, int prio);
+
 /*
  * By default, all objects share a set of texture coordinates in the form
  * [ul(s,t), ur(s,t), lr(s,t), ll(st)]. When any texture coordinate related
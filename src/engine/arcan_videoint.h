@@ -31,6 +31,11 @@
 struct arcan_vobject_litem;
 struct arcan_vobject;
 
+/* number of express lanes in the attachment skip list, ~4^n entries */
+#ifndef LITEM_SKIP_LEVELS
+#define LITEM_SKIP_LEVELS 8
+#endif
+
 enum rtgt_flags {
 	TGTFL_READING = 1,
 	TGTFL_ALIVE   = 2,
@@ -53,6 +58,9 @@ struct rendertarget {
 	struct arcan_vobject* color;
 	struct arcan_vobject_litem* first;
 
+/* skip list heads for the lanes above first, see attach_object */
+	struct arcan_vobject_litem* skip[LITEM_SKIP_LEVELS];
+
 /* it is possible for one rendertarget to share the pipeline with
  * another, if so, first is set to NULL and link points to the rtgt vid */
 	struct rendertarget* link;
@@ -107,6 +115,13 @@ struct rendertarget {
  * we need to track the lower accepted bounds and the max accepted bounds.
  */
 	size_t min_order, max_order;
+
+/* lazily created spatial index for pick / rpick, see arcan_video.c */
+	struct pick_index* pick;
+
+/* set when the draw list for the current refresh has already been built,
+ * possibly on a worker thread, and only the GL submission remains */
+	struct rtgt_cmdlist* cmds;
 };
 
 enum vobj_flags {
@@ -233,6 +248,7 @@ typedef struct arcan_vobject {
 	point origo_ofs;
 
 	surface_transform* transform;
+	uint32_t tfslot;
 	enum arcan_transform_mask mask;
 	enum arcan_clipmode clip;
 
@@ -244,6 +260,20 @@ typedef struct arcan_vobject {
 	surface_properties prop_cache;
 	float _Alignas(16) prop_matr[16];
 
+/* state in the pick index of the owning rendertarget, cell range
+ * (x1,y1)-(x2,y2) is only valid when binned */
+	struct {
+		uint64_t seq;
+		uint16_t x1, y1, x2, y2;
+		bool binned, vol, queued;
+	} pick;
+
+/* results from the batched transform pass for the current refresh, local is
+ * the interpolated state and world the resolved one, each only valid while
+ * its generation matches that of the pass */
+	unsigned frame_lgen, frame_wgen;
+	surface_properties frame_local, frame_world;
+
 /* life-cycle tracking */
 	unsigned long last_updated;
 	long lifetime;
@@ -270,11 +300,17 @@ typedef struct arcan_vobject {
 	char* tracetag;
 } arcan_vobject;
 
-/* regular old- linked list, but also mapped to an array */
+/* regular old- linked list sorted on order, with [skip] as the express lanes
+ * of a skip list over the same nodes so insert / remove doesn't need to scan,
+ * [levels] is the number of lanes the node is part of */
 struct arcan_vobject_litem {
 	arcan_vobject* elem;
 	struct arcan_vobject_litem* next;
 	struct arcan_vobject_litem* previous;
+	uint8_t levels;
+
+/* express lanes, the node is allocated with room for [levels] of them */
+	struct arcan_vobject_litem* skip[];
 };
 typedef struct arcan_vobject_litem arcan_vobject_litem;
 
@@ -321,6 +357,14 @@ struct arcan_video_display {
 
 	unsigned char msasamples;
 	char* txdump;
+
+/* consecutive plain 2D quads are drawn as batches unless disabled, [draws]
+ * covers the last refresh and [draws_total] everything since the last reset */
+	bool no_batch;
+	struct {
+		size_t calls, quads;
+	} draws, draws_total;
+	size_t draws_refreshes;
 };
 
 /* these all represent a subset of the current context that is to be drawn.  if
@@ -337,6 +381,26 @@ struct arcan_video_context {
 	long int nalive;
 	arcan_tickv last_tickstamp;
 
+/* free-slot bitmap over vitems_pool, one bit per vid in [vfree] and one bit
+ * per vfree word with any slot available in [vfree_sum]. It is built lazily
+ * and rebuilt when [vfree_pool] / [vfree_lim] no longer match the pool */
+	uint64_t* vfree;
+	uint64_t* vfree_sum;
+	arcan_vobject* vfree_pool;
+	unsigned vfree_lim;
+
+/* allocation counters, [allocs] / [frees] are running totals and [peak] is
+ * the high-water mark of [used] */
+	struct {
+		size_t allocs, frees;
+		size_t used, peak;
+	} vstats;
+
+/* vids of the objects that have a transform chain, [tfslot] in each object
+ * is its position + 1 so it can be removed without searching */
+	arcan_vobj_id* tfactive;
+	size_t tfactive_count, tfactive_limit;
+
 	arcan_vobject world;
 	arcan_vobject* vitems_pool;
 
@@ -389,11 +453,11 @@ void arcan_vint_pollreadback(struct rendertarget* rtgt);
 arcan_errc arcan_vint_attachobject(arcan_vobj_id id);
 
 /*
- * semaphore- rate limited image decoding and repacking to native
- * format used both threaded and non-threaded
+ * synchronous image decoding and repacking to native format, the
+ * asynchronous loaders share the decode step but apply on collection
  */
 arcan_errc arcan_vint_getimage(const char* fname,
-	arcan_vobject* dst, img_cons forced, bool asynchsrc);
+	arcan_vobject* dst, img_cons forced);
 
 #ifdef _DEBUG
 void arcan_debug_tracetag_dump();
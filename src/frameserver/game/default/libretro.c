@@ -158,6 +158,12 @@ static struct {
 	unsigned rollback_front;
 	char* rollback_state;
 	size_t state_sz;
+
+/* rewind history, fed with a serialized state every frame and
+ * traversed through TARGET_COMMAND_SEEKTIME */
+	struct stateman_ctx* rewind;
+	char* rewind_state;
+	int rewind_frame;
 	char* syspath;
 	bool res_empty;
 
@@ -197,6 +203,9 @@ static struct {
 static void update_ntsc();
 static void push_stats();
 
+/* rewind history management, after the event handlers */
+static void seek_rewind(bool rel, float secs);
+
 #ifdef FRAMESERVER_LIBRETRO_3D
 static void setup_3dcore(struct retro_hw_render_callback*);
 #endif
@@ -1366,6 +1375,10 @@ static inline void targetev(arcan_event* ev)
 		}
 		break;
 
+		case TARGET_COMMAND_SEEKTIME:
+			seek_rewind(ev->tgt.ioevs[0].iv != 0, ev->tgt.ioevs[1].fv);
+		break;
+
 		case TARGET_COMMAND_RESTORE:
 		{
 			ssize_t dstsize = retro.serialize_size();
@@ -1673,6 +1686,78 @@ static void setup_input()
 	});
 }
 
+/*
+ * The history is sized either in seconds worth of frames or in memory,
+ * the actual delta encoding happens on a stateman worker thread so the
+ * cost here is the serialization itself.
+ */
+static void setup_rewind(struct arg_arr* args)
+{
+	const char* val;
+	ssize_t limit = 0;
+
+	if (arg_lookup(args, "rewind", 0, &val))
+		limit = -(ssize_t)(strtof(val, NULL) * retro.avinfo.timing.fps);
+
+	if (arg_lookup(args, "rewindmb", 0, &val))
+		limit = strtoul(val, NULL, 10) * 1024 * 1024;
+
+	if (!limit)
+		return;
+
+	if (!retro.state_sz){
+		LOG("rewind requested but core does not support savestates\n");
+		return;
+	}
+
+	retro.rewind_state = malloc(retro.state_sz);
+	if (retro.rewind_state)
+		retro.rewind = stateman_setup(retro.state_sz, limit, 1);
+
+	if (!retro.rewind){
+		LOG("couldn't setup rewind history\n");
+		free(retro.rewind_state);
+		retro.rewind_state = NULL;
+	}
+}
+
+static void feed_rewind()
+{
+	if (!retro.rewind ||
+		!retro.serialize(retro.rewind_state, retro.state_sz))
+		return;
+
+	stateman_feed(retro.rewind, ++retro.rewind_frame, retro.rewind_state);
+}
+
+/*
+ * [secs] is relative to the current frame or absolute from the point
+ * rewind started tracking, forward seeking is not possible as history
+ * after the restored state gets pruned on the next feed.
+ */
+static void seek_rewind(bool rel, float secs)
+{
+	if (!retro.rewind){
+		LOG("seek requested without rewind history (see rewind argument)\n");
+		return;
+	}
+
+	int frames = secs * retro.avinfo.timing.fps;
+	if (rel && frames >= 0)
+		return;
+
+	int ts = stateman_seek(retro.rewind,
+		retro.rewind_state, rel ? -frames : frames, rel);
+
+	if (-1 == ts || !retro.deserialize(retro.rewind_state, retro.state_sz)){
+		LOG("couldn't restore state from rewind history\n");
+		return;
+	}
+
+	retro.rewind_frame = ts;
+	reset_timing(true);
+}
+
 static void dump_help()
 {
 	fprintf(stdout, "ARCAN_ARG (environment variable, "
@@ -1686,6 +1771,8 @@ static void dump_help()
 		" vbufc   \t num       \t (1) 1..4 - number of video buffers\n"
 		" abufc   \t num       \t (8) 1..16 - number of audio buffers\n"
 		" abufsz  \t num       \t audio buffer size in bytes (default = probe)\n"
+		" rewind  \t seconds   \t keep n seconds of history for seeking back\n"
+		" rewindmb\t num       \t cap rewind history at n MiB instead\n"
     " noreset \t           \t (3D) disable context reset calls\n"
     "---------\t-----------\t-----------------\n"
 	);
@@ -1834,6 +1921,8 @@ int	afsrv_game(struct arcan_shmif_cont* cont, struct arg_arr* args)
 	if (retro.state_sz > 0)
 		retro.rollback_state = malloc(retro.state_sz);
 
+	setup_rewind(args);
+
 /* basetime is used as epoch for all other timing calculations, run
  * an initial frame because sometimes first run can introduce a large stall */
 	retro.skipframe_v = retro.skipframe_a = true;
@@ -1882,6 +1971,7 @@ int	afsrv_game(struct arcan_shmif_cont* cont, struct arg_arr* args)
 		start = arcan_timemillis();
 			add_jitter(retro.jitterstep);
 			process_frames(1, false, false);
+			feed_rewind();
 		stop = arcan_timemillis();
 		retro.framecost = stop - start;
 		if (retro.sync_data){
@@ -1930,6 +2020,8 @@ int	afsrv_game(struct arcan_shmif_cont* cont, struct arg_arr* args)
 		if (retro.sync_data)
 				push_stats();
 	}
+
+	stateman_drop(&retro.rewind);
 	return EXIT_SUCCESS;
 }
 
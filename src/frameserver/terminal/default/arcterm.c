@@ -71,6 +71,9 @@ void* pump_pty()
 			write(term.dirtyfd, &(char){'1'}, 1);
 		}
 	}
+
+/* and once more so the main loop gets to see that the shell is gone */
+	write(term.dirtyfd, &(char){'1'}, 1);
 	return NULL;
 }
 
@@ -144,6 +144,7 @@ struct tsm_vte {
 	char *palette_name;
 
 	struct tsm_utf8_mach *mach;
+	int u8_state;
 	unsigned long parse_cnt;
 
 	unsigned int state;
@@ -51,6 +51,15 @@
 #include <inttypes.h>
 #include "libtsm_int.h"
 
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+
+/* upper bound on the number of codepoints forwarded in one screen write */
+#ifndef VTE_RUN_LIMIT
+#define VTE_RUN_LIMIT 512
+#endif
+
 /* Input parser states */
 enum parser_state {
 	STATE_NONE,		/* placeholder */
@@ -865,6 +874,7 @@ void tsm_vte_reset(struct tsm_vte *vte)
 	arcan_tui_set_flags(vte->con, TUI_AUTO_WRAP);
 
 	tsm_utf8_mach_reset(vte->mach);
+	vte->u8_state = TSM_UTF8_START;
 	vte->state = STATE_GROUND;
 	vte->gl = &vte->g0;
 	vte->gr = &vte->g1;
@@ -2662,6 +2672,129 @@ static void parse_data(struct tsm_vte *vte, uint32_t raw)
 	DEBUG_LOG(vte, "unhandled input %u in state %d", raw, vte->state);
 }
 
+/*
+ * Length of the prefix of [buf] that is printable ASCII (0x20..0x7e), these
+ * bytes always map to ACTION_PRINT in the ground state.
+ */
+static size_t scan_printable(const uint8_t *buf, size_t len)
+{
+	size_t i = 0;
+
+#ifdef __SSE2__
+/* signed compare, so anything >= 0x80 also fails the lower bound */
+	const __m128i lo = _mm_set1_epi8(0x1f);
+	const __m128i hi = _mm_set1_epi8(0x7f);
+
+	for (; i + 16 <= len; i += 16){
+		__m128i v = _mm_loadu_si128((const __m128i*) &buf[i]);
+		__m128i ok = _mm_and_si128(_mm_cmpgt_epi8(v, lo), _mm_cmplt_epi8(v, hi));
+		unsigned mask = ~_mm_movemask_epi8(ok) & 0xffff;
+		if (mask)
+			return i + __builtin_ctz(mask);
+	}
+#endif
+
+	while (i < len && buf[i] > 0x1f && buf[i] < 0x7f)
+		i++;
+
+	return i;
+}
+
+/*
+ * Decode one well-formed UTF-8 sequence, returns the number of bytes used or
+ * 0 if the sequence is incomplete, malformed or otherwise something the
+ * state machine in tsm_utf8_mach should get to treat.
+ */
+static size_t decode_utf8(const uint8_t *buf, size_t len, uint32_t *out)
+{
+	uint8_t c = buf[0];
+	size_t n;
+	uint32_t cp;
+
+	if (c >= 0xc2 && c <= 0xdf){
+		n = 2;
+		cp = c & 0x1f;
+	}
+	else if (c >= 0xe0 && c <= 0xef){
+		n = 3;
+		cp = c & 0x0f;
+	}
+	else if (c >= 0xf0 && c <= 0xf4){
+		n = 4;
+		cp = c & 0x07;
+	}
+	else
+		return 0;
+
+	if (n > len)
+		return 0;
+
+	for (size_t i = 1; i < n; i++){
+		if ((buf[i] & 0xc0) != 0x80)
+			return 0;
+		cp = (cp << 6) | (buf[i] & 0x3f);
+	}
+
+	if ((n == 3 && (cp < 0x800 || (cp >= 0xd800 && cp <= 0xdfff))) ||
+		(n == 4 && (cp < 0x10000 || cp > 0x10ffff)))
+		return 0;
+
+	*out = cp;
+	return n;
+}
+
+/*
+ * Fast path for plain text in the ground state. Collect the longest run of
+ * codepoints that would only ever reach ACTION_PRINT with an identity mapping
+ * in the current GL/GR sets and forward it as a single screen write. Returns
+ * the number of bytes consumed, 0 means that the full parser is needed.
+ */
+static size_t print_run(struct tsm_vte *vte, const uint8_t *u8, size_t len)
+{
+	bool utf8 = !(vte->flags & (FLAG_7BIT_MODE | FLAG_8BIT_MODE));
+
+	if (vte->glt || vte->grt || *vte->gl != &tsm_vte_unicode_lower)
+		return 0;
+
+	if (utf8 && vte->u8_state != TSM_UTF8_START &&
+		vte->u8_state != TSM_UTF8_ACCEPT && vte->u8_state != TSM_UTF8_REJECT)
+		return 0;
+
+	bool upper = *vte->gr == &tsm_vte_unicode_upper;
+	uint32_t run[VTE_RUN_LIMIT];
+	size_t pos = 0, n = 0;
+
+	while (pos < len && n < VTE_RUN_LIMIT){
+		size_t cap = len - pos;
+		if (cap > VTE_RUN_LIMIT - n)
+			cap = VTE_RUN_LIMIT - n;
+
+		size_t nb = scan_printable(&u8[pos], cap);
+		for (size_t i = 0; i < nb; i++)
+			run[n++] = u8[pos + i];
+		pos += nb;
+
+		if (pos == len || n == VTE_RUN_LIMIT || !utf8)
+			break;
+
+/* C1 controls are executed and 161..254 go through GR */
+		uint32_t cp;
+		size_t ub = decode_utf8(&u8[pos], len - pos, &cp);
+		if (!ub || cp < 0xa0 || (!upper && cp > 0xa0 && cp < 0xff))
+			break;
+
+		run[n++] = cp;
+		pos += ub;
+	}
+
+	if (n){
+		to_rgb(vte, false);
+		arcan_tui_writeucs4(vte->con, run, n, &vte->cattr);
+	}
+
+	return pos;
+}
+
 SHL_EXPORT
 void tsm_vte_input(struct tsm_vte *vte, const char *u8, size_t len)
 {
@@ -2674,6 +2807,14 @@ void tsm_vte_input(struct tsm_vte *vte, const char *u8, size_t len)
 
 	++vte->parse_cnt;
 	for (i = 0; i < len; ++i) {
+		if (vte->state == STATE_GROUND) {
+			size_t nb = print_run(vte, (const uint8_t*) &u8[i], len - i);
+			if (nb) {
+				i += nb - 1;
+				continue;
+			}
+		}
+
 		if (vte->flags & FLAG_7BIT_MODE) {
 			if (u8[i] & 0x80)
 				DEBUG_LOG(vte, "receiving 8bit character U+%d from pty while in 7bit mode",
@@ -2683,6 +2824,7 @@ void tsm_vte_input(struct tsm_vte *vte, const char *u8, size_t len)
 			parse_data(vte, u8[i]);
 		} else {
 			state = tsm_utf8_mach_feed(vte->mach, u8[i]);
+			vte->u8_state = state;
 			if (state == TSM_UTF8_ACCEPT ||
 			    state == TSM_UTF8_REJECT) {
 				ucs4 = tsm_utf8_mach_get(vte->mach);
@@ -1,13 +1,21 @@
 /*
- * Arcan Hijack/Frameserver State Manager (incomplete)
+ * Arcan Hijack/Frameserver State Manager
  * Copyright 2014-2016, Björn Ståhl
  * License: 3-Clause BSD, see COPYING file in arcan source repository.
  * Reference: http://arcan-fe.com
  */
 
 /*
- * Still just a stub, nothing to see here. The plan is to add
- * per-session state tracking and use that to enable rewinding.
+ * Keeps a bounded history of fixed-size state blobs (e.g. the output of
+ * retro_serialize) for rewinding. Each stored state is XORed against the one
+ * before it and the result is run-length encoded on runs of zeroes, so the
+ * parts that did not change cost next to nothing. Every n:th state is
+ * encoded against zero instead (keyframe) so that a seek never has to walk
+ * the entire history, and so that old history can be dropped one keyframe
+ * group at a time.
+ *
+ * The encoding is done on a worker thread, feed only copies the state into
+ * a free staging slot and skips it if the worker has fallen that far behind.
  */
 
 #include <stdlib.h>
@@ -15,32 +23,489 @@
 #include <stdint.h>
 #include <unistd.h>
 #include <stdbool.h>
+#include <pthread.h>
 
 #include "stateman.h"
 
+/* upper bound for the number of states between two keyframes */
+#ifndef STATEMAN_KEYFRAME
+#define STATEMAN_KEYFRAME 300
+#endif
+
+/* number of states that can be waiting for the worker */
+#ifndef STATEMAN_STAGING
+#define STATEMAN_STAGING 4
+#endif
+
+struct record {
+	int tstamp;
+	bool key;
+	size_t sz;
+	uint8_t data[];
+};
+
 struct stateman_ctx {
-	int range_start, range_end;
+	size_t state_sz;
+	size_t byte_limit;
+	size_t frame_limit;
+	size_t key_interval;
+	int precision;
+	int feed_count;
+
+/* history, oldest first, as a ring of [n_rec] records starting at [first] */
+	struct record** rec;
+	size_t rec_cap;
+	size_t first;
+	size_t n_rec;
+	size_t bytes;
+
+/* staging slots in FIFO order, only the worker touches [head] while
+ * [n_staged] is > 0 */
+	struct {
+		uint8_t* buf;
+		int tstamp;
+	} staged[STATEMAN_STAGING];
+	size_t head;
+	size_t n_staged;
+
+/* worker- owned, last encoded state and states since its keyframe */
+	uint8_t* prev;
+	bool have_prev;
+	size_t since_key;
+	uint8_t* scratch;
+
+	pthread_t worker;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t idle;
+	bool shutdown;
 };
 
-struct stateman_ctx* stateman_setup(size_t state_sz,
-	ssize_t limit, int precision){
+static struct record* rec_at(struct stateman_ctx* ctx, size_t i)
+{
+	return ctx->rec[(ctx->first + i) % ctx->rec_cap];
+}
+
+static size_t put_varint(uint8_t* out, size_t v)
+{
+	size_t n = 0;
+	while (v >= 0x80){
+		out[n++] = (v & 0x7f) | 0x80;
+		v >>= 7;
+	}
+	out[n++] = v;
+	return n;
+}
+
+static bool get_varint(const uint8_t** in, const uint8_t* end, size_t* v)
+{
+	size_t res = 0;
+	for (int shift = 0; *in < end && shift < 64; shift += 7){
+		uint8_t b = *(*in)++;
+		res |= (size_t)(b & 0x7f) << shift;
+		if (!(b & 0x80)){
+			*v = res;
+			return true;
+		}
+	}
+	return false;
+}
+
+static inline uint64_t xor_word(
+	const uint8_t* cur, const uint8_t* prev, size_t ofs)
+{
+	uint64_t a, b = 0;
+	memcpy(&a, &cur[ofs], 8);
+	if (prev)
+		memcpy(&b, &prev[ofs], 8);
+	return a ^ b;
+}
+
+static inline uint8_t xor_byte(
+	const uint8_t* cur, const uint8_t* prev, size_t ofs)
+{
+	return prev ? cur[ofs] ^ prev[ofs] : cur[ofs];
+}
+
+/*
+ * Encode [cur] XOR [prev] (or just [cur] if prev is NULL) as a series of
+ * (skip, length, bytes) runs. A literal run is broken on the first zero
+ * word so short zero runs inside of changed regions are just copied.
+ * [out] needs to fit state_sz + state_sz / 8 + 32 bytes.
+ */
+static size_t encode(uint8_t* out,
+	const uint8_t* cur, const uint8_t* prev, size_t sz)
+{
+	size_t i = 0, o = 0;
+
+	while (i < sz){
+		size_t z = i;
+		while (z + 8 <= sz && xor_word(cur, prev, z) == 0)
+			z += 8;
+		while (z < sz && xor_byte(cur, prev, z) == 0)
+			z++;
+
+		if (z == sz)
+			break;
+
+		size_t l = z;
+		while (l < sz){
+			if (l + 8 <= sz){
+				if (xor_word(cur, prev, l) == 0)
+					break;
+				l += 8;
+			}
+			else
+				l++;
+		}
+
+		o += put_varint(&out[o], z - i);
+		o += put_varint(&out[o], l - z);
+		if (prev)
+			for (size_t j = z; j < l; j++)
+				out[o++] = cur[j] ^ prev[j];
+		else {
+			memcpy(&out[o], &cur[z], l - z);
+			o += l - z;
+		}
+
+		i = l;
+	}
+
+	return o;
+}
+
+static void apply(uint8_t* dst, size_t sz, struct record* rec)
+{
+	const uint8_t* in = rec->data;
+	const uint8_t* end = in + rec->sz;
+	size_t pos = 0;
+
+	while (in < end){
+		size_t skip, len;
+		if (!get_varint(&in, end, &skip) || !get_varint(&in, end, &len))
+			return;
+
+		pos += skip;
+		if (pos + len > sz || len > (size_t)(end - in))
+			return;
+
+		for (size_t i = 0; i < len; i++)
+			dst[pos + i] ^= in[i];
+
+		in += len;
+		pos += len;
+	}
+}
+
+/* rebuild the state of record [ind] into [dst] from its keyframe */
+static void reconstruct(struct stateman_ctx* ctx, size_t ind, uint8_t* dst)
+{
+	size_t key = ind;
+	while (key > 0 && !rec_at(ctx, key)->key)
+		key--;
+
+	memset(dst, '\0', ctx->state_sz);
+	for (size_t i = key; i <= ind; i++)
+		apply(dst, ctx->state_sz, rec_at(ctx, i));
+}
+
+/* caller holds lock, drops the oldest keyframe group if there is a newer */
+static bool drop_group(struct stateman_ctx* ctx)
+{
+	size_t n = 1;
+	while (n < ctx->n_rec && !rec_at(ctx, n)->key)
+		n++;
+
+	if (n == ctx->n_rec)
+		return false;
+
+	for (size_t i = 0; i < n; i++){
+		struct record* rec = rec_at(ctx, 0);
+		ctx->bytes -= rec->sz;
+		free(rec);
+		ctx->first = (ctx->first + 1) % ctx->rec_cap;
+		ctx->n_rec--;
+	}
+
+	return true;
+}
+
+static bool over_limit(struct stateman_ctx* ctx)
+{
+	return (ctx->byte_limit && ctx->bytes > ctx->byte_limit) ||
+		(ctx->frame_limit && ctx->n_rec > ctx->frame_limit);
+}
+
+/* caller holds lock */
+static bool append(struct stateman_ctx* ctx, struct record* rec)
+{
+	if (ctx->n_rec == ctx->rec_cap){
+		size_t ncap = ctx->rec_cap ? ctx->rec_cap * 2 : 256;
+		struct record** nrec = malloc(sizeof(struct record*) * ncap);
+		if (!nrec)
+			return false;
+
+		for (size_t i = 0; i < ctx->n_rec; i++)
+			nrec[i] = rec_at(ctx, i);
+
+		free(ctx->rec);
+		ctx->rec = nrec;
+		ctx->rec_cap = ncap;
+		ctx->first = 0;
+	}
+
+	ctx->rec[(ctx->first + ctx->n_rec) % ctx->rec_cap] = rec;
+	ctx->n_rec++;
+	ctx->bytes += rec->sz;
+
+	while (over_limit(ctx) && drop_group(ctx)){}
+
+	return true;
+}
+
+/*
+ * A state that is not newer than the last one means the caller has seeked
+ * back and continued from there, drop the now alternate future and resume
+ * the delta chain from the state we branched off from.
+ */
+static void prune(struct stateman_ctx* ctx, int tstamp)
+{
+	pthread_mutex_lock(&ctx->lock);
+	while (ctx->n_rec && rec_at(ctx, ctx->n_rec - 1)->tstamp >= tstamp){
+		struct record* rec = rec_at(ctx, ctx->n_rec - 1);
+		ctx->bytes -= rec->sz;
+		free(rec);
+		ctx->n_rec--;
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
+	ctx->have_prev = false;
+	if (!ctx->n_rec)
+		return;
+
+	reconstruct(ctx, ctx->n_rec - 1, ctx->prev);
+	ctx->have_prev = true;
+	ctx->since_key = 0;
+	for (size_t i = ctx->n_rec - 1; i > 0 && !rec_at(ctx, i)->key; i--)
+		ctx->since_key++;
+}
+
+static void encode_state(struct stateman_ctx* ctx, uint8_t* buf, int tstamp)
+{
+	if (ctx->n_rec && rec_at(ctx, ctx->n_rec - 1)->tstamp >= tstamp)
+		prune(ctx, tstamp);
+
+/* can't drop the only keyframe group to make room, so start a new one */
+	bool key = !ctx->have_prev ||
+		ctx->since_key + 1 >= ctx->key_interval || over_limit(ctx);
+
+	size_t sz = encode(ctx->scratch, buf, key ? NULL : ctx->prev, ctx->state_sz);
+	struct record* rec = malloc(sizeof(struct record) + sz);
+	if (!rec)
+		return;
+
+	rec->tstamp = tstamp;
+	rec->key = key;
+	rec->sz = sz;
+	memcpy(rec->data, ctx->scratch, sz);
+
+	pthread_mutex_lock(&ctx->lock);
+	bool ok = append(ctx, rec);
+	pthread_mutex_unlock(&ctx->lock);
+
+	if (!ok){
+		free(rec);
+		return;
+	}
+
+	memcpy(ctx->prev, buf, ctx->state_sz);
+	ctx->have_prev = true;
+	ctx->since_key = key ? 0 : ctx->since_key + 1;
+}
+
+static void* worker(void* arg)
+{
+	struct stateman_ctx* ctx = arg;
+
+	pthread_mutex_lock(&ctx->lock);
+	for(;;){
+		while (!ctx->n_staged && !ctx->shutdown)
+			pthread_cond_wait(&ctx->wake, &ctx->lock);
+
+		if (ctx->shutdown)
+			break;
+
+		uint8_t* buf = ctx->staged[ctx->head].buf;
+		int tstamp = ctx->staged[ctx->head].tstamp;
+		pthread_mutex_unlock(&ctx->lock);
+
+		encode_state(ctx, buf, tstamp);
+
+		pthread_mutex_lock(&ctx->lock);
+		ctx->head = (ctx->head + 1) % STATEMAN_STAGING;
+		ctx->n_staged--;
+		pthread_cond_broadcast(&ctx->idle);
+	}
+	pthread_mutex_unlock(&ctx->lock);
+
 	return NULL;
 }
 
-void stateman_feed(struct stateman_ctx* ctx, int tstamp, void* inbuf)
+struct stateman_ctx* stateman_setup(size_t state_sz,
+	ssize_t limit, int precision)
 {
+	if (!state_sz || !limit)
+		return NULL;
+
+	struct stateman_ctx* ctx = malloc(sizeof(struct stateman_ctx));
 	if (!ctx)
+		return NULL;
+
+	*ctx = (struct stateman_ctx){
+		.state_sz = state_sz,
+		.precision = precision > 1 ? precision : 1,
+		.key_interval = STATEMAN_KEYFRAME
+	};
+
+/* with a frame limit, keep the groups small enough that dropping
+ * one does not throw away most of the history */
+	if (limit < 0){
+		ctx->frame_limit = -limit;
+		size_t ki = ctx->frame_limit / 4;
+		if (ki < ctx->key_interval)
+			ctx->key_interval = ki > 0 ? ki : 1;
+	}
+	else
+		ctx->byte_limit = limit;
+
+	bool ok = (ctx->prev = malloc(state_sz)) &&
+		(ctx->scratch = malloc(state_sz + state_sz / 8 + 32));
+
+	for (size_t i = 0; ok && i < STATEMAN_STAGING; i++)
+		ok = (ctx->staged[i].buf = malloc(state_sz)) != NULL;
+
+/* no worker or sync primitives yet, flag as shut down so drop only frees */
+	if (!ok){
+		ctx->shutdown = true;
+		stateman_drop(&ctx);
+		return NULL;
+	}
+
+	pthread_mutex_init(&ctx->lock, NULL);
+	pthread_cond_init(&ctx->wake, NULL);
+	pthread_cond_init(&ctx->idle, NULL);
+
+	if (0 != pthread_create(&ctx->worker, NULL, worker, ctx)){
+		pthread_mutex_destroy(&ctx->lock);
+		pthread_cond_destroy(&ctx->wake);
+		pthread_cond_destroy(&ctx->idle);
+		ctx->shutdown = true;
+		stateman_drop(&ctx);
+		return NULL;
+	}
+
+	return ctx;
+}
+
+void stateman_feed(struct stateman_ctx* ctx, int tstamp, void* inbuf)
+{
+	if (!ctx || (ctx->feed_count++ % ctx->precision) != 0)
 		return;
+
+	pthread_mutex_lock(&ctx->lock);
+	if (ctx->n_staged == STATEMAN_STAGING){
+		pthread_mutex_unlock(&ctx->lock);
+		return;
+	}
+	size_t ind = (ctx->head + ctx->n_staged) % STATEMAN_STAGING;
+	pthread_mutex_unlock(&ctx->lock);
+
+/* the slot is not visible to the worker until n_staged is bumped */
+	memcpy(ctx->staged[ind].buf, inbuf, ctx->state_sz);
+	ctx->staged[ind].tstamp = tstamp;
+
+	pthread_mutex_lock(&ctx->lock);
+	ctx->n_staged++;
+	pthread_cond_signal(&ctx->wake);
+	pthread_mutex_unlock(&ctx->lock);
 }
 
-bool stateman_seek(struct stateman_ctx* ctx, void* dstbuf, int tstamp, bool rel)
+int stateman_seek(struct stateman_ctx* ctx, void* dstbuf, int tstamp, bool rel)
 {
-	return false;
+	if (!ctx || !dstbuf)
+		return -1;
+
+	pthread_mutex_lock(&ctx->lock);
+	while (ctx->n_staged)
+		pthread_cond_wait(&ctx->idle, &ctx->lock);
+
+	if (!ctx->n_rec){
+		pthread_mutex_unlock(&ctx->lock);
+		return -1;
+	}
+
+	if (rel)
+		tstamp = rec_at(ctx, ctx->n_rec - 1)->tstamp - tstamp;
+
+/* closest state at or before tstamp, clamped to what is still around */
+	size_t lo = 0, hi = ctx->n_rec;
+	while (hi - lo > 1){
+		size_t mid = lo + (hi - lo) / 2;
+		if (rec_at(ctx, mid)->tstamp <= tstamp)
+			lo = mid;
+		else
+			hi = mid;
+	}
+
+	reconstruct(ctx, lo, dstbuf);
+	int res = rec_at(ctx, lo)->tstamp;
+	pthread_mutex_unlock(&ctx->lock);
+
+	return res;
+}
+
+void stateman_usage(struct stateman_ctx* ctx, size_t* bytes, size_t* states)
+{
+	if (!ctx)
+		return;
+
+	pthread_mutex_lock(&ctx->lock);
+	if (bytes)
+		*bytes = ctx->bytes;
+	if (states)
+		*states = ctx->n_rec;
+	pthread_mutex_unlock(&ctx->lock);
 }
 
 void stateman_drop(struct stateman_ctx** dst)
 {
 	if (!dst || *dst == NULL)
 		return;
-}
 
+	struct stateman_ctx* ctx = *dst;
+	*dst = NULL;
+
+	if (!ctx->shutdown){
+		pthread_mutex_lock(&ctx->lock);
+		ctx->shutdown = true;
+		pthread_cond_signal(&ctx->wake);
+		pthread_mutex_unlock(&ctx->lock);
+		pthread_join(ctx->worker, NULL);
+
+		pthread_mutex_destroy(&ctx->lock);
+		pthread_cond_destroy(&ctx->wake);
+		pthread_cond_destroy(&ctx->idle);
+	}
+
+	for (size_t i = 0; i < ctx->n_rec; i++)
+		free(rec_at(ctx, i));
+	free(ctx->rec);
+
+	for (size_t i = 0; i < STATEMAN_STAGING; i++)
+		free(ctx->staged[i].buf);
+
+	free(ctx->prev);
+	free(ctx->scratch);
+	free(ctx);
+}
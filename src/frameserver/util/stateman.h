@@ -11,6 +11,10 @@
  * state_sz defines block size
  * limit sets upper memory bounds in frames (limit( < 0)) or bytes
  * when reached, new frames will be added at the cost of old ones.
+ * History is dropped in keyframe groups, so the number of frames
+ * that can be seeked back will fluctuate somewhat below the limit.
+ * precision (> 1) only keeps every n:th fed state.
+ * Returns NULL on failure or if state_sz or limit is 0.
  */
 struct stateman_ctx* stateman_setup(size_t state_sz,
 	ssize_t limit, int precision);
@@ -24,10 +28,18 @@ struct stateman_ctx* stateman_setup(size_t state_sz,
 void stateman_feed(struct stateman_ctx*, int tstamp, void* inbuf);
 
 /*
- * Reconstruct the state closest to, timestamp. If Rel is set,
- * tstamp moves backward from the latest entry.
+ * Reconstruct the state closest to, but not after, timestamp. If Rel is
+ * set, tstamp moves backward from the latest entry. Pending states are
+ * flushed first. Returns the timestamp of the state written to dstbuf,
+ * or -1 if there is no history.
  */
-bool stateman_seek(struct stateman_ctx*, void* dstbuf, int tstamp, bool rel);
+int stateman_seek(struct stateman_ctx*, void* dstbuf, int tstamp, bool rel);
+
+/*
+ * Retrieve the current number of bytes used for encoded states and
+ * the number of states these cover, either pointer can be NULL.
+ */
+void stateman_usage(struct stateman_ctx*, size_t* bytes, size_t* states);
 
 /*
  * Drop a previously allocated staterecord
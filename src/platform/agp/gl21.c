@@ -64,6 +64,38 @@ const char * defcvprg =
 " gl_Position = (projection * modelview) * vertex;\n"
 "}";
 
+/* batched 2D quads, vertices are already transformed by the modelview and the
+ * per-object color / opacity comes as an attribute, see agp_batch_vobj */
+static const char* defbvprg =
+"#version 120\n"
+"uniform mat4 projection;\n"
+"attribute vec4 vertex;\n"
+"attribute vec2 texcoord;\n"
+"attribute vec4 color;\n"
+"varying vec2 texco;\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_Position = projection * vertex;\n"
+"	texco = texcoord;\n"
+"	vcol = color;\n"
+"}";
+
+static const char* defbfprg =
+"#version 120\n"
+"uniform sampler2D map_diffuse;\n"
+"varying vec2 texco;\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_FragColor = texture2D(map_diffuse, texco) * vcol;\n"
+"}";
+
+static const char* defbcfprg =
+"#version 120\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_FragColor = vcol;\n"
+"}";
+
 #ifdef _DEBUG
 #define DEBUG 1
 #else
@@ -93,6 +125,10 @@ agp_shader_id agp_default_shader(enum SHADER_TYPES type)
 		shids[COLOR_2D] = agp_shader_build(
 			"DEFAULT_COLOR", NULL, defcvprg, defcfprg);
 		shids[BASIC_3D] = shids[BASIC_2D];
+		shids[BATCH_2D] = agp_shader_build(
+			"DEFAULT_BATCH", NULL, defbvprg, defbfprg);
+		shids[BATCH_COLOR_2D] = agp_shader_build(
+			"DEFAULT_BATCH_COLOR", NULL, defbvprg, defbcfprg);
 		defshdr_build = true;
 	}
 
@@ -119,6 +155,16 @@ void agp_shader_source(enum SHADER_TYPES type,
 			*frag = defcfprg;
 		break;
 
+		case BATCH_2D:
+			*vert = defbvprg;
+			*frag = defbfprg;
+		break;
+
+		case BATCH_COLOR_2D:
+			*vert = defbvprg;
+			*frag = defbcfprg;
+		break;
+
 		default:
 			*vert = NULL;
 			*frag = NULL;
@@ -220,43 +266,151 @@ void agp_readback_synchronous(struct agp_vstore* dst)
 	env->bind_texture(GL_TEXTURE_2D, 0);
 }
 
+static bool pbo_ring_ok()
+{
+	struct agp_fenv* env = agp_env();
+	return env->map_buffer_range && env->fence_sync &&
+		env->client_wait_sync && env->delete_sync;
+}
+
+static void pbo_ring_rebuild(struct agp_vstore* s, size_t buf_sz)
+{
+	struct agp_fenv* env = agp_env();
+
+/* orphaning the old storage is enough, pending transfers keep theirs */
+	for (size_t i = 0; i < AGP_PBO_RING; i++){
+		if (s->vinf.text.wfence[i]){
+			env->delete_sync(s->vinf.text.wfence[i]);
+			s->vinf.text.wfence[i] = NULL;
+		}
+
+		if (!s->vinf.text.wring[i])
+			env->gen_buffers(1, &s->vinf.text.wring[i]);
+
+		env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, s->vinf.text.wring[i]);
+		env->buffer_data(GL_PIXEL_UNPACK_BUFFER, buf_sz, NULL, GL_STREAM_DRAW);
+	}
+
+	env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	s->vinf.text.wring_sz = buf_sz;
+	s->vinf.text.wring_ind = 0;
+
+	verbose_print("(%"PRIxPTR") built %d*%zu b upload ring",
+		(uintptr_t) s, AGP_PBO_RING, buf_sz);
+}
+
+/*
+ * Upload the [meta] region of [buf] through the next free slot in the PBO
+ * ring, the store is expected to be active. A slot is free when the fence
+ * placed after its last transfer has signalled, and that is only polled -
+ * if every slot is still in flight this returns false and the caller takes
+ * the synchronous path instead of stalling on the GPU.
+ */
+static bool pbo_ring_upload(
+	struct agp_vstore* s, av_pixel* buf, struct stream_meta* meta)
+{
+	struct agp_fenv* env = agp_env();
+	if (!pbo_ring_ok())
+		return false;
+
+	size_t buf_sz = s->w * s->h * sizeof(av_pixel);
+	if (s->vinf.text.wring_sz != buf_sz)
+		pbo_ring_rebuild(s, buf_sz);
+
+	size_t slot = AGP_PBO_RING;
+	for (size_t i = 0; i < AGP_PBO_RING; i++){
+		size_t ind = (s->vinf.text.wring_ind + i) % AGP_PBO_RING;
+		void* fence = s->vinf.text.wfence[ind];
+
+		if (fence){
+			if (env->client_wait_sync(fence, 0, 0) == GL_TIMEOUT_EXPIRED)
+				continue;
+			env->delete_sync(fence);
+			s->vinf.text.wfence[ind] = NULL;
+		}
+
+		slot = ind;
+		break;
+	}
+
+	if (slot == AGP_PBO_RING){
+		verbose_print("(%"PRIxPTR") upload ring saturated", (uintptr_t) s);
+		return false;
+	}
+
+/* rows are packed tightly at the start of the slot rather than mirroring the
+ * store layout, unpack skip-state combined with PBOs has been unreliable */
+	size_t row_sz = meta->w * sizeof(av_pixel);
+	size_t upl_sz = row_sz * meta->h;
+
+	env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, s->vinf.text.wring[slot]);
+	av_pixel* ptr = env->map_buffer_range(GL_PIXEL_UNPACK_BUFFER, 0, upl_sz,
+		GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+
+	if (!ptr){
+		verbose_print("(%"PRIxPTR") failed to map ring slot %zu", (uintptr_t) s, slot);
+		env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		return false;
+	}
+
+	if (meta->w == s->w)
+		memcpy(ptr, &buf[meta->y1 * s->w], upl_sz);
+	else
+		for (size_t y = 0; y < meta->h; y++)
+			memcpy(&ptr[y * meta->w],
+				&buf[(meta->y1 + y) * s->w + meta->x1], row_sz);
+
+	env->unmap_buffer(GL_PIXEL_UNPACK_BUFFER);
+	env->tex_subimage_2d(GL_TEXTURE_2D, 0, meta->x1, meta->y1, meta->w, meta->h,
+		s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
+		GL_UNSIGNED_BYTE, 0
+	);
+	env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+	s->vinf.text.wfence[slot] = env->fence_sync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	s->vinf.text.wring_ind = (slot + 1) % AGP_PBO_RING;
+
+	verbose_print("(%"PRIxPTR") ring upload %zu+%zu*%zu+%zu in slot %zu",
+		(uintptr_t) s, meta->x1, meta->w, meta->y1, meta->h, slot);
+	return true;
+}
+
 static void pbo_stream(struct agp_vstore* s,
 	av_pixel* buf, struct stream_meta* meta, bool synch)
 {
 	agp_activate_vstore(s);
 	struct agp_fenv* env = agp_env();
+	size_t ntc = s->w * s->h;
+
+	struct stream_meta full = {.w = s->w, .h = s->h};
+	if (pbo_ring_upload(s, buf, &full))
+		goto done;
+
+/* ring is busy, copy from client memory rather than wait for a slot */
+	if (pbo_ring_ok() || !s->vinf.text.wid){
+		env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0, s->w, s->h,
+			s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
+			GL_UNSIGNED_BYTE, buf
+		);
+		goto done;
+	}
 
+/* single PBO, orphan the previous storage so mapping doesn't block on the
+ * transfer that might still be reading from it */
 	env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, s->vinf.text.wid);
-	size_t ntc = s->w * s->h;
+	env->buffer_data(GL_PIXEL_UNPACK_BUFFER,
+		ntc * sizeof(av_pixel), NULL, GL_STREAM_DRAW);
 
 	av_pixel* ptr = env->map_buffer(GL_PIXEL_UNPACK_BUFFER,GL_WRITE_ONLY);
 
 	if (!ptr){
 		verbose_print("(%"PRIxPTR") failed to map PBO for writing", (uintptr_t) s);
+		env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+		agp_deactivate_vstore();
 		return;
 	}
 
-	av_pixel* obuf = buf;
-
-/* note, explicitly replace with a simd unaligned version */
-	if ( ((uintptr_t)ptr % 16) == 0 && ((uintptr_t)buf % 16) == 0	)
-		memcpy(ptr, buf, ntc * sizeof(av_pixel));
-	else
-		for (size_t i = 0; i < ntc; i++)
-			*ptr++ = *buf++;
-
-/* synch :- on-host backing store, one extra copy into local buffer */
-	if (synch){
-		buf = obuf;
-		ptr = s->vinf.text.raw;
-		s->update_ts = arcan_timemillis();
-
-		if ( ((uintptr_t)ptr % 16) == 0 && ((uintptr_t)buf % 16) == 0	)
-			memcpy(ptr, buf, ntc * sizeof(av_pixel));
-		else
-			for (size_t i = 0; i < ntc; i++)
-				*ptr++ = *buf++;
-	}
+	memcpy(ptr, buf, ntc * sizeof(av_pixel));
 
 	verbose_print(
 		"(%"PRIxPTR") pbo stream update %zu*%zu", (uintptr_t) s, s->w, s->h);
@@ -269,6 +423,14 @@ static void pbo_stream(struct agp_vstore* s,
 	);
 
 	env->bind_buffer(GL_PIXEL_UNPACK_BUFFER, 0);
+
+done:
+/* synch :- on-host backing store, one extra copy into local buffer */
+	if (synch && buf != s->vinf.text.raw){
+		memcpy(s->vinf.text.raw, buf, ntc * sizeof(av_pixel));
+		s->update_ts = arcan_timemillis();
+	}
+
 	agp_deactivate_vstore();
 }
 
@@ -277,54 +439,37 @@ static void pbo_stream_sub(struct agp_vstore* s,
 	av_pixel* buf, struct stream_meta* meta, bool synch)
 {
 	struct agp_fenv* env = agp_env();
-	if ( (float)(meta->w * meta->h) / (s->w * s->h) > 0.5)
+
+/* without the ring, large regions are cheaper as a single PBO transfer */
+	if (!pbo_ring_ok() && (float)(meta->w * meta->h) / (s->w * s->h) > 0.5)
 		return pbo_stream(s, buf, meta, synch);
 
 	agp_activate_vstore(s);
 	size_t row_sz = meta->w * sizeof(av_pixel);
-	set_pixel_store(s->w, *meta);
 
-	verbose_print(
-		"(%"PRIxPTR") pbo stream sub-update %zu+%zu*%zu+%zu",
-		(uintptr_t) s, meta->x1, meta->w, meta->y1, meta->h
-	);
+	if (!pbo_ring_upload(s, buf, meta)){
+		set_pixel_store(s->w, *meta);
+
+		verbose_print(
+			"(%"PRIxPTR") stream sub-update %zu+%zu*%zu+%zu",
+			(uintptr_t) s, meta->x1, meta->w, meta->y1, meta->h
+		);
+
+		env->tex_subimage_2d(GL_TEXTURE_2D, 0, meta->x1, meta->y1, meta->w, meta->h,
+			s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
+			GL_UNSIGNED_BYTE, buf
+		);
+		reset_pixel_store();
+	}
 
-	env->tex_subimage_2d(GL_TEXTURE_2D, 0, meta->x1, meta->y1, meta->w, meta->h,
-		s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
-		GL_UNSIGNED_BYTE, buf
-	);
-	reset_pixel_store();
 	agp_deactivate_vstore(s);
 
-	if (synch){
+	if (synch && buf != s->vinf.text.raw){
 		av_pixel* cpy = s->vinf.text.raw;
 		for (size_t y = meta->y1; y < meta->y1 + meta->h; y++)
 			memcpy(&cpy[y * s->w + meta->x1], &buf[y * s->w + meta->x1], row_sz);
 		s->update_ts = arcan_timemillis();
 	}
-
-/*
- * Currently disabled approach to update subregion using PBO, experienced
- * data corruption / driver bugs on several drivers :'(
- */
-
-#if 0
-	av_pixel* ptr = glMapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
-
-glBindBuffer(GL_PIXEL_UNPACK_BUFFER, s->vinf.text.wid);
-
-
-/* warning, with the normal copy we check alignment in beforehand as we have
- * had cases where glMapBuffer intermittently returns unaligned pointers AND
- * the compiler has emitted intrinsics that assumed alignment */
-	for (size_t y = meta->y1; y < meta->y1 + meta->h; y++)
-		memcpy(&ptr[y * s->w + meta->x1], &buf[y * s->w + meta->x1], row_sz);
-
-		glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
-	glTexSubImage2D(GL_TEXTURE_2D, 0, meta->x1, meta->y1, meta->w, meta->h,
-		GL_PIXEL_FORMAT, GL_UNSIGNED_BYTE, 0);
-	glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
-#endif
 }
 
 static inline void setup_unpack_pbo(struct agp_vstore* s, void* buf)
@@ -366,7 +511,7 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 	switch (type){
 	case STREAM_RAW:
 		verbose_print("(%"PRIxPTR") prepare upload (raw)", (uintptr_t) s);
-		if (!s->vinf.text.wid)
+		if (!s->vinf.text.wid && !pbo_ring_ok())
 			setup_unpack_pbo(s, NULL);
 
 		alloc_buffer(s);
@@ -379,7 +524,7 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 		alloc_buffer(s);
 	case STREAM_RAW_DIRECT:
 		verbose_print("(%"PRIxPTR") prepare upload (raw/direct)", (uintptr_t) s);
-		if (!s->vinf.text.wid)
+		if (!s->vinf.text.wid && !pbo_ring_ok())
 			setup_unpack_pbo(s, meta.buf);
 
 		if (meta.dirty)
@@ -409,13 +554,14 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 			);
 			reset_pixel_store();
 		}
-		else
+		else {
 			verbose_print(
 				"(%"PRIxPTR") raw synch (%zu*%zu)", (uintptr_t) s, meta.w, meta.h);
-				env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0, s->w, s->h,
+			env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0, s->w, s->h,
 				s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
 				GL_UNSIGNED_BYTE, meta.buf
 			);
+		}
 		agp_deactivate_vstore();
 	break;
 
@@ -424,6 +570,7 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
  * again, if that succeeds it means that we had to go through a RTT
  * indirection, if that fails we should convey back to the client that
 	we can't accept this kind of transfer */
+	s->vinf.text.tex_w = s->vinf.text.tex_h = 0;
 	res.state = platform_video_map_handle(s, meta.handle);
 	break;
 	}
@@ -87,6 +87,41 @@ const char * defcvprg =
 " gl_Position = (projection * modelview) * vertex;\n"
 "}";
 
+/* batched 2D quads, vertices are already transformed by the modelview and the
+ * per-object color / opacity comes as an attribute, see agp_batch_vobj */
+static const char* defbvprg =
+"#version 100\n"
+"precision mediump float;\n"
+"uniform mat4 projection;\n"
+"attribute vec4 vertex;\n"
+"attribute vec2 texcoord;\n"
+"attribute vec4 color;\n"
+"varying vec2 texco;\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_Position = projection * vertex;\n"
+"	texco = texcoord;\n"
+"	vcol = color;\n"
+"}";
+
+static const char* defbfprg =
+"#version 100\n"
+"precision mediump float;\n"
+"uniform sampler2D map_diffuse;\n"
+"varying vec2 texco;\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_FragColor = texture2D(map_diffuse, texco) * vcol;\n"
+"}";
+
+static const char* defbcfprg =
+"#version 100\n"
+"precision mediump float;\n"
+"varying vec4 vcol;\n"
+"void main(){\n"
+"	gl_FragColor = vcol;\n"
+"}";
+
 agp_shader_id agp_default_shader(enum SHADER_TYPES type)
 {
 	static agp_shader_id shids[SHADER_TYPE_ENDM];
@@ -99,6 +134,10 @@ agp_shader_id agp_default_shader(enum SHADER_TYPES type)
 		shids[COLOR_2D] = agp_shader_build(
 			"DEFAULT_COLOR", NULL, defcvprg, defcfprg);
 		shids[BASIC_3D] = shids[BASIC_2D];
+		shids[BATCH_2D] = agp_shader_build(
+			"DEFAULT_BATCH", NULL, defbvprg, defbfprg);
+		shids[BATCH_COLOR_2D] = agp_shader_build(
+			"DEFAULT_BATCH_COLOR", NULL, defbvprg, defbcfprg);
 		defshdr_build = true;
 	}
 
@@ -142,6 +181,16 @@ void agp_shader_source(enum SHADER_TYPES type,
 		*frag = defcfprg;
 	break;
 
+	case BATCH_2D:
+		*vert = defbvprg;
+		*frag = defbfprg;
+	break;
+
+	case BATCH_COLOR_2D:
+		*vert = defbvprg;
+		*frag = defbcfprg;
+	break;
+
 	default:
 		*vert = NULL;
 		*frag = NULL;
@@ -281,11 +330,44 @@ static void alloc_buffer(struct agp_vstore* s)
 	}
 }
 
+/*
+ * Upload the dirty region of [buf] if there is one. GLES2 lacks the unpack
+ * row length, but the dirty rows are contiguous at full width so the band
+ * covering them can be sent as-is.
+ */
+static void stream_upload(
+	struct agp_vstore* s, av_pixel* buf, struct stream_meta* meta)
+{
+	struct agp_fenv* env = agp_env();
+	GLenum fmt = s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT;
+	agp_activate_vstore(s);
+
+	if (!meta->dirty)
+		env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0,
+			s->w, s->h, fmt, GL_UNSIGNED_BYTE, buf);
+	else {
+#ifdef GLES3
+		env->pixel_storei(GL_UNPACK_SKIP_ROWS, meta->y1);
+		env->pixel_storei(GL_UNPACK_SKIP_PIXELS, meta->x1);
+		env->pixel_storei(GL_UNPACK_ROW_LENGTH, s->w);
+		env->tex_subimage_2d(GL_TEXTURE_2D, 0, meta->x1, meta->y1,
+			meta->w, meta->h, fmt, GL_UNSIGNED_BYTE, buf);
+		env->pixel_storei(GL_UNPACK_SKIP_ROWS, 0);
+		env->pixel_storei(GL_UNPACK_SKIP_PIXELS, 0);
+		env->pixel_storei(GL_UNPACK_ROW_LENGTH, 0);
+#else
+		env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, meta->y1,
+			s->w, meta->h, fmt, GL_UNSIGNED_BYTE, &buf[meta->y1 * s->w]);
+#endif
+	}
+
+	agp_deactivate_vstore();
+}
+
 struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 		struct stream_meta meta, enum stream_type type)
 {
 	struct stream_meta mout = meta;
-	struct agp_fenv* env = agp_env();
 	mout.state = true;
 
 	switch(type){
@@ -308,6 +390,8 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 		else
 			for (size_t i = 0; i < ntc; i++)
 				*ptr++ = *buf++;
+
+		stream_upload(s, meta.buf, &meta);
 	}
 	break;
 
@@ -319,16 +403,12 @@ struct stream_meta agp_stream_prepare(struct agp_vstore* s,
 
 	case STREAM_RAW_DIRECT:
 	case STREAM_RAW_DIRECT_SYNCHRONOUS:
-	agp_activate_vstore(s);
-		env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0, s->w, s->h,
-			s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
-			GL_UNSIGNED_BYTE, meta.buf
-		);
-		agp_deactivate_vstore();
+		stream_upload(s, meta.buf, &meta);
 	break;
 
 /* see notes in gl21.c */
 	case STREAM_HANDLE:
+		s->vinf.text.tex_w = s->vinf.text.tex_h = 0;
 		mout.state = platform_video_map_handle(s, meta.handle);
 	break;
 	}
@@ -53,6 +53,13 @@ struct agp_fenv {
 	void (*bind_buffer) (GLenum, GLuint);
 	void* (*map_buffer) (GLenum, GLenum);
 
+/* optional (GL3.x / GLES3), without them streaming uploads use a single PBO,
+ * sync objects are kept as opaque pointers as GLES2 headers lack GLsync */
+	void* (*map_buffer_range) (GLenum, GLintptr, GLsizeiptr, GLbitfield);
+	void* (*fence_sync) (GLenum, GLbitfield);
+	GLenum (*client_wait_sync) (void*, GLbitfield, uint64_t);
+	void (*delete_sync) (void*);
+
 /* FBOs */
 	void (*gen_framebuffers) (GLsizei, GLuint*);
 	void (*bind_framebuffer) (GLenum, GLuint);
@@ -150,6 +157,7 @@ struct agp_fenv {
 	int model_flags;
 	GLenum blend_src_alpha, blend_dst_alpha;
 	GLint last_store_mode;
+	GLuint batch_vbo;
 };
 
 void agp_glinit_fenv(struct agp_fenv* dst,
@@ -63,6 +63,18 @@ void agp_glinit_fenv(struct agp_fenv* dst,
 	dst->map_buffer =
 		(void*(*)(GLenum, GLenum))
 			lookup(tag, "glMapBuffer");
+	dst->map_buffer_range =
+		(void*(*)(GLenum, GLintptr, GLsizeiptr, GLbitfield))
+			lookup_opt(tag, "glMapBufferRange");
+	dst->fence_sync =
+		(void*(*)(GLenum, GLbitfield))
+			lookup_opt(tag, "glFenceSync");
+	dst->client_wait_sync =
+		(GLenum(*)(void*, GLbitfield, uint64_t))
+			lookup_opt(tag, "glClientWaitSync");
+	dst->delete_sync =
+		(void(*)(void*))
+			lookup_opt(tag, "glDeleteSync");
 #endif
 /* FBOs */
 	dst->gen_framebuffers =
@@ -6,6 +6,7 @@
 
 #include <stdlib.h>
 #include <stdint.h>
+#include <stddef.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <assert.h>
@@ -1011,6 +1012,7 @@ void agp_null_vstore(struct agp_vstore* store)
 		(uintptr_t) store, store->vinf.text.glid);
 	store->vinf.text.glid = GL_NONE;
 	store->vinf.text.glid_proxy = NULL;
+	store->vinf.text.tex_w = store->vinf.text.tex_h = 0;
 }
 
 void agp_resize_rendertarget(
@@ -1121,8 +1123,10 @@ void agp_update_vstore(struct agp_vstore* s, bool copy)
 	if (!copy)
 		env->bind_texture(GL_TEXTURE_2D, s->vinf.text.glid);
 	else{
-		if (GL_NONE == s->vinf.text.glid)
+		if (GL_NONE == s->vinf.text.glid){
 			env->gen_textures(1, &s->vinf.text.glid);
+			s->vinf.text.tex_w = s->vinf.text.tex_h = 0;
+		}
 
 /* for the launch_resume and resize states, were we'd push a new
  * update	but have multiple references */
@@ -1191,17 +1195,29 @@ void agp_update_vstore(struct agp_vstore* s, bool copy)
 		env->pixel_storei(GL_UNPACK_ROW_LENGTH, 0);
 #endif
 		s->update_ts = arcan_timemillis();
+		uint64_t dfmt = s->vinf.text.d_fmt ? s->vinf.text.d_fmt : GL_STORE_PIXEL_FORMAT;
+		GLenum sfmt = s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT;
+		GLenum stype = s->vinf.text.s_type ? s->vinf.text.s_type : GL_UNSIGNED_BYTE;
+
 		if (s->txmapped == TXSTATE_DEPTH)
 			env->tex_image_2d(GL_TEXTURE_2D, 0, GL_DEPTH_COMPONENT, s->w, s->h, 0,
 				GL_DEPTH_COMPONENT, GL_UNSIGNED_BYTE, 0);
-		else
-			env->tex_image_2d(GL_TEXTURE_2D, 0,
-				s->vinf.text.d_fmt ? s->vinf.text.d_fmt : GL_STORE_PIXEL_FORMAT,
-				s->w, s->h, 0,
-				s->vinf.text.s_fmt ? s->vinf.text.s_fmt : GL_PIXEL_FORMAT,
-				s->vinf.text.s_type ? s->vinf.text.s_type : GL_UNSIGNED_BYTE,
-				s->vinf.text.raw
-			);
+
+/* storage already has the right size and format, only replace the contents
+ * so the driver doesn't have to orphan and reallocate the texture */
+		else if (s->vinf.text.raw && s->txmapped == TXSTATE_TEX2D &&
+			s->vinf.text.tex_w == s->w && s->vinf.text.tex_h == s->h &&
+			s->vinf.text.tex_fmt == dfmt){
+			env->tex_subimage_2d(GL_TEXTURE_2D, 0, 0, 0,
+				s->w, s->h, sfmt, stype, s->vinf.text.raw);
+		}
+		else {
+			env->tex_image_2d(GL_TEXTURE_2D, 0, dfmt,
+				s->w, s->h, 0, sfmt, stype, s->vinf.text.raw);
+			s->vinf.text.tex_w = s->w;
+			s->vinf.text.tex_h = s->h;
+			s->vinf.text.tex_fmt = dfmt;
+		}
 		verbose_print("copied");
 	}
 
@@ -1251,6 +1267,40 @@ static float ident[] = {
 	0.0, 0.0, 0.0, 1.0
 };
 
+/*
+ * Number of quads that fit in the 2D batch before it gets flushed, each quad
+ * is two triangles worth of interleaved vertices that are streamed into the
+ * batch_vbo of the current agp_fenv.
+ */
+#ifndef AGP_BATCH_LIMIT
+#define AGP_BATCH_LIMIT 1024
+#endif
+
+struct batch_vertex {
+	float pos[4];
+	float tex[2];
+	float col[4];
+};
+
+static struct {
+	struct batch_vertex verts[AGP_BATCH_LIMIT * 6];
+	size_t count;
+} batch;
+
+static struct {
+	size_t calls, quads;
+} drawstats;
+
+void agp_drawstats(size_t* calls, size_t* quads, bool reset)
+{
+	if (calls)
+		*calls = drawstats.calls;
+	if (quads)
+		*quads = drawstats.quads;
+	if (reset)
+		drawstats.calls = drawstats.quads = 0;
+}
+
 void agp_blendstate(enum arcan_blendfunc mode)
 {
 	struct agp_fenv* env = agp_env();
@@ -1327,6 +1377,8 @@ void agp_draw_vobj(
 		}
 
 		env->draw_arrays(GL_TRIANGLE_FAN, 0, 4);
+		drawstats.calls++;
+		drawstats.quads++;
 
 		if (settex)
 			env->disable_vertex_attrarray(attrindt);
@@ -1337,6 +1389,97 @@ void agp_draw_vobj(
 	agp_rendertarget_dirty(active_rendertarget, &(struct agp_region){});
 }
 
+size_t agp_batch_flush()
+{
+	size_t count = batch.count;
+	if (!count)
+		return 0;
+
+	batch.count = 0;
+	verbose_print("batch-flush(%zu)", count);
+
+	struct agp_fenv* env = agp_env();
+	GLint attrindv = agp_shader_vattribute_loc(ATTRIBUTE_VERTEX);
+	GLint attrindt = agp_shader_vattribute_loc(ATTRIBUTE_TEXCORD0);
+	GLint attrindc = agp_shader_vattribute_loc(ATTRIBUTE_COLOR);
+	if (attrindv == -1)
+		return 0;
+
+/* re-specifying the whole store each flush lets the driver orphan the one
+ * that might still be in flight rather than stall on it */
+	if (!env->batch_vbo)
+		env->gen_buffers(1, &env->batch_vbo);
+
+	size_t stride = sizeof(struct batch_vertex);
+	env->bind_buffer(GL_ARRAY_BUFFER, env->batch_vbo);
+	env->buffer_data(GL_ARRAY_BUFFER,
+		stride * count * 6, batch.verts, GL_STREAM_DRAW);
+
+	env->enable_vertex_attrarray(attrindv);
+	env->vertex_attrpointer(attrindv, 4, GL_FLOAT, GL_FALSE, stride,
+		(void*) offsetof(struct batch_vertex, pos));
+
+	if (attrindt != -1){
+		env->enable_vertex_attrarray(attrindt);
+		env->vertex_attrpointer(attrindt, 2, GL_FLOAT, GL_FALSE, stride,
+			(void*) offsetof(struct batch_vertex, tex));
+	}
+
+	if (attrindc != -1){
+		env->enable_vertex_attrarray(attrindc);
+		env->vertex_attrpointer(attrindc, 4, GL_FLOAT, GL_FALSE, stride,
+			(void*) offsetof(struct batch_vertex, col));
+	}
+
+	env->draw_arrays(GL_TRIANGLES, 0, count * 6);
+	drawstats.calls++;
+	drawstats.quads += count;
+
+	if (attrindc != -1)
+		env->disable_vertex_attrarray(attrindc);
+	if (attrindt != -1)
+		env->disable_vertex_attrarray(attrindt);
+	env->disable_vertex_attrarray(attrindv);
+
+/* the rest of the 2D pipeline uses client side arrays */
+	env->bind_buffer(GL_ARRAY_BUFFER, 0);
+
+	agp_rendertarget_dirty(active_rendertarget, &(struct agp_region){});
+	return count;
+}
+
+void agp_batch_vobj(float x1, float y1, float x2, float y2,
+	const float* txcos, const float* model, const float col[4])
+{
+	if (batch.count == AGP_BATCH_LIMIT)
+		agp_batch_flush();
+
+	if (!model)
+		model = ident;
+
+	if (!txcos)
+		txcos = (const float[]){0, 0, 1, 0, 1, 1, 0, 1};
+
+/* same corner order as the fan in agp_draw_vobj, split into 0,1,2 + 0,2,3 */
+	const float corners[4][2] = {{x1, y1}, {x2, y1}, {x2, y2}, {x1, y2}};
+	struct batch_vertex quad[4];
+
+	for (size_t i = 0; i < 4; i++){
+		float x = corners[i][0];
+		float y = corners[i][1];
+		for (size_t j = 0; j < 4; j++)
+			quad[i].pos[j] = model[j] * x + model[4+j] * y + model[12+j];
+		quad[i].tex[0] = txcos[i*2+0];
+		quad[i].tex[1] = txcos[i*2+1];
+		memcpy(quad[i].col, col, sizeof(float) * 4);
+	}
+
+	struct batch_vertex* dst = &batch.verts[batch.count * 6];
+	dst[0] = quad[0]; dst[1] = quad[1]; dst[2] = quad[2];
+	dst[3] = quad[0]; dst[4] = quad[2]; dst[5] = quad[3];
+	batch.count++;
+}
+
 static void toggle_debugstates(float* modelview)
 {
 	struct agp_fenv* env = agp_env();
@@ -1483,17 +1626,20 @@ static void setup_transfer(struct agp_mesh_store* base, enum agp_mesh_flags fl)
 				"triangle-soup(indexed, %u indices)", (unsigned)base->n_indices);
 			env->draw_elements(GL_TRIANGLES,
 				base->n_indices, GL_UNSIGNED_INT, base->indices);
+			drawstats.calls++;
 		}
 		else{
 			verbose_print(
 				"triangle-soup(vertices, %u vertices)", (unsigned)base->n_vertices);
 			env->draw_arrays(GL_TRIANGLES, 0, base->n_vertices);
+			drawstats.calls++;
 		}
 	}
 	else if (base->type == AGP_MESH_POINTCLOUD){
 		verbose_print("point-cloud(%u points)", (unsigned)base->n_vertices);
 		env->enable(GL_VERTEX_PROGRAM_POINT_SIZE);
 		env->draw_arrays(GL_POINTS, 0, base->n_vertices);
+		drawstats.calls++;
 		env->disable(GL_VERTEX_PROGRAM_POINT_SIZE);
 	}
 
@@ -1537,6 +1683,13 @@ void agp_drop_vstore(struct agp_vstore* s)
 		env->delete_buffers(1, &s->vinf.text.wid);
 		s->vinf.text.wid = GL_NONE;
 	}
+
+	for (size_t i = 0; i < AGP_PBO_RING; i++){
+		if (s->vinf.text.wfence[i])
+			env->delete_sync(s->vinf.text.wfence[i]);
+		if (GL_NONE != s->vinf.text.wring[i])
+			env->delete_buffers(1, &s->vinf.text.wring[i]);
+	}
 #endif
 
 	verbose_print("dropped (%"PRIxPTR")", (uintptr_t) s);
@@ -259,7 +259,9 @@ bool agp_shader_destroy(agp_shader_id shid)
 	if (!agp_shader_valid(shid) ||
 		shid == agp_default_shader(BASIC_2D) ||
 		shid == agp_default_shader(BASIC_3D) ||
-		shid == agp_default_shader(COLOR_2D))
+		shid == agp_default_shader(COLOR_2D) ||
+		shid == agp_default_shader(BATCH_2D) ||
+		shid == agp_default_shader(BATCH_COLOR_2D))
 		return false;
 
 	struct shader_cont* cur = &shdr_global.slots[SHADER_INDEX(shid)];
@@ -163,6 +163,24 @@ void agp_draw_vobj(float x1, float y1,
 {
 }
 
+void agp_batch_vobj(float x1, float y1, float x2, float y2,
+	const float* txcos, const float* model, const float col[4])
+{
+}
+
+size_t agp_batch_flush()
+{
+	return 0;
+}
+
+void agp_drawstats(size_t* calls, size_t* quads, bool reset)
+{
+	if (calls)
+		*calls = 0;
+	if (quads)
+		*quads = 0;
+}
+
 void agp_submit_mesh(struct agp_mesh_store* base, enum agp_mesh_flags fl)
 {
 }
@@ -43,11 +43,16 @@ typedef uint32_t agp_shader_id;
  * Retrieve the default shader for a specific purpose,
  * BASIC_2D => single textured, alpha in obj_opacity
  * COLOR_2D => not textured, color channel in uniforms
+ * BATCH_2D => single textured, pre-transformed vertices, color attribute
+ *             modulates the texture (see agp_batch_vobj)
+ * BATCH_COLOR_2D => not textured, pre-transformed vertices, color attribute
  */
 enum SHADER_TYPES {
 	BASIC_2D = 0,
 	COLOR_2D,
 	BASIC_3D,
+	BATCH_2D,
+	BATCH_COLOR_2D,
 	SHADER_TYPE_ENDM
 };
 agp_shader_id agp_default_shader(enum SHADER_TYPES);
@@ -305,6 +310,29 @@ void agp_blendstate(enum arcan_blendfunc);
 void agp_draw_vobj(float x1, float y1, float x2, float y2,
 	const float* txcos, const float* modelview);
 
+/*
+ * Queue the same quad as agp_draw_vobj into the 2D batch. The corners are
+ * transformed by [modelview] on the CPU and [col] (r, g, b, opacity) is set
+ * per vertex, so consecutive quads that share vstore, blend state and a
+ * BATCH_2D / BATCH_COLOR_2D shader can be drawn with one call. The caller
+ * is responsible for calling agp_batch_flush before changing any of that
+ * state, the batch is flushed by itself when full.
+ */
+void agp_batch_vobj(float x1, float y1, float x2, float y2,
+	const float* txcos, const float* modelview, const float col[4]);
+
+/*
+ * Draw and reset the queued batch using the current state, returns the
+ * number of quads that were drawn.
+ */
+size_t agp_batch_flush();
+
+/*
+ * Retrieve the number of draw calls issued and the number of 2D quads they
+ * covered since the last call with [reset] set.
+ */
+void agp_drawstats(size_t* calls, size_t* quads, bool reset);
+
 /*
  * Destination format for rendertargets. Note that we do not currently suport
  * floating point targets and that for some platforms, COLOR_DEPTH will map to
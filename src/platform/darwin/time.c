@@ -16,9 +16,8 @@
 #include <stdint.h>
 #include <stdbool.h>
 
-unsigned long long int arcan_timemillis()
+static double timebase()
 {
-	uint64_t time = mach_absolute_time();
 	static double sf;
 
 	if (!sf){
@@ -30,7 +29,19 @@ unsigned long long int arcan_timemillis()
 			sf = 1.0;
 		}
 	}
-	return ( (double)time * sf) / 1000000;
+	return sf;
+}
+
+unsigned long long int arcan_timemillis()
+{
+	uint64_t time = mach_absolute_time();
+	return ( (double)time * timebase()) / 1000000;
+}
+
+unsigned long long int arcan_timemicros()
+{
+	uint64_t time = mach_absolute_time();
+	return ( (double)time * timebase()) / 1000;
 }
 
 void arcan_timesleep(unsigned long val)
@@ -25,6 +25,12 @@
  */
 unsigned long long arcan_timemillis();
 
+/*
+ * Same as arcan_timemillis but in microseconds, used for latency statistics
+ * where millisecond resolution would hide most of the distribution.
+ */
+unsigned long long arcan_timemicros();
+
 /*
  * Both these functions expect [argv / envv] to be modifiable and their
  * internal contents dynamically allocated (hence will possible replace / free
@@ -179,6 +179,14 @@ enum storage_source {
 	STORAGE_TEXTARRAY
 };
 
+/*
+ * number of unpack buffers cycled between when streaming into a store, a
+ * slot is only reused when the upload sourced from it has been consumed
+ */
+#ifndef AGP_PBO_RING
+#define AGP_PBO_RING 3
+#endif
+
 struct agp_vstore {
 	size_t refcount;
 	uint32_t update_ts;
@@ -190,8 +198,18 @@ struct agp_vstore {
 			unsigned glid;
 			unsigned* glid_proxy;
 
-/* used for PBO transfers */
+/* used for PBO transfers, [wring] is the streaming upload ring with one
+ * fence per slot, [wring_sz] is the size each slot was allocated with */
 			unsigned rid, wid;
+			unsigned wring[AGP_PBO_RING];
+			void* wfence[AGP_PBO_RING];
+			size_t wring_sz;
+			uint8_t wring_ind;
+
+/* dimensions / format the texture storage was last specified with, lets an
+ * update of the same size replace contents rather than reallocate */
+			size_t tex_w, tex_h;
+			uint64_t tex_fmt;
 
 /* intermediate storage for reconstructing lost context */
 			uint32_t s_raw;
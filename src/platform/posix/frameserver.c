@@ -114,6 +114,32 @@ static size_t shmpage_size(size_t w, size_t h,
 #endif
 }
 
+/*
+ * Segment sizes are rounded up to quarter steps between powers of two and
+ * [steps] classes of headroom are added on top. The shm backing only takes
+ * memory for what is actually touched, so the slack costs address space and
+ * lets interactive resizes step inside the mapping without a remap.
+ */
+static size_t shmpage_class(size_t sz, size_t steps)
+{
+	size_t base = 4096;
+	while (base * 2 <= sz)
+		base *= 2;
+
+	size_t step = base >> 2;
+	size_t res = (sz + step - 1) / step * step;
+
+	while (steps--){
+		if (res >= base * 2){
+			base *= 2;
+			step = base >> 2;
+		}
+		res += step;
+	}
+
+	return res;
+}
+
 static void dropshared_keyed(char** key)
 {
 	if (!key || !(*key))
@@ -711,6 +737,7 @@ struct arcan_frameserver* platform_fsrv_alloc()
 	res->parent.vid = ARCAN_EID;
 	res->desc.samplerate = ARCAN_SHMIF_SAMPLERATE;
 	res->vstream.handle = BADFD;
+	res->tpack.fd = BADFD;
 	res->sockmode = S_IRWXU;
 	res->child = BROKEN_PROCESS_HANDLE;
 
@@ -1220,9 +1247,11 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 	size_t abufsz = atomic_load(&shmpage->abufsize);
 	size_t vbufc = atomic_load(&shmpage->vpending);
 	size_t abufc = atomic_load(&shmpage->apending);
+	bool mbox = !!(vbufc & SHMIF_VBUFC_MAILBOX);
 	size_t samplerate = atomic_load(&shmpage->audiorate);
 	unsigned aproto = atomic_load(&shmpage->apad_type) & s->metamask;
 
+	vbufc &= ~SHMIF_VBUFC_MAILBOX;
 	vbufc = vbufc > FSRV_MAX_VBUFC ? FSRV_MAX_VBUFC : vbufc;
 	abufc = abufc > FSRV_MAX_ABUFC ? FSRV_MAX_ABUFC : abufc;
 	vbufc = vbufc == 0 ? 1 : vbufc;
@@ -1259,13 +1288,23 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 		shmsz = shmpage_size(w, h, vbufc, abufc, abufsz, apad_sz);
 	} while (shmsz > ARCAN_SHMPAGE_MAX_SZ && vbufc-- > 1);
 
+/* the mailbox needs one buffer for each of client, newest and server, and
+ * packed cell contents only carries the damaged lines so it can't drop */
+	if (vbufc < 3 || (atomic_load(&shmpage->hints) & SHMIF_RHINT_TPACK))
+		mbox = false;
+
 /* initial sanity check */
 	if (shmsz > ARCAN_SHMPAGE_MAX_SZ || (s->max_w && w > s->max_w) ||
 		(s->max_h && h > s->max_h))
 		goto fail;
 
-/* no remapping required, resize effect is insignificant or impossible */
-	bool rmap = (shmsz > src->shmsize || shmsz < (float) src->shmsize * 0.8);
+/* grow with a class of headroom so the next steps of an interactive resize
+ * fit, and only shrink when the mapping is well beyond what is needed */
+	size_t mapsz = shmpage_class(shmsz, 1);
+	if (mapsz > ARCAN_SHMPAGE_MAX_SZ)
+		mapsz = ARCAN_SHMPAGE_MAX_SZ;
+
+	bool rmap = shmsz > src->shmsize || shmpage_class(shmsz, 2) < src->shmsize;
 
 /* special case, no remap supported */
 #ifdef ARCAN_SHMIF_OVERCOMMIT
@@ -1274,9 +1313,9 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 #endif
 
 	if (rmap){
-	if (-1 == ftruncate(src->handle, shmsz)){
+	if (-1 == ftruncate(src->handle, mapsz)){
 		arcan_warning("truncate failed during resize operation (%d, %d)\n",
-			(int) src->handle, (int) shmsz);
+			(int) src->handle, (int) mapsz);
 		goto fail;
 	}
 
@@ -1284,7 +1323,7 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
  * asynchronous and push a MIGRATE event, but the gains seem rather pointless */
 #if defined(_GNU_SOURCE) && !defined(__APPLE__) && !defined(__BSD)
 	struct arcan_shmif_page* newp = mremap(src->ptr,
-		src->shmsize, shmsz, MREMAP_MAYMOVE, NULL);
+		src->shmsize, mapsz, MREMAP_MAYMOVE, NULL);
 	if (MAP_FAILED == newp){
 		if (-1 == ftruncate(src->handle, src->shmsize))
 			arcan_warning("_resize, truncate reset on resize fail fail\n");
@@ -1302,17 +1341,18 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 */
 #else
 	munmap(src->ptr, src->shmsize);
-	src->ptr = mmap(NULL, shmsz, PROT_READ|PROT_WRITE, MAP_SHARED,src->handle,0);
+	src->ptr = mmap(NULL, mapsz, PROT_READ|PROT_WRITE, MAP_SHARED,src->handle,0);
 	if (MAP_FAILED == src->ptr){
 		src->ptr = NULL;
 		arcan_warning("frameserver_resize() failed, reason: %s\n", strerror(errno));
 		goto fail;
 	}
 #endif
+
+	src->shmsize = mapsz;
 	}
 
 	shmpage = src->ptr;
-	src->shmsize = shmsz;
 
 /* commit to local tracking */
 	atomic_store(&shmpage->w, w);
@@ -1322,6 +1362,7 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 	s->desc.pending_hints = atomic_load(&shmpage->hints);
 	s->vbuf_cnt = vbufc;
 	s->abuf_cnt = abufc;
+	s->flags.mailbox = mbox;
 
 /* authenticate if needed */
 	if (s->desc.pending_hints & SHMIF_RHINT_AUTH_TOK){
@@ -1337,17 +1378,22 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 /* remap pointers, padding need to be updated first as shmif_mapav
  * uses that as a side-channel and we don't want to change the interface */
 	atomic_store(&shmpage->apad, apad_sz);
-	shmpage->segment_size = arcan_shmif_mapav(shmpage,
+	size_t used = arcan_shmif_mapav(shmpage,
 		s->vbufs, s->vbuf_cnt, w * h * sizeof(shmif_pixel),
 		s->abufs, s->abuf_cnt, abufsz);
 	s->abuf_sz = abufsz;
+
+/* the client maps all of it so it can follow us inside the headroom */
+	shmpage->segment_size = src->shmsize;
+	arcan_shmif_prefault(shmpage, src->shmsize, used);
 	arcan_shmif_setevqs(shmpage, s->esync, &(s->inqueue), &(s->outqueue), 1);
 
 /* commit to shared page */
 	shmpage->resized = 0;
 	shmpage->abufsize = abufsz;
 	shmpage->apending = s->abuf_cnt;
-	shmpage->vpending = s->vbuf_cnt;
+	shmpage->vpending = s->vbuf_cnt | (mbox ? SHMIF_VBUFC_MAILBOX : 0);
+	shmpage->vready = 0;
 
 /* realize the sub-protocol */
 	if (reset_proto){
@@ -1366,7 +1412,8 @@ int platform_fsrv_resynch(struct arcan_frameserver* s)
 fail:
 	atomic_store(&shmpage->abufsize, abufsz);
 	atomic_store(&shmpage->apending, s->abuf_cnt);
-	atomic_store(&shmpage->vpending, s->vbuf_cnt);
+	atomic_store(&shmpage->vpending,
+		s->vbuf_cnt | (s->flags.mailbox ? SHMIF_VBUFC_MAILBOX : 0));
 	atomic_store(&shmpage->w, s->desc.width);
 	atomic_store(&shmpage->h, s->desc.height);
 	shmpage->resized = -1;
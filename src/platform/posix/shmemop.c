@@ -1,4 +1,9 @@
 #include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
 #include "arcan_shmif.h"
 
 static inline void* alignv(uint8_t* inptr, size_t align_sz)
@@ -39,3 +44,74 @@ uintptr_t arcan_shmif_mapav(
 	return (uintptr_t) wbuf - (uintptr_t) addr;
 #endif
 }
+
+#ifdef MADV_POPULATE_WRITE
+struct prefault_job {
+	void* base;
+	size_t sz;
+};
+
+static void* prefault_thread(void* arg)
+{
+	struct prefault_job job = *(struct prefault_job*) arg;
+	free(arg);
+
+/* the mapping can be replaced while we run, populate doesn't touch the
+ * contents and simply fails on a range that is no longer mapped */
+	madvise(job.base, job.sz, MADV_POPULATE_WRITE);
+	return NULL;
+}
+#endif
+
+void arcan_shmif_prefault(
+	struct arcan_shmif_page* addr, size_t map_sz, size_t used_sz)
+{
+	static int enabled = -1;
+	if (-1 == enabled){
+		const char* env = getenv("ARCAN_SHMIF_HUGEPAGES");
+		enabled = env && env[0] && strcmp(env, "0") != 0;
+	}
+
+	if (!enabled || !addr || !map_sz)
+		return;
+
+/* the page structure with the event queues stays on normal pages, only the
+ * buffer region that follows it is of interest */
+	uintptr_t pg = sysconf(_SC_PAGESIZE);
+	uintptr_t base = (uintptr_t) addr + sizeof(struct arcan_shmif_page);
+	uintptr_t start = (base + pg - 1) & ~(pg - 1);
+	uintptr_t map_end = ((uintptr_t) addr + map_sz) & ~(pg - 1);
+	uintptr_t used_end =
+		((uintptr_t) addr + (used_sz < map_sz ? used_sz : map_sz)) & ~(pg - 1);
+
+	if (map_end <= start)
+		return;
+
+#ifdef MADV_HUGEPAGE
+	madvise((void*) start, map_end - start, MADV_HUGEPAGE);
+#endif
+
+#ifdef MADV_POPULATE_WRITE
+	if (used_end <= start)
+		return;
+
+	struct prefault_job* job = malloc(sizeof(struct prefault_job));
+	if (!job)
+		return;
+
+	*job = (struct prefault_job){
+		.base = (void*) start,
+		.sz = used_end - start
+	};
+
+	pthread_t pth;
+	pthread_attr_t pthattr;
+	pthread_attr_init(&pthattr);
+	pthread_attr_setdetachstate(&pthattr, PTHREAD_CREATE_DETACHED);
+
+	if (0 != pthread_create(&pth, &pthattr, prefault_thread, job))
+		free(job);
+
+	pthread_attr_destroy(&pthattr);
+#endif
+}
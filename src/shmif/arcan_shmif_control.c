@@ -115,6 +115,11 @@ struct shmif_hidden {
 	uint8_t vbuf_ind, vbuf_cnt;
 	shmif_pixel* vbuf[ARCAN_SHMIF_VBUFC_LIM];
 
+/* SHMIF_VBUF_MAILBOX tracking, the last buffer we published and the one that
+ * the server took most recently (and may still be reading from), -1 if none */
+	bool vbuf_mbox;
+	int8_t vbuf_last, vbuf_held;
+
 	shmif_trigger_hook audio_hook;
 	void* audio_hook_data;
 	uint8_t abuf_ind, abuf_cnt;
@@ -1205,12 +1210,15 @@ static void setup_avbuf(struct arcan_shmif_cont* res)
 	res->pitch = res->w;
 	res->priv->atype = atomic_load(&res->addr->apad_type);
 
-	res->priv->vbuf_cnt = atomic_load(&res->addr->vpending);
+	size_t vbufc = atomic_load(&res->addr->vpending);
+	res->priv->vbuf_mbox = !!(vbufc & SHMIF_VBUFC_MAILBOX);
+	res->priv->vbuf_cnt = vbufc & ~SHMIF_VBUFC_MAILBOX;
 	res->priv->abuf_cnt = atomic_load(&res->addr->apending);
 	res->segment_token = res->addr->segment_token;
 
 	res->priv->abuf_ind = 0;
 	res->priv->vbuf_ind = 0;
+	res->priv->vbuf_last = res->priv->vbuf_held = -1;
 	atomic_store(&res->addr->vpending, 0);
 	atomic_store(&res->addr->apending, 0);
 	res->abufused = res->abufpos = 0;
@@ -1221,10 +1229,11 @@ static void setup_avbuf(struct arcan_shmif_cont* res)
 	if (0 == res->samplerate)
 		res->samplerate = ARCAN_SHMIF_SAMPLERATE;
 
-	arcan_shmif_mapav(res->addr,
+	size_t used = arcan_shmif_mapav(res->addr,
 		res->priv->vbuf, res->priv->vbuf_cnt, res->w*res->h*sizeof(shmif_pixel),
 		res->priv->abuf, res->priv->abuf_cnt, res->abufsize
 	);
+	arcan_shmif_prefault(res->addr, res->shmsize, used);
 
 /*
  * NOTE, this means that every time we remap/rebuffer, the previous
@@ -1501,6 +1510,37 @@ unsigned arcan_shmif_signalhandle(struct arcan_shmif_cont* ctx,
 	return arcan_shmif_signal(ctx, mask);
 }
 
+/*
+ * Mailbox publish, swap in the finished buffer as the newest frame. If we get
+ * a frame back the server never took it so it is dropped and free for reuse,
+ * otherwise the server has taken our previous frame and holds on to that one
+ * until it takes the next. Then pick the next buffer that is neither.
+ */
+static void step_v_mbox(struct arcan_shmif_cont* ctx)
+{
+	struct shmif_hidden* priv = ctx->priv;
+
+	unsigned old = atomic_exchange_explicit(&ctx->addr->vready,
+		priv->vbuf_ind+1, memory_order_acq_rel);
+	atomic_fetch_add_explicit(&ctx->addr->vproduced, 1, memory_order_relaxed);
+
+	if (old)
+		atomic_fetch_add_explicit(&ctx->addr->vdropped, 1, memory_order_relaxed);
+	else
+		priv->vbuf_held = priv->vbuf_last;
+	priv->vbuf_last = priv->vbuf_ind;
+
+	for (size_t i = 1; i < priv->vbuf_cnt; i++){
+		int ind = (priv->vbuf_last + i) % priv->vbuf_cnt;
+		if (ind != priv->vbuf_held){
+			priv->vbuf_ind = ind;
+			break;
+		}
+	}
+
+	ctx->vidp = priv->vbuf[priv->vbuf_ind];
+}
+
 static bool step_v(struct arcan_shmif_cont* ctx)
 {
 	struct shmif_hidden* priv = ctx->priv;
@@ -1517,12 +1557,20 @@ static bool step_v(struct arcan_shmif_cont* ctx)
 		atomic_store(&ctx->addr->dirty, ctx->dirty);
 	}
 
+	if (priv->vbuf_mbox){
+		step_v_mbox(ctx);
+		return false;
+	}
+
 /* mark the current buffer as pending, this is used when we have
- * non-subregion + (double, triple, quadruple buffer) rendering */
+ * non-subregion + (double, triple, quadruple buffer) rendering, if
+ * there was a frame in vready that the server never took it is dropped */
 	int pending = atomic_fetch_or_explicit(
 		&ctx->addr->vpending, 1 << priv->vbuf_ind, memory_order_release);
-	atomic_store_explicit(&ctx->addr->vready,
-		priv->vbuf_ind+1, memory_order_release);
+	if (atomic_exchange_explicit(&ctx->addr->vready,
+		priv->vbuf_ind+1, memory_order_release))
+		atomic_fetch_add_explicit(&ctx->addr->vdropped, 1, memory_order_relaxed);
+	atomic_fetch_add_explicit(&ctx->addr->vproduced, 1, memory_order_relaxed);
 
 /* slide window so the caller don't have to care about which
  * buffer we are actually working against */
@@ -1619,7 +1667,8 @@ unsigned arcan_shmif_signal(
 			);
 		}
 
-		while ((ctx->hints & SHMIF_RHINT_SUBREGION) && ctx->addr->vready)
+		while (!priv->vbuf_mbox &&
+			(ctx->hints & SHMIF_RHINT_SUBREGION) && ctx->addr->vready)
 			arcan_sem_wait(ctx->vsem);
 
 		bool lock = step_v(ctx);
@@ -1635,6 +1684,23 @@ unsigned arcan_shmif_signal(
 	return arcan_timemillis() - startt;
 }
 
+bool arcan_shmif_vstats(
+	struct arcan_shmif_cont* ctx, struct shmif_vstats* out)
+{
+	if (!ctx || !ctx->addr || !ctx->priv)
+		return false;
+
+	if (out){
+		*out = (struct shmif_vstats){
+			.produced = atomic_load(&ctx->addr->vproduced),
+			.consumed = atomic_load(&ctx->addr->vconsumed),
+			.dropped = atomic_load(&ctx->addr->vdropped)
+		};
+	}
+
+	return ctx->priv->vbuf_mbox;
+}
+
 struct arg_arr* arcan_shmif_args( struct arcan_shmif_cont* inctx)
 {
 	if (!inctx || !inctx->priv)
@@ -1724,7 +1790,7 @@ void arcan_shmif_drop(struct arcan_shmif_cont* inctx)
 static bool shmif_resize(struct arcan_shmif_cont* arg,
 	unsigned width, unsigned height,
 	size_t abufsz, int vidc, int audc, int samplerate,
-	int adata)
+	int adata, int vmode)
 {
 	if (!arg->addr || !arcan_shmif_integrity_check(arg) ||
 	!arg->priv || width > PP_SHMPAGE_MAXW || height > PP_SHMPAGE_MAXH)
@@ -1737,7 +1803,11 @@ static bool shmif_resize(struct arcan_shmif_cont* arg,
 			return false;
 	}
 
-/* wait for any outstanding v/asynch */
+/* a mailbox frame that hasn't been taken can simply be withdrawn, otherwise
+ * wait for any outstanding v/asynch */
+	if (arg->priv->vbuf_mbox)
+		atomic_store(&arg->addr->vready, 0);
+
 	if (atomic_load(&arg->addr->vready)){
 		while (atomic_load(&arg->addr->vready) && arg->addr->dms)
 			arcan_sem_wait(arg->vsem);
@@ -1752,13 +1822,14 @@ static bool shmif_resize(struct arcan_shmif_cont* arg,
 
 /* 0 is allowed to disable any related data, useful for not wasting
  * storage when accelerated buffer passing is working */
+	bool mbox = vidc < 0 ? arg->priv->vbuf_mbox : vmode == SHMIF_VBUF_MAILBOX;
 	vidc = vidc < 0 ? arg->priv->vbuf_cnt : vidc;
 	audc = audc < 0 ? arg->priv->abuf_cnt : audc;
 
 /* don't negotiate unless the goals have changed */
 	if (arg->vidp && width == arg->w && height == arg->h &&
 		vidc == arg->priv->vbuf_cnt && audc == arg->priv->abuf_cnt &&
-		arg->addr->hints == arg->hints)
+		mbox == arg->priv->vbuf_mbox && arg->addr->hints == arg->hints)
 		return true;
 
 /* synchronize hints as _ORIGO_LL and similar changes only synch
@@ -1779,7 +1850,8 @@ static bool shmif_resize(struct arcan_shmif_cont* arg,
 	atomic_store(&arg->addr->h, height);
 	atomic_store(&arg->addr->abufsize, abufsz);
 	atomic_store_explicit(&arg->addr->apending, audc, memory_order_release);
-	atomic_store_explicit(&arg->addr->vpending, vidc, memory_order_release);
+	atomic_store_explicit(&arg->addr->vpending,
+		vidc | (mbox ? SHMIF_VBUFC_MAILBOX : 0), memory_order_release);
 	if (arg->priv->log_event){
 		fprintf(stderr, "(@%"PRIxPTR" rz-synch): %zu*%zu(fl:%d), %zu Hz\n",
 			(uintptr_t)arg, (size_t)width,(size_t)height,
@@ -1857,14 +1929,15 @@ bool arcan_shmif_resize_ext(struct arcan_shmif_cont* arg,
 	unsigned width, unsigned height, struct shmif_resize_ext ext)
 {
 	return shmif_resize(arg, width, height,
-		ext.abuf_sz, ext.vbuf_cnt, ext.abuf_cnt, ext.samplerate, ext.meta);
+		ext.abuf_sz, ext.vbuf_cnt, ext.abuf_cnt, ext.samplerate, ext.meta,
+		ext.vbuf_mode);
 }
 
 bool arcan_shmif_resize(struct arcan_shmif_cont* arg,
 	unsigned width, unsigned height)
 {
 	return arg->addr ?
-		shmif_resize(arg, width, height, arg->addr->abufsize, -1, -1, -1, 0) :
+		shmif_resize(arg, width, height, arg->addr->abufsize, -1, -1, -1, 0, 0) :
 		false;
 }
 
@@ -2239,6 +2312,9 @@ enum shmif_migrate_status arcan_shmif_migrate(
 
 /* got a valid connection, first synch source segment so we don't have
  * anything pending */
+	if (cont->priv->vbuf_mbox)
+		atomic_store(&cont->addr->vready, 0);
+
 	while(atomic_load(&cont->addr->vready) && cont->addr->dms)
 		arcan_sem_wait(cont->vsem);
 
@@ -2249,7 +2325,8 @@ enum shmif_migrate_status arcan_shmif_migrate(
 	size_t h = atomic_load(&cont->addr->h);
 
 	if (!shmif_resize(&ret, w, h, cont->abufsize, cont->priv->vbuf_cnt,
-		cont->priv->abuf_cnt, cont->samplerate, cont->priv->atype)){
+		cont->priv->abuf_cnt, cont->samplerate, cont->priv->atype,
+		cont->priv->vbuf_mbox ? SHMIF_VBUF_MAILBOX : SHMIF_VBUF_FIFO)){
 		return SHMIF_MIGRATE_TRANSFER_FAIL;
 	}
 
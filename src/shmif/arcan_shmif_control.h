@@ -109,7 +109,7 @@ static const int ARCAN_SHMIF_ACHANNELS = 2;
  * audiobuffer slot
  */
 #define ARCAN_SHMIF_ABUFC_LIM 12
-#define ARCAN_SHMIF_VBUFC_LIM 3
+#define ARCAN_SHMIF_VBUFC_LIM 4
 /*
  * These are technically limited by the combination of graphics and video
  * platforms. Since the buffers are placed at the end of the struct, they
@@ -426,6 +426,16 @@ uintptr_t arcan_shmif_mapav(
 	shmif_asample* abuf[], size_t abufc, size_t abuf_sz
 );
 
+/*
+ * Used internally on both sides after a segment has been (re)mapped or the
+ * buffers moved. Opt-in through the ARCAN_SHMIF_HUGEPAGES environment: the
+ * buffer region of [addr, addr+map_sz) is advised for transparent hugepages
+ * and the [used_sz] part that the buffers occupy is pre-faulted from a
+ * detached thread so the first frame after a resize doesn't take the faults.
+ */
+void arcan_shmif_prefault(
+	struct arcan_shmif_page* addr, size_t map_sz, size_t used_sz);
+
 /*
  * There can be one "post-flag, pre-semaphore" hook that will occur
  * before triggering a sigmask and can be used to synch audio to video
@@ -532,8 +542,35 @@ struct shmif_resize_ext {
 	ssize_t vbuf_cnt;
 	ssize_t samplerate;
 	uint32_t meta;
+	uint32_t vbuf_mode;
 };
 
+/*
+ * [vbuf_mode] in shmif_resize_ext, only considered when vbuf_cnt is >= 0.
+ *
+ * FIFO is the default where signalling walks the video buffers in order and
+ * blocks when the next one is still pending.
+ *
+ * MAILBOX requires at least three video buffers and turns them into a ring
+ * where _signal never blocks. The client always renders into a buffer that is
+ * neither the newest published frame nor the one the server last took, the
+ * server always takes the newest published frame and a frame that gets
+ * replaced before being taken is counted as dropped and recycled. Since frames
+ * can be dropped, SHMIF_RHINT_SUBREGION is ignored in this mode and every
+ * frame is treated as complete. If the server can't fit enough buffers, the
+ * mode falls back to FIFO, check with arcan_shmif_vstats.
+ */
+enum shmif_vbuf_mode {
+	SHMIF_VBUF_FIFO = 0,
+	SHMIF_VBUF_MAILBOX = 1
+};
+
+/*
+ * The requested count and mode share the [vpending] field during resize
+ * negotiation, this bit carries the mode.
+ */
+#define SHMIF_VBUFC_MAILBOX 0x100
+
 bool arcan_shmif_resize_ext(struct arcan_shmif_cont*,
 	unsigned width, unsigned height, struct shmif_resize_ext);
 
@@ -551,6 +588,20 @@ void arcan_shmif_drop(struct arcan_shmif_cont*);
  */
 unsigned arcan_shmif_signal(struct arcan_shmif_cont*, enum arcan_shmif_sigmask);
 
+/*
+ * Retrieve the video frame counters for the segment: [produced] frames
+ * signalled by the client, [consumed] frames taken by the server and
+ * [dropped] frames that were replaced by a newer one before being taken.
+ * The counters are 32-bit and wrap. Returns true if the segment is in
+ * SHMIF_VBUF_MAILBOX mode, the stats argument may be NULL.
+ */
+struct shmif_vstats {
+	uint32_t produced;
+	uint32_t consumed;
+	uint32_t dropped;
+};
+bool arcan_shmif_vstats(struct arcan_shmif_cont*, struct shmif_vstats*);
+
 /*
  * Signal a video transfer that is based on buffer sharing rather than on data
  * in the shmpage. Otherwise it behaves like [arcan_shmif_signal] but with a
@@ -883,12 +934,20 @@ struct arcan_shmif_page {
  * synchronzied.
  * [aready-1] indicates the starting index for buffers that have not
  * been synchronized, ring-buffer wrapping the bits that are set.
+ * In SHMIF_VBUF_MAILBOX mode, [vready-1] is the newest published frame and
+ * both sides swap it atomically, the one that gets the non-zero value back
+ * owns that buffer. [vpending] is only used for negotiation in that mode.
  */
 	volatile atomic_uint aready;
 	volatile atomic_uint apending;
 	volatile atomic_uint vready;
 	volatile atomic_uint vpending;
 
+/* [FSRV-SET (vproduced, vdropped), ARCAN-SET (vconsumed)]
+ * Running video frame counters, see arcan_shmif_vstats.
+ */
+	volatile _Atomic uint_least32_t vproduced, vconsumed, vdropped;
+
 /* abufused contains the number of bytes consumed in every slot */
 	volatile _Atomic uint_least16_t abufused[ARCAN_SHMIF_ABUFC_LIM];
 
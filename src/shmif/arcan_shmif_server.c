@@ -46,6 +46,9 @@ struct shmifsrv_client {
 	enum connstatus status;
 	size_t errors;
 	uint64_t cookie;
+
+/* mailbox mode, index of the buffer last taken from the client */
+	int vheld;
 };
 
 static struct shmifsrv_client* alloc_client()
@@ -324,8 +327,12 @@ void shmifsrv_set_protomask(struct shmifsrv_client* cl, unsigned mask)
 
 void shmifsrv_video_step(struct shmifsrv_client* cl)
 {
-/* signal that we're done with the buffer */
-	atomic_store_explicit(&cl->con->shm.ptr->vready, 0, memory_order_release);
+/* signal that we're done with the buffer, in mailbox mode it has already
+ * been taken and the client never waits for the release */
+	if (!cl->con->flags.mailbox)
+		atomic_store_explicit(&cl->con->shm.ptr->vready, 0, memory_order_release);
+	atomic_fetch_add_explicit(
+		&cl->con->shm.ptr->vconsumed, 1, memory_order_relaxed);
 	arcan_sem_post(cl->con->vsync);
 
 /* If the frameserver has indicated that it wants a frame callback every time
@@ -372,6 +379,18 @@ struct shmifsrv_vbuffer shmifsrv_video(struct shmifsrv_client* cl)
  * of 'n' buffering */
 	int vready = atomic_load_explicit(
 		&cl->con->shm.ptr->vready, memory_order_consume);
+
+/* mailbox mode, take the newest frame or stay on the one we already hold
+ * if the client withdrew it, and frames may have been dropped in between
+ * so the dirty region doesn't apply */
+	if (cl->con->flags.mailbox){
+		vready = atomic_exchange_explicit(
+			&cl->con->shm.ptr->vready, 0, memory_order_acq_rel);
+		if (vready <= 0 || vready > cl->con->vbuf_cnt)
+			vready = cl->vheld < cl->con->vbuf_cnt ? cl->vheld + 1 : 1;
+		cl->vheld = vready - 1;
+		res.flags.subregion = false;
+	}
 	vready = (vready <= 0 || vready > cl->con->vbuf_cnt) ? 0 : vready - 1;
 
 	int vmask = ~atomic_load_explicit(
@@ -838,6 +838,14 @@ void arcan_tui_erase_chars(struct tui_context*, size_t n);
 void arcan_tui_write(struct tui_context*,
 	uint32_t ucode, struct tui_screen_attr*);
 
+/*
+ * Write [n] UCS4 codepoints from [ucs4] at the current cursor position, the
+ * result is the same as calling arcan_tui_write for each codepoint but long
+ * runs of text are written a line at a time.
+ */
+void arcan_tui_writeucs4(struct tui_context*,
+	const uint32_t* ucs4, size_t n, struct tui_screen_attr*);
+
 /*
  * This converts [n] bytes from [u8] as UTF-8 into multiple UCS4 writes.
  * It is a more expensive form of arcan_tui_write. If the UTF-8 failed to
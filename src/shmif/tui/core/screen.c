@@ -28,6 +28,8 @@ static int tsm_draw_callback(struct tsm_screen* screen, uint32_t id,
 		tui->front[pos].draw_ch = tui->front[pos].ch = *ch;
 		tui->front[pos].attr = *attr;
 		tui->front[pos].fstamp = tui->fstamp;
+		tui->dmg[y * tui->dmg_stride + (x >> 6)] |= (uint64_t)1 << (x & 63);
+		tui->dmg_rows[y >> 6] |= (uint64_t)1 << (y & 63);
 		tui->dirty |= DIRTY_PARTIAL;
 	}
 
@@ -44,8 +46,14 @@ static void resize_cellbuffer(struct tui_context* tui)
 
 	tui->base = NULL;
 	tui->rbuf = NULL;
-
-	size_t buffer_sz = 2 * tui->rows * tui->cols * sizeof(struct tui_cell);
+	tui->dmg = tui->dmg_rows = NULL;
+
+/* the damage bitmaps are appended to the cell buffers, aligned to 8b */
+	size_t cells_sz = 2 * tui->rows * tui->cols * sizeof(struct tui_cell);
+	cells_sz = (cells_sz + 7) & ~(size_t)7;
+	size_t stride = (tui->cols + 63) >> 6;
+	size_t row_words = (tui->rows + 63) >> 6;
+	size_t buffer_sz = cells_sz + (tui->rows * stride + row_words) * sizeof(uint64_t);
 	size_t rbuf_sz =
 		sizeof(struct tui_raster_header) + /* always there */
 		((tui->rows * tui->cols + 2) * raster_cell_sz) + /* worst case, includes cursor */
@@ -76,26 +84,12 @@ static void resize_cellbuffer(struct tui_context* tui)
 
 	tui->front = tui->base;
 	tui->back = &tui->base[tui->rows * tui->cols];
+	tui->dmg = (uint64_t*)((uint8_t*)tui->base + cells_sz);
+	tui->dmg_rows = &tui->dmg[tui->rows * stride];
+	tui->dmg_stride = stride;
 	tui->dirty |= DIRTY_FULL;
 }
 
-/* sweep a row from a start offset until the first deviation
- * between front and back offset */
-static ssize_t find_row_ofs(
-	struct tui_context* tui, size_t row, size_t ofs)
-{
-	size_t pos = row * tui->cols;
-	struct tui_cell* front = &tui->front[pos];
-	struct tui_cell* back = &tui->back[pos];
-
-	for (pos = ofs; pos < tui->cols; pos++){
-		if (!tui_attr_equal(front[pos].attr,
-			back[pos].attr) || front[pos].ch != back[pos].ch)
-			return pos;
-	}
-	return -1;
-}
-
 static void pack_u32(uint32_t src, uint8_t* outb)
 {
 	outb[0] = (uint8_t)(src >> 0);
@@ -154,6 +148,71 @@ struct tui_cell* tcell, uint8_t* outb, uint8_t has_cursor)
 	return raster_cell_sz;
 }
 
+/* Emit the damaged cells of a row that actually differ between front and
+ * back. Runs of adjacent cells share a line header, while a gap starts a new
+ * one as a header is smaller than the skip cells it would take to bridge it.
+ * The damage bits for the row are consumed in the process. */
+static size_t pack_row_damage(struct tui_context* tui, size_t row,
+	uint8_t* out, size_t outsz, struct tui_raster_header* hdr)
+{
+	uint64_t* dmg = &tui->dmg[row * tui->dmg_stride];
+	size_t row_base = row * tui->cols;
+	struct tui_raster_line line = {
+		.start_line = row
+	};
+	size_t line_dst = 0;
+	bool open = false;
+
+	for (size_t i = 0; i < tui->dmg_stride; i++){
+		uint64_t mask = dmg[i];
+		dmg[i] = 0;
+
+		while (mask){
+			size_t col = (i << 6) + __builtin_ctzll(mask);
+			mask &= mask - 1;
+
+			struct tui_cell* front = &tui->front[row_base + col];
+			struct tui_cell* back = &tui->back[row_base + col];
+			if (col >= tui->cols || (front->ch == back->ch &&
+				tui_attr_equal(front->attr, back->attr)))
+				continue;
+
+			*back = *front;
+
+			if (open && line.offset + line.ncells != col){
+				memcpy(&out[line_dst], &line, sizeof(struct tui_raster_line));
+				hdr->lines++;
+				hdr->cells += line.ncells;
+				open = false;
+			}
+
+			if (!open){
+				line.offset = col;
+				line.ncells = 0;
+				line_dst = outsz;
+				outsz += sizeof(struct tui_raster_line);
+				open = true;
+			}
+
+/* if we overdraw the save-cursor position, don't emit the glyph again */
+			if (tui->last_cursor.active &&
+				tui->last_cursor.row == row && tui->last_cursor.col == col)
+				tui->last_cursor.active = false;
+
+			line.ncells++;
+			outsz += cell_to_rcell(front, &out[outsz], 0);
+		}
+	}
+
+	if (open){
+		memcpy(&out[line_dst], &line, sizeof(struct tui_raster_line));
+		hdr->lines++;
+		hdr->cells += line.ncells;
+	}
+
+	return outsz;
+}
+
 static int build_raster_buffer(
 	struct tui_context* tui, uint8_t** rbuf, size_t* rbuf_sz)
 {
@@ -201,60 +260,26 @@ static int build_raster_buffer(
 				front++;
 			}
 		}
+
+/* everything is in synch now so any pending damage is moot */
+		memset(tui->dmg, '\0', (tui->rows * tui->dmg_stride +
+			((tui->rows + 63) >> 6)) * sizeof(uint64_t));
 		rv = 2;
 	}
 
-/* delta update, find_row_ofs gives the next mismatch on the row */
+/* delta update, only rows flagged in the damage map are visited and within
+ * those only the cells that tsm reported as changed */
 	else if (tui->dirty & DIRTY_PARTIAL){
-		for (size_t row = 0; row < tui->rows; row++){
-			ssize_t ofs = find_row_ofs(tui, row, 0);
-			if (-1 == ofs)
-				continue;
-
-			size_t row_base = row * tui->cols;
-
-/* if we overdraw the save-cursor position, don't emit the glyph again */
-			if (tui->last_cursor.active &&
-				tui->last_cursor.row == row && tui->last_cursor.col == ofs)
-				tui->last_cursor.active = false;
-
-/* we forward all lines where there is some kind of difference,
- * assuming most follow the pattern -----XXXXXX----- XXXXXXXXXX,
- * with the worst- case being X-------------X that gets 'full-line
- * with skip-cells'). */
-			struct tui_raster_line line = {
-				.start_line = row,
-				.offset = ofs
-			};
-
-/* alias line header position */
-			size_t line_dst = outsz;
-			outsz += sizeof(line);
-
-			while(ofs != -1 && ofs < tui->cols){
-				struct tui_cell* attr = &tui->front[row_base + ofs];
-				tui->back[row_base + ofs] = *attr;
-				line.ncells++;
-				outsz += cell_to_rcell(attr, &out[outsz], 0);
-/* iterate forward */
-				ssize_t last_ofs = ofs;
-				ofs = find_row_ofs(tui, row, ofs+1);
-				if (-1 == ofs)
-					break;
-
-/* encode 'skip-draw' cell for the ones that don't matter,
- * just set the most significant attribute bit (ignore) */
-				for (; last_ofs + 1 != ofs; last_ofs++){
-					memset(&out[outsz], '\0', raster_cell_sz);
-					out[outsz + 6] = 128;
-					out[outsz + 7] = 0;
-					outsz += raster_cell_sz;
-					line.ncells++;
-				}
+		size_t row_words = (tui->rows + 63) >> 6;
+		for (size_t i = 0; i < row_words; i++){
+			uint64_t mask = tui->dmg_rows[i];
+			tui->dmg_rows[i] = 0;
+
+			while (mask){
+				size_t row = (i << 6) + __builtin_ctzll(mask);
+				mask &= mask - 1;
+				outsz = pack_row_damage(tui, row, out, outsz, &hdr);
 			}
-
-			memcpy(&out[line_dst], &line, sizeof(struct tui_raster_line));
-			hdr.lines++;
 		}
 		rv = 1;
 	}
@@ -311,6 +336,10 @@ static int build_raster_buffer(
 		tui->last_cursor.active = true;
 	}
 
+/* damage that turned out to match the back buffer leaves nothing to draw */
+	if (!hdr.lines)
+		rv = 0;
+
 /* write the header and return */
 	memcpy(tui->rbuf, &hdr, sizeof(hdr));
 	*rbuf_sz = outsz;
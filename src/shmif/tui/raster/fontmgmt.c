@@ -42,6 +42,19 @@ static void probe_font(
 	TTF_Flush_Cache(font);
 }
 
+/*
+ * Swap the atlas the raster draws from, the raster keeps using our font
+ * slots for anything the atlas can't do (fallback fonts)
+ */
+static void set_atlas(struct tui_context* tui, struct tui_raster_atlas* atlas)
+{
+	if (!tui->raster)
+		return;
+
+	tui_raster_setatlas(tui->raster, atlas);
+	tui_raster_setfont(tui->raster, tui->font, 2);
+}
+
 bool tryload_truetype(struct tui_context* tui,
 	int fd, int mode, size_t pt_size, float dpi)
 {
@@ -66,10 +79,21 @@ bool tryload_truetype(struct tui_context* tui,
 	TTF_SetFontStyle(font, TTF_STYLE_NORMAL);
 	TTF_SetFontHinting(font, tui->hint);
 
-/* the first slot determines cell size */
+/* the first slot determines cell size, with a persistent glyph cache
+ * it comes from the cache along with the glyphs */
 	if (mode == 0){
 		size_t dw = 0, dh = 0;
-		probe_font(tui, tui->font[0]->truetype, &dw, &dh);
+		struct tui_raster_atlas* atlas = NULL;
+
+		if (getenv(TUI_GLYPHCACHE_ENV) && tui->raster)
+			atlas = tui_raster_atlas_grab(fd, pt_size, dpi, tui->hint);
+
+		if (atlas)
+			tui_raster_atlas_cell_size(atlas, &dw, &dh);
+		else
+			probe_font(tui, tui->font[0]->truetype, &dw, &dh);
+
+		set_atlas(tui, atlas);
 		tui->cell_w = dw;
 		tui->cell_h = dh;
 	}
@@ -163,6 +187,7 @@ static bool setup_font(
 	if (fd != BADFD){
 		if (tryload_bitmap(tui, fd, modeind, px_sz)){
 			size_t w, h;
+			set_atlas(tui, NULL);
 			tui_pixelfont_setsz(tui->font[0]->bitmap, px_sz, &w, &h);
 			tui->cell_w = w;
 			tui->cell_h = h;
@@ -267,6 +292,9 @@ void tui_fontmgmt_setup(
 	tui->font[1] = &fonts[1];
 	tui->hint = TTF_HINTING_LIGHT;
 
+/* the raster is needed first so that the font setup can attach an atlas */
+	tui->raster = tui_raster_setup(0, 0);
+
 	if (init){
 		setup_font(tui, init->fonts[0].fd, init->fonts[0].size_mm, 0);
 		init->fonts[0].fd = -1;
@@ -280,6 +308,9 @@ void tui_fontmgmt_setup(
 		setup_font(tui, -1, 3.527780, 0);
 	}
 
-	tui->raster = tui_raster_setup(tui->cell_w, tui->cell_h);
+	if (!tui->raster)
+		return;
+
+	tui_raster_cell_size(tui->raster, tui->cell_w, tui->cell_h);
 	tui_raster_setfont(tui->raster, tui->font, 2);
 }
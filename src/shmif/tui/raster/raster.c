@@ -1,4 +1,13 @@
 #include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdatomic.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
 #include "../../arcan_shmif.h"
 #include "../../arcan_tui.h"
 #define SHMIF_TTF
@@ -22,8 +31,110 @@ struct cell {
 	uint8_t attr;
 };
 
+/*
+ * Glyph atlas, shared between all raster contexts that use the same font file
+ * at the same size, density and hinting. Each slot holds one cell worth of
+ * glyph coverage (rendered white on black) so that it can be colorized into
+ * any fg/bg combination without going through freetype again.
+ */
+#ifndef TUI_ATLAS_SLOT_BASE
+#define TUI_ATLAS_SLOT_BASE 256
+#endif
+
+#ifndef TUI_ATLAS_SLOT_LIMIT
+#define TUI_ATLAS_SLOT_LIMIT 4096
+#endif
+
+/*
+ * Optional on-disk backing for the atlas, enabled by pointing the
+ * TUI_GLYPHCACHE_ENV variable at a directory. The cache file is mapped
+ * read-only and shared by every process that rasters with the same font
+ * contents, size, density and hinting - so glyphs only go through freetype
+ * once, across restarts as well.
+ *
+ * Writers serialize on flock() and append with pwrite, the key is published
+ * last so that the lock-free readers never see a partially written slot. The
+ * file is never resized or rewritten, when it is full the atlas falls back to
+ * its private slots.
+ */
+#ifndef TUI_GLYPHCACHE_SLOTS
+#define TUI_GLYPHCACHE_SLOTS 4096
+#endif
+
+#define TUI_GLYPHCACHE_VERSION 1
+#define TUI_GLYPHCACHE_HDR_SZ 64
+
+struct glyphcache_hdr {
+	char magic[8];
+	uint32_t version;
+	uint32_t hdr_sz;
+	uint64_t font_hash;
+	uint32_t pt_size;
+	uint32_t dpi;
+	int32_t hint;
+	uint32_t cell_w;
+	uint32_t cell_h;
+	uint32_t n_keys;
+	uint32_t n_slots;
+
+/* only accessed with the lock held */
+	uint32_t used;
+};
+
+struct glyphcache {
+	int fd;
+	bool writable;
+
+	uint8_t* map;
+	size_t map_sz;
+
+/* aliases into map: [hdr][keys][slots][coverage] */
+	struct glyphcache_hdr* hdr;
+	_Atomic uint32_t* keys;
+	uint32_t* slots;
+	shmif_pixel* coverage;
+	size_t cell_px;
+};
+
+struct tui_raster_atlas {
+	size_t refcount;
+
+/* lookup key for sharing */
+	dev_t dev;
+	ino_t ino;
+	size_t pt_size;
+	float dpi;
+	int hint;
+	pthread_t owner;
+
+	int fd;
+	struct tui_font font[2];
+	int last_style;
+
+	size_t cell_w, cell_h;
+
+/* open-addressed, [key + 1] -> slot, 0 marks free */
+	uint32_t* keys;
+	uint16_t* slots;
+	size_t n_keys;
+
+	shmif_pixel* coverage;
+	size_t n_slots;
+	size_t used;
+
+	struct glyphcache cache;
+
+	struct tui_raster_atlas* next;
+};
+
+/* grab/drop can come from different threads (one tui context each), the
+ * lock covers the list and the refcounts, not the atlas contents */
+static struct tui_raster_atlas* atlas_list;
+static pthread_mutex_t atlas_lock = PTHREAD_MUTEX_INITIALIZER;
+
 struct tui_raster_context {
 	struct tui_font* fonts[4];
+	struct tui_raster_atlas* atlas;
 	int last_style;
 	int cursor_state;
 
@@ -101,6 +212,585 @@ static void linehint(struct tui_raster_context* ctx, struct cell* cell,
 	}
 }
 
+/*
+ * Identify a font by its contents rather than the path, so that the same
+ * file installed in different places share cache. Large fonts are sampled
+ * in evenly spaced blocks rather than read in full, the header tables and
+ * size are distinctive enough.
+ */
+static uint64_t glyphcache_fonthash(int fd, size_t sz)
+{
+	uint8_t buf[4096];
+	uint64_t h = 0xcbf29ce484222325ull;
+	size_t step = sz > 64 * sizeof(buf) ? (sz - sizeof(buf)) / 63 : sizeof(buf);
+
+	for (size_t ofs = 0; ofs < sz; ofs += step){
+		ssize_t nr = pread(fd, buf, sizeof(buf), ofs);
+		if (nr <= 0)
+			break;
+
+		for (ssize_t i = 0; i < nr; i++)
+			h = (h ^ buf[i]) * 0x100000001b3ull;
+	}
+
+	return (h ^ sz) * 0x100000001b3ull;
+}
+
+static size_t glyphcache_size(struct glyphcache_hdr* hdr)
+{
+	return TUI_GLYPHCACHE_HDR_SZ +
+		(size_t)hdr->n_keys * 2 * sizeof(uint32_t) +
+		(size_t)hdr->n_slots * hdr->cell_w * hdr->cell_h * sizeof(shmif_pixel);
+}
+
+static bool glyphcache_path(
+	char* buf, size_t buf_sz, const char* dir, struct glyphcache_hdr* want)
+{
+	uint64_t h = want->font_hash;
+	h = (h ^ want->pt_size) * 0x100000001b3ull;
+	h = (h ^ want->dpi) * 0x100000001b3ull;
+	h = (h ^ (uint32_t) want->hint) * 0x100000001b3ull;
+	h = (h ^ TUI_GLYPHCACHE_VERSION) * 0x100000001b3ull;
+
+	int nw = snprintf(buf, buf_sz, "%s/tui_%016"PRIx64".glyphs", dir, h);
+	return nw > 0 && nw < buf_sz;
+}
+
+static bool pwrite_full(int fd, const void* buf, size_t sz, off_t ofs)
+{
+	const uint8_t* src = buf;
+	while (sz){
+		ssize_t nw = pwrite(fd, src, sz, ofs);
+		if (nw == -1 && errno == EINTR)
+			continue;
+		if (nw <= 0)
+			return false;
+		src += nw;
+		ofs += nw;
+		sz -= nw;
+	}
+	return true;
+}
+
+static void glyphcache_close(struct glyphcache* gc)
+{
+	if (!gc->map)
+		return;
+
+	munmap(gc->map, gc->map_sz);
+	close(gc->fd);
+	*gc = (struct glyphcache){0};
+}
+
+/*
+ * Validate the header of [fd] against [want] and map it, the cell size is
+ * taken from the cache unless [want] already has one (then it must match).
+ */
+static bool glyphcache_map(struct glyphcache* gc, int fd, struct glyphcache_hdr* want)
+{
+	struct glyphcache_hdr hdr;
+	struct stat fs;
+
+	if (sizeof(hdr) != pread(fd, &hdr, sizeof(hdr), 0) || -1 == fstat(fd, &fs))
+		return false;
+
+	if (memcmp(hdr.magic, "arctuigc", 8) != 0 ||
+		hdr.version != TUI_GLYPHCACHE_VERSION ||
+		hdr.hdr_sz != TUI_GLYPHCACHE_HDR_SZ ||
+		hdr.font_hash != want->font_hash ||
+		hdr.pt_size != want->pt_size ||
+		hdr.dpi != want->dpi ||
+		hdr.hint != want->hint ||
+		!hdr.cell_w || !hdr.cell_h || hdr.cell_w > 1024 || hdr.cell_h > 1024 ||
+		(want->cell_w && (hdr.cell_w != want->cell_w || hdr.cell_h != want->cell_h)) ||
+		!hdr.n_slots || hdr.n_keys < hdr.n_slots * 2 ||
+		(hdr.n_keys & (hdr.n_keys - 1)) ||
+		fs.st_size != glyphcache_size(&hdr))
+		return false;
+
+	uint8_t* map = mmap(NULL, fs.st_size, PROT_READ, MAP_SHARED, fd, 0);
+	if (map == MAP_FAILED)
+		return false;
+
+	*gc = (struct glyphcache){
+		.fd = fd,
+		.writable = (fcntl(fd, F_GETFL) & O_ACCMODE) == O_RDWR,
+		.map = map,
+		.map_sz = fs.st_size,
+		.hdr = (struct glyphcache_hdr*) map,
+		.keys = (_Atomic uint32_t*) &map[TUI_GLYPHCACHE_HDR_SZ],
+		.cell_px = hdr.cell_w * hdr.cell_h
+	};
+	gc->slots = (uint32_t*) &gc->keys[hdr.n_keys];
+	gc->coverage = (shmif_pixel*) &gc->slots[hdr.n_keys];
+
+	want->cell_w = hdr.cell_w;
+	want->cell_h = hdr.cell_h;
+	return true;
+}
+
+static bool glyphcache_open(
+	struct glyphcache* gc, const char* dir, struct glyphcache_hdr* want)
+{
+	char path[PATH_MAX];
+	if (!glyphcache_path(path, sizeof(path), dir, want))
+		return false;
+
+/* a shared read-only cache is still useful, it just won't grow */
+	int fd = open(path, O_RDWR | O_CLOEXEC);
+	if (-1 == fd)
+		fd = open(path, O_RDONLY | O_CLOEXEC);
+	if (-1 == fd)
+		return false;
+
+	if (!glyphcache_map(gc, fd, want)){
+		close(fd);
+		return false;
+	}
+
+	return true;
+}
+
+/*
+ * Build the cache in a temporary file and link it into place, if someone
+ * else got there first we go with theirs.
+ */
+static bool glyphcache_create(
+	struct glyphcache* gc, const char* dir, struct glyphcache_hdr* want)
+{
+	char path[PATH_MAX], tmp[PATH_MAX];
+	if (!glyphcache_path(path, sizeof(path), dir, want) ||
+		snprintf(tmp, sizeof(tmp), "%s/.tui_glyphs_XXXXXX", dir) >= sizeof(tmp))
+		return false;
+
+	int fd = mkstemp(tmp);
+	if (-1 == fd)
+		return false;
+
+	struct glyphcache_hdr hdr = *want;
+	memcpy(hdr.magic, "arctuigc", 8);
+	hdr.version = TUI_GLYPHCACHE_VERSION;
+	hdr.hdr_sz = TUI_GLYPHCACHE_HDR_SZ;
+	hdr.n_slots = TUI_GLYPHCACHE_SLOTS;
+	hdr.n_keys = TUI_GLYPHCACHE_SLOTS * 2;
+	hdr.used = 0;
+
+/* the file is sparse, only the slots that get written take up space */
+	bool ok = -1 != ftruncate(fd, glyphcache_size(&hdr)) &&
+		pwrite_full(fd, &hdr, sizeof(hdr), 0) &&
+		-1 != fchmod(fd, 0644);
+
+	if (ok && -1 == link(tmp, path) && errno != EEXIST)
+		ok = false;
+
+	unlink(tmp);
+	close(fd);
+
+	return ok && glyphcache_open(gc, dir, want);
+}
+
+/*
+ * Lock-free probe for [key], if [free_pos] is provided it is set to the
+ * first empty position on a miss.
+ */
+static shmif_pixel* glyphcache_lookup(
+	struct glyphcache* gc, uint32_t key, size_t* free_pos)
+{
+	size_t mask = gc->hdr->n_keys - 1;
+	size_t pos = (key * 2654435761u) & mask;
+	uint32_t cur;
+
+	while ((cur = atomic_load_explicit(&gc->keys[pos], memory_order_acquire))){
+		if (cur == key){
+			uint32_t slot = gc->slots[pos];
+			return slot < gc->hdr->n_slots ? &gc->coverage[slot * gc->cell_px] : NULL;
+		}
+		pos = (pos + 1) & mask;
+	}
+
+	if (free_pos)
+		*free_pos = pos;
+
+	return NULL;
+}
+
+/*
+ * Append [cov] as [key], returns the mapped copy or NULL if the cache is
+ * full or can't be written to.
+ */
+static shmif_pixel* glyphcache_publish(
+	struct glyphcache* gc, uint32_t key, shmif_pixel* cov)
+{
+	if (!gc->writable || -1 == flock(gc->fd, LOCK_EX))
+		return NULL;
+
+/* another writer might have added it since our lookup */
+	size_t pos;
+	shmif_pixel* res = glyphcache_lookup(gc, key, &pos);
+	uint32_t used = gc->hdr->used;
+
+	if (res || used >= gc->hdr->n_slots)
+		goto out;
+
+	size_t cov_sz = gc->cell_px * sizeof(shmif_pixel);
+	shmif_pixel* dst = &gc->coverage[used * gc->cell_px];
+	uint32_t next = used + 1;
+
+	if (pwrite_full(gc->fd, cov, cov_sz, (uint8_t*) dst - gc->map) &&
+		pwrite_full(gc->fd, &used, sizeof(uint32_t),
+			(uint8_t*) &gc->slots[pos] - gc->map) &&
+		pwrite_full(gc->fd, &next, sizeof(uint32_t),
+			offsetof(struct glyphcache_hdr, used)) &&
+		pwrite_full(gc->fd, &key, sizeof(uint32_t),
+			(uint8_t*) &gc->keys[pos] - gc->map))
+		res = dst;
+
+out:
+	flock(gc->fd, LOCK_UN);
+	return res;
+}
+
+/*
+ * The atlas font is only opened once something actually needs rastering,
+ * with a warm cache that might be never.
+ */
+static bool atlas_font(struct tui_raster_atlas* atlas)
+{
+	if (atlas->font[0].truetype)
+		return true;
+
+	atlas->font[0].truetype =
+		TTF_OpenFontFD(atlas->fd, atlas->pt_size, atlas->dpi, atlas->dpi);
+	if (!atlas->font[0].truetype)
+		return false;
+
+	TTF_SetFontStyle(atlas->font[0].truetype, atlas->last_style);
+	TTF_SetFontHinting(atlas->font[0].truetype, atlas->hint);
+	return true;
+}
+
+static void atlas_flush(struct tui_raster_atlas* atlas)
+{
+	memset(atlas->keys, '\0', atlas->n_keys * sizeof(uint32_t));
+	atlas->used = 0;
+}
+
+/*
+ * Resolve [ucs4, style] to a slot of coverage in the atlas, rasterizing on
+ * a miss. Returns NULL if the glyph couldn't be produced.
+ */
+static shmif_pixel* atlas_lookup(
+	struct tui_raster_atlas* atlas, uint32_t ucs4, int style)
+{
+	size_t cell_px = atlas->cell_w * atlas->cell_h;
+	uint32_t key = ((ucs4 << 2) | (style & 3)) + 1;
+	size_t mask = atlas->n_keys - 1;
+	size_t pos = (key * 2654435761u) & mask;
+
+	if (atlas->cache.map){
+		shmif_pixel* cov = glyphcache_lookup(&atlas->cache, key, NULL);
+		if (cov)
+			return cov;
+	}
+
+	while (atlas->keys[pos]){
+		if (atlas->keys[pos] == key)
+			return &atlas->coverage[atlas->slots[pos] * cell_px];
+		pos = (pos + 1) & mask;
+	}
+
+/* out of slots, grow until we hit the limit and then just start over -
+ * cheaper than tracking LRU for the few cases where a client actually
+ * cycles through this many glyphs */
+	if (atlas->used == atlas->n_slots){
+		shmif_pixel* cov = NULL;
+		if (atlas->n_slots < TUI_ATLAS_SLOT_LIMIT)
+			cov = realloc(atlas->coverage,
+				atlas->n_slots * 2 * cell_px * sizeof(shmif_pixel));
+
+		if (cov){
+			atlas->coverage = cov;
+			atlas->n_slots *= 2;
+		}
+		else {
+			atlas_flush(atlas);
+			pos = (key * 2654435761u) & mask;
+		}
+	}
+
+	if (!atlas_font(atlas))
+		return NULL;
+
+	TTF_Font* fonts[2] = {atlas->font[0].truetype, atlas->font[1].truetype};
+	size_t nfonts = fonts[1] ? 2 : 1;
+
+	if (style != atlas->last_style){
+		atlas->last_style = style;
+		TTF_SetFontStyle(fonts[0], style);
+		if (fonts[1])
+			TTF_SetFontStyle(fonts[1], style);
+	}
+
+	shmif_pixel* dst = &atlas->coverage[atlas->used * cell_px];
+	memset(dst, '\0', cell_px * sizeof(shmif_pixel));
+
+	uint8_t fg[4] = {0xff, 0xff, 0xff, 0xff};
+	uint8_t bg[4] = {0x00, 0x00, 0x00, 0xff};
+	int adv = 0;
+	unsigned xs = 0;
+	unsigned ind = 0;
+
+	if (!TTF_RenderUNICODEglyph(dst, atlas->cell_w, atlas->cell_h,
+		atlas->cell_w, fonts, nfonts, ucs4, &xs, fg, bg, true, false,
+		style, &adv, &ind))
+		return NULL;
+
+/* if it made it into the cache the private slot can be reused */
+	if (atlas->cache.map){
+		shmif_pixel* cov = glyphcache_publish(&atlas->cache, key, dst);
+		if (cov)
+			return cov;
+	}
+
+	atlas->keys[pos] = key;
+	atlas->slots[pos] = atlas->used;
+	atlas->used++;
+
+	return dst;
+}
+
+/*
+ * Colorize a coverage slot into [vidp] at [x, y], each channel is treated
+ * separately so subpixel hinted glyphs come out right.
+ */
+static void atlas_blit(struct tui_raster_atlas* atlas, shmif_pixel* cov,
+	shmif_pixel* vidp, size_t pitch, int x, int y, size_t maxx, size_t maxy,
+	shmif_pixel fc, shmif_pixel bc)
+{
+	uint8_t fg[4], bg[4];
+	SHMIF_RGBA_DECOMP(fc, &fg[0], &fg[1], &fg[2], &fg[3]);
+	SHMIF_RGBA_DECOMP(bc, &bg[0], &bg[1], &bg[2], &bg[3]);
+
+	size_t w = atlas->cell_w;
+	size_t h = atlas->cell_h;
+	if (x + w > maxx)
+		w = x < maxx ? maxx - x : 0;
+	if (y + h > maxy)
+		h = y < maxy ? maxy - y : 0;
+
+	for (size_t cy = 0; cy < h; cy++){
+		shmif_pixel* src = &cov[cy * atlas->cell_w];
+		shmif_pixel* dst = &vidp[(y + cy) * pitch + x];
+
+		for (size_t cx = 0; cx < w; cx++){
+			uint8_t c[4];
+			SHMIF_RGBA_DECOMP(src[cx], &c[0], &c[1], &c[2], &c[3]);
+
+/* common case, background only */
+			if (!(c[0] | c[1] | c[2])){
+				dst[cx] = bc;
+				continue;
+			}
+
+			dst[cx] = SHMIF_RGBA(
+				bg[0] + (((int)fg[0] - bg[0]) * c[0]) / 255,
+				bg[1] + (((int)fg[1] - bg[1]) * c[1]) / 255,
+				bg[2] + (((int)fg[2] - bg[2]) * c[2]) / 255,
+				bg[3]
+			);
+		}
+	}
+}
+
+/*
+ * For a truetype font, run a static table and check the maximum sizes of the
+ * glyphs at the configured pt_size/dpi and style, matches fontmgmt.c
+ */
+static void atlas_probe(TTF_Font* font, int hint, size_t* dw, size_t* dh)
+{
+	static const char* msg[] = {
+		"A", "a", "!", "_", "J", "j", "G", "g", "M", "m", "`", "-", "=", NULL
+	};
+
+	for (size_t i = 0; msg[i]; i++){
+		int w = 0, h = 0;
+		TTF_SizeUTF8(font, msg[i], &w, &h, TTF_STYLE_BOLD | TTF_STYLE_UNDERLINE);
+
+		if (hint == TTF_HINTING_RGB)
+			w++;
+
+		if (w > *dw)
+			*dw = w;
+
+		if (h > *dh)
+			*dh = h;
+	}
+
+	TTF_Flush_Cache(font);
+}
+
+struct tui_raster_atlas* tui_raster_atlas_grab(
+	int fd, size_t pt_size, float dpi, int hint)
+{
+	struct stat fs;
+	if (-1 == fd || -1 == fstat(fd, &fs))
+		return NULL;
+
+/* same file on disk and same raster properties? then share, the lock is
+ * held through creation so two threads don't both build the same atlas */
+	pthread_mutex_lock(&atlas_lock);
+	for (struct tui_raster_atlas* cur = atlas_list; cur; cur = cur->next){
+		if (cur->dev == fs.st_dev && cur->ino == fs.st_ino &&
+			cur->pt_size == pt_size && cur->hint == hint && cur->dpi == dpi &&
+			pthread_equal(cur->owner, pthread_self())){
+			cur->refcount++;
+			pthread_mutex_unlock(&atlas_lock);
+			return cur;
+		}
+	}
+
+	struct tui_raster_atlas* res = malloc(sizeof(struct tui_raster_atlas));
+	if (!res){
+		pthread_mutex_unlock(&atlas_lock);
+		return NULL;
+	}
+
+	*res = (struct tui_raster_atlas){
+		.refcount = 1,
+		.dev = fs.st_dev,
+		.ino = fs.st_ino,
+		.pt_size = pt_size,
+		.dpi = dpi,
+		.hint = hint,
+		.owner = pthread_self(),
+		.fd = dup(fd),
+		.last_style = TTF_STYLE_NORMAL,
+		.n_slots = TUI_ATLAS_SLOT_BASE,
+		.n_keys = TUI_ATLAS_SLOT_LIMIT * 2
+	};
+
+	if (-1 == res->fd){
+		free(res);
+		pthread_mutex_unlock(&atlas_lock);
+		return NULL;
+	}
+
+	res->font[0].vector = true;
+	res->font[0].fd = res->fd;
+	res->font[0].hint = hint;
+	res->font[1].vector = false;
+	res->font[1].fd = -1;
+
+/* a warm cache has the cell size so freetype isn't needed until a glyph
+ * actually misses, otherwise probe and seed a new cache with the result */
+	const char* dir = getenv(TUI_GLYPHCACHE_ENV);
+	struct glyphcache_hdr want = {
+		.pt_size = pt_size,
+		.dpi = dpi * 100.0f,
+		.hint = hint
+	};
+
+	if (dir && dir[0])
+		want.font_hash = glyphcache_fonthash(res->fd, fs.st_size);
+
+	if (dir && dir[0] && glyphcache_open(&res->cache, dir, &want)){
+		res->cell_w = want.cell_w;
+		res->cell_h = want.cell_h;
+	}
+	else {
+		if (!atlas_font(res))
+			goto fail;
+
+		atlas_probe(res->font[0].truetype, hint, &res->cell_w, &res->cell_h);
+		if (!res->cell_w || !res->cell_h)
+			goto fail;
+
+		if (dir && dir[0]){
+			want.cell_w = res->cell_w;
+			want.cell_h = res->cell_h;
+			glyphcache_create(&res->cache, dir, &want);
+		}
+	}
+
+	res->keys = malloc(res->n_keys * sizeof(uint32_t));
+	res->slots = malloc(res->n_keys * sizeof(uint16_t));
+	res->coverage = malloc(
+		res->n_slots * res->cell_w * res->cell_h * sizeof(shmif_pixel));
+
+	if (!res->keys || !res->slots || !res->coverage)
+		goto fail;
+
+	atlas_flush(res);
+	res->next = atlas_list;
+	atlas_list = res;
+	pthread_mutex_unlock(&atlas_lock);
+	return res;
+
+fail:
+	free(res->keys);
+	free(res->slots);
+	free(res->coverage);
+	glyphcache_close(&res->cache);
+	if (res->font[0].truetype)
+		TTF_CloseFont(res->font[0].truetype);
+	close(res->fd);
+	free(res);
+	pthread_mutex_unlock(&atlas_lock);
+	return NULL;
+}
+
+void tui_raster_atlas_drop(struct tui_raster_atlas* atlas)
+{
+	if (!atlas)
+		return;
+
+	pthread_mutex_lock(&atlas_lock);
+	if (--atlas->refcount > 0){
+		pthread_mutex_unlock(&atlas_lock);
+		return;
+	}
+
+	struct tui_raster_atlas** cur = &atlas_list;
+	while (*cur && *cur != atlas)
+		cur = &(*cur)->next;
+	if (*cur)
+		*cur = atlas->next;
+	pthread_mutex_unlock(&atlas_lock);
+
+	glyphcache_close(&atlas->cache);
+	if (atlas->font[0].truetype)
+		TTF_CloseFont(atlas->font[0].truetype);
+	close(atlas->fd);
+	free(atlas->keys);
+	free(atlas->slots);
+	free(atlas->coverage);
+	free(atlas);
+}
+
+void tui_raster_atlas_cell_size(
+	struct tui_raster_atlas* atlas, size_t* w, size_t* h)
+{
+	*w = atlas ? atlas->cell_w : 0;
+	*h = atlas ? atlas->cell_h : 0;
+}
+
+void tui_raster_setatlas(
+	struct tui_raster_context* ctx, struct tui_raster_atlas* atlas)
+{
+	struct tui_raster_atlas* old = ctx->atlas;
+	ctx->atlas = atlas;
+
+	if (atlas){
+		struct tui_font* fonts[] = {&atlas->font[0], &atlas->font[1]};
+		tui_raster_setfont(ctx, fonts, 2);
+		tui_raster_cell_size(ctx, atlas->cell_w, atlas->cell_h);
+	}
+	else
+		tui_raster_setfont(ctx, NULL, 0);
+
+	tui_raster_atlas_drop(old);
+}
+
 static size_t drawglyph(struct tui_raster_context* ctx, struct cell* cell,
 	shmif_pixel* vidp, size_t pitch, int x, int y, size_t maxx, size_t maxy,
 	bool delta)
@@ -158,6 +848,28 @@ static size_t drawglyph(struct tui_raster_context* ctx, struct cell* cell,
 	prem |= TTF_STYLE_ITALIC * !!(cell->attr & (1 << CATTR_ITALIC));
 	prem |= TTF_STYLE_BOLD * !!(cell->attr & (1 << CATTR_BOLD));
 
+/* shared atlas path, the coverage for the glyph is only rastered once and
+ * then just colorized into the cell */
+	shmif_pixel* cov;
+	if (ctx->atlas && nfonts == 1 &&
+		(cov = atlas_lookup(ctx->atlas, cell->ucs4, prem))){
+		atlas_blit(ctx->atlas, cov,
+			vidp, pitch, x, y, maxx, maxy, cell->fc, bc);
+
+		if (cell->attr & ((1 << CATTR_STRIKETHROUGH) | (1 << CATTR_UNDERLINE)))
+			linehint(ctx, cell, vidp, pitch, x, y, maxx, maxy,
+				cell->attr & (1 << CATTR_STRIKETHROUGH),
+				cell->attr & (1 << CATTR_UNDERLINE)
+			);
+
+		return ctx->cell_w;
+	}
+
+/* the atlas opens its font on the first miss, so re-read the slot */
+	fonts[0] = ctx->fonts[0]->truetype;
+	if (!fonts[0])
+		return ctx->cell_w;
+
 /* seriously expensive so only perform if we actually need to as it can cause a
  * glyph cache flush (bold / italic / ...), other option would be to run
  * separate glyph caches on the different style options.. */
@@ -213,8 +925,11 @@ static int raster_tobuf(
 
 	ctx->cursor_state = hdr.cursor_state;
 
-	ssize_t cur_y = -1;
-	size_t last_line = 0;
+/* for full draw we clear to the background color first, then only the lines
+ * that are actually present in the buffer get rastered */
+	if (!update){
+		draw_box_px(vidp, pitch, max_w, max_h, 0, 0, max_w, max_h, bgc);
+	}
 
 	for (size_t i = 0; i < hdr.lines && buf_sz; i++){
 		if (buf_sz < sizeof(struct tui_raster_line))
@@ -225,41 +940,24 @@ static int raster_tobuf(
 
 		memcpy(&line, buf, sizeof(struct tui_raster_line));
 		buf += sizeof(line);
-
-/* remember the lower line we were at, these are not always ordered */
-		if (line.start_line > last_line)
-			last_line = line.start_line;
+		buf_sz -= sizeof(line);
 
 /* respecting scrolling will need another drawing routine, as we need clipping
  * etc. and multiple lines can be scrolled, and that's better fixed when we
  * have an atlas to work from */
-
-/* skip omitted lines */
-		if (cur_y != line.start_line){
-
-/* for full draw we fill in the skipped space with the background color */
-			if (!update){
-				draw_box_px(vidp, pitch, max_w, max_h,
-					0, cur_y * ctx->cell_h,
-					ctx->cell_w, ctx->cell_h * (line.start_line - cur_y), bgc
-				);
-			}
-			cur_y = line.start_line;
-		}
+		size_t cur_y = line.start_line;
 
 /* the line- raster routine isn't right, we actually need to unpack each line
  * into a local buffer, make not of actual offsets, and then two-pass with bg
  * first and then blend the glyphs on top of that - otherwise kerning, shapes
- * etc. looks bad. */
-		if (cur_y * ctx->cell_h < *y1){
-			*y1 = cur_y * ctx->cell_h;
-		}
-
-/* Shaping, BiDi, ... missing here now while we get the rest in place */
+ * etc. looks bad.
+ *
+ * Shaping, BiDi, ... missing here now while we get the rest in place */
 		size_t draw_x = line.offset * ctx->cell_w;
 
-		if (update && *x1 > draw_x)
-			*x1 = draw_x;
+/* only cells that actually get drawn contribute to the damaged region, skip
+ * cells keep whatever the previous frame had */
+		size_t dx1 = max_w, dx2 = 0;
 
 		for (size_t i = line.offset; line.ncells && buf_sz >= raster_cell_sz; i++){
 			line.ncells--;
@@ -277,21 +975,39 @@ static int raster_tobuf(
 				continue;
 			}
 
-/* blit or discard if OOB */
-			if (draw_x < max_w - ctx->cell_w){
+/* blit or discard if OOB, still need to consume the rest of the cells */
+			if (draw_x + ctx->cell_w <= max_w){
+				if (draw_x < dx1)
+					dx1 = draw_x;
 				draw_x += drawglyph(ctx, &cell, vidp, pitch,
 					draw_x, cur_y * ctx->cell_h, max_w, max_h, true);
+				dx2 = draw_x;
 			}
-			else
-				break;
 		}
-		if (*x2)
-			*x2 = draw_x;
 
-		cur_y++;
+		if (dx2 <= dx1)
+			continue;
+
+		if (dx1 < *x1)
+			*x1 = dx1;
+
+		if (dx2 > *x2)
+			*x2 = dx2 > max_w ? max_w : dx2;
+
+		if (cur_y * ctx->cell_h < *y1)
+			*y1 = cur_y * ctx->cell_h;
+
+		if ((cur_y + 1) * ctx->cell_h > *y2)
+			*y2 = (cur_y + 1) * ctx->cell_h;
 	}
 
-	*y2 = (last_line + 1) * ctx->cell_h;
+/* clamp to the buffer so the upload region is always valid */
+	if (*y2 > max_h)
+		*y2 = max_h;
+
+	if (*x1 > *x2 || *y1 > *y2){
+		*x1 = *x2 = *y1 = *y2 = 0;
+	}
 
 /* sweep through the context struct and blit the glyphs */
 	return 1;
@@ -306,23 +1022,34 @@ int tui_raster_render(struct tui_raster_context* ctx,
 /* pixel- rasterization over shmif should work with one big BB until we have
  * chain-mode. server-side, the vertex buffer slicing will just stream so not
  * much to care about there */
+	uint16_t x1, y1, x2, y2;
 	if (!update){
-		dst->dirty.x1 = 0;
-		dst->dirty.y1 = 0;
-		dst->dirty.x2 = dst->w;
-		dst->dirty.y2 = dst->h;
+		x1 = y1 = 0;
+		x2 = dst->w;
+		y2 = dst->h;
 	}
 	else {
-		dst->dirty.x1 = dst->w;
-		dst->dirty.y1 = dst->h;
-		dst->dirty.x2 = 0;
-		dst->dirty.y2 = 0;
+		x1 = dst->w;
+		y1 = dst->h;
+		x2 = y2 = 0;
 	}
 
-	return raster_tobuf(ctx, dst->vidp, dst->pitch,
-		dst->w, dst->h, &dst->dirty.x1, &dst->dirty.y1,
-		&dst->dirty.y1, &dst->dirty.y2, buf, buf_sz, update
-	);
+	int rv = raster_tobuf(ctx, dst->vidp, dst->pitch,
+		dst->w, dst->h, &x1, &y1, &x2, &y2, buf, buf_sz, update);
+
+	if (1 != rv)
+		return rv;
+
+/* nothing was drawn, so there is nothing to synch either */
+	if (x2 <= x1 || y2 <= y1)
+		return 0;
+
+/* the region accumulates until signalled, reset it to the tight box */
+	dst->dirty = (struct arcan_shmif_region){
+		.x1 = dst->w, .y1 = dst->h
+	};
+	arcan_shmif_dirty(dst, x1, y1, x2, y2, 0);
+	return 1;
 }
 
 void tui_raster_offset(
@@ -346,11 +1073,11 @@ void tui_raster_offset(
  * becomes easier as those won't need to be 'predicted'.
  */
 #ifndef NO_ARCAN_AGP
-void tui_raster_renderagp(struct tui_raster_context* ctx,
+int tui_raster_renderagp(struct tui_raster_context* ctx,
 	struct agp_vstore* dst, uint8_t* buf, size_t buf_sz, bool update)
 {
-	if (!ctx || !dst)
-		return;
+	if (!ctx || !dst || !ctx->fonts[0] || !dst->vinf.text.raw)
+		return -1;
 
 	uint16_t x1, y1, x2, y2;
 	if (update){
@@ -366,15 +1093,22 @@ void tui_raster_renderagp(struct tui_raster_context* ctx,
 
 	if (-1 == raster_tobuf(ctx, dst->vinf.text.raw, dst->w,
 		dst->w, dst->h, &x1, &y1, &x2, &y2, buf, buf_sz, update))
-		return;
+		return -1;
+
+/* only the lines that were part of the buffer have been touched, so the
+ * upload can be restricted to their bounding region */
+	if (x2 <= x1 || y2 <= y1)
+		return 0;
 
 	struct stream_meta stream = {
+		.buf = dst->vinf.text.raw,
 		.x1 = x1, .y1 = y1, .w = x2 - x1, .h = y2 - y1,
 		.dirty = true
 	};
 
 	stream = agp_stream_prepare(dst, stream, STREAM_RAW_DIRECT);
 	agp_stream_commit(dst, stream);
+	return 1;
 }
 #endif
 
@@ -386,5 +1120,6 @@ void tui_raster_free(struct tui_raster_context* ctx)
 	if (!ctx)
 		return;
 
+	tui_raster_atlas_drop(ctx->atlas);
 	free(ctx);
 }
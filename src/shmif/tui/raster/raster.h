@@ -147,13 +147,63 @@ int tui_raster_render(struct tui_raster_context* ctx,
 void tui_raster_cell_size(struct tui_raster_context* ctx, size_t w, size_t h);
 
 /*
- * Synch the raster state into the agp_store
+ * Synch the raster state into the agp_store, only the lines present in [buf]
+ * are rastered and uploaded. If [delta] is not set, the store is cleared to
+ * the background color first.
+ *
+ * Returns -1 on a malformed buffer, 0 if nothing was updated, 1 on upload.
  */
-#ifdef HAVE_ARCAN_AGP
-void tui_raster_renderagp(struct tui_raster_context* ctx,
+#ifndef NO_ARCAN_AGP
+struct agp_vstore;
+int tui_raster_renderagp(struct tui_raster_context* ctx,
 	struct agp_vstore* dst, uint8_t* buf, size_t buf_sz, bool delta);
 #endif
 
+/*
+ * Reference-counted glyph atlas shared by all contexts that raster with the
+ * same font file (matched on device/inode), pt size, density and hinting.
+ * Glyphs are rastered into the atlas on first use and then only colorized
+ * into cells, so N contexts with the same font pay freetype cost once.
+ *
+ * [fd] is duplicated when a new atlas is created, the caller retains
+ * ownership. Returns NULL if the font couldn't be loaded.
+ *
+ * If TUI_GLYPHCACHE_ENV is set to a directory, the atlas is also backed by
+ * a memory mapped cache file there, keyed on the font contents, size,
+ * density and hinting. Other processes using the same font map the same
+ * file, and with a warm cache the font isn't rastered or even opened by
+ * freetype until a glyph is missing.
+ *
+ * Grab and drop are thread-safe, but the atlas itself is not: glyphs are
+ * added from the raster calls without locking. Atlases are therefore only
+ * shared between grabs from the same thread, and a grabbed atlas must not
+ * be used (set on a context, rastered from) by any other thread.
+ */
+#define TUI_GLYPHCACHE_ENV "ARCAN_TUI_GLYPHCACHE"
+
+struct tui_raster_atlas;
+struct tui_raster_atlas* tui_raster_atlas_grab(
+	int fd, size_t pt_size, float dpi, int hint);
+
+/*
+ * Release a reference, the atlas is freed when the last one is dropped.
+ */
+void tui_raster_atlas_drop(struct tui_raster_atlas*);
+
+/*
+ * Retrieve the cell dimensions probed for the atlas font.
+ */
+void tui_raster_atlas_cell_size(
+	struct tui_raster_atlas*, size_t* w, size_t* h);
+
+/*
+ * Switch the raster context to draw from [atlas], this replaces the font
+ * slots and cell size. The context takes over the reference, and it will be
+ * dropped in tui_raster_free.
+ */
+void tui_raster_setatlas(
+	struct tui_raster_context* ctx, struct tui_raster_atlas* atlas);
+
 /*
  * Free any buffers and resources bound to the raster.
  */
@@ -101,8 +101,13 @@ struct line {
 	struct cell *cells;
 	uint64_t sb_id;
 	tsm_age_t age;
+
+	/* cold scrollback lines have cells == NULL and keep their contents here */
+	uint8_t *packed;
 };
 
+struct line_slab;
+
 #define SELECTION_TOP -1
 struct selection_pos {
 	struct line *line;
@@ -140,6 +145,21 @@ struct tsm_screen {
 	unsigned int sb_max;		/* max-limit of lines in sb */
 	struct line *sb_pos;		/* current position in sb or NULL */
 	uint64_t sb_last_id;		/* last id given to sb-line */
+	struct line *sb_hot;		/* oldest sb-line that is not packed */
+	unsigned int sb_hot_count;	/* number of unpacked lines in sb */
+
+	/* line recycling */
+	struct line_slab *slabs;	/* backing store for line headers */
+	struct line *free_lines;	/* unused headers, linked through next */
+	struct cell *free_cells;	/* unused cell arrays of free_width */
+	unsigned int free_width;
+	unsigned int free_count;
+
+	/* scratch space for packing / unpacking sb-lines */
+	struct cell *sb_scratch;
+	unsigned int sb_scratch_sz;
+	uint8_t *pack_buf;
+	size_t pack_buf_sz;
 
 	/* cursor */
 	unsigned int cursor_x;
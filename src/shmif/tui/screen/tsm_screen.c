@@ -145,6 +145,100 @@ static void cell_init(struct tsm_screen *con, struct cell *cell)
 	memcpy(&cell->attr, &con->def_attr, sizeof(cell->attr));
 }
 
+/*
+ * Lines are recycled rather than going back to the heap for every scroll.
+ * Headers are carved out of slabs that live as long as the screen and cell
+ * arrays of the current width are kept on a free list (chained through the
+ * first cell) up to TSM_CELL_POOL entries.
+ */
+#ifndef TSM_LINE_SLAB
+#define TSM_LINE_SLAB 256
+#endif
+
+#ifndef TSM_CELL_POOL
+#define TSM_CELL_POOL 256
+#endif
+
+/*
+ * Scrollback lines further than this from the newest one are packed into
+ * attribute runs and UTF-8, and only unpacked to a scratch line on use.
+ */
+#ifndef TSM_SB_HOT
+#define TSM_SB_HOT 512
+#endif
+
+struct line_slab {
+	struct line_slab *next;
+	struct line lines[TSM_LINE_SLAB];
+};
+
+static struct line *line_alloc(struct tsm_screen *con)
+{
+	struct line *line;
+
+	if (!con->free_lines) {
+		struct line_slab *slab = malloc(sizeof(struct line_slab));
+		if (!slab)
+			return NULL;
+
+		slab->next = con->slabs;
+		con->slabs = slab;
+
+		for (size_t i = 0; i < TSM_LINE_SLAB; i++) {
+			slab->lines[i].next = con->free_lines;
+			con->free_lines = &slab->lines[i];
+		}
+	}
+
+	line = con->free_lines;
+	con->free_lines = line->next;
+	return line;
+}
+
+static struct cell *cells_alloc(struct tsm_screen *con, unsigned int width)
+{
+	if (con->free_cells && con->free_width == width) {
+		struct cell *cells = con->free_cells;
+		memcpy(&con->free_cells, cells, sizeof(struct cell *));
+		con->free_count--;
+		return cells;
+	}
+
+	return malloc(sizeof(struct cell) * width);
+}
+
+static void cells_flush(struct tsm_screen *con)
+{
+	while (con->free_cells) {
+		struct cell *cells = con->free_cells;
+		memcpy(&con->free_cells, cells, sizeof(struct cell *));
+		free(cells);
+	}
+	con->free_count = 0;
+}
+
+static void cells_release(struct tsm_screen *con,
+	struct cell *cells, unsigned int width)
+{
+	if (!cells)
+		return;
+
+	if (width != con->size_x || con->free_count >= TSM_CELL_POOL) {
+		free(cells);
+		return;
+	}
+
+/* the width changed since the pool was filled, start over */
+	if (con->free_width != width) {
+		cells_flush(con);
+		con->free_width = width;
+	}
+
+	memcpy(cells, &con->free_cells, sizeof(struct cell *));
+	con->free_cells = cells;
+	con->free_count++;
+}
+
 static int line_new(struct tsm_screen *con, struct line **out,
 		    unsigned int width)
 {
@@ -154,17 +248,20 @@ static int line_new(struct tsm_screen *con, struct line **out,
 	if (!width)
 		return -EINVAL;
 
-	line = malloc(sizeof(*line));
+	line = line_alloc(con);
 	if (!line)
 		return -ENOMEM;
 	line->next = NULL;
 	line->prev = NULL;
 	line->size = width;
 	line->age = con->age_cnt;
+	line->sb_id = 0;
+	line->packed = NULL;
 
-	line->cells = malloc(sizeof(struct cell) * width);
+	line->cells = cells_alloc(con, width);
 	if (!line->cells) {
-		free(line);
+		line->next = con->free_lines;
+		con->free_lines = line;
 		return -ENOMEM;
 	}
 
@@ -175,10 +272,265 @@ static int line_new(struct tsm_screen *con, struct line **out,
 	return 0;
 }
 
-static void line_free(struct line *line)
+static void line_free(struct tsm_screen *con, struct line *line)
 {
-	free(line->cells);
-	free(line);
+	cells_release(con, line->cells, line->size);
+	free(line->packed);
+	line->cells = NULL;
+	line->packed = NULL;
+
+	line->next = con->free_lines;
+	con->free_lines = line;
+}
+
+static void lines_release(struct tsm_screen *con)
+{
+	struct line_slab *slab = con->slabs;
+	while (slab) {
+		struct line_slab *next = slab->next;
+		free(slab);
+		slab = next;
+	}
+
+	con->slabs = NULL;
+	con->free_lines = NULL;
+	cells_flush(con);
+	free(con->sb_scratch);
+	free(con->pack_buf);
+	con->sb_scratch = NULL;
+	con->pack_buf = NULL;
+	con->sb_scratch_sz = 0;
+	con->pack_buf_sz = 0;
+}
+
+/*
+ * Packed form of a line:
+ *  varint n_text, cells beyond that have ch = 0
+ *  runs of [varint count, attr(8), width(1)] covering line->size cells
+ *  n_text symbols as UTF-8, with 0xff + 4 raw bytes for symbol-table ids
+ */
+static size_t varint_put(uint8_t *dst, size_t val)
+{
+	size_t i = 0;
+	while (val >= 0x80) {
+		dst[i++] = (val & 0x7f) | 0x80;
+		val >>= 7;
+	}
+	dst[i++] = val;
+	return i;
+}
+
+static size_t varint_get(const uint8_t **src)
+{
+	size_t val = 0;
+	unsigned int shift = 0;
+	const uint8_t *cur = *src;
+
+	do {
+		val |= (size_t)(*cur & 0x7f) << shift;
+		shift += 7;
+	} while (*cur++ & 0x80);
+
+	*src = cur;
+	return val;
+}
+
+static void attr_put(uint8_t dst[8], const struct tui_screen_attr *attr)
+{
+	dst[0] = attr->fr;
+	dst[1] = attr->fg;
+	dst[2] = attr->fb;
+	dst[3] = attr->br;
+	dst[4] = attr->bg;
+	dst[5] = attr->bb;
+	dst[6] = attr->bold | attr->underline << 1 | attr->italic << 2 |
+		attr->inverse << 3 | attr->protect << 4 | attr->blink << 5 |
+		attr->strikethrough << 6 | attr->shape_break << 7;
+	dst[7] = attr->custom_id;
+}
+
+static void attr_get(struct tui_screen_attr *attr, const uint8_t src[8])
+{
+	*attr = (struct tui_screen_attr){
+		.fr = src[0], .fg = src[1], .fb = src[2],
+		.br = src[3], .bg = src[4], .bb = src[5],
+		.bold = src[6] & 1,
+		.underline = (src[6] >> 1) & 1,
+		.italic = (src[6] >> 2) & 1,
+		.inverse = (src[6] >> 3) & 1,
+		.protect = (src[6] >> 4) & 1,
+		.blink = (src[6] >> 5) & 1,
+		.strikethrough = (src[6] >> 6) & 1,
+		.shape_break = (src[6] >> 7) & 1,
+		.custom_id = src[7]
+	};
+}
+
+static size_t sym_put(uint8_t *dst, tsm_symbol_t ch)
+{
+	if (ch < 0x80) {
+		dst[0] = ch;
+		return 1;
+	}
+	else if (ch < 0x800) {
+		dst[0] = 0xc0 | (ch >> 6);
+		dst[1] = 0x80 | (ch & 0x3f);
+		return 2;
+	}
+	else if (ch < 0x10000) {
+		dst[0] = 0xe0 | (ch >> 12);
+		dst[1] = 0x80 | ((ch >> 6) & 0x3f);
+		dst[2] = 0x80 | (ch & 0x3f);
+		return 3;
+	}
+	else if (ch < 0x110000) {
+		dst[0] = 0xf0 | (ch >> 18);
+		dst[1] = 0x80 | ((ch >> 12) & 0x3f);
+		dst[2] = 0x80 | ((ch >> 6) & 0x3f);
+		dst[3] = 0x80 | (ch & 0x3f);
+		return 4;
+	}
+
+	dst[0] = 0xff;
+	memcpy(&dst[1], &ch, 4);
+	return 5;
+}
+
+static tsm_symbol_t sym_get(const uint8_t **src)
+{
+	const uint8_t *cur = *src;
+	tsm_symbol_t ch;
+
+	if (cur[0] < 0x80) {
+		ch = cur[0];
+		cur += 1;
+	}
+	else if (cur[0] == 0xff) {
+		memcpy(&ch, &cur[1], 4);
+		cur += 5;
+	}
+	else if (cur[0] >= 0xf0) {
+		ch = (cur[0] & 0x07) << 18 | (cur[1] & 0x3f) << 12 |
+			(cur[2] & 0x3f) << 6 | (cur[3] & 0x3f);
+		cur += 4;
+	}
+	else if (cur[0] >= 0xe0) {
+		ch = (cur[0] & 0x0f) << 12 | (cur[1] & 0x3f) << 6 | (cur[2] & 0x3f);
+		cur += 3;
+	}
+	else {
+		ch = (cur[0] & 0x1f) << 6 | (cur[1] & 0x3f);
+		cur += 2;
+	}
+
+	*src = cur;
+	return ch;
+}
+
+static void line_pack(struct tsm_screen *con, struct line *line)
+{
+	unsigned int i, n_text = 0;
+
+	if (!line->cells)
+		return;
+
+/* worst case is one run and one escaped symbol per cell */
+	size_t need = 16 + (size_t) line->size * (10 + 8 + 1 + 5);
+	if (need > con->pack_buf_sz) {
+		uint8_t *buf = realloc(con->pack_buf, need);
+		if (!buf)
+			return;
+		con->pack_buf = buf;
+		con->pack_buf_sz = need;
+	}
+
+	for (i = 0; i < line->size; i++) {
+		if (line->cells[i].ch)
+			n_text = i + 1;
+		if (line->cells[i].age > line->age)
+			line->age = line->cells[i].age;
+	}
+
+	uint8_t *out = con->pack_buf;
+	size_t ofs = varint_put(out, n_text);
+
+	for (i = 0; i < line->size;) {
+		uint8_t attr[8];
+		attr_put(attr, &line->cells[i].attr);
+		unsigned int width = line->cells[i].width;
+		unsigned int run = 1;
+
+		for (; i + run < line->size; run++) {
+			uint8_t next[8];
+			attr_put(next, &line->cells[i + run].attr);
+			if (line->cells[i + run].width != width || memcmp(next, attr, 8))
+				break;
+		}
+
+		ofs += varint_put(&out[ofs], run);
+		memcpy(&out[ofs], attr, 8);
+		out[ofs + 8] = width;
+		ofs += 9;
+		i += run;
+	}
+
+	for (i = 0; i < n_text; i++)
+		ofs += sym_put(&out[ofs], line->cells[i].ch);
+
+	uint8_t *packed = malloc(ofs);
+	if (!packed)
+		return;
+
+	memcpy(packed, out, ofs);
+	line->packed = packed;
+	cells_release(con, line->cells, line->size);
+	line->cells = NULL;
+}
+
+static void line_unpack(struct line *line, struct cell *cells)
+{
+	const uint8_t *cur = line->packed;
+	unsigned int i, n_text = varint_get(&cur);
+
+	for (i = 0; i < line->size;) {
+		struct tui_screen_attr attr;
+		size_t run = varint_get(&cur);
+		attr_get(&attr, cur);
+		unsigned int width = cur[8];
+		cur += 9;
+
+		for (; run && i < line->size; run--, i++) {
+			cells[i].attr = attr;
+			cells[i].width = width;
+			cells[i].age = 0;
+			cells[i].ch = 0;
+		}
+	}
+
+	for (i = 0; i < n_text; i++)
+		cells[i].ch = sym_get(&cur);
+}
+
+/*
+ * Get the cells of [line], unpacking into the screen scratch line if it has
+ * gone cold. The result is only valid until the next call.
+ */
+static struct cell *line_cells(struct tsm_screen *con, struct line *line)
+{
+	if (line->cells)
+		return line->cells;
+
+	if (line->size > con->sb_scratch_sz) {
+		struct cell *scratch =
+			realloc(con->sb_scratch, sizeof(struct cell) * line->size);
+		if (!scratch)
+			return NULL;
+		con->sb_scratch = scratch;
+		con->sb_scratch_sz = line->size;
+	}
+
+	line_unpack(line, con->sb_scratch);
+	return con->sb_scratch;
 }
 
 static int line_resize(struct tsm_screen *con, struct line *line,
@@ -223,7 +575,7 @@ static void link_to_scrollback(struct tsm_screen *con, struct line *line)
 				con->sel_end.y = SELECTION_TOP;
 			}
 		}
-		line_free(line);
+		line_free(con, line);
 		return;
 	}
 
@@ -267,7 +619,12 @@ static void link_to_scrollback(struct tsm_screen *con, struct line *line)
 				con->sel_end.y = SELECTION_TOP;
 			}
 		}
-		line_free(tmp);
+
+		if (con->sb_hot == tmp) {
+			con->sb_hot = tmp->next;
+			--con->sb_hot_count;
+		}
+		line_free(con, tmp);
 	}
 
 	line->sb_id = ++con->sb_last_id;
@@ -279,6 +636,18 @@ static void link_to_scrollback(struct tsm_screen *con, struct line *line)
 		con->sb_first = line;
 	con->sb_last = line;
 	++con->sb_count;
+
+	/* lines that have scrolled far enough back are packed, these are only
+	 * unpacked (to a scratch line) when drawn or copied from */
+	if (!con->sb_hot)
+		con->sb_hot = line;
+	++con->sb_hot_count;
+
+	while (con->sb_hot_count > TSM_SB_HOT) {
+		line_pack(con, con->sb_hot);
+		con->sb_hot = con->sb_hot->next;
+		--con->sb_hot_count;
+	}
 }
 
 static int screen_scroll_up(struct tsm_screen *con, unsigned int num)
@@ -522,9 +891,10 @@ int tsm_screen_new(struct tsm_screen **out, tsm_log_t log, void *log_data)
 
 err_free:
 	for (i = 0; i < con->line_num; ++i) {
-		line_free(con->main_lines[i]);
-		line_free(con->alt_lines[i]);
+		line_free(con, con->main_lines[i]);
+		line_free(con, con->alt_lines[i]);
 	}
+	lines_release(con);
 	free(con->main_lines);
 	free(con->alt_lines);
 	free(con->tab_ruler);
@@ -550,11 +920,12 @@ void tsm_screen_unref(struct tsm_screen *con)
 	if (!con || !con->ref || --con->ref)
 		return;
 
-
+	tsm_screen_clear_sb(con);
 	for (i = 0; i < con->line_num; ++i) {
-		line_free(con->main_lines[i]);
-		line_free(con->alt_lines[i]);
+		line_free(con, con->main_lines[i]);
+		line_free(con, con->alt_lines[i]);
 	}
+	lines_release(con);
 	free(con->main_lines);
 	free(con->alt_lines);
 	free(con->tab_ruler);
@@ -638,7 +1009,7 @@ int tsm_screen_resize(
 			ret = line_new(con, &con->alt_lines[con->line_num],
 				       width);
 			if (ret) {
-				line_free(con->main_lines[con->line_num]);
+				line_free(con, con->main_lines[con->line_num]);
 				return ret;
 			}
 
@@ -887,7 +1258,12 @@ void tsm_screen_set_max_sb(struct tsm_screen *con,
 				con->sel_end.y = SELECTION_TOP;
 			}
 		}
-		line_free(line);
+
+		if (con->sb_hot == line) {
+			con->sb_hot = line->next;
+			con->sb_hot_count--;
+		}
+		line_free(con, line);
 	}
 
 	con->sb_max = max;
@@ -908,13 +1284,15 @@ void tsm_screen_clear_sb(struct tsm_screen *con)
 	for (iter = con->sb_first; iter; ) {
 		tmp = iter;
 		iter = iter->next;
-		line_free(tmp);
+		line_free(con, tmp);
 	}
 
 	con->sb_first = NULL;
 	con->sb_last = NULL;
 	con->sb_count = 0;
 	con->sb_pos = NULL;
+	con->sb_hot = NULL;
+	con->sb_hot_count = 0;
 
 	if (con->sel_active) {
 		if (con->sel_start.line) {
@@ -1180,7 +1558,7 @@ int tsm_screen_write(struct tsm_screen *con, tsm_symbol_t ch,
 
 	if (con->cursor_y > last) {
 		move_cursor(con, con->cursor_x, last);
-		return screen_scroll_up(con, 1);
+		rv = screen_scroll_up(con, 1);
 	}
 
 	screen_write(con,
@@ -1189,6 +1567,87 @@ int tsm_screen_write(struct tsm_screen *con, tsm_symbol_t ch,
 	return rv;
 }
 
+/*
+ * Bulk version of tsm_screen_write. When every symbol in the run is single
+ * width and neither insert mode nor disabled wrapping needs per-symbol
+ * handling, cells are filled a line at a time and wrapping past the bottom
+ * margin scrolls all the lines the rest of the run will need in one go.
+ */
+SHL_EXPORT
+int tsm_screen_write_run(struct tsm_screen *con, const tsm_symbol_t *ch,
+			  size_t n, const struct tui_screen_attr *attr)
+{
+	int rv = 0;
+	size_t i;
+
+	if (!con || !n)
+		return 0;
+
+	if (!attr)
+		attr = &con->def_attr;
+
+	bool bulk = (con->flags & TSM_SCREEN_AUTO_WRAP) &&
+		!(con->flags & TSM_SCREEN_INSERT_MODE);
+
+	for (i = 0; bulk && i < n; i++)
+		if (ch[i] < 0x20 || (ch[i] > 0x7e &&
+			tsm_symbol_get_width(con->sym_table, ch[i]) != 1))
+			bulk = false;
+
+	if (!bulk){
+		for (i = 0; i < n; i++)
+			rv += tsm_screen_write(con, ch[i], attr);
+		return rv;
+	}
+
+	inc_age(con);
+
+	for (i = 0; i < n;){
+		unsigned int last;
+
+		if (con->cursor_y <= con->margin_bottom ||
+		    con->cursor_y >= con->size_y)
+			last = con->margin_bottom;
+		else
+			last = con->size_y - 1;
+
+		if (con->cursor_x >= con->size_x)
+			move_cursor(con, 0, con->cursor_y + 1);
+
+/* scrolling k lines at once leaves the same lines behind as k single steps
+ * as long as k stays within the region, below the margin only step once */
+		if (con->cursor_y > last) {
+			size_t rows = 1;
+			if (last == con->margin_bottom){
+				unsigned int max = con->margin_bottom + 1 - con->margin_top;
+				rows = (n - i + con->size_x - 1) / con->size_x;
+				if (rows > max)
+					rows = max;
+			}
+
+			rv += screen_scroll_up(con, rows);
+			move_cursor(con, con->cursor_x, last + 1 - rows);
+		}
+
+		size_t cnt = con->size_x - con->cursor_x;
+		if (cnt > n - i)
+			cnt = n - i;
+
+		struct cell *cells = &con->lines[con->cursor_y]->cells[con->cursor_x];
+		for (size_t j = 0; j < cnt; j++){
+			cells[j].ch = ch[i + j];
+			cells[j].width = 1;
+			cells[j].age = con->age_cnt;
+			cells[j].attr = *attr;
+		}
+
+		move_cursor(con, con->cursor_x + cnt, con->cursor_y);
+		i += cnt;
+	}
+
+	return rv;
+}
+
 struct export_metadata {
 	uint8_t magic[4];
 	uint32_t sb_count;
@@ -1910,21 +2369,25 @@ void tsm_screen_selection_target(struct tsm_screen *con,
 	selection_set(con, &con->sel_end, posx, posy);
 }
 
-static unsigned int copy_line(struct line *line, char *buf,
-			      unsigned int start, unsigned int len, bool conv)
+static unsigned int copy_line(struct tsm_screen *con, struct line *line,
+			      char *buf, unsigned int start, unsigned int len, bool conv)
 {
 	unsigned int i, end;
 	char *pos = buf;
+	struct cell *cells = line_cells(con, line);
+
+	if (!cells)
+		return 0;
 
 	end = start + len;
 	for (i = start; i < line->size && i < end; ++i) {
-		if (i < line->size || !line->cells[i].ch){
+		if (i < line->size || !cells[i].ch){
 			if (!conv){
-				memcpy(pos, &line->cells[i].ch, 4);
+				memcpy(pos, &cells[i].ch, 4);
 				pos += 4;
 			}
 			else
-				pos += tsm_ucs4_to_utf8(line->cells[i].ch, pos);
+				pos += tsm_ucs4_to_utf8(cells[i].ch, pos);
 		}
 		else{
 			if (!conv){
@@ -2087,22 +2550,22 @@ int tsm_screen_selection_copy(struct tsm_screen *con, char **out, bool conv)
 					len = end->x - start->x + 1;
 				else
 					len = iter->size - start->x;
-				pos += copy_line(iter, pos, start->x, len, conv);
+				pos += copy_line(con, iter, pos, start->x, len, conv);
 			}
 			break;
 		} else if (iter == start->line) {
 			if (iter->size > start->x)
-				pos += copy_line(iter, pos, start->x,
+				pos += copy_line(con, iter, pos, start->x,
 						 iter->size - start->x, conv);
 		} else if (iter == end->line) {
 			if (iter->size > end->x)
 				len = end->x + 1;
 			else
 				len = iter->size;
-			pos += copy_line(iter, pos, 0, len, conv);
+			pos += copy_line(con, iter, pos, 0, len, conv);
 			break;
 		} else {
-			pos += copy_line(iter, pos, 0, iter->size, conv);
+			pos += copy_line(con, iter, pos, 0, iter->size, conv);
 		}
 
 		if (conv){
@@ -2129,22 +2592,22 @@ int tsm_screen_selection_copy(struct tsm_screen *con, char **out, bool conv)
 						len = end->x - start->x + 1;
 					else
 						len = con->size_x - start->x;
-					pos += copy_line(iter, pos, start->x, len, conv);
+					pos += copy_line(con, iter, pos, start->x, len, conv);
 				}
 				break;
 			} else if (!start->line && start->y == i) {
 				if (con->size_x > start->x)
-					pos += copy_line(iter, pos, start->x,
+					pos += copy_line(con, iter, pos, start->x,
 							 con->size_x - start->x, conv);
 			} else if (end->y == i) {
 				if (con->size_x > end->x)
 					len = end->x + 1;
 				else
 					len = con->size_x;
-				pos += copy_line(iter, pos, 0, len, conv);
+				pos += copy_line(con, iter, pos, 0, len, conv);
 				break;
 			} else {
-				pos += copy_line(iter, pos, 0, con->size_x, conv);
+				pos += copy_line(con, iter, pos, 0, con->size_x, conv);
 			}
 
 			if (conv){
@@ -2170,7 +2633,7 @@ tsm_age_t tsm_screen_draw(struct tsm_screen *con, tsm_screen_draw_cb draw_cb,
 {
 	unsigned int i, j, k;
 	struct line *iter, *line = NULL;
-	struct cell *cell, empty;
+	struct cell *cells, *cell, empty;
 	struct tui_screen_attr attr;
 	const uint32_t *ch;
 	size_t len;
@@ -2211,6 +2674,8 @@ tsm_age_t tsm_screen_draw(struct tsm_screen *con, tsm_screen_draw_cb draw_cb,
 			k++;
 		}
 
+		cells = line_cells(con, line);
+
 		if (con->sel_active) {
 			if (con->sel_start.line == line ||
 			    (!con->sel_start.line &&
@@ -2229,8 +2694,8 @@ tsm_age_t tsm_screen_draw(struct tsm_screen *con, tsm_screen_draw_cb draw_cb,
 		}
 
 		for (j = 0; j < con->size_x; ++j) {
-			if (j < line->size)
-				cell = &line->cells[j];
+			if (j < line->size && cells)
+				cell = &cells[j];
 			else
 				cell = &empty;
 			memcpy(&attr, &cell->attr, sizeof(attr));
@@ -44,6 +44,14 @@ struct tui_context {
 	struct tui_cell* back;
 	uint8_t fstamp;
 
+/* Damage bitmaps, also carved out of BASE. One bit per cell in [dmg] with
+ * [dmg_stride] words per row, set when tsm reports a cell as newer than the
+ * last draw, and one bit per row in [dmg_rows] so a partial update only has
+ * to visit the cells that were actually touched. */
+	uint64_t* dmg;
+	uint64_t* dmg_rows;
+	size_t dmg_stride;
+
 /* rbuf is used to package / convert the representation in base(front|back)
  * to a line format that can be used to forward to a raster engine. The size
  * is derived when allocating base
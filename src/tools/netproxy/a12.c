@@ -28,6 +28,7 @@
 #include <sys/stat.h>
 #include <unistd.h>
 #include <errno.h>
+#include <pthread.h>
 
 int a12_trace_targets = 0;
 FILE* a12_trace_dst = NULL;
@@ -47,6 +48,123 @@ size_t a12int_header_size(int kind)
 	return header_sizes[kind];
 }
 
+/*
+ * Fork-join worker pool shared by all states, used by the encode and decode
+ * stages to process independent tiles of a video frame. Jobs are coarse
+ * (one compressed tile each) so they are claimed under the lock, the caller
+ * participates and returns when all jobs in its batch have finished.
+ */
+#ifndef A12_WORKER_LIMIT
+#define A12_WORKER_LIMIT 8
+#endif
+
+static struct {
+	pthread_mutex_t run;
+	pthread_mutex_t lock;
+	pthread_cond_t wake;
+	pthread_cond_t done;
+	size_t n_threads;
+	bool spawned;
+
+	void (*job)(void*, size_t);
+	void* tag;
+	size_t n_jobs;
+	size_t next;
+	size_t finished;
+} workers = {
+	.run = PTHREAD_MUTEX_INITIALIZER,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.wake = PTHREAD_COND_INITIALIZER,
+	.done = PTHREAD_COND_INITIALIZER
+};
+
+/* claim and run jobs until the current batch is drained, lock is held on
+ * entry and exit */
+static void worker_drain()
+{
+	while (workers.next < workers.n_jobs){
+		size_t ind = workers.next++;
+		void (*job)(void*, size_t) = workers.job;
+		void* tag = workers.tag;
+		pthread_mutex_unlock(&workers.lock);
+
+		job(tag, ind);
+
+		pthread_mutex_lock(&workers.lock);
+		if (++workers.finished == workers.n_jobs)
+			pthread_cond_signal(&workers.done);
+	}
+}
+
+static void* worker_loop(void* arg)
+{
+	pthread_mutex_lock(&workers.lock);
+	for(;;){
+		while (workers.next >= workers.n_jobs)
+			pthread_cond_wait(&workers.wake, &workers.lock);
+		worker_drain();
+	}
+	return NULL;
+}
+
+static void worker_spawn()
+{
+	workers.spawned = true;
+	long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t lim = ncpu > 1 ? ncpu - 1 : 0;
+	if (lim > A12_WORKER_LIMIT)
+		lim = A12_WORKER_LIMIT;
+
+	pthread_attr_t pthattr;
+	pthread_attr_init(&pthattr);
+	pthread_attr_setdetachstate(&pthattr, PTHREAD_CREATE_DETACHED);
+
+	for (size_t i = 0; i < lim; i++){
+		pthread_t pth;
+		if (0 != pthread_create(&pth, &pthattr, worker_loop, NULL))
+			break;
+		workers.n_threads++;
+	}
+
+	pthread_attr_destroy(&pthattr);
+	a12int_trace(A12_TRACE_ALLOC,
+		"kind=workers:count=%zu", workers.n_threads);
+}
+
+void a12int_parallel(void (*job)(void*, size_t), void* tag, size_t n_jobs)
+{
+	if (!n_jobs)
+		return;
+
+/* not worth the wakeup */
+	if (n_jobs == 1){
+		job(tag, 0);
+		return;
+	}
+
+	pthread_mutex_lock(&workers.run);
+	pthread_mutex_lock(&workers.lock);
+	if (!workers.spawned)
+		worker_spawn();
+
+	workers.job = job;
+	workers.tag = tag;
+	workers.n_jobs = n_jobs;
+	workers.next = 0;
+	workers.finished = 0;
+	if (workers.n_threads)
+		pthread_cond_broadcast(&workers.wake);
+
+	worker_drain();
+	while (workers.finished < workers.n_jobs)
+		pthread_cond_wait(&workers.done, &workers.lock);
+
+	workers.n_jobs = 0;
+	workers.next = 0;
+	pthread_mutex_unlock(&workers.lock);
+	pthread_mutex_unlock(&workers.run);
+}
+
 static void unlink_node(struct a12_state*, struct blob_out*);
 
 static uint8_t* grow_array(uint8_t* dst, size_t* cur_sz, size_t new_sz, int ind)
@@ -288,6 +406,8 @@ a12_channel_close(struct a12_state* S)
 	if (S->channels[S->out_channel].active){
 		S->channels[S->out_channel].cont = NULL;
 		S->channels[S->out_channel].active = false;
+		a12int_vframe_tiles_drop(
+			&S->channels[S->out_channel].unpack_state.vframe);
 	}
 
 	a12int_trace(A12_TRACE_SYSTEM, "closing channel (%"PRIu8")", S->out_channel);
@@ -606,10 +726,18 @@ static void command_videoframe(struct a12_state* S)
 	if (!cont){
 		a12int_trace(A12_TRACE_SYSTEM,
 			"kind=videoframe_header:status=EINVAL:channel=%d", (int) channel);
+		a12int_vframe_tiles_drop(vframe);
 		vframe->commit = 255;
 		return;
 	}
 
+/* tiles from an uncommitted batch need to land before the store can be
+ * resized or written to by anything other than another tile */
+	if (vframe->sw != cont->w || vframe->sh != cont->h ||
+		(vframe->postprocess != POSTPROCESS_VIDEO_MINIZ &&
+		vframe->postprocess != POSTPROCESS_VIDEO_DMINIZ))
+		a12int_vframe_tiles_flush(vframe, cont);
+
 	if (vframe->sw != cont->w || vframe->sh != cont->h){
 		arcan_shmif_resize(cont, vframe->sw, vframe->sh);
 		if (vframe->sw != cont->w || vframe->sh != cont->h){
@@ -1191,6 +1319,10 @@ struct a12_state* S, struct arcan_shmif_cont* wnd, uint8_t chid)
 		return;
 	}
 
+/* pending tiles were addressed to the previous destination */
+	if (S->channels[chid].cont != wnd)
+		a12int_vframe_tiles_drop(&S->channels[chid].unpack_state.vframe);
+
 	S->channels[chid].cont = wnd;
 	S->channels[chid].active = wnd != NULL;
 }
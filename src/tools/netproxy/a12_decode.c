@@ -29,18 +29,39 @@ bool a12int_buffer_format(int method)
 		method == POSTPROCESS_VIDEO_DMINIZ;
 }
 
+/*
+ * Self-contained unpack state for one compressed frame or tile so that
+ * several of them can be inflated at the same time, the destination regions
+ * of tiles in a batch never overlap.
+ */
+struct vframe_tile {
+	uint8_t* inbuf;
+	size_t inbuf_sz;
+	uint8_t postprocess;
+
+	size_t w;
+	size_t out_pos;
+	size_t row_left;
+	uint32_t expanded_sz;
+
+	uint8_t pxbuf[4];
+	uint8_t carry;
+
+	shmif_pixel* vidp;
+	size_t pitch;
+};
+
 /*
  * performance wise we should check if the extra branch in miniz vs. dminiz
  * should be handled here or by inlining and copying
  */
 static int video_miniz(const void* buf, int len, void* user)
 {
-	struct a12_state* S = user;
-	struct video_frame* cvf = &S->channels[S->in_channel].unpack_state.vframe;
-	struct arcan_shmif_cont* cont = S->channels[S->in_channel].cont;
+	struct vframe_tile* cvf = user;
+	shmif_pixel* vidp = cvf->vidp;
 	const uint8_t* inbuf = buf;
 
-	if (!cont || len > cvf->expanded_sz){
+	if (len > cvf->expanded_sz){
 		a12int_trace(A12_TRACE_SYSTEM, "decompression resulted in data overcommit");
 		return 0;
 	}
@@ -60,9 +81,9 @@ static int video_miniz(const void* buf, int len, void* user)
 /* and commit */
 		if (cvf->postprocess == POSTPROCESS_VIDEO_DMINIZ){
 			uint8_t r, g, b, a;
-			SHMIF_RGBA_DECOMP(cont->vidp[cvf->out_pos], &r, &g, &b, &a);
+			SHMIF_RGBA_DECOMP(vidp[cvf->out_pos], &r, &g, &b, &a);
 
-			cont->vidp[cvf->out_pos++] = SHMIF_RGBA(
+			vidp[cvf->out_pos++] = SHMIF_RGBA(
 				cvf->pxbuf[0] ^ r,
 				cvf->pxbuf[1] ^ g,
 				cvf->pxbuf[2] ^ b,
@@ -70,14 +91,14 @@ static int video_miniz(const void* buf, int len, void* user)
 			);
 		}
 		else
-			cont->vidp[cvf->out_pos++] =
+			vidp[cvf->out_pos++] =
 				SHMIF_RGBA(cvf->pxbuf[0], cvf->pxbuf[1], cvf->pxbuf[2], 0xff);
 
 /* which can happen on a row boundary */
 		cvf->row_left--;
 		if (cvf->row_left == 0){
 			cvf->out_pos -= cvf->w;
-			cvf->out_pos += cont->pitch;
+			cvf->out_pos += cvf->pitch;
 			cvf->row_left = cvf->w;
 		}
 		cvf->carry = 0;
@@ -88,9 +109,9 @@ static int video_miniz(const void* buf, int len, void* user)
 	for (size_t i = 0; i < npx; i += 3){
 		if (cvf->postprocess == POSTPROCESS_VIDEO_DMINIZ){
 			uint8_t r, g, b, a;
-			SHMIF_RGBA_DECOMP(cont->vidp[cvf->out_pos], &r, &g, &b, &a);
+			SHMIF_RGBA_DECOMP(vidp[cvf->out_pos], &r, &g, &b, &a);
 
-			cont->vidp[cvf->out_pos++] = SHMIF_RGBA(
+			vidp[cvf->out_pos++] = SHMIF_RGBA(
 				inbuf[i+0] ^ r,
 				inbuf[i+1] ^ g,
 				inbuf[i+2] ^ b,
@@ -98,14 +119,14 @@ static int video_miniz(const void* buf, int len, void* user)
 			);
 		}
 		else{
-			cont->vidp[cvf->out_pos++] =
+			vidp[cvf->out_pos++] =
 				SHMIF_RGBA(inbuf[i], inbuf[i+1], inbuf[i+2], 0xff);
 		}
 
 		cvf->row_left--;
 		if (cvf->row_left == 0){
 			cvf->out_pos -= cvf->w;
-			cvf->out_pos += cont->pitch;
+			cvf->out_pos += cvf->pitch;
 			cvf->row_left = cvf->w;
 		}
 	}
@@ -122,23 +143,93 @@ static int video_miniz(const void* buf, int len, void* user)
 	return 1;
 }
 
+static void tile_job(void* tag, size_t ind)
+{
+	struct vframe_tile* tile = &((struct vframe_tile*)tag)[ind];
+	size_t inbuf_pos = tile->inbuf_sz;
+	tinfl_decompress_mem_to_callback(tile->inbuf, &inbuf_pos, video_miniz, tile, 0);
+	free(tile->inbuf);
+	tile->inbuf = NULL;
+}
+
+void a12int_vframe_tiles_flush(
+	struct video_frame* cvf, struct arcan_shmif_cont* cont)
+{
+	if (!cvf->n_tiles)
+		return;
+
+	a12int_trace(A12_TRACE_VIDEO,
+		"kind=status:message=unpack tiles:count=%zu", cvf->n_tiles);
+
+	for (size_t i = 0; i < cvf->n_tiles; i++){
+		cvf->tiles[i].vidp = cont->vidp;
+		cvf->tiles[i].pitch = cont->pitch;
+	}
+
+	a12int_parallel(tile_job, cvf->tiles, cvf->n_tiles);
+	cvf->n_tiles = 0;
+}
+
+void a12int_vframe_tiles_drop(struct video_frame* cvf)
+{
+	for (size_t i = 0; i < cvf->n_tiles; i++)
+		free(cvf->tiles[i].inbuf);
+
+	free(cvf->tiles);
+	cvf->tiles = NULL;
+	cvf->n_tiles = 0;
+	cvf->tiles_sz = 0;
+}
+
+static bool queue_tile(struct video_frame* cvf, struct vframe_tile* tile)
+{
+	if (cvf->n_tiles == cvf->tiles_sz){
+		size_t new_sz = cvf->tiles_sz ? cvf->tiles_sz * 2 : 64;
+		struct vframe_tile* new_tiles =
+			realloc(cvf->tiles, new_sz * sizeof(struct vframe_tile));
+		if (!new_tiles)
+			return false;
+
+		cvf->tiles = new_tiles;
+		cvf->tiles_sz = new_sz;
+	}
+
+	cvf->tiles[cvf->n_tiles++] = *tile;
+	return true;
+}
+
 void a12int_decode_vbuffer(
 	struct a12_state* S, struct video_frame* cvf, struct arcan_shmif_cont* cont)
 {
 	a12int_trace(A12_TRACE_VIDEO, "decode vbuffer, method: %d", cvf->postprocess);
 	if (cvf->postprocess == POSTPROCESS_VIDEO_MINIZ ||
 			cvf->postprocess == POSTPROCESS_VIDEO_DMINIZ){
-		size_t inbuf_pos = cvf->inbuf_pos;
-		tinfl_decompress_mem_to_callback(cvf->inbuf, &inbuf_pos, video_miniz, S, 0);
-
-		a12int_trace(A12_TRACE_ALLOC, "freeing zlib/png input block");
-		free(cvf->inbuf);
+		struct vframe_tile tile = {
+			.inbuf = cvf->inbuf,
+			.inbuf_sz = cvf->inbuf_pos,
+			.postprocess = cvf->postprocess,
+			.w = cvf->w,
+			.out_pos = cvf->out_pos,
+			.row_left = cvf->row_left,
+			.expanded_sz = cvf->expanded_sz
+		};
 		cvf->inbuf = NULL;
 		cvf->carry = 0;
 
+/* tiles without commit are deferred so the whole batch can be inflated in
+ * parallel, if we can't queue, land what we have and unpack this one inline */
+		if (!queue_tile(cvf, &tile)){
+			a12int_trace(A12_TRACE_ALLOC, "couldn't queue tile, unpack inline");
+			a12int_vframe_tiles_flush(cvf, cont);
+			tile.vidp = cont->vidp;
+			tile.pitch = cont->pitch;
+			tile_job(&tile, 0);
+		}
+
 /* this is a junction where other local transfer strategies should be considered,
  * i.e. no-block and defer process on the next stepframe or spin on the vready */
 		if (cvf->commit && cvf->commit != 255){
+			a12int_vframe_tiles_flush(cvf, cont);
 			a12int_trace(A12_TRACE_VIDEO, "kind=pre_signal:cont=%"PRIx64, (uintptr_t)cont);
 			arcan_shmif_signal(cont, SHMIF_SIGVID);
 			a12int_trace(A12_TRACE_VIDEO, "kind=post_signal:cont=%"PRIx64, (uintptr_t)cont);
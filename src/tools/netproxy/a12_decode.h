@@ -8,6 +8,19 @@
 bool a12int_buffer_format(int method);
 void a12int_decode_vbuffer(
 	struct a12_state* S, struct video_frame*, struct arcan_shmif_cont*);
+
+/*
+ * Unpack any compressed tiles that are waiting on a commit into [cont],
+ * needed before the store is resized or written to through other means.
+ */
+void a12int_vframe_tiles_flush(
+	struct video_frame* cvf, struct arcan_shmif_cont* cont);
+
+/*
+ * Discard pending tiles and release the tile queue.
+ */
+void a12int_vframe_tiles_drop(struct video_frame* cvf);
+
 void a12int_unpack_vbuffer(
 	struct a12_state* S, struct video_frame* cvf, struct arcan_shmif_cont* cont);
 #endif
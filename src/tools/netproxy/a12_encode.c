@@ -348,137 +348,216 @@ void a12int_encode_rgb(PACK_ARGS)
 	free(outb);
 }
 
-struct compress_res {
-	bool ok;
-	uint8_t type;
-	size_t out_sz;
+/*
+ * Frames are split into A12_TILE_SZ tiles clipped to the dirty region, each
+ * compressed on its own so that they can be processed over the worker pool
+ * and decoded independently on the other end. The accumulation buffer keeps
+ * a tightly packed copy of the last sent frame in the native pixel format so
+ * unchanged tiles can be rejected with a plain row memcmp (vectorized in any
+ * reasonable libc) before doing any packing.
+ */
+struct dpng_tile {
+	size_t x, y, w, h;
+	bool force;
 	uint8_t* out_buf;
+	size_t out_sz;
 };
 
-static struct compress_res compress_deltaz(struct a12_state* S, uint8_t ch,
-	struct shmifsrv_vbuffer* vb, size_t* x, size_t* y, size_t* w, size_t* h)
-{
+struct dpng_batch {
+	struct shmifsrv_vbuffer* vb;
+	struct shmifsrv_vbuffer* ab;
+	struct dpng_tile* tiles;
 	int type;
-	uint8_t* compress_in;
-	size_t compress_in_sz = 0;
-	struct shmifsrv_vbuffer* ab = &S->channels[ch].acc;
+};
+
+static bool tile_changed(struct shmifsrv_vbuffer* vb,
+	struct shmifsrv_vbuffer* ab, struct dpng_tile* t)
+{
+	for (size_t cy = t->y; cy < t->y + t->h; cy++){
+		if (memcmp(&vb->buffer[cy * vb->pitch + t->x],
+			&ab->buffer[cy * ab->pitch + t->x], t->w * sizeof(shmif_pixel)))
+			return true;
+	}
+	return false;
+}
+
+static void dpng_tile_job(void* tag, size_t ind)
+{
+	struct dpng_batch* B = tag;
+	struct dpng_tile* t = &B->tiles[ind];
+	struct shmifsrv_vbuffer* vb = B->vb;
+	struct shmifsrv_vbuffer* ab = B->ab;
+	bool delta = B->type == POSTPROCESS_VIDEO_DMINIZ;
+
+	if (delta && !t->force && !tile_changed(vb, ab, t))
+		return;
+
+/* the compression input stores a ^ b for delta tiles and plain rgb for
+ * the others, this should provide a better basis for deflates RLE etc. */
+	size_t nb = t->w * t->h * 3;
+	uint8_t* compress_in = malloc(nb);
+	if (!compress_in)
+		return;
+
+	size_t ofs = 0;
+	for (size_t cy = t->y; cy < t->y + t->h; cy++){
+		shmif_pixel* src = &vb->buffer[cy * vb->pitch + t->x];
+		shmif_pixel* acc = &ab->buffer[cy * ab->pitch + t->x];
+
+		for (size_t cx = 0; cx < t->w; cx++){
+			uint8_t r, g, b, ign;
+			SHMIF_RGBA_DECOMP(src[cx], &r, &g, &b, &ign);
+			if (delta){
+				uint8_t pr, pg, pb, pa;
+				SHMIF_RGBA_DECOMP(acc[cx], &pr, &pg, &pb, &pa);
+				r ^= pr;
+				g ^= pg;
+				b ^= pb;
+			}
+			compress_in[ofs++] = r;
+			compress_in[ofs++] = g;
+			compress_in[ofs++] = b;
+		}
+	}
+
+	t->out_buf = tdefl_compress_mem_to_heap(compress_in, nb, &t->out_sz, 0);
+	free(compress_in);
+
+/* only advance the accumulation buffer for the tiles that will be sent,
+ * a dropped tile is then just picked up as changed on the next frame */
+	if (!t->out_buf)
+		return;
+
+	for (size_t cy = t->y; cy < t->y + t->h; cy++){
+		memcpy(&ab->buffer[cy * ab->pitch + t->x],
+			&vb->buffer[cy * vb->pitch + t->x], t->w * sizeof(shmif_pixel));
+	}
+}
+
+void a12int_encode_dpng(PACK_ARGS)
+{
+	struct shmifsrv_vbuffer* ab = &S->channels[chid].acc;
+	int type = POSTPROCESS_VIDEO_DMINIZ;
 
 /* reset the accumulation buffer so that we rebuild the normal frame */
 	if (ab->w != vb->w || ab->h != vb->h){
 		a12int_trace(A12_TRACE_VIDEO,
-			"kind=resize:ch=%"PRIu8"prev_w=%zu:rev_h=%zu:new_w%zu:new_h=%zu",
-			ch, (size_t) ab->w, (size_t) ab->h, (size_t) vb->w, (size_t) vb->h
+			"kind=resize:ch=%d:prev_w=%zu:rev_h=%zu:new_w%zu:new_h=%zu",
+			chid, (size_t) ab->w, (size_t) ab->h, (size_t) vb->w, (size_t) vb->h
 		);
 		free(ab->buffer);
-		free(S->channels[ch].compression);
 		ab->buffer = NULL;
-		S->channels[ch].compression = NULL;
 	}
 
-/* first, reset or no-delta mode, build accumulation buffer and copy */
+/* first, reset or no-delta mode, build accumulation buffer and send all */
 	if (!ab->buffer){
-		type = POSTPROCESS_VIDEO_MINIZ;
 		*ab = *vb;
-		size_t nb = vb->w * vb->h * 3;
-		ab->buffer = malloc(nb);
-		*w = vb->w;
-		*h = vb->h;
-		*x = 0;
-		*y = 0;
+		ab->pitch = vb->w;
+		ab->stride = vb->w * sizeof(shmif_pixel);
+		ab->buffer = malloc(vb->w * vb->h * sizeof(shmif_pixel));
+		if (!ab->buffer)
+			return;
+
+		type = POSTPROCESS_VIDEO_MINIZ;
+		x = 0;
+		y = 0;
+		w = vb->w;
+		h = vb->h;
 		a12int_trace(A12_TRACE_VIDEO,
-			"kind=status:ch=%"PRIu8"compress=dpng:message=I", ch);
+			"kind=status:ch=%d:compress=dpng:message=I", chid);
+	}
 
-		if (!ab->buffer)
-			return (struct compress_res){};
-
-/* the compression buffer stores a ^ b, accumulation is a packed copy of the
- * contents of the previous input frame, this should provide a better basis for
- * deflates RLE etc. stages, but also act as an option for us to provide our
- * cheaper RLE or send out a raw- frame when the RLE didn't work out */
-		S->channels[ch].compression = malloc(nb);
-		compress_in_sz = nb;
-
-		if (!S->channels[ch].compression){
-			free(ab->buffer);
-			ab->buffer = NULL;
-			return (struct compress_res){};
-		}
+/* align to the tile grid so tiles stay put between frames, but clip to the
+ * dirty region so we don't compare what the client says hasn't changed */
+	size_t tx1 = x / A12_TILE_SZ;
+	size_t ty1 = y / A12_TILE_SZ;
+	size_t tx2 = (x + w + A12_TILE_SZ - 1) / A12_TILE_SZ;
+	size_t ty2 = (y + h + A12_TILE_SZ - 1) / A12_TILE_SZ;
+	size_t n_tiles = (tx2 - tx1) * (ty2 - ty1);
+	if (!n_tiles)
+		return;
 
-/* so accumulation buffer might be tightly packed while the source
- * buffer do not have to be, thus we need to iterate and do this copy */
-		compress_in = (uint8_t*) ab->buffer;
-		uint8_t* acc = compress_in;
-		size_t ofs = 0;
-		for (size_t y = 0; y < vb->h; y++){
-			for (size_t x = 0; x < vb->w; x++){
-				uint8_t ign;
-				shmif_pixel px = vb->buffer[y*vb->pitch+x];
-				SHMIF_RGBA_DECOMP(px, &acc[ofs], &acc[ofs+1], &acc[ofs+2], &ign);
-				ofs += 3;
-			}
-		}
+	struct dpng_tile* tiles = malloc(n_tiles * sizeof(struct dpng_tile));
+	if (!tiles){
+		a12int_trace(A12_TRACE_ALLOC,
+			"failed to alloc %zu tiles for dpng", n_tiles);
+		return;
 	}
-/* We have a delta frame, use accumulation buffer as a way to calculate a ^ b
- * and store ^ b. For smaller regions, we might want to do something simpler
- * like RLE only. The flags (,0) can be derived with the _zip helper */
-	else {
-		a12int_trace(A12_TRACE_VDETAIL,
-			"kind=status:ch=%"PRIu8"dw=%zu:dh=%zu:x=%zu:y=%zu",
-			ch, (size_t)*w, (size_t)*h, (size_t) *x, (size_t) *y
-		);
-		compress_in = S->channels[ch].compression;
-		uint8_t* acc = (uint8_t*) ab->buffer;
-		for (size_t cy = (*y); cy < (*y)+(*h); cy++){
-			size_t rs = (cy * ab->w + (*x)) * 3;
-
-			for (size_t cx = *x; cx < (*x)+(*w); cx++){
-				uint8_t r, g, b, ign;
-				shmif_pixel px = vb->buffer[cy * vb->pitch + cx];
-				SHMIF_RGBA_DECOMP(px, &r, &g, &b, &ign);
-				compress_in[compress_in_sz++] = acc[rs+0] ^ r;
-				compress_in[compress_in_sz++] = acc[rs+1] ^ g;
-				compress_in[compress_in_sz++] = acc[rs+2] ^ b;
-				acc[rs+0] = r; acc[rs+1] = g; acc[rs+2] = b;
-				rs += 3;
-			}
+
+	size_t ind = 0;
+	for (size_t ty = ty1; ty < ty2; ty++){
+		size_t y1 = ty * A12_TILE_SZ < y ? y : ty * A12_TILE_SZ;
+		size_t y2 = (ty + 1) * A12_TILE_SZ > y + h ? y + h : (ty + 1) * A12_TILE_SZ;
+
+		for (size_t tx = tx1; tx < tx2; tx++){
+			size_t x1 = tx * A12_TILE_SZ < x ? x : tx * A12_TILE_SZ;
+			size_t x2 = (tx + 1) * A12_TILE_SZ > x + w ? x + w : (tx + 1) * A12_TILE_SZ;
+			tiles[ind++] = (struct dpng_tile){
+				.x = x1, .y = y1, .w = x2 - x1, .h = y2 - y1,
+				.force = type == POSTPROCESS_VIDEO_MINIZ
+			};
 		}
-		type = POSTPROCESS_VIDEO_DMINIZ;
 	}
 
-	size_t out_sz;
+	struct dpng_batch batch = {
+		.vb = vb,
+		.ab = ab,
+		.tiles = tiles,
+		.type = type
+	};
+	a12int_parallel(dpng_tile_job, &batch, n_tiles);
+
+/* the frame still needs a commit even if nothing changed, so send the first
+ * tile as an empty delta */
+	size_t last = n_tiles;
+	for (size_t i = 0; i < n_tiles; i++)
+		if (tiles[i].out_buf)
+			last = i;
+
+	if (last == n_tiles){
+		tiles[0].force = true;
+		dpng_tile_job(&batch, 0);
+		last = 0;
+	}
 
-	uint8_t* buf = tdefl_compress_mem_to_heap(
-			compress_in, compress_in_sz, &out_sz, 0);
+	size_t b_in = 0, b_out = 0, n_out = 0;
+	bool dropped = false;
 
-	return (struct compress_res){
-		.type = type,
-		.ok = buf != NULL,
-		.out_buf = buf,
-		.out_sz = out_sz
-	};
-}
+	for (size_t i = 0; i < n_tiles; i++){
+		struct dpng_tile* t = &tiles[i];
+		if (!t->out_buf){
+			dropped |= t->force;
+			continue;
+		}
 
-void a12int_encode_dpng(PACK_ARGS)
-{
-	struct compress_res cres = compress_deltaz(S, chid, vb, &x, &y, &w, &h);
-	if (!cres.ok)
-		return;
+		uint8_t hdr_buf[CONTROL_PACKET_SIZE];
+		a12int_vframehdr_build(hdr_buf, S->last_seen_seqnr, chid,
+			type, 0, vb->w, vb->h, t->w, t->h, t->x, t->y,
+			t->out_sz, t->w * t->h * 3, i == last
+		);
+		a12int_append_out(S,
+			STATE_CONTROL_PACKET, hdr_buf, CONTROL_PACKET_SIZE, NULL, 0);
+		chunk_pack(S, STATE_VIDEO_PACKET, chid, t->out_buf, t->out_sz, chunk_sz);
 
-	uint8_t hdr_buf[CONTROL_PACKET_SIZE];
-	a12int_vframehdr_build(hdr_buf, S->last_seen_seqnr, chid,
-		cres.type, 0, vb->w, vb->h, w, h, x, y,
-		cres.out_sz, w * h * 3, 1
-	);
+		b_in += t->w * t->h * 3;
+		b_out += t->out_sz;
+		n_out++;
+		free(t->out_buf);
+	}
 
 	a12int_trace(A12_TRACE_VDETAIL,
-		"kind=status:codec=dpng:b_in=%zu:b_out=%zu", w * h * 3, cres.out_sz
+		"kind=status:codec=dpng:tiles=%zu/%zu:b_in=%zu:b_out=%zu",
+		n_out, n_tiles, b_in, b_out
 	);
 
-	a12int_append_out(S,
-		STATE_CONTROL_PACKET, hdr_buf, CONTROL_PACKET_SIZE, NULL, 0);
-	chunk_pack(S, STATE_VIDEO_PACKET, chid, cres.out_buf, cres.out_sz, chunk_sz);
+/* a tile missing from a full frame leaves the accumulation buffer undefined
+ * there, so start over with a new one */
+	if (dropped && type == POSTPROCESS_VIDEO_MINIZ){
+		free(ab->buffer);
+		ab->buffer = NULL;
+	}
 
-	free(cres.out_buf);
+	free(tiles);
 }
 
 #ifdef WANT_H264_ENC
@@ -93,6 +93,20 @@ enum {
 
 size_t a12int_header_size(int type);
 
+/*
+ * Run [n_jobs] calls to [job](tag, index) over the shared worker pool and
+ * return when all of them have completed. Jobs must not touch the state
+ * machine output buffers, only their own slot in [tag].
+ */
+void a12int_parallel(void (*job)(void*, size_t), void* tag, size_t n_jobs);
+
+/*
+ * DPNG/DMINIZ frames are split into tiles of this size (aligned to the
+ * surface origin) that are compressed and sent as separate frames, only
+ * the last one in a batch carries commit.
+ */
+#define A12_TILE_SZ 128
+
 struct audio_frame {
 	uint32_t rate;
 	uint8_t encoding;
@@ -138,6 +152,12 @@ struct video_frame {
 	uint8_t pxbuf[4];
 	uint8_t carry;
 
+/* compressed tiles received without commit, these are unpacked together
+ * over the worker pool when the frame is committed */
+	struct vframe_tile* tiles;
+	size_t n_tiles;
+	size_t tiles_sz;
+
 #ifdef WANT_H264_DEC
 	struct {
 		AVCodecParserContext* parser;
@@ -204,22 +224,20 @@ struct a12_state {
 			struct binary_frame bframe;
 		} unpack_state;
 
-/* encoding (recall, both sides can actually do this) */
+/* encoding (recall, both sides can actually do this), acc is a tightly
+ * packed copy of the last frame sent for delta tiles */
 		struct shmifsrv_vbuffer acc;
-		union {
-			uint8_t* compression;
 #ifdef WANT_H264_ENC
-			struct {
-				AVCodecContext* encoder;
-				AVCodec* codec;
-				AVFrame* frame;
-				AVPacket* packet;
-				struct SwsContext* scaler;
-				size_t w, h;
-				bool failed;
-			} videnc;
+		struct {
+			AVCodecContext* encoder;
+			AVCodec* codec;
+			AVFrame* frame;
+			AVPacket* packet;
+			struct SwsContext* scaler;
+			size_t w, h;
+			bool failed;
+		} videnc;
 #endif
-		};
 	} channels[256];
 
 /* current decoding state, tracked / used by the process_* functions */
@@ -104,6 +104,10 @@ struct scratch_req {
 };
 
 #define SURF_TAGLEN 16
+struct damage_rect {
+	size_t x1, y1, x2, y2;
+};
+
 struct comp_surf {
 	struct wl_listener l_bufrem;
 	bool l_bufrem_a;
@@ -133,6 +137,18 @@ struct comp_surf {
 	int fail_accel;
 	int accel_fmt;
 
+/*
+ * accumulated damage since the last commit, empty when x2 <= x1. [damage] is
+ * in buffer coordinates and [sdamage] in surface coordinates, the latter is
+ * converted using the buffer scale / transform and merged on commit.
+ * shm_valid is set when vidp holds the full contents of the last committed
+ * shm buffer, so that only the damaged region needs to be repacked on the
+ * next one.
+ */
+	struct damage_rect damage, sdamage;
+	int32_t buffer_scale, buffer_transform;
+	bool shm_valid;
+
 /*
  * Just keep this fugly thing here as it is on par with wl_list masturbation,
  * the protocol is just riddled with unbounded allocations because all the bad
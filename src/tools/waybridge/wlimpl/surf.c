@@ -80,8 +80,46 @@ static void surf_attach(struct wl_client* cl, struct wl_resource* res,
 /*
  * Similar to the X damage stuff, just grow the synch region for shm repacking
  * but there's more to this (of course there is) as there's the whole buffer
- * isn't necessarily 1:1 of surface.
+ * isn't necessarily 1:1 of surface. Clients like to send INT32_MAX for 'all'
+ * so clamp here and crop against the buffer dimensions on commit.
  */
+static void damage_grow(struct damage_rect* dmg,
+	int32_t x, int32_t y, int32_t w, int32_t h)
+{
+	if (w <= 0 || h <= 0)
+		return;
+
+	int64_t x2 = (int64_t)x + w;
+	int64_t y2 = (int64_t)y + h;
+	if (x2 <= 0 || y2 <= 0)
+		return;
+
+	size_t x1 = x < 0 ? 0 : x;
+	size_t y1 = y < 0 ? 0 : y;
+	if (x2 > INT32_MAX)
+		x2 = INT32_MAX;
+	if (y2 > INT32_MAX)
+		y2 = INT32_MAX;
+
+	if (dmg->x2 <= dmg->x1){
+		dmg->x1 = x1;
+		dmg->y1 = y1;
+		dmg->x2 = x2;
+		dmg->y2 = y2;
+		return;
+	}
+
+	if (x1 < dmg->x1)
+		dmg->x1 = x1;
+	if (x2 > dmg->x2)
+		dmg->x2 = x2;
+	if (y1 < dmg->y1)
+		dmg->y1 = y1;
+	if (y2 > dmg->y2)
+		dmg->y2 = y2;
+}
+
+/* wl_surface.damage, surface coordinates */
 static void surf_damage(struct wl_client* cl, struct wl_resource* res,
 	int32_t x, int32_t y, int32_t w, int32_t h)
 {
@@ -89,14 +127,56 @@ static void surf_damage(struct wl_client* cl, struct wl_resource* res,
 	trace(TRACE_SURF,"%s:(%"PRIxPTR") @x,y+w,h(%d+%d, %d+%d)",
 		surf->tracetag, (uintptr_t)res, (int)x, (int)w, (int)y, (int)h);
 
-	if (x < surf->acon.dirty.x1)
-		surf->acon.dirty.x1 = x;
-	if (x+w > surf->acon.dirty.x2)
-		surf->acon.dirty.x2 = x+w;
-	if (y < surf->acon.dirty.y1)
-		surf->acon.dirty.y1 = y;
-	if (y+h > surf->acon.dirty.y2)
-		surf->acon.dirty.y2 = y+h;
+	damage_grow(&surf->sdamage, x, y, w, h);
+}
+
+/* wl_surface.damage_buffer, buffer coordinates */
+static void surf_damage_buffer(struct wl_client* cl, struct wl_resource* res,
+	int32_t x, int32_t y, int32_t w, int32_t h)
+{
+	struct comp_surf* surf = wl_resource_get_user_data(res);
+	trace(TRACE_SURF,"%s:(%"PRIxPTR") buffer @x,y+w,h(%d+%d, %d+%d)",
+		surf->tracetag, (uintptr_t)res, (int)x, (int)w, (int)y, (int)h);
+
+	damage_grow(&surf->damage, x, y, w, h);
+}
+
+/*
+ * Move the surface- space damage into the buffer- space one. With a buffer
+ * transform the mapping would need the buffer dimensions as well, so just
+ * damage everything in that case.
+ */
+static void damage_merge(struct comp_surf* surf)
+{
+	struct damage_rect* sd = &surf->sdamage;
+	if (sd->x2 <= sd->x1)
+		return;
+
+	struct damage_rect* dmg = &surf->damage;
+	if (surf->buffer_transform){
+		*dmg = (struct damage_rect){.x2 = INT32_MAX, .y2 = INT32_MAX};
+		sd->x1 = sd->x2 = 0;
+		return;
+	}
+
+	size_t scale = surf->buffer_scale > 1 ? surf->buffer_scale : 1;
+	struct damage_rect r = {
+		.x1 = sd->x1 * scale,
+		.y1 = sd->y1 * scale,
+		.x2 = sd->x2 > INT32_MAX / scale ? INT32_MAX : sd->x2 * scale,
+		.y2 = sd->y2 > INT32_MAX / scale ? INT32_MAX : sd->y2 * scale
+	};
+	sd->x1 = sd->x2 = 0;
+
+	if (dmg->x2 <= dmg->x1){
+		*dmg = r;
+		return;
+	}
+
+	dmg->x1 = r.x1 < dmg->x1 ? r.x1 : dmg->x1;
+	dmg->y1 = r.y1 < dmg->y1 ? r.y1 : dmg->y1;
+	dmg->x2 = r.x2 > dmg->x2 ? r.x2 : dmg->x2;
+	dmg->y2 = r.y2 > dmg->y2 ? r.y2 : dmg->y2;
 }
 
 /*
@@ -221,6 +301,8 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 		return;
 	}
 
+	damage_merge(surf);
+
 /*
  * if we don't defer the release, we seem to provoke some kind of race
  * condition in the client or support libs that end very SIGSEGVy
@@ -292,6 +374,7 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 		if (drm_buf){
 			trace(TRACE_SURF, "surf_commit(egl:%s)", surf->tracetag);
 			wayland_drm_commit(surf, drm_buf, acon);
+			surf->shm_valid = false;
 			surf->last_buf = buf;
 		}
 		else
@@ -309,6 +392,7 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 			trace(TRACE_SURF,
 				"surf_commit(shm, resize to: %zu, %zu)", (size_t)w, (size_t)h);
 			arcan_shmif_resize(acon, w, h);
+			surf->shm_valid = false;
 		}
 
 /* resize failed, this will only happen when growing, thus we can crop */
@@ -352,6 +436,8 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 					0, SHMIF_SIGVID | SHMIF_SIGBLK_NONE, SHMIFEXT_BUILTIN);
 				acon->vidp = old_vidp;
 				acon->stride = old_stride;
+				surf->shm_valid = false;
+				surf->damage.x1 = surf->damage.x2 = 0;
 				if (wl.defer_release)
 					surf->last_buf = buf;
 				else
@@ -360,19 +446,34 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 			}
 		}
 
-/* if stride mismatch, copy row by row - this do NOT handle format conversion /
- * swizzling yet, copy code from fsrv_game for that */
-		if (stride != acon->stride){
-			trace(TRACE_SURF,"surf_commit(stride-mismatch)");
-			for (size_t row = 0; row < h; row++){
-				memcpy(&acon->vidp[row * acon->pitch],
-					&((uint8_t*)data)[row * stride],
-					w * sizeof(shmif_pixel)
-				);
+/* vidp is single-buffered and retains the last committed contents, so unless
+ * the store was resized, came from another path or belongs to another segment
+ * (cursor), only the damaged region needs repacking. This does NOT handle
+ * format conversion / swizzling yet, copy code from fsrv_game for that */
+		size_t x1 = 0, y1 = 0, x2 = w, y2 = h;
+		if (surf->shm_valid && acon == &surf->acon){
+			x1 = surf->damage.x1 < w ? surf->damage.x1 : w;
+			y1 = surf->damage.y1 < h ? surf->damage.y1 : h;
+			x2 = surf->damage.x2 < w ? surf->damage.x2 : w;
+			y2 = surf->damage.y2 < h ? surf->damage.y2 : h;
+		}
+
+		if (x2 > x1 && y2 > y1){
+			size_t bpp = sizeof(shmif_pixel);
+			uint8_t* src = &((uint8_t*)data)[y1 * stride + x1 * bpp];
+
+			if (x1 == 0 && x2 == w && stride == acon->stride){
+				memcpy(&acon->vidp[y1 * acon->pitch], src, (y2 - y1) * stride);
+			}
+			else {
+				trace(TRACE_SURF,"surf_commit(partial/stride-mismatch)");
+				for (size_t row = y1; row < y2; row++, src += stride)
+					memcpy(&acon->vidp[row * acon->pitch + x1], src, (x2 - x1) * bpp);
 			}
+
+			arcan_shmif_dirty(acon, x1, y1, x2, y2, 0);
 		}
-		else
-			memcpy(acon->vidp, data, w * h * sizeof(shmif_pixel));
+		surf->shm_valid = acon == &surf->acon;
 
 		arcan_shmif_signal(acon, SHMIF_SIGVID | SHMIF_SIGBLK_NONE);
 		if (wl.defer_release)
@@ -391,6 +492,7 @@ static void surf_commit(struct wl_client* cl, struct wl_resource* res)
 	acon->dirty.x2 = 0;
 	acon->dirty.y1 = acon->h;
 	acon->dirty.y2 = 0;
+	surf->damage.x1 = surf->damage.x2 = 0;
 }
 
 static void surf_transform(struct wl_client* cl,
@@ -398,7 +500,11 @@ static void surf_transform(struct wl_client* cl,
 {
 	trace(TRACE_SURF, "surf_transform(%d)", (int) transform);
 	struct comp_surf* surf = wl_resource_get_user_data(res);
-	if (!surf || !surf->acon.addr)
+	if (!surf)
+		return;
+
+	surf->buffer_transform = transform;
+	if (!surf->acon.addr)
 		return;
 
 	struct arcan_event ev = {
@@ -415,7 +521,11 @@ static void surf_scale(struct wl_client* cl,
 {
 	trace(TRACE_SURF, "surf_scale(%d)", (int) scale);
 	struct comp_surf* surf = wl_resource_get_user_data(res);
-	if (!surf || !surf->acon.addr)
+	if (!surf)
+		return;
+
+	surf->buffer_scale = scale;
+	if (!surf->acon.addr)
 		return;
 
 	struct arcan_event ev = {
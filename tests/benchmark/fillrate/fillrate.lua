@@ -20,6 +20,10 @@ end
 
 function fillrate_clock_pulse()
 	if (not benchmark:tick()) then
+		local dc = benchmark_drawcalls();
+		print(string.format("drawcalls:%s:%d:%.2f",
+			dc.batching and "batch" or "nobatch", dc.quads,
+			dc.total_calls / math.max(dc.refreshes, 1)));
 		return shutdown();
 	end
 end
@@ -0,0 +1,50 @@
+--
+-- Terminal throughput test, spawns the terminal frameserver with a
+-- command that writes [mb] megabytes of text and reports how fast the
+-- terminal managed to consume it, i.e. the parser and screen update.
+--
+-- arcan /path/to/termrate [mb] [ascii | utf8 | sgr | mixed]
+--
+-- output (stdout) follows the mode:mb:seconds:mb_per_s format
+--
+
+local patterns = {
+	ascii = "the quick brown fox jumps over the lazy dog 0123456789",
+	utf8 = "blåbärssylt på smörgåsbordet, ĉiuĵaŭde, αβγδεζ, ½ ¼ ¾ ±",
+	sgr = "$(printf '\\033[1;32mok\\033[0m \\033[38;5;208mwarn\\033[0m line')",
+	mixed = "$(printf 'plain ascii, åäö, \\033[7mrev\\033[27m, 日本語 \\tx')"
+};
+
+function termrate(arguments)
+	local mb = tonumber(arguments[1]) and tonumber(arguments[1]) or 100;
+	local mode = arguments[2] and arguments[2] or "ascii";
+
+	if (not patterns[mode]) then
+		warning("unknown mode, accepted: ascii, utf8, sgr, mixed");
+		return shutdown();
+	end
+
+	local cmd = string.format("yes \"%s\" | head -c %d",
+		patterns[mode], mb * 1024 * 1024);
+
+	local start = benchmark_timestamp();
+	local vid = launch_avfeed("env=ARCAN_TERMINAL_EXEC=" .. cmd, "terminal",
+	function(source, status)
+		if (status.kind == "resized") then
+			resize_image(source, status.width, status.height);
+			show_image(source);
+
+		elseif (status.kind == "terminated") then
+			local elapsed = (benchmark_timestamp() - start) / 1000.0;
+			print(string.format("%s:%d:%.3f:%.2f",
+				mode, mb, elapsed, mb / elapsed));
+			delete_image(source);
+			shutdown();
+		end
+	end);
+
+	if (not valid_vid(vid)) then
+		warning("couldn't spawn terminal frameserver");
+		return shutdown();
+	end
+end
@@ -33,6 +33,10 @@ end
 
 _G[ _G["APPLID"] .. "_clock_pulse"] = function()
 	if (not benchmark:tick()) then
+		local dc = benchmark_drawcalls();
+		print(string.format("drawcalls:%s:%d:%.2f",
+			dc.batching and "batch" or "nobatch", dc.quads,
+			dc.total_calls / math.max(dc.refreshes, 1)));
 		return shutdown();
 	end
 end